@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+#
+# Copyright (c)  2024  Xiaomi Corporation
+
+"""
+A websocket client for sherpa-onnx-offline-websocket-server using the
+incremental mode.
+
+The file is uploaded in chunks without telling the server its length.
+The server splits it into segments with a VAD and sends the result of
+each segment as soon as it is decoded, so results arrive while the file
+is still being uploaded.
+
+Usage:
+    ./offline-websocket-client-incremental.py \
+      --server-addr localhost \
+      --server-port 6006 \
+      /path/to/16kHz.wav
+
+(Note: You have to first start the server with --silero-vad-model
+before starting the client)
+
+You can find the server at
+https://github.com/k2-fsa/sherpa-onnx/blob/master/sherpa-onnx/csrc/offline-websocket-server.cc
+
+Note: The server is implemented in C++.
+"""
+
+import argparse
+import asyncio
+import json
+import logging
+import wave
+from typing import Tuple
+
+try:
+    import websockets
+except ImportError:
+    print("please run:")
+    print("")
+    print("  pip install websockets")
+    print("")
+    print("before you run this script")
+    print("")
+
+import numpy as np
+
+
+def get_args():
+    parser = argparse.ArgumentParser(
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter
+    )
+
+    parser.add_argument(
+        "--server-addr",
+        type=str,
+        default="localhost",
+        help="Address of the server",
+    )
+
+    parser.add_argument(
+        "--server-port",
+        type=int,
+        default=6006,
+        help="Port of the server",
+    )
+
+    parser.add_argument(
+        "--seconds-per-message",
+        type=float,
+        default=1.0,
+        help="Number of seconds of audio in each message",
+    )
+
+    parser.add_argument(
+        "--speed",
+        type=float,
+        default=0,
+        help="Upload speed relative to real time. 0 means as fast as "
+        "possible. Use 1 to simulate a live recording.",
+    )
+
+    parser.add_argument(
+        "sound_file",
+        type=str,
+        help="The input sound file to decode. It must be of WAVE "
+        "format with a single channel, and each sample has 16-bit, "
+        "i.e., int16_t. Its sample rate must be the one of the VAD "
+        "model of the server, which is usually 16 kHz",
+    )
+
+    return parser.parse_args()
+
+
+def read_wave(wave_filename: str) -> Tuple[np.ndarray, int]:
+    """
+    Args:
+      wave_filename:
+        Path to a wave file. It should be single channel and each sample should
+        be 16-bit.
+    Returns:
+      Return a tuple containing:
+       - A 1-D array of dtype np.float32 containing the samples, which are
+       normalized to the range [-1, 1].
+       - sample rate of the wave file
+    """
+
+    with wave.open(wave_filename) as f:
+        assert f.getnchannels() == 1, f.getnchannels()
+        assert f.getsampwidth() == 2, f.getsampwidth()  # it is in bytes
+        num_samples = f.getnframes()
+        samples = f.readframes(num_samples)
+        samples_int16 = np.frombuffer(samples, dtype=np.int16)
+        samples_float32 = samples_int16.astype(np.float32)
+
+        samples_float32 = samples_float32 / 32768
+        return samples_float32, f.getframerate()
+
+
+async def receive_results(websocket):
+    while True:
+        message = json.loads(await websocket.recv())
+        if message["is_final"]:
+            logging.info(f"Number of segments: {message['num_segments']}")
+            break
+
+        start = message["start"]
+        end = start + message["duration"]
+        text = message["result"]["text"]
+        print(f"{start:.2f} -- {end:.2f}: {text}")
+
+
+async def run(args):
+    samples, sample_rate = read_wave(args.sound_file)
+
+    async with websockets.connect(
+        f"ws://{args.server_addr}:{args.server_port}"
+    ) as websocket:  # noqa
+        receive_task = asyncio.create_task(receive_results(websocket))
+
+        # -1 means the length is not known in advance
+        header = sample_rate.to_bytes(4, byteorder="little")
+        header += (-1).to_bytes(4, byteorder="little", signed=True)
+
+        n = int(args.seconds_per_message * sample_rate)
+        for start in range(0, samples.size, n):
+            buf = samples[start : start + n].tobytes()
+            if start == 0:
+                buf = header + buf
+            await websocket.send(buf)
+
+            if args.speed > 0:
+                await asyncio.sleep(args.seconds_per_message / args.speed)
+
+        # to signal the end of the upload
+        await websocket.send("Done")
+
+        await receive_task
+
+        # to close the connection
+        await websocket.send("Done")
+
+
+async def main():
+    args = get_args()
+    logging.info(vars(args))
+
+    await run(args)
+
+
+if __name__ == "__main__":
+    formatter = (
+        "%(asctime)s %(levelname)s [%(filename)s:%(lineno)d] %(message)s"  # noqa
+    )
+    logging.basicConfig(format=formatter, level=logging.INFO)
+    asyncio.run(main())
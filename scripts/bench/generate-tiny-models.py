@@ -0,0 +1,422 @@
+#!/usr/bin/env python3
+#
+# Copyright (c)  2024  Xiaomi Corporation
+
+"""
+This script generates tiny randomly initialized ONNX models for
+sherpa-onnx-bench. The models have the same inputs, outputs and meta data
+as the real ones, so they exercise the same code paths in sherpa-onnx
+without downloading anything. Their outputs are meaningless.
+
+The weights are generated with a fixed seed, so the models are the same
+every time this script is run.
+
+Usage:
+
+  pip install onnx numpy
+  ./generate-tiny-models.py --out-dir ./bench-models
+
+It generates:
+
+  - zipformer2-encoder.onnx, zipformer2-decoder.onnx, zipformer2-joiner.onnx
+      A streaming zipformer2 transducer. The states have the same shapes
+      as a real model.
+  - zipformer-ctc.onnx
+      A non-streaming zipformer CTC model
+  - tokens.txt, keywords.txt
+      Tokens for the above models and keywords for keyword spotting
+  - silero-vad.onnx
+      A silero VAD model. Its output is high for loud audio.
+  - vits.onnx, vits-tokens.txt, vits-lexicon.txt
+      A VITS TTS model using a lexicon
+"""
+
+import argparse
+from pathlib import Path
+from typing import Dict, List
+
+try:
+    import numpy as np
+    import onnx
+    from onnx import TensorProto, helper, numpy_helper
+except ImportError:
+    print("please run:")
+    print("")
+    print("  pip install onnx numpy")
+    print("")
+    print("before you run this script")
+    print("")
+    raise
+
+OPSET = 13
+
+VOCAB_SIZE = 500
+FEATURE_DIM = 80
+JOINER_DIM = 256
+CONTEXT_SIZE = 2
+
+# Similar to a small streaming zipformer2 model with chunk size 16
+ENCODER_DIMS = [192, 256, 256, 256, 256, 256]
+NUM_ENCODER_LAYERS = [2, 2, 2, 2, 2, 2]
+QUERY_HEAD_DIMS = [32, 32, 32, 32, 32, 32]
+VALUE_HEAD_DIMS = [12, 12, 12, 12, 12, 12]
+NUM_HEADS = [4, 4, 4, 8, 4, 4]
+CNN_MODULE_KERNELS = [31, 31, 15, 15, 15, 31]
+LEFT_CONTEXT_LEN = [128, 64, 32, 16, 32, 64]
+DECODE_CHUNK_LEN = 32
+T = DECODE_CHUNK_LEN + 13
+
+# Words used by the TTS benchmark
+WORDS = (
+    "the quick brown fox jumps over lazy dog a an and of to in is it "
+    "that was he for on are as with his they at be this from have or by "
+    "one had not but what all were when we there can said which do their "
+    "time if will way about many then them would write like so these her "
+    "long make thing see him two has look more day could go come did my "
+    "sound no most number who over know water than call first people may "
+    "down side been now find any new work part take get place made live "
+    "where after back little only round man year came show every good me "
+    "give our under name very through just form much great think say help "
+    "low line before turn cause same mean differ move right boy old too "
+    "does tell sentence set three want air well also play small end put "
+    "home read hand port large spell add even land here must big high such"
+).split()
+
+
+def get_args():
+    parser = argparse.ArgumentParser()
+    parser.add_argument(
+        "--out-dir",
+        type=str,
+        required=True,
+        help="Directory to save the generated files",
+    )
+    parser.add_argument(
+        "--seed",
+        type=int,
+        default=20240101,
+        help="Seed for the random weights",
+    )
+    return parser.parse_args()
+
+
+class Builder:
+    """Helper to build an ONNX graph with random initializers."""
+
+    def __init__(self, rng: np.random.Generator):
+        self.rng = rng
+        self.nodes = []
+        self.initializers = []
+        self.count = 0
+
+    def name(self, prefix: str) -> str:
+        self.count += 1
+        return f"{prefix}_{self.count}"
+
+    def weight(self, shape: List[int], scale: float = 0.1) -> str:
+        name = self.name("w")
+        value = (self.rng.standard_normal(shape) * scale).astype(np.float32)
+        self.initializers.append(numpy_helper.from_array(value, name))
+        return name
+
+    def const(self, value: np.ndarray) -> str:
+        name = self.name("c")
+        self.initializers.append(numpy_helper.from_array(value, name))
+        return name
+
+    def op(self, op_type: str, inputs: List[str], output: str = None, **kw):
+        if output is None:
+            output = self.name(op_type.lower())
+        self.nodes.append(helper.make_node(op_type, inputs, [output], **kw))
+        return output
+
+    def save(
+        self,
+        inputs,
+        outputs,
+        filename: str,
+        meta_data: Dict[str, str] = None,
+    ):
+        graph = helper.make_graph(
+            self.nodes,
+            "bench",
+            inputs,
+            outputs,
+            initializer=self.initializers,
+        )
+        model = helper.make_model(
+            graph, opset_imports=[helper.make_opsetid("", OPSET)]
+        )
+        model.ir_version = 8
+
+        for key, value in (meta_data or {}).items():
+            meta = model.metadata_props.add()
+            meta.key = key
+            meta.value = str(value)
+
+        onnx.checker.check_model(model)
+        onnx.save(model, filename)
+
+
+def to_str(v: List[int]) -> str:
+    return ",".join(map(str, v))
+
+
+def zipformer2_states():
+    """Return a list of (name, elem_type, shape) of the encoder states.
+
+    It has to match OnlineZipformer2TransducerModel::GetEncoderInitStates().
+    """
+    ans = []
+    k = 0
+    for i in range(len(ENCODER_DIMS)):
+        key_dim = QUERY_HEAD_DIMS[i] * NUM_HEADS[i]
+        value_dim = VALUE_HEAD_DIMS[i] * NUM_HEADS[i]
+        nonlin_attn_head_dim = 3 * ENCODER_DIMS[i] // 4
+        left = LEFT_CONTEXT_LEN[i]
+        conv = CNN_MODULE_KERNELS[i] // 2
+
+        for _ in range(NUM_ENCODER_LAYERS[i]):
+            f = TensorProto.FLOAT
+            ans += [
+                (f"cached_key_{k}", f, [left, "N", key_dim]),
+                (f"cached_nonlin_attn_{k}", f, [1, "N", left, nonlin_attn_head_dim]),
+                (f"cached_val1_{k}", f, [left, "N", value_dim]),
+                (f"cached_val2_{k}", f, [left, "N", value_dim]),
+                (f"cached_conv1_{k}", f, ["N", ENCODER_DIMS[i], conv]),
+                (f"cached_conv2_{k}", f, ["N", ENCODER_DIMS[i], conv]),
+            ]
+            k += 1
+
+    embed_dim = (((FEATURE_DIM - 1) // 2) - 1) // 2
+    ans.append(("embed_states", TensorProto.FLOAT, ["N", 128, 3, embed_dim]))
+    ans.append(("processed_lens", TensorProto.INT64, ["N"]))
+    return ans
+
+
+def generate_zipformer2(rng, out_dir: Path):
+    # encoder
+    b = Builder(rng)
+    # Subsample the first DECODE_CHUNK_LEN frames by 4
+    x = b.op(
+        "Slice",
+        [
+            "x",
+            b.const(np.array([0], dtype=np.int64)),
+            b.const(np.array([DECODE_CHUNK_LEN], dtype=np.int64)),
+            b.const(np.array([1], dtype=np.int64)),
+            b.const(np.array([4], dtype=np.int64)),
+        ],
+    )
+    x = b.op("MatMul", [x, b.weight([FEATURE_DIM, JOINER_DIM])])
+    b.op("Tanh", [x], "encoder_out")
+
+    states = zipformer2_states()
+    inputs = [helper.make_tensor_value_info("x", TensorProto.FLOAT, ["N", T, FEATURE_DIM])]
+    outputs = [
+        helper.make_tensor_value_info(
+            "encoder_out", TensorProto.FLOAT, ["N", DECODE_CHUNK_LEN // 4, JOINER_DIM]
+        )
+    ]
+    for name, elem_type, shape in states:
+        inputs.append(helper.make_tensor_value_info(name, elem_type, shape))
+        outputs.append(helper.make_tensor_value_info(f"new_{name}", elem_type, shape))
+        b.op("Identity", [name], f"new_{name}")
+
+    meta_data = {
+        "model_type": "zipformer2",
+        "version": "1",
+        "model_author": "sherpa-onnx-bench",
+        "comment": "tiny random model for benchmarking",
+        "encoder_dims": to_str(ENCODER_DIMS),
+        "query_head_dims": to_str(QUERY_HEAD_DIMS),
+        "value_head_dims": to_str(VALUE_HEAD_DIMS),
+        "num_heads": to_str(NUM_HEADS),
+        "num_encoder_layers": to_str(NUM_ENCODER_LAYERS),
+        "cnn_module_kernels": to_str(CNN_MODULE_KERNELS),
+        "left_context_len": to_str(LEFT_CONTEXT_LEN),
+        "T": T,
+        "decode_chunk_len": DECODE_CHUNK_LEN,
+    }
+    b.save(inputs, outputs, str(out_dir / "zipformer2-encoder.onnx"), meta_data)
+
+    # decoder
+    b = Builder(rng)
+    y = b.op("Gather", [b.weight([VOCAB_SIZE, JOINER_DIM]), "y"])
+    y = b.op("ReduceMean", [y], axes=[1], keepdims=0)
+    b.op("Relu", [y], "decoder_out")
+    b.save(
+        [helper.make_tensor_value_info("y", TensorProto.INT64, ["N", CONTEXT_SIZE])],
+        [helper.make_tensor_value_info("decoder_out", TensorProto.FLOAT, ["N", JOINER_DIM])],
+        str(out_dir / "zipformer2-decoder.onnx"),
+        {"vocab_size": VOCAB_SIZE, "context_size": CONTEXT_SIZE},
+    )
+
+    # joiner
+    b = Builder(rng)
+    x = b.op("Add", ["encoder_out", "decoder_out"])
+    x = b.op("Tanh", [x])
+    x = b.op("MatMul", [x, b.weight([JOINER_DIM, VOCAB_SIZE], scale=0.3)])
+
+    # Make blank the most likely output so that the decoder emits
+    # a token only now and then, like a real model
+    bias = np.zeros(VOCAB_SIZE, dtype=np.float32)
+    bias[0] = 14
+    b.op("Add", [x, b.const(bias)], "logit")
+    b.save(
+        [
+            helper.make_tensor_value_info("encoder_out", TensorProto.FLOAT, ["N", JOINER_DIM]),
+            helper.make_tensor_value_info("decoder_out", TensorProto.FLOAT, ["N", JOINER_DIM]),
+        ],
+        [helper.make_tensor_value_info("logit", TensorProto.FLOAT, ["N", VOCAB_SIZE])],
+        str(out_dir / "zipformer2-joiner.onnx"),
+        {"joiner_dim": JOINER_DIM},
+    )
+
+
+def generate_zipformer_ctc(rng, out_dir: Path):
+    b = Builder(rng)
+    x = b.op(
+        "Slice",
+        [
+            "x",
+            b.const(np.array([0], dtype=np.int64)),
+            b.const(np.array([2**31], dtype=np.int64)),
+            b.const(np.array([1], dtype=np.int64)),
+            b.const(np.array([4], dtype=np.int64)),
+        ],
+    )
+    x = b.op("MatMul", [x, b.weight([FEATURE_DIM, JOINER_DIM])])
+    x = b.op("Tanh", [x])
+    x = b.op("MatMul", [x, b.weight([JOINER_DIM, VOCAB_SIZE], scale=0.3)])
+
+    bias = np.zeros(VOCAB_SIZE, dtype=np.float32)
+    bias[0] = 14
+    x = b.op("Add", [x, b.const(bias)])
+    b.op("LogSoftmax", [x], "log_probs", axis=-1)
+
+    # ceil(x_lens / 4), which is the number of output frames of Slice above
+    x_lens = b.op("Add", ["x_lens", b.const(np.array(3, dtype=np.int64))])
+    b.op("Div", [x_lens, b.const(np.array(4, dtype=np.int64))], "log_probs_len")
+
+    b.save(
+        [
+            helper.make_tensor_value_info("x", TensorProto.FLOAT, ["N", "T", FEATURE_DIM]),
+            helper.make_tensor_value_info("x_lens", TensorProto.INT64, ["N"]),
+        ],
+        [
+            helper.make_tensor_value_info(
+                "log_probs", TensorProto.FLOAT, ["N", "T_out", VOCAB_SIZE]
+            ),
+            helper.make_tensor_value_info("log_probs_len", TensorProto.INT64, ["N"]),
+        ],
+        str(out_dir / "zipformer-ctc.onnx"),
+    )
+
+
+def generate_tokens(rng, out_dir: Path):
+    with open(out_dir / "tokens.txt", "w") as f:
+        f.write("<blk> 0\n<sos/eos> 1\n<unk> 2\n")
+        for i in range(3, VOCAB_SIZE):
+            f.write(f"t{i} {i}\n")
+
+    # 20 keywords, each of which contains 3 to 6 tokens
+    with open(out_dir / "keywords.txt", "w") as f:
+        for i in range(20):
+            n = rng.integers(3, 7)
+            tokens = rng.integers(3, VOCAB_SIZE, size=n)
+            f.write(" ".join(f"t{t}" for t in tokens) + f" @kw{i}\n")
+
+
+def generate_silero_vad(rng, out_dir: Path):
+    b = Builder(rng)
+
+    # The probability of speech depends only on the mean absolute value
+    # of the input samples
+    x = b.op("Abs", ["input"])
+    x = b.op("ReduceMean", [x], axes=[1], keepdims=1)
+    x = b.op("Mul", [x, b.const(np.array(50, dtype=np.float32))])
+    x = b.op("Sub", [x, b.const(np.array(2.5, dtype=np.float32))])
+    b.op("Sigmoid", [x], "output")
+
+    b.op("Tanh", [b.op("MatMul", ["h", b.weight([64, 64])])], "hn")
+    b.op("Tanh", [b.op("MatMul", ["c", b.weight([64, 64])])], "cn")
+
+    b.save(
+        [
+            helper.make_tensor_value_info("input", TensorProto.FLOAT, [1, "T"]),
+            helper.make_tensor_value_info("sr", TensorProto.INT64, [1]),
+            helper.make_tensor_value_info("h", TensorProto.FLOAT, [2, 1, 64]),
+            helper.make_tensor_value_info("c", TensorProto.FLOAT, [2, 1, 64]),
+        ],
+        [
+            helper.make_tensor_value_info("output", TensorProto.FLOAT, [1, 1]),
+            helper.make_tensor_value_info("hn", TensorProto.FLOAT, [2, 1, 64]),
+            helper.make_tensor_value_info("cn", TensorProto.FLOAT, [2, 1, 64]),
+        ],
+        str(out_dir / "silero-vad.onnx"),
+    )
+
+
+def generate_vits(rng, out_dir: Path):
+    letters = [chr(ord("a") + i) for i in range(26)]
+    punctuations = [",", ".", "!", "?", ";", ":"]
+
+    # 0 is the blank inserted between tokens and 1 is the space
+    tokens = ["_", " "] + letters + punctuations
+
+    with open(out_dir / "vits-tokens.txt", "w") as f:
+        for i, t in enumerate(tokens):
+            f.write(f"{t} {i}\n" if t != " " else f" {i}\n")
+
+    with open(out_dir / "vits-lexicon.txt", "w") as f:
+        for w in sorted(set(WORDS)):
+            f.write(f"{w} {' '.join(w)}\n")
+
+    # Each token produces hop_size samples
+    hop_size = 256
+    b = Builder(rng)
+    x = b.op("Gather", [b.weight([len(tokens), hop_size], scale=1.0), "x"])
+    x = b.op("Tanh", [x])
+    b.op("Reshape", [x, b.const(np.array([1, 1, -1], dtype=np.int64))], "y")
+
+    b.save(
+        [
+            helper.make_tensor_value_info("x", TensorProto.INT64, [1, "L"]),
+            helper.make_tensor_value_info("x_length", TensorProto.INT64, [1]),
+            helper.make_tensor_value_info("noise_scale", TensorProto.FLOAT, [1]),
+            helper.make_tensor_value_info("length_scale", TensorProto.FLOAT, [1]),
+            helper.make_tensor_value_info("noise_scale_w", TensorProto.FLOAT, [1]),
+        ],
+        [helper.make_tensor_value_info("y", TensorProto.FLOAT, [1, 1, "S"])],
+        str(out_dir / "vits.onnx"),
+        {
+            "model_type": "vits",
+            "comment": "tiny random model for benchmarking",
+            "language": "English",
+            "add_blank": 1,
+            "n_speakers": 0,
+            "sample_rate": 16000,
+            "punctuation": " ".join(punctuations),
+        },
+    )
+
+
+def main():
+    args = get_args()
+    out_dir = Path(args.out_dir)
+    out_dir.mkdir(parents=True, exist_ok=True)
+
+    rng = np.random.default_rng(args.seed)
+
+    generate_zipformer2(rng, out_dir)
+    generate_zipformer_ctc(rng, out_dir)
+    generate_tokens(rng, out_dir)
+    generate_silero_vad(rng, out_dir)
+    generate_vits(rng, out_dir)
+
+    print(f"Saved to {out_dir}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,34 @@
+# Copyright (c)  2024  Xiaomi Corporation
+#
+# Write the git sha of the source tree to a header for sherpa-onnx-bench.
+#
+# It is run at build time by sherpa-onnx/csrc/CMakeLists.txt, so the sha
+# is the one of the tree being built, not of the tree that was configured.
+#
+# Usage:
+#   cmake -DSOURCE_DIR=/path/to/sherpa-onnx -DOUTPUT=/path/to/git-sha.h \
+#     [-DGIT_EXECUTABLE=/path/to/git] -P git-sha.cmake
+
+set(git_sha "")
+if(GIT_EXECUTABLE)
+  execute_process(
+    COMMAND ${GIT_EXECUTABLE} rev-parse --short HEAD
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE git_sha
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    ERROR_QUIET
+  )
+endif()
+
+set(content "#define SHERPA_ONNX_BENCH_GIT_SHA \"${git_sha}\"\n")
+
+# Rewrite the file only if the sha has changed so that sherpa-onnx-bench
+# is not recompiled on every build
+set(old_content "")
+if(EXISTS ${OUTPUT})
+  file(READ ${OUTPUT} old_content)
+endif()
+
+if(NOT old_content STREQUAL content)
+  file(WRITE ${OUTPUT} "${content}")
+endif()
@@ -15,6 +15,7 @@
 #include "sherpa-onnx/csrc/display.h"
 #include "sherpa-onnx/csrc/keyword-spotter.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/metrics.h"
 #include "sherpa-onnx/csrc/offline-punctuation.h"
 #include "sherpa-onnx/csrc/offline-recognizer.h"
 #include "sherpa-onnx/csrc/online-recognizer.h"
@@ -150,6 +151,24 @@ void AcceptWaveform(const SherpaOnnxOnlineStream *stream, int32_t sample_rate,
   stream->impl->AcceptWaveform(sample_rate, samples, n);
 }
 
+void AcceptWaveformInt16(const SherpaOnnxOnlineStream *stream,
+                         int32_t sample_rate, const int16_t *samples,
+                         int32_t n) {
+  stream->impl->AcceptWaveform(sample_rate, samples, n);
+}
+
+void AcceptWaveformMuLaw(const SherpaOnnxOnlineStream *stream,
+                         int32_t sample_rate, const uint8_t *samples,
+                         int32_t n) {
+  stream->impl->AcceptWaveformMuLaw(sample_rate, samples, n);
+}
+
+void AcceptWaveformALaw(const SherpaOnnxOnlineStream *stream,
+                        int32_t sample_rate, const uint8_t *samples,
+                        int32_t n) {
+  stream->impl->AcceptWaveformALaw(sample_rate, samples, n);
+}
+
 int32_t IsOnlineStreamReady(const SherpaOnnxOnlineRecognizer *recognizer,
                             const SherpaOnnxOnlineStream *stream) {
   return recognizer->impl->IsReady(stream->impl.get());
@@ -415,6 +434,24 @@ void AcceptWaveformOffline(const SherpaOnnxOfflineStream *stream,
   stream->impl->AcceptWaveform(sample_rate, samples, n);
 }
 
+void AcceptWaveformOfflineInt16(const SherpaOnnxOfflineStream *stream,
+                                int32_t sample_rate, const int16_t *samples,
+                                int32_t n) {
+  stream->impl->AcceptWaveform(sample_rate, samples, n);
+}
+
+void AcceptWaveformOfflineMuLaw(const SherpaOnnxOfflineStream *stream,
+                                int32_t sample_rate, const uint8_t *samples,
+                                int32_t n) {
+  stream->impl->AcceptWaveformMuLaw(sample_rate, samples, n);
+}
+
+void AcceptWaveformOfflineALaw(const SherpaOnnxOfflineStream *stream,
+                               int32_t sample_rate, const uint8_t *samples,
+                               int32_t n) {
+  stream->impl->AcceptWaveformALaw(sample_rate, samples, n);
+}
+
 void DecodeOfflineStream(const SherpaOnnxOfflineRecognizer *recognizer,
                          const SherpaOnnxOfflineStream *stream) {
   recognizer->impl->DecodeStream(stream->impl.get());
@@ -1372,3 +1409,21 @@ const char *SherpaOfflinePunctuationAddPunct(
 }
 
 void SherpaOfflinePunctuationFreeText(const char *text) { delete[] text; }
+
+void SherpaOnnxEnableMetrics(int32_t enabled) {
+  sherpa_onnx::EnableMetrics(enabled != 0);
+}
+
+const char *SherpaOnnxGetMetrics() {
+  std::string metrics = sherpa_onnx::MetricsToPrometheusText();
+
+  char *ans = new char[metrics.size() + 1];
+  std::copy(metrics.begin(), metrics.end(), ans);
+  ans[metrics.size()] = 0;
+
+  return ans;
+}
+
+void SherpaOnnxFreeMetrics(const char *metrics) { delete[] metrics; }
+
+void SherpaOnnxResetMetrics() { sherpa_onnx::ResetMetrics(); }
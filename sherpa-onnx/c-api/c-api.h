@@ -232,6 +232,24 @@ SHERPA_ONNX_API void AcceptWaveform(const SherpaOnnxOnlineStream *stream,
                                     int32_t sample_rate, const float *samples,
                                     int32_t n);
 
+/// Same as AcceptWaveform() but the input samples are 16-bit linear PCM.
+/// The samples are converted to float inside sherpa-onnx.
+SHERPA_ONNX_API void AcceptWaveformInt16(const SherpaOnnxOnlineStream *stream,
+                                         int32_t sample_rate,
+                                         const int16_t *samples, int32_t n);
+
+/// Same as AcceptWaveform() but the input samples are encoded with
+/// G.711 mu-law.
+SHERPA_ONNX_API void AcceptWaveformMuLaw(const SherpaOnnxOnlineStream *stream,
+                                         int32_t sample_rate,
+                                         const uint8_t *samples, int32_t n);
+
+/// Same as AcceptWaveform() but the input samples are encoded with
+/// G.711 A-law.
+SHERPA_ONNX_API void AcceptWaveformALaw(const SherpaOnnxOnlineStream *stream,
+                                        int32_t sample_rate,
+                                        const uint8_t *samples, int32_t n);
+
 /// Return 1 if there are enough number of feature frames for decoding.
 /// Return 0 otherwise.
 ///
@@ -447,6 +465,25 @@ SHERPA_ONNX_API void DestroyOfflineStream(
 SHERPA_ONNX_API void AcceptWaveformOffline(
     const SherpaOnnxOfflineStream *stream, int32_t sample_rate,
     const float *samples, int32_t n);
+
+/// Same as AcceptWaveformOffline() but the input samples are 16-bit
+/// linear PCM.
+SHERPA_ONNX_API void AcceptWaveformOfflineInt16(
+    const SherpaOnnxOfflineStream *stream, int32_t sample_rate,
+    const int16_t *samples, int32_t n);
+
+/// Same as AcceptWaveformOffline() but the input samples are encoded with
+/// G.711 mu-law.
+SHERPA_ONNX_API void AcceptWaveformOfflineMuLaw(
+    const SherpaOnnxOfflineStream *stream, int32_t sample_rate,
+    const uint8_t *samples, int32_t n);
+
+/// Same as AcceptWaveformOffline() but the input samples are encoded with
+/// G.711 A-law.
+SHERPA_ONNX_API void AcceptWaveformOfflineALaw(
+    const SherpaOnnxOfflineStream *stream, int32_t sample_rate,
+    const uint8_t *samples, int32_t n);
+
 /// Decode an offline stream.
 ///
 /// We assume you have invoked AcceptWaveformOffline() for the given stream
@@ -1204,6 +1241,24 @@ SHERPA_ONNX_API const char *SherpaOfflinePunctuationAddPunct(
 
 SHERPA_ONNX_API void SherpaOfflinePunctuationFreeText(const char *text);
 
+// ============================================================
+// For metrics
+// ============================================================
+
+// Enable (non-zero) or disable (0) collecting per-stage latency and
+// throughput metrics. It is disabled by default.
+SHERPA_ONNX_API void SherpaOnnxEnableMetrics(int32_t enabled);
+
+// Return all metrics in the Prometheus text exposition format.
+// The user has to invoke SherpaOnnxFreeMetrics()
+// to free the returned pointer to avoid memory leak
+SHERPA_ONNX_API const char *SherpaOnnxGetMetrics();
+
+SHERPA_ONNX_API void SherpaOnnxFreeMetrics(const char *metrics);
+
+// Set all metrics to 0
+SHERPA_ONNX_API void SherpaOnnxResetMetrics();
+
 #if defined(__GNUC__)
 #pragma GCC diagnostic pop
 #endif
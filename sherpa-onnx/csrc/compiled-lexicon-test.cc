@@ -0,0 +1,92 @@
+// sherpa-onnx/csrc/compiled-lexicon-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/compiled-lexicon.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+static std::unordered_map<std::string, std::vector<int32_t>> GetWord2Ids() {
+  return {
+      {"hello", {1, 2, 3}},
+      {"hell", {1, 2}},
+      {"world", {4, 5, 6, 7}},
+      {"你好", {8, 9}},
+      {"a", {10}},
+      {"z", {}},
+  };
+}
+
+static void CheckLexicon(
+    const CompiledLexicon &lexicon,
+    const std::unordered_map<std::string, std::vector<int32_t>> &word2ids) {
+  EXPECT_EQ(lexicon.NumWords(), static_cast<int32_t>(word2ids.size()));
+
+  for (const auto &p : word2ids) {
+    int32_t n = -1;
+    const int32_t *ids = lexicon.Lookup(p.first, &n);
+    ASSERT_NE(ids, nullptr) << p.first;
+    EXPECT_EQ(std::vector<int32_t>(ids, ids + n), p.second) << p.first;
+  }
+
+  for (const char *w : {"", "he", "helloo", "b", "你", "zz"}) {
+    int32_t n = -1;
+    EXPECT_EQ(lexicon.Lookup(w, &n), nullptr) << w;
+    EXPECT_EQ(n, 0);
+    EXPECT_FALSE(lexicon.Contains(w));
+  }
+}
+
+TEST(CompiledLexicon, FromBuffer) {
+  auto word2ids = GetWord2Ids();
+
+  std::ostringstream os;
+  CompiledLexicon::Write(word2ids, os);
+  std::string s = os.str();
+
+  EXPECT_TRUE(CompiledLexicon::IsCompiledLexicon(s.data(), s.size()));
+  EXPECT_FALSE(CompiledLexicon::IsCompiledLexicon("hello 1 2 3\n", 12));
+
+  CompiledLexicon lexicon(std::vector<char>(s.begin(), s.end()));
+  CheckLexicon(lexicon, word2ids);
+}
+
+TEST(CompiledLexicon, FromFile) {
+  auto word2ids = GetWord2Ids();
+
+  std::string filename = "compiled-lexicon-test.bin";
+  {
+    std::ofstream os(filename, std::ios::binary);
+    CompiledLexicon::Write(word2ids, os);
+  }
+
+  EXPECT_TRUE(CompiledLexicon::IsCompiledLexicon(filename));
+
+  {
+    CompiledLexicon lexicon(filename);
+    CheckLexicon(lexicon, word2ids);
+  }
+
+  std::remove(filename.c_str());
+}
+
+TEST(CompiledLexicon, Empty) {
+  std::ostringstream os;
+  CompiledLexicon::Write({}, os);
+  std::string s = os.str();
+
+  CompiledLexicon lexicon(std::vector<char>(s.begin(), s.end()));
+  EXPECT_EQ(lexicon.NumWords(), 0);
+  EXPECT_FALSE(lexicon.Contains("a"));
+}
+
+}  // namespace sherpa_onnx
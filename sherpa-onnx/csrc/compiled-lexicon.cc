@@ -0,0 +1,292 @@
+// sherpa-onnx/csrc/compiled-lexicon.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/compiled-lexicon.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+namespace {
+
+constexpr char kMagic[4] = {'S', 'O', 'L', 'X'};
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_words;
+  uint32_t num_ids;
+  uint32_t strings_size;
+  uint32_t reserved[3];
+};
+
+static_assert(sizeof(Header) == 32, "");
+
+bool IsLittleEndian() {
+  uint32_t x = 1;
+  char c;
+  std::memcpy(&c, &x, 1);
+  return c == 1;
+}
+
+// Convert between little-endian and the host byte order. It is a no-op on
+// little-endian hosts.
+uint32_t ToLittleEndian(uint32_t x) {
+  if (IsLittleEndian()) {
+    return x;
+  }
+
+  return ((x & 0xff) << 24) | ((x & 0xff00) << 8) | ((x >> 8) & 0xff00) |
+         (x >> 24);
+}
+
+void ToLittleEndian(Header *h) {
+  h->version = ToLittleEndian(h->version);
+  h->num_words = ToLittleEndian(h->num_words);
+  h->num_ids = ToLittleEndian(h->num_ids);
+  h->strings_size = ToLittleEndian(h->strings_size);
+}
+
+// p may be unaligned
+void ToLittleEndian(char *p, size_t num_integers) {
+  for (size_t i = 0; i != num_integers; ++i, p += sizeof(uint32_t)) {
+    uint32_t x;
+    std::memcpy(&x, p, sizeof(x));
+    x = ToLittleEndian(x);
+    std::memcpy(p, &x, sizeof(x));
+  }
+}
+
+template <typename T>
+void WriteLittleEndian(std::vector<T> v, std::ostream &os) {
+  static_assert(sizeof(T) == sizeof(uint32_t), "");
+  ToLittleEndian(reinterpret_cast<char *>(v.data()), v.size());
+  os.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+}
+
+}  // namespace
+
+CompiledLexicon::CompiledLexicon(const std::string &filename) {
+#if !defined(_WIN32)
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    SHERPA_ONNX_LOGE("Failed to open %s", filename.c_str());
+    exit(-1);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p != MAP_FAILED) {
+      mapped_ = p;
+      mapped_size_ = st.st_size;
+    }
+  }
+  close(fd);
+
+  if (mapped_) {
+    Init(static_cast<const char *>(mapped_), mapped_size_);
+    return;
+  }
+#endif
+
+  // Fall back to reading the whole file
+  std::ifstream is(filename, std::ios::binary);
+  if (!is) {
+    SHERPA_ONNX_LOGE("Failed to open %s", filename.c_str());
+    exit(-1);
+  }
+
+  buf_.assign(std::istreambuf_iterator<char>(is),
+              std::istreambuf_iterator<char>());
+  Init(buf_.data(), buf_.size());
+}
+
+CompiledLexicon::CompiledLexicon(std::vector<char> buf)
+    : buf_(std::move(buf)) {
+  Init(buf_.data(), buf_.size());
+}
+
+CompiledLexicon::~CompiledLexicon() {
+#if !defined(_WIN32)
+  if (mapped_) {
+    munmap(mapped_, mapped_size_);
+  }
+#endif
+}
+
+void CompiledLexicon::Init(const char *data, size_t size) {
+  if (!IsCompiledLexicon(data, size)) {
+    SHERPA_ONNX_LOGE("Not a compiled lexicon");
+    exit(-1);
+  }
+
+  Header h;
+  std::memcpy(&h, data, sizeof(h));
+  ToLittleEndian(&h);
+  if (h.version != kVersion) {
+    SHERPA_ONNX_LOGE("Unsupported compiled lexicon version %u. Expected: %u",
+                     h.version, kVersion);
+    exit(-1);
+  }
+
+  size_t expected_size = sizeof(Header) +
+                         2 * (static_cast<size_t>(h.num_words) + 1) * 4 +
+                         static_cast<size_t>(h.num_ids) * 4 + h.strings_size;
+  if (size != expected_size) {
+    SHERPA_ONNX_LOGE(
+        "Corrupted compiled lexicon. Expected size: %zu. Actual size: %zu",
+        expected_size, size);
+    exit(-1);
+  }
+
+  if (!IsLittleEndian()) {
+    // The file is little-endian. Convert it to the host byte order in
+    // memory; a mapped file cannot be used as it is.
+    if (data != buf_.data()) {
+      buf_.assign(data, data + size);
+#if !defined(_WIN32)
+      if (mapped_) {
+        munmap(mapped_, mapped_size_);
+        mapped_ = nullptr;
+      }
+#endif
+    }
+    data = buf_.data();
+
+    ToLittleEndian(buf_.data() + sizeof(Header),
+                   (size - sizeof(Header) - h.strings_size) / 4);
+  }
+
+  num_words_ = h.num_words;
+
+  const char *p = data + sizeof(Header);
+  word_offsets_ = reinterpret_cast<const uint32_t *>(p);
+  p += (h.num_words + 1) * sizeof(uint32_t);
+
+  id_offsets_ = reinterpret_cast<const uint32_t *>(p);
+  p += (h.num_words + 1) * sizeof(uint32_t);
+
+  ids_ = reinterpret_cast<const int32_t *>(p);
+  p += h.num_ids * sizeof(int32_t);
+
+  strings_ = p;
+
+  if (word_offsets_[num_words_] != h.strings_size ||
+      id_offsets_[num_words_] != h.num_ids) {
+    SHERPA_ONNX_LOGE("Corrupted compiled lexicon");
+    exit(-1);
+  }
+}
+
+const int32_t *CompiledLexicon::Lookup(const std::string &word,
+                                       int32_t *num_ids) const {
+  // Binary search for the word in byte order
+  int32_t lo = 0;
+  int32_t hi = num_words_;
+  while (lo < hi) {
+    int32_t mid = lo + (hi - lo) / 2;
+
+    const char *s = strings_ + word_offsets_[mid];
+    size_t n = word_offsets_[mid + 1] - word_offsets_[mid];
+
+    int32_t c = std::memcmp(s, word.data(), std::min(n, word.size()));
+    if (c == 0) {
+      c = (n < word.size()) ? -1 : (n > word.size() ? 1 : 0);
+    }
+
+    if (c == 0) {
+      *num_ids = id_offsets_[mid + 1] - id_offsets_[mid];
+      return ids_ + id_offsets_[mid];
+    }
+
+    if (c < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  *num_ids = 0;
+  return nullptr;
+}
+
+bool CompiledLexicon::IsCompiledLexicon(const char *data, size_t size) {
+  return size >= sizeof(Header) &&
+         std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool CompiledLexicon::IsCompiledLexicon(const std::string &filename) {
+  std::ifstream is(filename, std::ios::binary);
+  char buf[sizeof(Header)];
+  if (!is.read(buf, sizeof(buf))) {
+    return false;
+  }
+
+  return IsCompiledLexicon(buf, sizeof(buf));
+}
+
+void CompiledLexicon::Write(
+    const std::unordered_map<std::string, std::vector<int32_t>> &word2ids,
+    std::ostream &os) {
+  std::vector<const std::string *> words;
+  words.reserve(word2ids.size());
+  for (const auto &p : word2ids) {
+    words.push_back(&p.first);
+  }
+
+  // std::string compares characters as unsigned char, which is the same
+  // as memcmp() in Lookup()
+  std::sort(words.begin(), words.end(),
+            [](const std::string *a, const std::string *b) { return *a < *b; });
+
+  std::vector<uint32_t> word_offsets;
+  std::vector<uint32_t> id_offsets;
+  std::vector<int32_t> ids;
+  std::string strings;
+
+  word_offsets.reserve(words.size() + 1);
+  id_offsets.reserve(words.size() + 1);
+
+  for (const auto *w : words) {
+    word_offsets.push_back(strings.size());
+    id_offsets.push_back(ids.size());
+
+    strings.append(*w);
+
+    const auto &v = word2ids.at(*w);
+    ids.insert(ids.end(), v.begin(), v.end());
+  }
+  word_offsets.push_back(strings.size());
+  id_offsets.push_back(ids.size());
+
+  Header h = {};
+  std::memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kVersion;
+  h.num_words = words.size();
+  h.num_ids = ids.size();
+  h.strings_size = strings.size();
+  ToLittleEndian(&h);
+
+  os.write(reinterpret_cast<const char *>(&h), sizeof(h));
+  WriteLittleEndian(std::move(word_offsets), os);
+  WriteLittleEndian(std::move(id_offsets), os);
+  WriteLittleEndian(std::move(ids), os);
+  os.write(strings.data(), strings.size());
+}
+
+}  // namespace sherpa_onnx
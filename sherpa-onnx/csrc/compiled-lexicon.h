@@ -0,0 +1,108 @@
+// sherpa-onnx/csrc/compiled-lexicon.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_COMPILED_LEXICON_H_
+#define SHERPA_ONNX_CSRC_COMPILED_LEXICON_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sherpa_onnx {
+
+/** A read-only lexicon in a binary format that can be used without parsing.
+ *
+ * It maps a word to a list of token IDs. A text lexicon is converted to
+ * this format offline with Write() (see sherpa-onnx-compile-lexicon). Since
+ * token IDs are saved, the file has to be used with the same tokens.txt.
+ *
+ * The file is memory-mapped when possible, so loading it takes constant
+ * time and its pages are shared by all processes using the same file.
+ *
+ * File layout. All integers are little-endian. On big-endian hosts the
+ * file is converted in memory at load time instead of being mapped.
+ *
+ *   Header (32 bytes)
+ *     char magic[4] = "SOLX"
+ *     uint32_t version = 1
+ *     uint32_t num_words
+ *     uint32_t num_ids
+ *     uint32_t strings_size
+ *     uint32_t reserved[3]
+ *   uint32_t word_offsets[num_words + 1]  // into strings
+ *   uint32_t id_offsets[num_words + 1]    // into ids
+ *   int32_t ids[num_ids]
+ *   char strings[strings_size]
+ *
+ * Words are sorted in byte order. Word i is
+ * strings[word_offsets[i], word_offsets[i+1]) and its token IDs are
+ * ids[id_offsets[i], id_offsets[i+1]).
+ */
+class CompiledLexicon {
+ public:
+  // Load a compiled lexicon from a file. It aborts if the file is invalid.
+  explicit CompiledLexicon(const std::string &filename);
+
+  // Use a compiled lexicon that is already in memory, e.g., from
+  // the asset manager on Android
+  explicit CompiledLexicon(std::vector<char> buf);
+
+  ~CompiledLexicon();
+
+  CompiledLexicon(const CompiledLexicon &) = delete;
+  CompiledLexicon &operator=(const CompiledLexicon &) = delete;
+
+  /** Look up a word. It does not allocate memory.
+   *
+   * @param word The word to look up.
+   * @param num_ids On return, it contains the number of token IDs of
+   *                the word.
+   * @return Pointer to the token IDs of the word, or nullptr if the word
+   *         is not in the lexicon. It is valid as long as this object is
+   *         alive.
+   */
+  const int32_t *Lookup(const std::string &word, int32_t *num_ids) const;
+
+  bool Contains(const std::string &word) const {
+    int32_t num_ids;
+    return Lookup(word, &num_ids) != nullptr;
+  }
+
+  int32_t NumWords() const { return num_words_; }
+
+  // Return true if the first bytes of data look like a compiled lexicon
+  static bool IsCompiledLexicon(const char *data, size_t size);
+
+  // Return true if the file exists and it is a compiled lexicon
+  static bool IsCompiledLexicon(const std::string &filename);
+
+  // Save a lexicon in the binary format
+  static void Write(
+      const std::unordered_map<std::string, std::vector<int32_t>> &word2ids,
+      std::ostream &os);
+
+ private:
+  void Init(const char *data, size_t size);
+
+ private:
+  // Set if the file is memory-mapped
+  void *mapped_ = nullptr;
+  size_t mapped_size_ = 0;
+
+  // Used if the file cannot be memory-mapped
+  std::vector<char> buf_;
+
+  int32_t num_words_ = 0;
+  const uint32_t *word_offsets_ = nullptr;
+  const uint32_t *id_offsets_ = nullptr;
+  const int32_t *ids_ = nullptr;
+  const char *strings_ = nullptr;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_COMPILED_LEXICON_H_
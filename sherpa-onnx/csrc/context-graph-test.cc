@@ -7,6 +7,7 @@
 #include <chrono>  // NOLINT
 #include <cmath>
 #include <map>
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
@@ -74,6 +75,104 @@ TEST(ContextGraph, TestCustomizeNonStrict) {
   TestHelper(queries, 5, false);
 }
 
+static float Score(const ContextGraph &graph, const std::string &query) {
+  float total_scores = 0;
+  auto state = graph.Root();
+  auto base_state = graph.BaseRoot();
+  for (auto q : query) {
+    auto res = graph.ForwardOneStep(state, &base_state, q);
+    total_scores += std::get<0>(res);
+    state = std::get<1>(res);
+  }
+  total_scores += graph.Finalize(state, &base_state).first;
+  return total_scores;
+}
+
+static std::vector<std::vector<int32_t>> ToIds(
+    const std::vector<std::string> &contexts_str) {
+  std::vector<std::vector<int32_t>> contexts;
+  for (const auto &s : contexts_str) {
+    contexts.emplace_back(s.begin(), s.end());
+  }
+  return contexts;
+}
+
+TEST(ContextGraph, TestOverlay) {
+  // Use disjoint alphabets for the two layers so that the layered graph
+  // must give the same scores as a single graph containing all phrases.
+  std::vector<std::string> base_str({"AB", "ABC", "BCD", "CA"});
+  std::vector<std::string> overlay_str({"XY", "XYZ", "YZ", "ZXY"});
+
+  std::vector<std::string> all_str = base_str;
+  all_str.insert(all_str.end(), overlay_str.begin(), overlay_str.end());
+
+  auto base = std::make_shared<ContextGraph>(ToIds(base_str), 1);
+  ContextGraph overlay(base, ToIds(overlay_str), 1);
+  ContextGraph merged(ToIds(all_str), 1);
+
+  for (const auto &q : {"ABCXYZ", "XYABCD", "AXBYCZ", "ZXYCAB", "QQ"}) {
+    EXPECT_EQ(Score(overlay, q), Score(merged, q)) << q;
+  }
+
+  // Phrases already in the base graph must not be boosted twice.
+  ContextGraph duplicated(base, ToIds({"ABC", "BCD"}), 1);
+  ContextGraph empty_overlay(base, {}, 1);
+  for (const auto &q : {"ABCD", "XABCY", "CAB"}) {
+    EXPECT_EQ(Score(duplicated, q), Score(empty_overlay, q)) << q;
+    EXPECT_EQ(Score(duplicated, q), Score(*base, q)) << q;
+  }
+}
+
+// Scores of each step of query, including Finalize() as the last one
+static std::vector<float> StepScores(const ContextGraph &graph,
+                                     const std::string &query,
+                                     bool strict_mode) {
+  std::vector<float> ans;
+  auto state = graph.Root();
+  auto base_state = graph.BaseRoot();
+  for (auto q : query) {
+    auto res = graph.ForwardOneStep(state, &base_state, q, strict_mode);
+    ans.push_back(std::get<0>(res));
+    state = std::get<1>(res);
+  }
+  ans.push_back(graph.Finalize(state, &base_state).first);
+  return ans;
+}
+
+TEST(ContextGraph, TestOverlaySharedPrefix) {
+  // Phrases of the two layers share prefixes and suffixes. A prefix matched
+  // by both layers must be boosted only once, and so must the backoff when
+  // the query diverges from it.
+  std::vector<std::string> base_str({"ABCD", "BC", "XYZ"});
+  std::vector<std::string> overlay_str({"ABXY", "AB", "CDE"});
+
+  std::vector<std::string> all_str = base_str;
+  all_str.insert(all_str.end(), overlay_str.begin(), overlay_str.end());
+
+  auto base = std::make_shared<ContextGraph>(ToIds(base_str), 1);
+  ContextGraph overlay(base, ToIds(overlay_str), 1);
+  ContextGraph merged(ToIds(all_str), 1);
+
+  for (bool strict_mode : {true, false}) {
+    for (const auto &q :
+         {"ABCD", "ABXY", "ABXYZ", "ABQ", "ABCDE", "AABXBCD", "XABCQ"}) {
+      auto expected = StepScores(merged, q, strict_mode);
+      auto actual = StepScores(overlay, q, strict_mode);
+      ASSERT_EQ(actual.size(), expected.size());
+      for (int32_t i = 0; i != static_cast<int32_t>(actual.size()); ++i) {
+        EXPECT_NEAR(actual[i], expected[i], 1e-5)
+            << q << ", step " << i << ", strict mode " << strict_mode;
+      }
+    }
+  }
+
+  // The example of global "ABCD" and per-stream "ABXY"
+  auto abcd = std::make_shared<ContextGraph>(ToIds({"ABCD"}), 1);
+  ContextGraph abxy(abcd, ToIds({"ABXY"}), 1);
+  EXPECT_EQ(StepScores(abxy, "ABXY", true),
+            (std::vector<float>{1, 1, 1, 5, -4}));
+}
+
 TEST(ContextGraph, Benchmark) {
   std::random_device rd;
   std::mt19937 mt(rd());
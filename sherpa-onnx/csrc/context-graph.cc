@@ -14,6 +14,59 @@
 #include "sherpa-onnx/csrc/macros.h"
 
 namespace sherpa_onnx {
+
+// Return true if token_ids is a complete phrase in the graph rooted at root.
+static bool ContainsPhrase(const ContextState *root,
+                           const std::vector<int32_t> &token_ids) {
+  const ContextState *node = root;
+  for (auto token : token_ids) {
+    auto it = node->next.find(token);
+    if (it == node->next.end()) {
+      return false;
+    }
+    node = it->second.get();
+  }
+  return node != root && node->is_end;
+}
+
+ContextGraph::ContextGraph(ContextGraphPtr base,
+                           const std::vector<std::vector<int32_t>> &token_ids,
+                           float context_score,
+                           const std::vector<float> &scores /*= {}*/,
+                           const std::vector<std::string> &phrases /*= {}*/)
+    : context_score_(context_score),
+      ac_threshold_(0.0f),
+      base_(std::move(base)) {
+  root_ = std::make_unique<ContextState>(-1, 0, 0, 0);
+  root_->fail = root_.get();
+
+  if (base_ == nullptr) {
+    Build(token_ids, scores, phrases, {});
+    return;
+  }
+
+  std::vector<std::vector<int32_t>> new_token_ids;
+  std::vector<float> new_scores;
+  std::vector<std::string> new_phrases;
+  new_token_ids.reserve(token_ids.size());
+
+  for (int32_t i = 0; i != static_cast<int32_t>(token_ids.size()); ++i) {
+    if (ContainsPhrase(base_->Root(), token_ids[i])) {
+      continue;
+    }
+
+    new_token_ids.push_back(token_ids[i]);
+    if (!scores.empty()) {
+      new_scores.push_back(scores[i]);
+    }
+    if (!phrases.empty()) {
+      new_phrases.push_back(phrases[i]);
+    }
+  }
+
+  Build(new_token_ids, new_scores, new_phrases, {});
+}
+
 void ContextGraph::Build(const std::vector<std::vector<int32_t>> &token_ids,
                          const std::vector<float> &scores,
                          const std::vector<std::string> &phrases,
@@ -101,12 +154,78 @@ ContextGraph::ForwardOneStep(const ContextState *state, int32_t token,
   return std::make_tuple(score + node->output_score, node, matched_node);
 }
 
+std::tuple<float, const ContextState *, const ContextState *>
+ContextGraph::ForwardOneStep(const ContextState *state,
+                             const ContextState **base_state, int32_t token,
+                             bool strict_mode /*= true*/) const {
+  auto res = ForwardOneStep(state, token, strict_mode);
+  if (base_ == nullptr || base_state == nullptr) {
+    return res;
+  }
+
+  if (*base_state == nullptr) {
+    *base_state = base_->Root();
+  }
+
+  const ContextState *prev_base_state = *base_state;
+  auto base_res = base_->ForwardOneStep(*base_state, token, strict_mode);
+  *base_state = std::get<1>(base_res);
+
+  // The score of a layer is the change of the node score of its state
+  // plus the bonus of the phrases it matches. A prefix shared by both
+  // layers must be boosted only once, as in a single graph containing the
+  // phrases of both layers, so the node scores of the two layers are
+  // combined by max, not by sum. Bonuses of matched phrases are added.
+  float bonus = std::get<0>(res) -
+                (std::get<1>(res)->node_score - state->node_score);
+  float base_bonus = std::get<0>(base_res) - ((*base_state)->node_score -
+                                              prev_base_state->node_score);
+
+  // In the non-strict mode, a single graph goes back to the root after a
+  // match, so both layers do.
+  bool matched = std::get<1>(res) == root_.get() && std::get<2>(res);
+  bool base_matched =
+      std::get<1>(base_res) == base_->Root() && std::get<2>(base_res);
+  if (!strict_mode && (matched || base_matched)) {
+    std::get<1>(res) = root_.get();
+    *base_state = base_->Root();
+  }
+
+  float prev_node_score =
+      std::max(state->node_score, prev_base_state->node_score);
+  float node_score =
+      std::max(std::get<1>(res)->node_score, (*base_state)->node_score);
+
+  std::get<0>(res) = node_score - prev_node_score + bonus + base_bonus;
+  if (std::get<2>(res) == nullptr) {
+    std::get<2>(res) = std::get<2>(base_res);
+  }
+
+  return res;
+}
+
 std::pair<float, const ContextState *> ContextGraph::Finalize(
     const ContextState *state) const {
   float score = -state->node_score;
   return std::make_pair(score, root_.get());
 }
 
+std::pair<float, const ContextState *> ContextGraph::Finalize(
+    const ContextState *state, const ContextState **base_state) const {
+  auto res = Finalize(state);
+  if (base_ == nullptr || base_state == nullptr) {
+    return res;
+  }
+
+  // See ForwardOneStep() for why max is used
+  if (*base_state != nullptr) {
+    res.first = -std::max(state->node_score, (*base_state)->node_score);
+  }
+  *base_state = base_->Root();
+
+  return res;
+}
+
 std::pair<bool, const ContextState *> ContextGraph::IsMatched(
     const ContextState *state) const {
   bool status = false;
@@ -66,22 +66,55 @@ class ContextGraph {
       : ContextGraph(token_ids, context_score, 0.0f, scores, phrases,
                      std::vector<float>()) {}
 
+  /** Create an overlay graph on top of a shared, immutable base graph.
+   *
+   * Only `token_ids` are inserted into the overlay, so the cost is
+   * proportional to the size of the overlay, not to the size of `base`.
+   * Phrases that already exist in `base` are skipped so that they are not
+   * boosted twice. Use the ForwardOneStep() and Finalize() overloads taking
+   * a base state to score both layers.
+   */
+  ContextGraph(ContextGraphPtr base,
+               const std::vector<std::vector<int32_t>> &token_ids,
+               float context_score, const std::vector<float> &scores = {},
+               const std::vector<std::string> &phrases = {});
+
   std::tuple<float, const ContextState *, const ContextState *> ForwardOneStep(
       const ContextState *state, int32_t token_id,
       bool strict_mode = true) const;
 
+  /* Like the above one, but it also advances `*base_state` in the base
+   * graph if this graph is an overlay. A prefix matched by both layers is
+   * boosted only once, as if a single graph contained the phrases of both
+   * layers. `base_state` is not touched if this graph has no base graph.
+   */
+  std::tuple<float, const ContextState *, const ContextState *> ForwardOneStep(
+      const ContextState *state, const ContextState **base_state,
+      int32_t token_id, bool strict_mode = true) const;
+
   std::pair<bool, const ContextState *> IsMatched(
       const ContextState *state) const;
 
   std::pair<float, const ContextState *> Finalize(
       const ContextState *state) const;
 
+  std::pair<float, const ContextState *> Finalize(
+      const ContextState *state, const ContextState **base_state) const;
+
   const ContextState *Root() const { return root_.get(); }
 
+  // Return the root of the base graph, or nullptr if there is no base graph.
+  const ContextState *BaseRoot() const {
+    return base_ != nullptr ? base_->Root() : nullptr;
+  }
+
+  const ContextGraphPtr &Base() const { return base_; }
+
  private:
   float context_score_;
   float ac_threshold_;
   std::unique_ptr<ContextState> root_;
+  ContextGraphPtr base_;
   void Build(const std::vector<std::vector<int32_t>> &token_ids,
              const std::vector<float> &scores,
              const std::vector<std::string> &phrases,
@@ -0,0 +1,131 @@
+// sherpa-onnx/csrc/decoder-out-cache-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/decoder-out-cache.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+// A fake decoder whose output for context (a, b) is {a, b, a + b}
+class FakeDecoder {
+ public:
+  void operator()(const int64_t *contexts, int32_t n,
+                  std::vector<float> *decoder_out) {
+    ++num_calls;
+    num_rows += n;
+    decoder_out->clear();
+    for (int32_t i = 0; i != n; ++i) {
+      int64_t a = contexts[2 * i];
+      int64_t b = contexts[2 * i + 1];
+      decoder_out->push_back(a);
+      decoder_out->push_back(b);
+      decoder_out->push_back(a + b);
+    }
+  }
+
+  int32_t num_calls = 0;
+  int32_t num_rows = 0;
+};
+
+static void CheckOutput(const std::vector<int64_t> &contexts,
+                        const std::vector<float> &decoder_out) {
+  int32_t n = static_cast<int32_t>(contexts.size() / 2);
+  ASSERT_EQ(decoder_out.size(), n * 3);
+  for (int32_t i = 0; i != n; ++i) {
+    EXPECT_EQ(decoder_out[3 * i], contexts[2 * i]);
+    EXPECT_EQ(decoder_out[3 * i + 1], contexts[2 * i + 1]);
+    EXPECT_EQ(decoder_out[3 * i + 2], contexts[2 * i] + contexts[2 * i + 1]);
+  }
+}
+
+TEST(DecoderOutCache, Basic) {
+  DecoderOutCache cache(2, 10);
+  FakeDecoder decoder;
+  auto run = [&decoder](const int64_t *c, int32_t n, std::vector<float> *d) {
+    decoder(c, n, d);
+  };
+
+  std::vector<float> out;
+  std::vector<int64_t> contexts = {-1, 0, 3, 5, -1, 0, 5, 3};
+  cache.Get(contexts.data(), 4, run, &out);
+  CheckOutput(contexts, out);
+
+  // (-1, 0) appears twice but is run only once
+  EXPECT_EQ(decoder.num_calls, 1);
+  EXPECT_EQ(decoder.num_rows, 3);
+  EXPECT_EQ(cache.Size(), 3);
+
+  contexts = {3, 5, 5, 3, 5, 7, -1, 0};
+  cache.Get(contexts.data(), 4, run, &out);
+  CheckOutput(contexts, out);
+  EXPECT_EQ(decoder.num_calls, 2);
+  EXPECT_EQ(decoder.num_rows, 4);
+  EXPECT_EQ(cache.Size(), 4);
+  EXPECT_EQ(cache.NumLookups(), 8);
+  EXPECT_EQ(cache.NumHits(), 3);
+
+  // All of them are cached
+  cache.Get(contexts.data(), 4, run, &out);
+  CheckOutput(contexts, out);
+  EXPECT_EQ(decoder.num_calls, 2);
+}
+
+TEST(DecoderOutCache, Evict) {
+  DecoderOutCache cache(2, 2);
+  FakeDecoder decoder;
+  auto run = [&decoder](const int64_t *c, int32_t n, std::vector<float> *d) {
+    decoder(c, n, d);
+  };
+
+  std::vector<float> out;
+  std::vector<int64_t> a = {1, 2};
+  std::vector<int64_t> b = {3, 4};
+  std::vector<int64_t> c = {5, 6};
+
+  cache.Get(a.data(), 1, run, &out);
+  cache.Get(b.data(), 1, run, &out);
+  EXPECT_EQ(decoder.num_calls, 2);
+
+  // a is now more recently used than b
+  cache.Get(a.data(), 1, run, &out);
+  EXPECT_EQ(decoder.num_calls, 2);
+
+  // b is evicted
+  cache.Get(c.data(), 1, run, &out);
+  CheckOutput(c, out);
+  EXPECT_EQ(decoder.num_calls, 3);
+  EXPECT_EQ(cache.Size(), 2);
+
+  cache.Get(a.data(), 1, run, &out);
+  CheckOutput(a, out);
+  EXPECT_EQ(decoder.num_calls, 3);
+
+  cache.Get(b.data(), 1, run, &out);
+  CheckOutput(b, out);
+  EXPECT_EQ(decoder.num_calls, 4);
+}
+
+TEST(DecoderOutCache, Disabled) {
+  DecoderOutCache cache(2, 0);
+  FakeDecoder decoder;
+  auto run = [&decoder](const int64_t *c, int32_t n, std::vector<float> *d) {
+    decoder(c, n, d);
+  };
+
+  std::vector<float> out;
+  std::vector<int64_t> contexts = {1, 2, 1, 2};
+  cache.Get(contexts.data(), 2, run, &out);
+  CheckOutput(contexts, out);
+  cache.Get(contexts.data(), 2, run, &out);
+  CheckOutput(contexts, out);
+
+  EXPECT_EQ(decoder.num_calls, 2);
+  EXPECT_EQ(decoder.num_rows, 2);
+  EXPECT_EQ(cache.Size(), 0);
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,117 @@
+// sherpa-onnx/csrc/decoder-out-cache.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/decoder-out-cache.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+size_t DecoderOutCache::ContextHash::operator()(
+    const std::vector<int64_t> &context) const {
+  // FNV-1a over the token IDs
+  uint64_t h = 14695981039346656037ULL;
+  for (auto t : context) {
+    h ^= static_cast<uint64_t>(t);
+    h *= 1099511628211ULL;
+  }
+  return static_cast<size_t>(h);
+}
+
+DecoderOutCache::DecoderOutCache(int32_t context_size, int32_t capacity)
+    : context_size_(context_size), cache_(capacity) {
+  if (context_size_ <= 0) {
+    SHERPA_ONNX_LOGE("context_size should be positive. Given: %d",
+                     context_size_);
+    exit(-1);
+  }
+}
+
+void DecoderOutCache::Get(const int64_t *contexts, int32_t n,
+                          const DecoderFunc &run_decoder,
+                          std::vector<float> *decoder_out) {
+  // miss_index[i] is the row in the decoder input of the i-th context
+  // if it is not in the cache; -1 otherwise.
+  std::vector<int32_t> miss_index(n, -1);
+  std::vector<std::vector<int64_t>> misses;
+
+  // Map a missing context to its row in misses
+  std::unordered_map<std::vector<int64_t>, int32_t, ContextHash> seen;
+
+  // Dimension of a decoder output. It is 0 until it is known.
+  int32_t dim = 0;
+
+  std::vector<int64_t> context;
+  for (int32_t i = 0; i != n; ++i) {
+    context.assign(contexts + i * context_size_,
+                   contexts + (i + 1) * context_size_);
+
+    bool found = cache_.Visit(context, [&](const std::vector<float> &src) {
+      if (dim == 0) {
+        dim = static_cast<int32_t>(src.size());
+        decoder_out->resize(static_cast<size_t>(n) * dim);
+      }
+      std::copy(src.begin(), src.end(), decoder_out->begin() + i * dim);
+    });
+
+    if (found) {
+      continue;
+    }
+
+    auto it = seen.find(context);
+    if (it != seen.end()) {
+      miss_index[i] = it->second;
+      continue;
+    }
+
+    miss_index[i] = static_cast<int32_t>(misses.size());
+    seen.emplace(context, miss_index[i]);
+    misses.push_back(context);
+  }
+
+  int32_t num_misses = static_cast<int32_t>(misses.size());
+  if (num_misses == 0) {
+    return;
+  }
+
+  std::vector<int64_t> decoder_in;
+  decoder_in.reserve(num_misses * context_size_);
+  for (const auto &c : misses) {
+    decoder_in.insert(decoder_in.end(), c.begin(), c.end());
+  }
+
+  std::vector<float> out;
+  run_decoder(decoder_in.data(), num_misses, &out);
+
+  if (dim == 0) {
+    // Nothing was found in the cache, so its size depends on the
+    // decoder output
+    dim = static_cast<int32_t>(out.size() / num_misses);
+    decoder_out->resize(static_cast<size_t>(n) * dim);
+  }
+
+  for (int32_t i = 0; i != n; ++i) {
+    if (miss_index[i] == -1) {
+      continue;
+    }
+
+    const float *src = out.data() + miss_index[i] * dim;
+    std::copy(src, src + dim, decoder_out->begin() + i * dim);
+  }
+
+  if (cache_.Capacity() == 0) {
+    return;
+  }
+
+  for (int32_t i = 0; i != num_misses; ++i) {
+    const float *src = out.data() + i * dim;
+    cache_.Put(misses[i], std::vector<float>(src, src + dim));
+  }
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,86 @@
+// sherpa-onnx/csrc/decoder-out-cache.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_DECODER_OUT_CACHE_H_
+#define SHERPA_ONNX_CSRC_DECODER_OUT_CACHE_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "sherpa-onnx/csrc/lru-cache.h"
+
+namespace sherpa_onnx {
+
+/** An LRU cache of transducer decoder outputs.
+ *
+ * The decoder (prediction network) of a stateless transducer depends only
+ * on the last context_size tokens of a hypothesis, so its output can be
+ * shared by all hypotheses, frames and streams with the same context.
+ *
+ * It is thread-safe. The decoder itself is run without holding the lock.
+ */
+class DecoderOutCache {
+ public:
+  /** Run the decoder on n contexts.
+   *
+   * @param contexts  Pointer to n * context_size tokens. Row i is the
+   *                  context of the i-th decoder input.
+   * @param n  Number of contexts.
+   * @param decoder_out  On return, it contains n rows, one for each context.
+   */
+  using DecoderFunc = std::function<void(const int64_t *contexts, int32_t n,
+                                         std::vector<float> *decoder_out)>;
+
+  /**
+   * @param context_size  Number of tokens the decoder output depends on.
+   * @param capacity  Maximum number of decoder outputs to keep. The least
+   *                  recently used one is evicted when the cache is full.
+   *                  If it is 0, nothing is cached, though identical
+   *                  contexts in a batch are still run only once.
+   */
+  DecoderOutCache(int32_t context_size, int32_t capacity);
+
+  /** Get the decoder outputs of n contexts.
+   *
+   * Contexts that are not in the cache are deduplicated and passed to
+   * run_decoder in a single batch. Their outputs are then added to the cache.
+   *
+   * @param contexts  Pointer to n * context_size tokens.
+   * @param n  Number of contexts.
+   * @param run_decoder  It is called at most once.
+   * @param decoder_out  On return, it contains n rows. Row i is the decoder
+   *                     output for the i-th context.
+   */
+  void Get(const int64_t *contexts, int32_t n, const DecoderFunc &run_decoder,
+           std::vector<float> *decoder_out);
+
+  int32_t ContextSize() const { return context_size_; }
+
+  int32_t Capacity() const { return cache_.Capacity(); }
+
+  // Number of cached decoder outputs
+  int32_t Size() const { return cache_.Size(); }
+
+  // Number of contexts looked up so far
+  int64_t NumLookups() const { return cache_.NumLookups(); }
+
+  // Number of contexts found in the cache so far
+  int64_t NumHits() const { return cache_.NumHits(); }
+
+ private:
+  struct ContextHash {
+    size_t operator()(const std::vector<int64_t> &context) const;
+  };
+
+ private:
+  int32_t context_size_;
+
+  // Map a context to its decoder output
+  LruCache<std::vector<int64_t>, std::vector<float>, ContextHash> cache_;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_DECODER_OUT_CACHE_H_
@@ -13,6 +13,7 @@
 #include "kaldi-native-fbank/csrc/online-feature.h"
 #include "sherpa-onnx/csrc/macros.h"
 #include "sherpa-onnx/csrc/resample.h"
+#include "sherpa-onnx/csrc/sample-format.h"
 
 namespace sherpa_onnx {
 
@@ -75,61 +76,32 @@ class FeatureExtractor::Impl {
   }
 
   void AcceptWaveform(int32_t sampling_rate, const float *waveform, int32_t n) {
-    if (config_.normalize_samples) {
-      AcceptWaveformImpl(sampling_rate, waveform, n);
-    } else {
-      std::vector<float> buf(n);
-      for (int32_t i = 0; i != n; ++i) {
-        buf[i] = waveform[i] * 32768;
-      }
-      AcceptWaveformImpl(sampling_rate, buf.data(), n);
-    }
-  }
-
-  void AcceptWaveformImpl(int32_t sampling_rate, const float *waveform,
-                          int32_t n) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    if (resampler_) {
-      if (sampling_rate != resampler_->GetInputSamplingRate()) {
-        SHERPA_ONNX_LOGE(
-            "You changed the input sampling rate!! Expected: %d, given: "
-            "%d",
-            resampler_->GetInputSamplingRate(), sampling_rate);
-        exit(-1);
-      }
-
-      std::vector<float> samples;
-      resampler_->Resample(waveform, n, false, &samples);
-      fbank_->AcceptWaveform(opts_.frame_opts.samp_freq, samples.data(),
-                             samples.size());
+    if (config_.normalize_samples) {
+      AcceptWaveformImpl(sampling_rate, waveform, n);
       return;
     }
 
-    if (sampling_rate != opts_.frame_opts.samp_freq) {
-      SHERPA_ONNX_LOGE(
-          "Creating a resampler:\n"
-          "   in_sample_rate: %d\n"
-          "   output_sample_rate: %d\n",
-          sampling_rate, static_cast<int32_t>(opts_.frame_opts.samp_freq));
-
-      float min_freq =
-          std::min<int32_t>(sampling_rate, opts_.frame_opts.samp_freq);
-      float lowpass_cutoff = 0.99 * 0.5 * min_freq;
+    AcceptSamples(sampling_rate, SampleFormat::kFloat, waveform, n);
+  }
 
-      int32_t lowpass_filter_width = 6;
-      resampler_ = std::make_unique<LinearResample>(
-          sampling_rate, opts_.frame_opts.samp_freq, lowpass_cutoff,
-          lowpass_filter_width);
+  void AcceptWaveform(int32_t sampling_rate, const int16_t *waveform,
+                      int32_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AcceptSamples(sampling_rate, SampleFormat::kInt16, waveform, n);
+  }
 
-      std::vector<float> samples;
-      resampler_->Resample(waveform, n, false, &samples);
-      fbank_->AcceptWaveform(opts_.frame_opts.samp_freq, samples.data(),
-                             samples.size());
-      return;
-    }
+  void AcceptWaveformMuLaw(int32_t sampling_rate, const uint8_t *waveform,
+                           int32_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AcceptSamples(sampling_rate, SampleFormat::kMuLaw, waveform, n);
+  }
 
-    fbank_->AcceptWaveform(sampling_rate, waveform, n);
+  void AcceptWaveformALaw(int32_t sampling_rate, const uint8_t *waveform,
+                          int32_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AcceptSamples(sampling_rate, SampleFormat::kALaw, waveform, n);
   }
 
   void InputFinished() const {
@@ -181,12 +153,75 @@ class FeatureExtractor::Impl {
 
   int32_t FeatureDim() const { return opts_.mel_opts.num_bins; }
 
+ private:
+  // The caller must hold mutex_
+  void AcceptSamples(int32_t sampling_rate, SampleFormat format,
+                     const void *samples, int32_t n) {
+    // converted_ is reused across calls so that we don't allocate memory
+    // for every chunk
+    ConvertSamples(format, samples, n, config_.normalize_samples,
+                   &converted_);
+    AcceptWaveformImpl(sampling_rate, converted_.data(), n);
+  }
+
+  // The caller must hold mutex_
+  void AcceptWaveformImpl(int32_t sampling_rate, const float *waveform,
+                          int32_t n) {
+    if (resampler_) {
+      if (sampling_rate != resampler_->GetInputSamplingRate()) {
+        SHERPA_ONNX_LOGE(
+            "You changed the input sampling rate!! Expected: %d, given: "
+            "%d",
+            resampler_->GetInputSamplingRate(), sampling_rate);
+        exit(-1);
+      }
+
+      Resample(waveform, n);
+      return;
+    }
+
+    if (sampling_rate != opts_.frame_opts.samp_freq) {
+      SHERPA_ONNX_LOGE(
+          "Creating a resampler:\n"
+          "   in_sample_rate: %d\n"
+          "   output_sample_rate: %d\n",
+          sampling_rate, static_cast<int32_t>(opts_.frame_opts.samp_freq));
+
+      float min_freq =
+          std::min<int32_t>(sampling_rate, opts_.frame_opts.samp_freq);
+      float lowpass_cutoff = 0.99 * 0.5 * min_freq;
+
+      int32_t lowpass_filter_width = 6;
+      resampler_ = std::make_unique<LinearResample>(
+          sampling_rate, opts_.frame_opts.samp_freq, lowpass_cutoff,
+          lowpass_filter_width);
+
+      Resample(waveform, n);
+      return;
+    }
+
+    fbank_->AcceptWaveform(sampling_rate, waveform, n);
+  }
+
+  // The caller must hold mutex_
+  void Resample(const float *waveform, int32_t n) {
+    // resampled_ is reused across calls so that we don't allocate memory
+    // for every chunk
+    resampled_.resize(resampler_->NumOutputSamples(n, false));
+    int32_t num_samples =
+        resampler_->Resample(waveform, n, false, resampled_.data());
+    fbank_->AcceptWaveform(opts_.frame_opts.samp_freq, resampled_.data(),
+                           num_samples);
+  }
+
  private:
   std::unique_ptr<knf::OnlineFbank> fbank_;
   knf::FbankOptions opts_;
   FeatureExtractorConfig config_;
   mutable std::mutex mutex_;
   std::unique_ptr<LinearResample> resampler_;
+  std::vector<float> converted_;
+  std::vector<float> resampled_;
   int32_t last_frame_index_ = 0;
 };
 
@@ -202,6 +237,24 @@ void FeatureExtractor::AcceptWaveform(int32_t sampling_rate,
 
 void FeatureExtractor::InputFinished() const { impl_->InputFinished(); }
 
+void FeatureExtractor::AcceptWaveform(int32_t sampling_rate,
+                                      const int16_t *waveform,
+                                      int32_t n) const {
+  impl_->AcceptWaveform(sampling_rate, waveform, n);
+}
+
+void FeatureExtractor::AcceptWaveformMuLaw(int32_t sampling_rate,
+                                           const uint8_t *waveform,
+                                           int32_t n) const {
+  impl_->AcceptWaveformMuLaw(sampling_rate, waveform, n);
+}
+
+void FeatureExtractor::AcceptWaveformALaw(int32_t sampling_rate,
+                                          const uint8_t *waveform,
+                                          int32_t n) const {
+  impl_->AcceptWaveformALaw(sampling_rate, waveform, n);
+}
+
 int32_t FeatureExtractor::NumFramesReady() const {
   return impl_->NumFramesReady();
 }
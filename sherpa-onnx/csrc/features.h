@@ -90,6 +90,22 @@ class FeatureExtractor {
   void AcceptWaveform(int32_t sampling_rate, const float *waveform,
                       int32_t n) const;
 
+  /** Same as above, but the input is 16-bit linear PCM.
+   *
+   * The samples are converted and scaled in a single pass, so you don't
+   * need to convert them to float by yourself.
+   */
+  void AcceptWaveform(int32_t sampling_rate, const int16_t *waveform,
+                      int32_t n) const;
+
+  /// Same as above, but the input is encoded with G.711 mu-law
+  void AcceptWaveformMuLaw(int32_t sampling_rate, const uint8_t *waveform,
+                           int32_t n) const;
+
+  /// Same as above, but the input is encoded with G.711 A-law
+  void AcceptWaveformALaw(int32_t sampling_rate, const uint8_t *waveform,
+                          int32_t n) const;
+
   /**
    * InputFinished() tells the class you won't be providing any
    * more waveform.  This will help flush out the last frame or two
@@ -9,18 +9,14 @@
 #include <utility>
 
 #include "cppjieba/Jieba.hpp"
+#include "sherpa-onnx/csrc/compiled-lexicon.h"
 #include "sherpa-onnx/csrc/file-utils.h"
+#include "sherpa-onnx/csrc/lexicon.h"
 #include "sherpa-onnx/csrc/macros.h"
 #include "sherpa-onnx/csrc/text-utils.h"
 
 namespace sherpa_onnx {
 
-// implemented in ./lexicon.cc
-std::unordered_map<std::string, int32_t> ReadTokens(std::istream &is);
-std::vector<int32_t> ConvertTokensToIds(
-    const std::unordered_map<std::string, int32_t> &token2id,
-    const std::vector<std::string> &tokens);
-
 class JiebaLexicon::Impl {
  public:
   Impl(const std::string &lexicon, const std::string &tokens,
@@ -47,7 +43,9 @@ class JiebaLexicon::Impl {
       InitTokens(is);
     }
 
-    {
+    if (CompiledLexicon::IsCompiledLexicon(lexicon)) {
+      compiled_lexicon_ = std::make_unique<CompiledLexicon>(lexicon);
+    } else {
       std::ifstream is(lexicon);
       InitLexicon(is);
     }
@@ -114,9 +112,27 @@ class JiebaLexicon::Impl {
   }
 
  private:
+  // Return nullptr if the word is not in the lexicon
+  const int32_t *LookupWord(const std::string &word, int32_t *num_ids) const {
+    if (compiled_lexicon_) {
+      return compiled_lexicon_->Lookup(word, num_ids);
+    }
+
+    auto it = word2ids_.find(word);
+    if (it == word2ids_.end()) {
+      *num_ids = 0;
+      return nullptr;
+    }
+
+    *num_ids = static_cast<int32_t>(it->second.size());
+    return it->second.data();
+  }
+
   std::vector<int32_t> ConvertWordToIds(const std::string &w) const {
-    if (word2ids_.count(w)) {
-      return word2ids_.at(w);
+    int32_t num_ids = 0;
+    const int32_t *ids = LookupWord(w, &num_ids);
+    if (ids) {
+      return std::vector<int32_t>(ids, ids + num_ids);
     }
 
     if (token2id_.count(w)) {
@@ -127,9 +143,9 @@ class JiebaLexicon::Impl {
 
     std::vector<std::string> words = SplitUtf8(w);
     for (const auto &word : words) {
-      if (word2ids_.count(word)) {
-        auto ids = ConvertWordToIds(word);
-        ans.insert(ans.end(), ids.begin(), ids.end());
+      const int32_t *word_ids = LookupWord(word, &num_ids);
+      if (word_ids) {
+        ans.insert(ans.end(), word_ids, word_ids + num_ids);
       }
     }
 
@@ -158,44 +174,14 @@ class JiebaLexicon::Impl {
   }
 
   void InitLexicon(std::istream &is) {
-    std::string word;
-    std::vector<std::string> token_list;
-    std::string line;
-    std::string phone;
-    int32_t line_num = 0;
-
-    while (std::getline(is, line)) {
-      ++line_num;
-
-      std::istringstream iss(line);
-
-      token_list.clear();
-
-      iss >> word;
-      ToLowerCase(&word);
-
-      if (word2ids_.count(word)) {
-        SHERPA_ONNX_LOGE("Duplicated word: %s at line %d:%s. Ignore it.",
-                         word.c_str(), line_num, line.c_str());
-        continue;
-      }
-
-      while (iss >> phone) {
-        token_list.push_back(std::move(phone));
-      }
-
-      std::vector<int32_t> ids = ConvertTokensToIds(token2id_, token_list);
-      if (ids.empty()) {
-        continue;
-      }
-
-      word2ids_.insert({std::move(word), std::move(ids)});
-    }
+    word2ids_ = ReadLexicon(is, token2id_);
   }
 
  private:
-  // lexicon.txt is saved in word2ids_
+  // lexicon.txt is saved in word2ids_. If the lexicon is compiled,
+  // compiled_lexicon_ is used instead.
   std::unordered_map<std::string, std::vector<int32_t>> word2ids_;
+  std::unique_ptr<CompiledLexicon> compiled_lexicon_;
 
   // tokens.txt is saved in token2id_
   std::unordered_map<std::string, int32_t> token2id_;
@@ -78,7 +78,7 @@ class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
 
     decoder_ = std::make_unique<TransducerKeywordDecoder>(
         model_.get(), config_.max_active_paths, config_.num_trailing_blanks,
-        unk_id_);
+        unk_id_, config_.blank_skip_threshold);
   }
 
 #if __ANDROID_API__ >= 9
@@ -97,7 +97,7 @@ class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
 
     decoder_ = std::make_unique<TransducerKeywordDecoder>(
         model_.get(), config_.max_active_paths, config_.num_trailing_blanks,
-        unk_id_);
+        unk_id_, config_.blank_skip_threshold);
   }
 #endif
 
@@ -307,10 +307,10 @@ class KeywordSpotterTransducerImpl : public KeywordSpotterImpl {
 
   void InitOnlineStream(OnlineStream *stream) const {
     auto r = decoder_->GetEmptyResult();
-    SHERPA_ONNX_CHECK_EQ(r.hyps.Size(), 1);
+    SHERPA_ONNX_CHECK_EQ(r.hyps.size(), 1);
 
     SHERPA_ONNX_CHECK(stream->GetContextGraph() != nullptr);
-    r.hyps.begin()->second.context_state = stream->GetContextGraph()->Root();
+    r.hyps[0].context_state = stream->GetContextGraph()->Root();
 
     stream->SetKeywordResult(r);
     stream->SetStates(model_->GetEncoderInitStates());
@@ -87,9 +87,20 @@ void KeywordSpotterConfig::Register(ParseOptions *po) {
       "phrase the bpe/cjkchar are separated by a space. For example: "
       "▁HE LL O ▁WORLD"
       "你 好 世 界");
+  po->Register("blank-skip-threshold", &blank_skip_threshold,
+               "If positive, a frame is not expanded in the beam search if "
+               "the blank probability of every active path exceeds it. "
+               "It saves computation for always-on keyword spotting. "
+               "0.95 is a good value to start with. 0 disables it.");
 }
 
 bool KeywordSpotterConfig::Validate() const {
+  if (blank_skip_threshold < 0 || blank_skip_threshold >= 1) {
+    SHERPA_ONNX_LOGE("--blank-skip-threshold should be in [0, 1). Given: %f",
+                     blank_skip_threshold);
+    return false;
+  }
+
   if (keywords_file.empty()) {
     SHERPA_ONNX_LOGE("Please provide --keywords-file.");
     return false;
@@ -120,7 +131,8 @@ std::string KeywordSpotterConfig::ToString() const {
   os << "num_trailing_blanks=" << num_trailing_blanks << ", ";
   os << "keywords_score=" << keywords_score << ", ";
   os << "keywords_threshold=" << keywords_threshold << ", ";
-  os << "keywords_file=\"" << keywords_file << "\")";
+  os << "keywords_file=\"" << keywords_file << "\", ";
+  os << "blank_skip_threshold=" << blank_skip_threshold << ")";
 
   return os.str();
 }
@@ -69,6 +69,10 @@ struct KeywordSpotterConfig {
 
   std::string keywords_file;
 
+  // If positive, frames where the blank probability of every active path
+  // exceeds it are not expanded in the beam search. 0 disables it.
+  float blank_skip_threshold = 0;
+
   KeywordSpotterConfig() = default;
 
   KeywordSpotterConfig(const FeatureExtractorConfig &feat_config,
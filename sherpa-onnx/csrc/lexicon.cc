@@ -129,6 +129,48 @@ std::vector<int32_t> ConvertTokensToIds(
   return ids;
 }
 
+std::unordered_map<std::string, std::vector<int32_t>> ReadLexicon(
+    std::istream &is,
+    const std::unordered_map<std::string, int32_t> &token2id) {
+  std::unordered_map<std::string, std::vector<int32_t>> word2ids;
+
+  std::string word;
+  std::vector<std::string> token_list;
+  std::string line;
+  std::string phone;
+  int32_t line_num = 0;
+
+  while (std::getline(is, line)) {
+    ++line_num;
+
+    std::istringstream iss(line);
+
+    token_list.clear();
+
+    iss >> word;
+    ToLowerCase(&word);
+
+    if (word2ids.count(word)) {
+      SHERPA_ONNX_LOGE("Duplicated word: %s at line %d:%s. Ignore it.",
+                       word.c_str(), line_num, line.c_str());
+      continue;
+    }
+
+    while (iss >> phone) {
+      token_list.push_back(std::move(phone));
+    }
+
+    std::vector<int32_t> ids = ConvertTokensToIds(token2id, token_list);
+    if (ids.empty()) {
+      continue;
+    }
+
+    word2ids.insert({std::move(word), std::move(ids)});
+  }
+
+  return word2ids;
+}
+
 Lexicon::Lexicon(const std::string &lexicon, const std::string &tokens,
                  const std::string &punctuations, const std::string &language,
                  bool debug /*= false*/)
@@ -140,7 +182,9 @@ Lexicon::Lexicon(const std::string &lexicon, const std::string &tokens,
     InitTokens(is);
   }
 
-  {
+  if (CompiledLexicon::IsCompiledLexicon(lexicon)) {
+    compiled_lexicon_ = std::make_unique<CompiledLexicon>(lexicon);
+  } else {
     std::ifstream is(lexicon);
     InitLexicon(is);
   }
@@ -164,8 +208,12 @@ Lexicon::Lexicon(AAssetManager *mgr, const std::string &lexicon,
 
   {
     auto buf = ReadFile(mgr, lexicon);
-    std::istrstream is(buf.data(), buf.size());
-    InitLexicon(is);
+    if (CompiledLexicon::IsCompiledLexicon(buf.data(), buf.size())) {
+      compiled_lexicon_ = std::make_unique<CompiledLexicon>(std::move(buf));
+    } else {
+      std::istrstream is(buf.data(), buf.size());
+      InitLexicon(is);
+    }
   }
 
   InitPunctuations(punctuations);
@@ -262,14 +310,14 @@ std::vector<std::vector<int64_t>> Lexicon::ConvertTextToTokenIdsChinese(
       continue;
     }
 
-    if (!word2ids_.count(w)) {
+    int32_t num_ids = 0;
+    const int32_t *token_ids = LookupWord(w, &num_ids);
+    if (!token_ids) {
       SHERPA_ONNX_LOGE("OOV %s. Ignore it!", w.c_str());
       continue;
     }
 
-    const auto &token_ids = word2ids_.at(w);
-    this_sentence.insert(this_sentence.end(), token_ids.begin(),
-                         token_ids.end());
+    this_sentence.insert(this_sentence.end(), token_ids, token_ids + num_ids);
     if (blank != -1) {
       this_sentence.push_back(blank);
     }
@@ -329,14 +377,14 @@ std::vector<std::vector<int64_t>> Lexicon::ConvertTextToTokenIdsNotChinese(
       continue;
     }
 
-    if (!word2ids_.count(w)) {
+    int32_t num_ids = 0;
+    const int32_t *token_ids = LookupWord(w, &num_ids);
+    if (!token_ids) {
       SHERPA_ONNX_LOGE("OOV %s. Ignore it!", w.c_str());
       continue;
     }
 
-    const auto &token_ids = word2ids_.at(w);
-    this_sentence.insert(this_sentence.end(), token_ids.begin(),
-                         token_ids.end());
+    this_sentence.insert(this_sentence.end(), token_ids, token_ids + num_ids);
     this_sentence.push_back(blank);
   }
 
@@ -368,35 +416,23 @@ void Lexicon::InitLanguage(const std::string &_lang) {
 }
 
 void Lexicon::InitLexicon(std::istream &is) {
-  std::string word;
-  std::vector<std::string> token_list;
-  std::string line;
-  std::string phone;
-
-  while (std::getline(is, line)) {
-    std::istringstream iss(line);
-
-    token_list.clear();
-
-    iss >> word;
-    ToLowerCase(&word);
-
-    if (word2ids_.count(word)) {
-      SHERPA_ONNX_LOGE("Duplicated word: %s. Ignore it.", word.c_str());
-      continue;
-    }
-
-    while (iss >> phone) {
-      token_list.push_back(std::move(phone));
-    }
+  word2ids_ = ReadLexicon(is, token2id_);
+}
 
-    std::vector<int32_t> ids = ConvertTokensToIds(token2id_, token_list);
-    if (ids.empty()) {
-      continue;
-    }
+const int32_t *Lexicon::LookupWord(const std::string &word,
+                                   int32_t *num_ids) const {
+  if (compiled_lexicon_) {
+    return compiled_lexicon_->Lookup(word, num_ids);
+  }
 
-    word2ids_.insert({std::move(word), std::move(ids)});
+  auto it = word2ids_.find(word);
+  if (it == word2ids_.end()) {
+    *num_ids = 0;
+    return nullptr;
   }
+
+  *num_ids = static_cast<int32_t>(it->second.size());
+  return it->second.data();
 }
 
 void Lexicon::InitPunctuations(const std::string &punctuations) {
@@ -6,6 +6,7 @@
 #define SHERPA_ONNX_CSRC_LEXICON_H_
 
 #include <cstdint>
+#include <istream>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -17,15 +18,33 @@
 #include "android/asset_manager_jni.h"
 #endif
 
+#include "sherpa-onnx/csrc/compiled-lexicon.h"
 #include "sherpa-onnx/csrc/offline-tts-frontend.h"
 
 namespace sherpa_onnx {
 
+// Read tokens.txt. Each line contains a token and its ID.
+std::unordered_map<std::string, int32_t> ReadTokens(std::istream &is);
+
+// Return an empty vector if any of the tokens is not in token2id
+std::vector<int32_t> ConvertTokensToIds(
+    const std::unordered_map<std::string, int32_t> &token2id,
+    const std::vector<std::string> &tokens);
+
+// Read a text lexicon. Each line contains a word followed by its tokens.
+// Words are converted to lowercase. Words with unknown tokens are skipped.
+std::unordered_map<std::string, std::vector<int32_t>> ReadLexicon(
+    std::istream &is,
+    const std::unordered_map<std::string, int32_t> &token2id);
+
 class Lexicon : public OfflineTtsFrontend {
  public:
   Lexicon() = default;  // for subclasses
                         //
   // Note: for models from piper, we won't use this class.
+  //
+  // lexicon is either a text file or a lexicon compiled with
+  // sherpa-onnx-compile-lexicon using the same tokens.
   Lexicon(const std::string &lexicon, const std::string &tokens,
           const std::string &punctuations, const std::string &language,
           bool debug = false);
@@ -51,6 +70,9 @@ class Lexicon : public OfflineTtsFrontend {
   void InitLexicon(std::istream &is);
   void InitPunctuations(const std::string &punctuations);
 
+  // Return nullptr if the word is not in the lexicon
+  const int32_t *LookupWord(const std::string &word, int32_t *num_ids) const;
+
  private:
   enum class Language {
     kNotChinese,
@@ -59,7 +81,10 @@ class Lexicon : public OfflineTtsFrontend {
   };
 
  private:
+  // Only one of them is used, depending on the format of the lexicon
   std::unordered_map<std::string, std::vector<int32_t>> word2ids_;
+  std::unique_ptr<CompiledLexicon> compiled_lexicon_;
+
   std::unordered_set<std::string> punctuations_;
   std::unordered_map<std::string, int32_t> token2id_;
   Language language_;
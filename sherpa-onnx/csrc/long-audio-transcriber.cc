@@ -0,0 +1,424 @@
+// sherpa-onnx/csrc/long-audio-transcriber.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/long-audio-transcriber.h"
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <fstream>
+#include <map>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <utility>
+
+#include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/resample.h"
+#include "sherpa-onnx/csrc/thread-pool.h"
+#include "sherpa-onnx/csrc/voice-activity-detector.h"
+#include "sherpa-onnx/csrc/wave-reader.h"
+
+namespace sherpa_onnx {
+
+void LongAudioTranscriberConfig::Register(ParseOptions *po) {
+  recognizer_config.Register(po);
+  vad_config.Register(po);
+
+  po->Register("batch-size", &batch_size,
+               "Max number of segments decoded together.");
+
+  po->Register("num-buckets", &num_buckets,
+               "Number of length buckets. Segments in a batch are from the "
+               "same bucket.");
+
+  po->Register("bucket-width", &bucket_width,
+               "Width in seconds of a length bucket. The last bucket takes "
+               "all longer segments.");
+
+  po->Register("max-segment-length", &max_segment_length,
+               "Speech longer than this number of seconds is cut into "
+               "several segments.");
+
+  po->Register("num-decoding-threads", &num_decoding_threads,
+               "Number of threads decoding batches in parallel. If it is 0, "
+               "batches are decoded in the thread reading the audio.");
+}
+
+bool LongAudioTranscriberConfig::Validate() const {
+  if (!recognizer_config.Validate()) {
+    return false;
+  }
+
+  if (!vad_config.Validate()) {
+    return false;
+  }
+
+  if (batch_size < 1) {
+    SHERPA_ONNX_LOGE("--batch-size should be positive. Given: %d",
+                     batch_size);
+    return false;
+  }
+
+  if (num_buckets < 1) {
+    SHERPA_ONNX_LOGE("--num-buckets should be positive. Given: %d",
+                     num_buckets);
+    return false;
+  }
+
+  if (bucket_width <= 0) {
+    SHERPA_ONNX_LOGE("--bucket-width should be positive. Given: %.3f",
+                     bucket_width);
+    return false;
+  }
+
+  if (max_segment_length <= 0) {
+    SHERPA_ONNX_LOGE("--max-segment-length should be positive. Given: %.3f",
+                     max_segment_length);
+    return false;
+  }
+
+  if (num_decoding_threads < 0) {
+    SHERPA_ONNX_LOGE("--num-decoding-threads should be >= 0. Given: %d",
+                     num_decoding_threads);
+    return false;
+  }
+
+  return true;
+}
+
+std::string LongAudioTranscriberConfig::ToString() const {
+  std::ostringstream os;
+
+  os << "LongAudioTranscriberConfig(";
+  os << "recognizer_config=" << recognizer_config.ToString() << ", ";
+  os << "vad_config=" << vad_config.ToString() << ", ";
+  os << "batch_size=" << batch_size << ", ";
+  os << "num_buckets=" << num_buckets << ", ";
+  os << "bucket_width=" << bucket_width << ", ";
+  os << "max_segment_length=" << max_segment_length << ", ";
+  os << "num_decoding_threads=" << num_decoding_threads << ")";
+
+  return os.str();
+}
+
+namespace {
+
+struct PendingSegment {
+  int32_t index;   // of the segment in the audio
+  float start;     // in seconds
+  float duration;  // in seconds
+  std::vector<float> samples;
+};
+
+using Batch = std::vector<PendingSegment>;
+
+// Speech longer than max_segment_length is cut by the VAD
+static VadModelConfig GetVadConfig(const LongAudioTranscriberConfig &config) {
+  VadModelConfig ans = config.vad_config;
+  ans.max_speech_duration = config.max_segment_length;
+  return ans;
+}
+
+// State of a call of LongAudioTranscriber::Transcribe()
+class TranscribeJob {
+ public:
+  TranscribeJob(const LongAudioTranscriberConfig &config,
+                const OfflineRecognizer *recognizer, ThreadPool *pool,
+                int32_t sample_rate,
+                const LongAudioTranscriber::Callback &callback)
+      : config_(config),
+        recognizer_(recognizer),
+        pool_(pool),
+        callback_(callback),
+        vad_(GetVadConfig(config)),
+        sample_rate_(config.vad_config.sample_rate),
+        max_running_(2 * std::max(config.num_decoding_threads, 1)),
+        max_delay_(config.num_buckets * config.batch_size),
+        buckets_(config.num_buckets) {
+    if (sample_rate != sample_rate_) {
+      float min_freq = std::min(sample_rate, sample_rate_);
+      float lowpass_cutoff = 0.99 * 0.5 * min_freq;
+
+      int32_t lowpass_filter_width = 6;
+      resampler_ = std::make_unique<LinearResample>(
+          sample_rate, sample_rate_, lowpass_cutoff, lowpass_filter_width);
+    }
+  }
+
+  // Samples are at the sample rate given in the constructor
+  void AcceptWaveform(const float *samples, int32_t n) {
+    if (resampler_) {
+      resampler_->Resample(samples, n, false, &resampled_);
+      AcceptVad(resampled_.data(), resampled_.size());
+    } else {
+      AcceptVad(samples, n);
+    }
+
+    Emit();
+  }
+
+  // Decode the remaining segments and wait for all of them
+  void InputFinished() {
+    if (resampler_) {
+      resampler_->Resample(nullptr, 0, true, &resampled_);
+      AcceptVad(resampled_.data(), resampled_.size());
+    }
+
+    vad_.Flush();
+    PopSegments();
+
+    for (auto &b : buckets_) {
+      if (!b.empty()) {
+        Submit(&b);
+      }
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return num_running_ == 0; });
+    }
+
+    Emit();
+  }
+
+ private:
+  // Samples are at the sample rate of the VAD model
+  void AcceptVad(const float *samples, int32_t n) {
+    vad_.AcceptWaveform(samples, n);
+    PopSegments();
+  }
+
+  void PopSegments() {
+    while (!vad_.Empty()) {
+      SpeechSegment &s = vad_.Front();
+
+      PendingSegment p;
+      p.index = num_segments_++;
+      p.start = static_cast<float>(s.start) / sample_rate_;
+      p.duration = static_cast<float>(s.samples.size()) / sample_rate_;
+      p.samples = std::move(s.samples);
+
+      vad_.Pop();
+
+      AddSegment(std::move(p));
+    }
+  }
+
+  void AddSegment(PendingSegment p) {
+    int32_t k =
+        std::min(static_cast<int32_t>(p.duration / config_.bucket_width),
+                 config_.num_buckets - 1);
+    int32_t index = p.index;
+
+    buckets_[k].push_back(std::move(p));
+    if (static_cast<int32_t>(buckets_[k].size()) == config_.batch_size) {
+      Submit(&buckets_[k]);
+    }
+
+    // Results are returned in the order of time, so a segment waiting
+    // for a full batch delays the results of all segments after it.
+    for (auto &b : buckets_) {
+      if (!b.empty() && index - b.front().index >= max_delay_) {
+        Submit(&b);
+      }
+    }
+  }
+
+  void Submit(Batch *b) {
+    auto batch = std::make_shared<Batch>(std::move(*b));
+    b->clear();
+
+    {
+      // Wait so that the audio of only a few batches is kept in memory
+      // if decoding is slower than the VAD
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return num_running_ < max_running_; });
+      ++num_running_;
+    }
+
+    // If the pool has no threads, it runs in the calling thread
+    pool_->Run([this, batch]() { DecodeBatch(batch.get()); });
+  }
+
+  // It is called by a thread of the pool
+  void DecodeBatch(Batch *batch) {
+    int32_t n = static_cast<int32_t>(batch->size());
+
+    std::vector<std::unique_ptr<OfflineStream>> ss(n);
+    std::vector<OfflineStream *> p_ss(n);
+    for (int32_t i = 0; i != n; ++i) {
+      auto &samples = (*batch)[i].samples;
+
+      ss[i] = recognizer_->CreateStream();
+      ss[i]->AcceptWaveform(sample_rate_, samples.data(), samples.size());
+      p_ss[i] = ss[i].get();
+
+      // Features have been computed
+      std::vector<float>().swap(samples);
+    }
+
+    recognizer_->DecodeStreams(p_ss.data(), n);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int32_t i = 0; i != n; ++i) {
+      const auto &p = (*batch)[i];
+
+      LongAudioSegment s;
+      s.start = p.start;
+      s.duration = p.duration;
+      s.result = ss[i]->GetResult();
+      for (auto &t : s.result.timestamps) {
+        t += p.start;
+      }
+
+      done_.emplace(p.index, std::move(s));
+    }
+
+    --num_running_;
+
+    // Notify with the lock held since the job may be destroyed as soon as
+    // InputFinished() sees num_running_ == 0
+    cond_.notify_all();
+  }
+
+  // Call callback_ for decoded segments in the order of time
+  void Emit() {
+    std::vector<LongAudioSegment> ready;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto it = done_.find(next_); it != done_.end();
+           it = done_.find(next_)) {
+        ready.push_back(std::move(it->second));
+        done_.erase(it);
+        ++next_;
+      }
+    }
+
+    for (const auto &s : ready) {
+      callback_(s);
+    }
+  }
+
+ private:
+  const LongAudioTranscriberConfig &config_;
+  const OfflineRecognizer *recognizer_;  // not owned
+  ThreadPool *pool_;                     // not owned
+  const LongAudioTranscriber::Callback &callback_;
+
+  VoiceActivityDetector vad_;
+  int32_t sample_rate_;  // of the VAD model
+
+  std::unique_ptr<LinearResample> resampler_;
+  std::vector<float> resampled_;
+
+  int32_t max_running_;
+  int32_t max_delay_;  // in number of segments
+
+  int32_t num_segments_ = 0;
+  std::vector<Batch> buckets_;
+
+  // Index of the next segment passed to callback_
+  int32_t next_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  int32_t num_running_ = 0;  // batches being decoded
+
+  // Decoded segments not passed to callback_ yet
+  std::map<int32_t, LongAudioSegment> done_;
+};
+
+}  // namespace
+
+class LongAudioTranscriber::Impl {
+ public:
+  explicit Impl(const LongAudioTranscriberConfig &config)
+      : config_(config),
+        recognizer_(config.recognizer_config),
+        pool_(config.num_decoding_threads) {}
+
+  void Transcribe(int32_t sample_rate, const Reader &read,
+                  const Callback &callback) {
+    TranscribeJob job(config_, &recognizer_, &pool_, sample_rate, callback);
+
+    // Read 1 second at a time
+    std::vector<float> buffer(sample_rate);
+
+    int32_t n;
+    while ((n = read(buffer.data(), buffer.size())) > 0) {
+      job.AcceptWaveform(buffer.data(), n);
+    }
+
+    job.InputFinished();
+  }
+
+ private:
+  LongAudioTranscriberConfig config_;
+  OfflineRecognizer recognizer_;
+  ThreadPool pool_;
+};
+
+LongAudioTranscriber::LongAudioTranscriber(
+    const LongAudioTranscriberConfig &config)
+    : impl_(std::make_unique<Impl>(config)) {}
+
+LongAudioTranscriber::~LongAudioTranscriber() = default;
+
+void LongAudioTranscriber::Transcribe(int32_t sample_rate, const Reader &read,
+                                      const Callback &callback) const {
+  impl_->Transcribe(sample_rate, read, callback);
+}
+
+std::vector<LongAudioSegment> LongAudioTranscriber::Transcribe(
+    int32_t sample_rate, const float *samples, int32_t n) const {
+  std::vector<LongAudioSegment> ans;
+
+  int32_t offset = 0;
+  auto read = [samples, n, &offset](float *p, int32_t size) {
+    size = std::min(size, n - offset);
+    std::copy(samples + offset, samples + offset + size, p);
+    offset += size;
+    return size;
+  };
+
+  Transcribe(sample_rate, read,
+             [&ans](const LongAudioSegment &s) { ans.push_back(s); });
+
+  return ans;
+}
+
+bool LongAudioTranscriber::TranscribeFile(const std::string &filename,
+                                          const Callback &callback) const {
+  std::ifstream is(filename, std::ifstream::binary);
+
+  int32_t sample_rate = 0;
+  int32_t num_samples = ReadWaveHeader(is, &sample_rate);
+  if (num_samples < 0) {
+    SHERPA_ONNX_LOGE("Failed to read '%s'", filename.c_str());
+    return false;
+  }
+
+  std::vector<int16_t> buffer;
+  auto read = [&is, &num_samples, &buffer](float *p, int32_t size) {
+    size = std::min(size, num_samples);
+
+    buffer.resize(size);
+    is.read(reinterpret_cast<char *>(buffer.data()), size * sizeof(int16_t));
+
+    // The file may be truncated
+    size = is.gcount() / sizeof(int16_t);
+    num_samples = is ? num_samples - size : 0;
+
+    for (int32_t i = 0; i != size; ++i) {
+      p[i] = buffer[i] / 32768.;
+    }
+
+    return size;
+  };
+
+  Transcribe(sample_rate, read, callback);
+
+  return true;
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,123 @@
+// sherpa-onnx/csrc/long-audio-transcriber.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_LONG_AUDIO_TRANSCRIBER_H_
+#define SHERPA_ONNX_CSRC_LONG_AUDIO_TRANSCRIBER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sherpa-onnx/csrc/offline-recognizer.h"
+#include "sherpa-onnx/csrc/parse-options.h"
+#include "sherpa-onnx/csrc/vad-model-config.h"
+
+namespace sherpa_onnx {
+
+struct LongAudioTranscriberConfig {
+  OfflineRecognizerConfig recognizer_config;
+  VadModelConfig vad_config;
+
+  // Max number of segments in a call of DecodeStreams()
+  int32_t batch_size = 8;
+
+  // Segments in a batch have similar lengths. A segment of d seconds goes
+  // to bucket floor(d / bucket_width); the last bucket takes the rest.
+  int32_t num_buckets = 6;
+  float bucket_width = 5;  // seconds
+
+  // Speech longer than this value is cut into several segments
+  float max_segment_length = 30;  // seconds
+
+  // Number of threads running DecodeStreams() in parallel. If it is 0,
+  // batches are decoded in the calling thread.
+  int32_t num_decoding_threads = 2;
+
+  LongAudioTranscriberConfig() = default;
+
+  void Register(ParseOptions *po);
+  bool Validate() const;
+
+  std::string ToString() const;
+};
+
+struct LongAudioSegment {
+  // Start time and duration of the segment in the audio, in seconds
+  float start = 0;
+  float duration = 0;
+
+  // result.timestamps are relative to the start of the audio,
+  // not to the start of the segment
+  OfflineRecognitionResult result;
+};
+
+/** Transcribe long audio, e.g., a recording of a few hours.
+ *
+ * The audio is split into segments by a VAD as it is read. Segments of
+ * similar lengths are decoded together with OfflineRecognizer::DecodeStreams()
+ * in a pool of threads, while the VAD keeps reading the audio.
+ *
+ * Memory usage does not depend on the length of the audio. At most
+ * num_buckets * batch_size segments waiting for a batch and
+ * 2 * num_decoding_threads batches being decoded are kept in memory,
+ * each segment being at most about max_segment_length seconds.
+ *
+ * Usage:
+ *
+ *   LongAudioTranscriber transcriber(config);
+ *   transcriber.TranscribeFile("foo.wav", [](const LongAudioSegment &s) {
+ *     std::cout << s.start << ": " << s.result.text << "\n";
+ *   });
+ */
+class LongAudioTranscriber {
+ public:
+  /** Read samples of the audio.
+   *
+   * @param samples Buffer for the samples, normalized to the range [-1, 1].
+   * @param n Size of the buffer.
+   * @return Return the number of samples written to the buffer. 0 means
+   *         the end of the audio.
+   */
+  using Reader = std::function<int32_t(float *samples, int32_t n)>;
+
+  // Called for each segment in the order of time
+  using Callback = std::function<void(const LongAudioSegment &segment)>;
+
+  explicit LongAudioTranscriber(const LongAudioTranscriberConfig &config);
+
+  ~LongAudioTranscriber();
+
+  /** Transcribe audio given by read().
+   *
+   * callback is called in the calling thread. Audio of a different sample
+   * rate than the one of the VAD model is resampled.
+   *
+   * Several threads can call it at the same time; they share the
+   * decoding threads.
+   */
+  void Transcribe(int32_t sample_rate, const Reader &read,
+                  const Callback &callback) const;
+
+  // Transcribe audio in memory and return all segments in the order of time
+  std::vector<LongAudioSegment> Transcribe(int32_t sample_rate,
+                                           const float *samples,
+                                           int32_t n) const;
+
+  /** Transcribe a wave file, reading it a piece at a time.
+   *
+   * @param filename It MUST be single channel, 16-bit PCM encoded.
+   * @return Return false if the file cannot be read.
+   */
+  bool TranscribeFile(const std::string &filename,
+                      const Callback &callback) const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_LONG_AUDIO_TRANSCRIBER_H_
@@ -0,0 +1,78 @@
+// sherpa-onnx/csrc/lru-cache-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/lru-cache.h"
+
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(LruCache, Evict) {
+  LruCache<std::string, int32_t> cache(2);
+
+  int32_t v = 0;
+  EXPECT_FALSE(cache.Get("a", &v));
+
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+
+  // "a" becomes the most recently used one
+  EXPECT_TRUE(cache.Get("a", &v));
+  EXPECT_EQ(v, 1);
+
+  // so "b" is evicted
+  cache.Put("c", 3);
+  EXPECT_EQ(cache.Size(), 2);
+  EXPECT_FALSE(cache.Get("b", &v));
+  EXPECT_TRUE(cache.Get("c", &v));
+  EXPECT_EQ(v, 3);
+
+  cache.Put("c", 30);
+  EXPECT_TRUE(cache.Get("c", &v));
+  EXPECT_EQ(v, 30);
+  EXPECT_EQ(cache.Size(), 2);
+
+  EXPECT_EQ(cache.NumLookups(), 5);
+  EXPECT_EQ(cache.NumHits(), 3);
+}
+
+TEST(LruCache, ZeroCapacity) {
+  LruCache<int32_t, int32_t> cache(0);
+  cache.Put(1, 1);
+
+  int32_t v = 0;
+  EXPECT_FALSE(cache.Get(1, &v));
+  EXPECT_EQ(cache.Size(), 0);
+}
+
+TEST(LruCache, Concurrent) {
+  LruCache<int32_t, std::vector<int32_t>> cache(8);
+
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t != 4; ++t) {
+    threads.emplace_back([&cache]() {
+      std::vector<int32_t> v;
+      for (int32_t i = 0; i != 1000; ++i) {
+        int32_t key = i % 13;
+        if (cache.Get(key, &v)) {
+          EXPECT_EQ(v, std::vector<int32_t>(key, key));
+        } else {
+          cache.Put(key, std::vector<int32_t>(key, key));
+        }
+      }
+    });
+  }
+
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(cache.Size(), 8);
+}
+
+}  // namespace sherpa_onnx
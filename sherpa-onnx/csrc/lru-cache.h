@@ -0,0 +1,122 @@
+// sherpa-onnx/csrc/lru-cache.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_LRU_CACHE_H_
+#define SHERPA_ONNX_CSRC_LRU_CACHE_H_
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <utility>
+
+namespace sherpa_onnx {
+
+/** A thread-safe cache that evicts the least recently used entry when full.
+ *
+ * Values are copied in and out, so the cache can be used while another
+ * thread evicts the entry.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+ public:
+  // If capacity is 0, nothing is cached.
+  explicit LruCache(int32_t capacity)
+      : capacity_(capacity > 0 ? capacity : 0) {}
+
+  LruCache(const LruCache &) = delete;
+  LruCache &operator=(const LruCache &) = delete;
+
+  /** Look up a key.
+   *
+   * @return true if the key is found. In that case, its value is copied
+   *         to value and it becomes the most recently used entry.
+   */
+  bool Get(const Key &key, Value *value) {
+    return Visit(key, [value](const Value &v) { *value = v; });
+  }
+
+  /** Look up a key and call f(value) on the cached value if it is found.
+   *
+   * It avoids copying the whole value, e.g., when only a part of it is
+   * needed. f is called with the lock held, so it must not use the cache.
+   *
+   * @return true if the key is found.
+   */
+  template <typename F>
+  bool Visit(const Key &key, F f) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++num_lookups_;
+
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+
+    ++num_hits_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    f(static_cast<const Value &>(it->second->second));
+    return true;
+  }
+
+  // Add or replace the value of a key
+  void Put(const Key &key, const Value &value) {
+    if (capacity_ == 0) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = value;
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return;
+    }
+
+    if (static_cast<int32_t>(entries_.size()) == capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+
+    entries_.emplace_front(key, value);
+    index_[key] = entries_.begin();
+  }
+
+  int32_t Capacity() const { return capacity_; }
+
+  int32_t Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int32_t>(entries_.size());
+  }
+
+  int64_t NumLookups() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_lookups_;
+  }
+
+  int64_t NumHits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_hits_;
+  }
+
+ private:
+  using Entry = std::pair<Key, Value>;
+
+  int32_t capacity_;
+
+  mutable std::mutex mutex_;
+
+  // The most recently used entry is at the front
+  std::list<Entry> entries_;
+  std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index_;
+
+  int64_t num_lookups_ = 0;
+  int64_t num_hits_ = 0;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_LRU_CACHE_H_
@@ -0,0 +1,105 @@
+// sherpa-onnx/csrc/metrics-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/metrics.h"
+
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(Metrics, Histogram) {
+  Histogram h({1, 2, 4});
+  for (double v : {0.5, 1.0, 1.5, 3.0, 10.0, 20.0}) {
+    h.Observe(v);
+  }
+
+  // Bounds are inclusive
+  EXPECT_EQ(h.BucketCount(0), 2);
+  EXPECT_EQ(h.BucketCount(1), 1);
+  EXPECT_EQ(h.BucketCount(2), 1);
+  EXPECT_EQ(h.BucketCount(3), 2);
+  EXPECT_EQ(h.Count(), 6);
+  EXPECT_DOUBLE_EQ(h.Sum(), 36);
+
+  h.Reset();
+  EXPECT_EQ(h.Count(), 0);
+  EXPECT_EQ(h.BucketCount(3), 0);
+  EXPECT_DOUBLE_EQ(h.Sum(), 0);
+}
+
+TEST(Metrics, ScopedTimer) {
+  Histogram *h = GetHistogram("metrics_test_timer_seconds", "test", {1});
+
+  EnableMetrics(false);
+  { ScopedTimer timer(h); }
+  EXPECT_EQ(h->Count(), 0);
+
+  EnableMetrics(true);
+  {
+    ScopedTimer timer(h);
+    timer.Stop();
+    timer.Stop();
+  }
+  EnableMetrics(false);
+
+  EXPECT_EQ(h->Count(), 1);
+  EXPECT_EQ(h->BucketCount(0), 1);
+}
+
+TEST(Metrics, PrometheusText) {
+  Counter *c = GetCounter("metrics_test_total", "A counter", "k=\"v\"");
+  EXPECT_EQ(c, GetCounter("metrics_test_total", "A counter", "k=\"v\""));
+
+  Histogram *h = GetHistogram("metrics_test_seconds", "A histogram", {1, 2});
+  c->Inc(3);
+  h->Observe(0.5);
+  h->Observe(5);
+
+  std::string s = MetricsToPrometheusText();
+  for (const char *line : {
+           "# HELP metrics_test_total A counter\n",
+           "# TYPE metrics_test_total counter\n",
+           "metrics_test_total{k=\"v\"} 3\n",
+           "# TYPE metrics_test_seconds histogram\n",
+           "metrics_test_seconds_bucket{le=\"1\"} 1\n",
+           "metrics_test_seconds_bucket{le=\"2\"} 1\n",
+           "metrics_test_seconds_bucket{le=\"+Inf\"} 2\n",
+           "metrics_test_seconds_sum 5.5\n",
+           "metrics_test_seconds_count 2\n",
+       }) {
+    EXPECT_NE(s.find(line), std::string::npos) << line << "\n" << s;
+  }
+
+  ResetMetrics();
+  EXPECT_EQ(c->Value(), 0);
+  EXPECT_EQ(h->Count(), 0);
+}
+
+TEST(Metrics, Concurrent) {
+  Histogram *h = GetBatchSizeHistogram("metrics_test");
+  Counter *c = GetAudioSecondsCounter("metrics_test");
+
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t != 4; ++t) {
+    threads.emplace_back([h, c]() {
+      for (int32_t i = 0; i != 1000; ++i) {
+        h->Observe(i % 8);
+        c->Inc(0.5);
+      }
+    });
+  }
+
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(h->Count(), 4000);
+  EXPECT_DOUBLE_EQ(c->Value(), 2000);
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,260 @@
+// sherpa-onnx/csrc/metrics.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <utility>
+
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+namespace internal {
+std::atomic<bool> g_metrics_enabled{false};
+}  // namespace internal
+
+void EnableMetrics(bool enabled) {
+  internal::g_metrics_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Counter::Inc(double v) {
+  double old = value_.load(std::memory_order_relaxed);
+  while (!value_.compare_exchange_weak(old, old + v,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+Histogram::Histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)),
+      counts_(new std::atomic<int64_t>[bounds_.size() + 1]) {
+  if (!std::is_sorted(bounds_.begin(), bounds_.end())) {
+    SHERPA_ONNX_LOGE("Histogram bounds must be in increasing order");
+    exit(-1);
+  }
+
+  Reset();
+}
+
+void Histogram::Observe(double v) {
+  int32_t i = std::lower_bound(bounds_.begin(), bounds_.end(), v) -
+              bounds_.begin();
+  counts_[i].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.Inc(v);
+}
+
+void Histogram::Reset() {
+  for (size_t i = 0; i <= bounds_.size(); ++i) {
+    counts_[i].store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_.Reset();
+}
+
+namespace {
+
+// All metrics with the same name
+struct Family {
+  std::string help;
+  bool is_histogram = false;
+
+  // Indexed by labels
+  std::map<std::string, std::unique_ptr<Counter>> counters;
+  std::map<std::string, std::unique_ptr<Histogram>> histograms;
+};
+
+class Registry {
+ public:
+  static Registry &Get() {
+    // Never destroyed so that metrics can be used in static destructors
+    static Registry *registry = new Registry;
+    return *registry;
+  }
+
+  Counter *GetCounter(const std::string &name, const std::string &help,
+                      const std::string &labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Family &f = GetFamily(name, help, false);
+
+    auto &p = f.counters[labels];
+    if (!p) {
+      p = std::make_unique<Counter>();
+    }
+    return p.get();
+  }
+
+  Histogram *GetHistogram(const std::string &name, const std::string &help,
+                          const std::vector<double> &bounds,
+                          const std::string &labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Family &f = GetFamily(name, help, true);
+
+    auto &p = f.histograms[labels];
+    if (!p) {
+      p = std::make_unique<Histogram>(bounds);
+    }
+    return p.get();
+  }
+
+  std::string ToPrometheusText() const {
+    std::ostringstream os;
+    os << std::setprecision(9);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &p : families_) {
+      const std::string &name = p.first;
+      const Family &f = p.second;
+
+      os << "# HELP " << name << " " << f.help << "\n";
+      os << "# TYPE " << name << " "
+         << (f.is_histogram ? "histogram" : "counter") << "\n";
+
+      for (const auto &c : f.counters) {
+        os << name << Braces(c.first) << " " << c.second->Value() << "\n";
+      }
+
+      for (const auto &h : f.histograms) {
+        WriteHistogram(name, h.first, *h.second, os);
+      }
+    }
+
+    return os.str();
+  }
+
+  void Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &p : families_) {
+      for (auto &c : p.second.counters) {
+        c.second->Reset();
+      }
+
+      for (auto &h : p.second.histograms) {
+        h.second->Reset();
+      }
+    }
+  }
+
+ private:
+  Family &GetFamily(const std::string &name, const std::string &help,
+                    bool is_histogram) {
+    auto it = families_.find(name);
+    if (it == families_.end()) {
+      Family &f = families_[name];
+      f.help = help;
+      f.is_histogram = is_histogram;
+      return f;
+    }
+
+    if (it->second.is_histogram != is_histogram) {
+      SHERPA_ONNX_LOGE("Metric %s is registered with a different type",
+                       name.c_str());
+      exit(-1);
+    }
+
+    return it->second;
+  }
+
+  static std::string Braces(const std::string &labels) {
+    return labels.empty() ? "" : "{" + labels + "}";
+  }
+
+  static void WriteHistogram(const std::string &name,
+                             const std::string &labels, const Histogram &h,
+                             std::ostream &os) {
+    std::string sep = labels.empty() ? "" : ",";
+
+    // Read the buckets first so that _count is consistent with the
+    // +Inf bucket even if other threads are observing
+    const auto &bounds = h.Bounds();
+    int64_t cumulative = 0;
+    for (size_t i = 0; i <= bounds.size(); ++i) {
+      cumulative += h.BucketCount(i);
+
+      os << name << "_bucket{" << labels << sep << "le=\"";
+      if (i == bounds.size()) {
+        os << "+Inf";
+      } else {
+        os << bounds[i];
+      }
+      os << "\"} " << cumulative << "\n";
+    }
+
+    os << name << "_sum" << Braces(labels) << " " << h.Sum() << "\n";
+    os << name << "_count" << Braces(labels) << " " << cumulative << "\n";
+  }
+
+ private:
+  mutable std::mutex mutex_;
+
+  // Sorted by name so that the output is stable
+  std::map<std::string, Family> families_;
+};
+
+std::string ComponentLabel(const std::string &component) {
+  return "component=\"" + component + "\"";
+}
+
+}  // namespace
+
+Counter *GetCounter(const std::string &name, const std::string &help,
+                    const std::string &labels /*= ""*/) {
+  return Registry::Get().GetCounter(name, help, labels);
+}
+
+Histogram *GetHistogram(const std::string &name, const std::string &help,
+                        const std::vector<double> &bounds,
+                        const std::string &labels /*= ""*/) {
+  return Registry::Get().GetHistogram(name, help, bounds, labels);
+}
+
+Histogram *GetStageHistogram(const std::string &component,
+                             const std::string &stage) {
+  return GetHistogram("sherpa_onnx_stage_seconds",
+                      "Time in seconds spent in each processing stage",
+                      LatencyBuckets(),
+                      ComponentLabel(component) + ",stage=\"" + stage + "\"");
+}
+
+Histogram *GetBatchSizeHistogram(const std::string &component) {
+  return GetHistogram("sherpa_onnx_batch_size",
+                      "Number of streams processed in one batch",
+                      BatchSizeBuckets(), ComponentLabel(component));
+}
+
+Counter *GetAudioSecondsCounter(const std::string &component) {
+  return GetCounter("sherpa_onnx_audio_seconds_total",
+                    "Seconds of audio processed", ComponentLabel(component));
+}
+
+const std::vector<double> &LatencyBuckets() {
+  static const std::vector<double> buckets = []() {
+    std::vector<double> ans;
+    for (int32_t i = 0; i != 17; ++i) {
+      ans.push_back(0.0005 * std::pow(2, i));
+    }
+    return ans;
+  }();
+
+  return buckets;
+}
+
+const std::vector<double> &BatchSizeBuckets() {
+  static const std::vector<double> buckets = {1,  2,  4,   8,  16,
+                                              32, 64, 128, 256};
+  return buckets;
+}
+
+std::string MetricsToPrometheusText() {
+  return Registry::Get().ToPrometheusText();
+}
+
+void ResetMetrics() { Registry::Get().Reset(); }
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,178 @@
+// sherpa-onnx/csrc/metrics.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_METRICS_H_
+#define SHERPA_ONNX_CSRC_METRICS_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sherpa_onnx {
+
+/* Opt-in latency and throughput metrics.
+ *
+ * Metrics are disabled by default. When disabled, a ScopedTimer costs a
+ * single relaxed atomic load and nothing is recorded.
+ *
+ * All metrics live in a process-wide registry and are exported in the
+ * Prometheus text exposition format by MetricsToPrometheusText().
+ *
+ * Usage:
+ *
+ *   EnableMetrics(true);
+ *   ...
+ *   {
+ *     static Histogram *h = GetStageHistogram("online_recognizer", "encoder");
+ *     ScopedTimer timer(h);
+ *     // run the encoder
+ *   }
+ *   ...
+ *   std::cout << MetricsToPrometheusText();
+ */
+
+namespace internal {
+extern std::atomic<bool> g_metrics_enabled;
+}  // namespace internal
+
+inline bool MetricsEnabled() {
+  return internal::g_metrics_enabled.load(std::memory_order_relaxed);
+}
+
+void EnableMetrics(bool enabled);
+
+// A monotonically increasing value
+class Counter {
+ public:
+  void Inc(double v = 1);
+
+  double Value() const { return value_.load(std::memory_order_relaxed); }
+
+  void Reset() { value_.store(0, std::memory_order_relaxed); }
+
+ private:
+  std::atomic<double> value_{0};
+};
+
+// Counts observations into buckets with fixed upper bounds
+class Histogram {
+ public:
+  // bounds are upper bounds of the buckets in increasing order. An extra
+  // +Inf bucket is added automatically.
+  explicit Histogram(std::vector<double> bounds);
+
+  void Observe(double v);
+
+  const std::vector<double> &Bounds() const { return bounds_; }
+
+  // Number of observations in bucket i, not cumulative.
+  // i == Bounds().size() is the +Inf bucket.
+  int64_t BucketCount(int32_t i) const {
+    return counts_[i].load(std::memory_order_relaxed);
+  }
+
+  int64_t Count() const { return count_.load(std::memory_order_relaxed); }
+
+  double Sum() const { return sum_.Value(); }
+
+  void Reset();
+
+ private:
+  std::vector<double> bounds_;
+  std::unique_ptr<std::atomic<int64_t>[]> counts_;
+  std::atomic<int64_t> count_{0};
+  Counter sum_;
+};
+
+/* Return the metric with the given name and labels, creating it on first use.
+ *
+ * @param name  Metric name, e.g., sherpa_onnx_stage_seconds
+ * @param help  Description shown in the HELP line. Only the first one
+ *              registered for a name is used.
+ * @param labels  Labels in the Prometheus format without braces, e.g.,
+ *                component="vad",stage="model". Can be empty.
+ *
+ * The returned pointer is valid until the program exits, so callers
+ * should cache it, e.g., in a function-local static variable.
+ */
+Counter *GetCounter(const std::string &name, const std::string &help,
+                    const std::string &labels = "");
+
+Histogram *GetHistogram(const std::string &name, const std::string &help,
+                        const std::vector<double> &bounds,
+                        const std::string &labels = "");
+
+// Time in seconds spent in a stage of a component,
+// i.e., sherpa_onnx_stage_seconds{component="...",stage="..."}
+Histogram *GetStageHistogram(const std::string &component,
+                             const std::string &stage);
+
+// Number of streams decoded in one batch,
+// i.e., sherpa_onnx_batch_size{component="..."}
+Histogram *GetBatchSizeHistogram(const std::string &component);
+
+// Seconds of audio processed, e.g., fed into the VAD or generated by TTS,
+// i.e., sherpa_onnx_audio_seconds_total{component="..."}
+Counter *GetAudioSecondsCounter(const std::string &component);
+
+// Exponential buckets from 0.5 ms to about 33 s
+const std::vector<double> &LatencyBuckets();
+
+// 1, 2, 4, ..., 256
+const std::vector<double> &BatchSizeBuckets();
+
+// Export all metrics in the Prometheus text exposition format
+std::string MetricsToPrometheusText();
+
+// Set all metrics to 0. Registered metrics are kept.
+void ResetMetrics();
+
+// Record the lifetime of this object in a histogram if metrics are enabled
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Histogram *h) : h_(MetricsEnabled() ? h : nullptr) {
+    if (h_) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~ScopedTimer() { Stop(); }
+
+  // Record the elapsed time now instead of in the destructor
+  void Stop() {
+    if (h_) {
+      auto end = std::chrono::steady_clock::now();
+      h_->Observe(std::chrono::duration<double>(end - start_).count());
+      h_ = nullptr;
+    }
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+ private:
+  Histogram *h_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Observe v in h if metrics are enabled
+inline void ObserveIfEnabled(Histogram *h, double v) {
+  if (MetricsEnabled()) {
+    h->Observe(v);
+  }
+}
+
+// Increase c by v if metrics are enabled
+inline void IncIfEnabled(Counter *c, double v) {
+  if (MetricsEnabled()) {
+    c->Inc(v);
+  }
+}
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_METRICS_H_
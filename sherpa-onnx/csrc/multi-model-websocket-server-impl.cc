@@ -0,0 +1,498 @@
+// sherpa-onnx/csrc/multi-model-websocket-server-impl.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/multi-model-websocket-server-impl.h"
+
+#include <cctype>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sherpa-onnx/csrc/log.h"
+#include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/metrics.h"
+#include "sherpa-onnx/csrc/text-utils.h"
+
+namespace sherpa_onnx {
+
+// Decode a percent-encoded component of a URL, e.g., HELLO%20WORLD
+static std::string UrlDecode(const std::string &s) {
+  std::string ans;
+  ans.reserve(s.size());
+
+  for (size_t i = 0; i < s.size(); ++i) {
+    if (s[i] == '+') {
+      ans.push_back(' ');
+    } else if (s[i] == '%' && i + 2 < s.size() && std::isxdigit(s[i + 1]) &&
+               std::isxdigit(s[i + 2])) {
+      ans.push_back(static_cast<char>(std::stoi(s.substr(i + 1, 2), nullptr,
+                                                /*base*/ 16)));
+      i += 2;
+    } else {
+      ans.push_back(s[i]);
+    }
+  }
+
+  return ans;
+}
+
+// Parse the query string of a resource, e.g., /?model=en&language=en
+static std::map<std::string, std::string> ParseQuery(
+    const std::string &resource) {
+  std::map<std::string, std::string> ans;
+
+  auto pos = resource.find('?');
+  if (pos == std::string::npos) {
+    return ans;
+  }
+
+  std::vector<std::string> pairs;
+  SplitStringToVector(resource.substr(pos + 1), "&", true, &pairs);
+
+  for (const auto &p : pairs) {
+    auto eq = p.find('=');
+    if (eq == std::string::npos) {
+      ans[UrlDecode(p)] = "";
+    } else {
+      ans[UrlDecode(p.substr(0, eq))] = UrlDecode(p.substr(eq + 1));
+    }
+  }
+
+  return ans;
+}
+
+void WebsocketModelInfo::Register(ParseOptions *po) {
+  po->Register("name", &name,
+               "Name of the model. Clients select it with ?model=name");
+
+  po->Register("language", &language,
+               "Language of the model. Clients can select the first model "
+               "of a language with ?language=xx");
+
+  po->Register("weight", &weight,
+               "Share of the work threads the model gets when all models "
+               "are busy");
+}
+
+void WebsocketModelInfo::Validate() const {
+  if (name.empty()) {
+    SHERPA_ONNX_LOGE("Please provide --name for each model");
+    exit(-1);
+  }
+
+  if (weight <= 0) {
+    SHERPA_ONNX_LOGE("--weight of model '%s' should be positive. Given: %.3f",
+                     name.c_str(), weight);
+    exit(-1);
+  }
+}
+
+void MultiModelWebsocketServerConfig::Register(ParseOptions *po) {
+  po->Register("online-models", &online_models,
+               "Comma-separated list of config files of streaming models. "
+               "Each file contains the options of a model, one per line, "
+               "e.g., --name=en --language=en --weight=1 --tokens=... "
+               "--encoder=... --max-batch-size=5");
+
+  po->Register("offline-models", &offline_models,
+               "Comma-separated list of config files of non-streaming "
+               "models. See also --online-models");
+
+  po->Register("default-model", &default_model,
+               "Name of the model used if a client selects neither a model "
+               "nor a language. If empty, the first model is used");
+
+  po->Register("log-file", &log_file,
+               "Path to the log file. Logs are "
+               "appended to this file");
+
+  po->Register("num-work-threads", &num_work_threads,
+               "Thread pool size for neural network computation and "
+               "decoding. It is shared by all models. If it is greater "
+               "than 1, --num-threads of each model is set to 1 to avoid "
+               "oversubscribing the CPU.");
+
+  po->Register("enable-metrics", &enable_metrics,
+               "true to collect per-stage latency and throughput metrics "
+               "and serve them in the Prometheus text format at /metrics");
+
+  po->Register("max-active-streams", &max_active_streams,
+               "Maximum number of concurrent connections of all models. "
+               "New connections beyond it are closed with code 1013 "
+               "(try again later). 0 means no limit.");
+}
+
+void MultiModelWebsocketServerConfig::Validate() const {
+  if (online_models.empty() && offline_models.empty()) {
+    SHERPA_ONNX_LOGE("Please provide --online-models or --offline-models");
+    exit(-1);
+  }
+
+  SHERPA_ONNX_CHECK_GE(num_work_threads, 1);
+  SHERPA_ONNX_CHECK_GE(max_active_streams, 0);
+}
+
+// Each ONNX Runtime session has its own intra-op thread pool. With
+// several work threads running models in parallel, num_work_threads *
+// num_threads threads would compete for the CPU.
+static void LimitNumThreads(const std::string &name,
+                            int32_t num_work_threads,
+                            int32_t *num_threads) {
+  if (num_work_threads > 1 && *num_threads > 1) {
+    SHERPA_ONNX_LOGE(
+        "Model '%s': use --num-threads=1 instead of %d since there are %d "
+        "work threads",
+        name.c_str(), *num_threads, num_work_threads);
+    *num_threads = 1;
+  }
+}
+
+WebsocketModel::WebsocketModel(MultiModelWebsocketServer *server,
+                               const WebsocketModelInfo &info, int32_t queue)
+    : server_(server), info_(info), queue_(queue) {}
+
+server &WebsocketModel::GetServer() { return server_->GetServer(); }
+
+asio::io_context &WebsocketModel::GetConnectionContext() {
+  return server_->GetConnectionContext();
+}
+
+asio::io_context &WebsocketModel::GetWorkContext() {
+  return server_->GetWorkContext();
+}
+
+void WebsocketModel::PostWork(std::function<void()> f) {
+  server_->PostWork(queue_, std::move(f));
+}
+
+bool WebsocketModel::Contains(connection_hdl hdl) const {
+  return server_->Contains(hdl);
+}
+
+MultiModelWebsocketServer::MultiModelWebsocketServer(
+    asio::io_context &io_conn,  // NOLINT
+    asio::io_context &io_work,  // NOLINT
+    const MultiModelWebsocketServerConfig &config)
+    : config_(config),
+      io_conn_(io_conn),
+      io_work_(io_work),
+      log_(config.log_file, std::ios::app),
+      tee_(std::cout, log_) {
+  SetupLog();
+
+  if (config.enable_metrics) {
+    EnableMetrics(true);
+  }
+
+  LoadModels(config_.online_models, true);
+  LoadModels(config_.offline_models, false);
+
+  std::set<std::string> names;
+  for (const auto &m : models_) {
+    const std::string &name = m->GetInfo().name;
+    if (names.count(name)) {
+      SHERPA_ONNX_LOGE("Duplicate model name: '%s'", name.c_str());
+      exit(-1);
+    }
+    names.insert(name);
+
+    if (name == config_.default_model) {
+      default_model_ = m.get();
+    }
+  }
+
+  if (config_.default_model.empty()) {
+    default_model_ = models_[0].get();
+  } else if (!default_model_) {
+    SHERPA_ONNX_LOGE("Unknown --default-model: '%s'",
+                     config_.default_model.c_str());
+    exit(-1);
+  }
+
+  server_.init_asio(&io_conn_);
+
+  server_.set_validate_handler(
+      [this](connection_hdl hdl) { return OnValidate(hdl); });
+
+  server_.set_open_handler([this](connection_hdl hdl) { OnOpen(hdl); });
+
+  server_.set_close_handler([this](connection_hdl hdl) { OnClose(hdl); });
+
+  server_.set_http_handler([this](connection_hdl hdl) { OnHttp(hdl); });
+
+  server_.set_message_handler(
+      [this](connection_hdl hdl, server::message_ptr msg) {
+        OnMessage(hdl, msg);
+      });
+}
+
+void MultiModelWebsocketServer::LoadModels(const std::string &filenames,
+                                           bool online) {
+  std::vector<std::string> files;
+  SplitStringToVector(filenames, ",", false, &files);
+
+  for (const auto &f : files) {
+    ParseOptions po("");
+
+    WebsocketModelInfo info;
+    info.Register(&po);
+    info.online = online;
+
+    OnlineWebsocketDecoderConfig online_config;
+    OfflineWebsocketDecoderConfig offline_config;
+    if (online) {
+      online_config.Register(&po);
+    } else {
+      offline_config.Register(&po);
+      po.DisableOption("sample-rate");
+    }
+
+    po.ReadConfigFile(f);
+    info.Validate();
+
+    int32_t n = config_.num_work_threads;
+    if (online) {
+      auto &model_config = online_config.recognizer_config.model_config;
+      LimitNumThreads(info.name, n, &model_config.num_threads);
+    } else {
+      auto &model_config = offline_config.recognizer_config.model_config;
+      LimitNumThreads(info.name, n, &model_config.num_threads);
+      LimitNumThreads(info.name, n, &offline_config.vad_config.num_threads);
+    }
+
+    auto m = std::make_unique<WebsocketModel>(this, info,
+                                              scheduler_.AddQueue(info.weight));
+    if (online) {
+      online_config.Validate();
+      m->online_decoder =
+          std::make_unique<OnlineWebsocketDecoder>(online_config, m.get());
+
+      m->warm_up = online_config.recognizer_config.model_config.warm_up;
+      m->model_type = online_config.recognizer_config.model_config.model_type;
+    } else {
+      offline_config.Validate();
+      m->offline_decoder =
+          std::make_unique<OfflineWebsocketDecoder>(offline_config, m.get());
+    }
+
+    SHERPA_ONNX_LOGE("Loaded %s model '%s' from %s",
+                     online ? "online" : "offline", info.name.c_str(),
+                     f.c_str());
+
+    models_.push_back(std::move(m));
+  }
+}
+
+void MultiModelWebsocketServer::Run(uint16_t port) {
+  server_.set_reuse_addr(true);
+  server_.listen(asio::ip::tcp::v4(), port);
+  server_.start_accept();
+
+  for (auto &m : models_) {
+    if (!m->online_decoder) {
+      continue;
+    }
+
+    if (m->warm_up > 0) {
+      if (m->model_type == "zipformer2") {
+        m->online_decoder->Warmup();
+        SHERPA_ONNX_LOGE("Warm up of '%s' completed : %d times.",
+                         m->GetInfo().name.c_str(), m->warm_up);
+      } else {
+        SHERPA_ONNX_LOGE("Only Zipformer2 has warmup support for now. "
+                         "Skip warm up of '%s'",
+                         m->GetInfo().name.c_str());
+      }
+    }
+
+    m->online_decoder->Run();
+  }
+}
+
+void MultiModelWebsocketServer::SetupLog() {
+  server_.clear_access_channels(websocketpp::log::alevel::all);
+
+  // So that it also prints to std::cout and std::cerr
+  server_.get_alog().set_ostream(&tee_);
+  server_.get_elog().set_ostream(&tee_);
+}
+
+bool MultiModelWebsocketServer::Contains(connection_hdl hdl) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return connections_.count(hdl);
+}
+
+void MultiModelWebsocketServer::PostWork(int32_t queue,
+                                         std::function<void()> f) {
+  scheduler_.Push(queue, std::move(f));
+
+  // It may run a task of another queue if that queue has priority
+  asio::post(io_work_, [this]() { scheduler_.RunOne(); });
+}
+
+WebsocketModel *MultiModelWebsocketServer::Route(
+    const std::string &resource, std::string *hotwords) const {
+  auto query = ParseQuery(resource);
+
+  auto it = query.find("hotwords");
+  *hotwords = it != query.end() ? it->second : "";
+
+  it = query.find("model");
+  if (it != query.end()) {
+    for (const auto &m : models_) {
+      if (m->GetInfo().name == it->second) {
+        return m.get();
+      }
+    }
+    return nullptr;
+  }
+
+  auto language = query.find("language");
+  auto type = query.find("type");
+  if (language == query.end() && type == query.end()) {
+    return default_model_;
+  }
+
+  for (const auto &m : models_) {
+    const auto &info = m->GetInfo();
+    if (language != query.end() && info.language != language->second) {
+      continue;
+    }
+
+    if (type != query.end() &&
+        (info.online ? "online" : "offline") != type->second) {
+      continue;
+    }
+
+    return m.get();
+  }
+
+  return nullptr;
+}
+
+bool MultiModelWebsocketServer::OnValidate(connection_hdl hdl) {
+  server::connection_ptr con = server_.get_con_from_hdl(hdl);
+
+  std::string hotwords;
+  if (!Route(con->get_resource(), &hotwords)) {
+    con->set_status(websocketpp::http::status_code::not_found);
+    con->set_body("No model matches " + con->get_resource() +
+                  ". See /models for available models.");
+    return false;
+  }
+
+  return true;
+}
+
+void MultiModelWebsocketServer::OnOpen(connection_hdl hdl) {
+  server::connection_ptr con = server_.get_con_from_hdl(hdl);
+
+  // It is not null since it is checked in OnValidate()
+  std::string hotwords;
+  WebsocketModel *model = Route(con->get_resource(), &hotwords);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (config_.max_active_streams > 0 &&
+      static_cast<int32_t>(connections_.size()) >=
+          config_.max_active_streams) {
+    lock.unlock();
+
+    model->Close(hdl, websocketpp::close::status::try_again_later,
+                 "Too many active streams");
+    return;
+  }
+
+  ConnectionState state;
+  state.model = model;
+  if (model->offline_decoder) {
+    state.data = std::make_shared<ConnectionData>();
+    state.data->hotwords = hotwords;
+  }
+  connections_.emplace(hdl, state);
+
+  std::ostringstream os;
+  os << "New connection: " << con->get_remote_endpoint() << " for model '"
+     << model->GetInfo().name << "'. "
+     << "Number of active connections: " << connections_.size() << ".\n";
+  SHERPA_ONNX_LOG(INFO) << os.str();
+  lock.unlock();
+
+  if (model->online_decoder) {
+    model->online_decoder->GetOrCreateConnection(hdl, hotwords);
+  }
+}
+
+void MultiModelWebsocketServer::OnClose(connection_hdl hdl) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  connections_.erase(hdl);
+
+  SHERPA_ONNX_LOG(INFO) << "Number of active connections: "
+                        << connections_.size() << "\n";
+}
+
+std::string MultiModelWebsocketServer::ModelsAsJson() const {
+  std::ostringstream os;
+  os << "{\"models\": [";
+  std::string sep;
+  for (const auto &m : models_) {
+    const auto &info = m->GetInfo();
+    os << sep << "{\"name\": \"" << info.name << "\", "
+       << "\"type\": \"" << (info.online ? "online" : "offline") << "\", "
+       << "\"language\": \"" << info.language << "\", "
+       << "\"weight\": " << info.weight << ", "
+       << "\"default\": " << (m.get() == default_model_ ? "true" : "false")
+       << "}";
+    sep = ", ";
+  }
+  os << "]}";
+
+  return os.str();
+}
+
+void MultiModelWebsocketServer::OnHttp(connection_hdl hdl) {
+  server::connection_ptr con = server_.get_con_from_hdl(hdl);
+
+  const std::string &resource = con->get_resource();
+  bool is_get = con->get_request().get_method() == "GET";
+
+  if (is_get && resource == "/models") {
+    con->replace_header("Content-Type", "application/json");
+    con->set_body(ModelsAsJson());
+    con->set_status(websocketpp::http::status_code::ok);
+    return;
+  }
+
+  if (is_get && resource == "/metrics" && config_.enable_metrics) {
+    con->replace_header("Content-Type", "text/plain; version=0.0.4");
+    con->set_body(MetricsToPrometheusText());
+    con->set_status(websocketpp::http::status_code::ok);
+    return;
+  }
+
+  con->set_status(websocketpp::http::status_code::not_found);
+  con->set_body("Not found");
+}
+
+void MultiModelWebsocketServer::OnMessage(connection_hdl hdl,
+                                          server::message_ptr msg) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = connections_.find(hdl);
+  if (it == connections_.end()) {
+    // It is rejected in OnOpen() and is being closed
+    return;
+  }
+
+  ConnectionState state = it->second;
+  lock.unlock();
+
+  if (state.model->online_decoder) {
+    state.model->online_decoder->OnMessage(hdl, msg);
+  } else {
+    state.model->offline_decoder->OnMessage(hdl, state.data, msg);
+  }
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,217 @@
+// sherpa-onnx/csrc/multi-model-websocket-server-impl.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_MULTI_MODEL_WEBSOCKET_SERVER_IMPL_H_
+#define SHERPA_ONNX_CSRC_MULTI_MODEL_WEBSOCKET_SERVER_IMPL_H_
+
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "sherpa-onnx/csrc/offline-websocket-server-impl.h"
+#include "sherpa-onnx/csrc/online-websocket-server-impl.h"
+#include "sherpa-onnx/csrc/parse-options.h"
+#include "sherpa-onnx/csrc/tee-stream.h"
+#include "sherpa-onnx/csrc/websocket-decoder-host.h"
+#include "sherpa-onnx/csrc/weighted-fair-scheduler.h"
+
+namespace sherpa_onnx {
+
+// Options of a model in the multi-model server besides its decoder config.
+// They are given in the config file of the model.
+struct WebsocketModelInfo {
+  // Clients select the model by name with ?model=name
+  std::string name;
+
+  // Clients can also select the model by language with ?language=xx
+  std::string language;
+
+  // Share of the work threads the model gets when all models are busy
+  float weight = 1;
+
+  // Set by the server. Not read from the config file.
+  bool online = true;
+
+  void Register(ParseOptions *po);
+  void Validate() const;
+};
+
+struct MultiModelWebsocketServerConfig {
+  // Comma-separated lists of config files, one per model. Each file
+  // contains the options of WebsocketModelInfo and of
+  // OnlineWebsocketDecoderConfig or OfflineWebsocketDecoderConfig, e.g.,
+  //
+  //   --name=en
+  //   --language=en
+  //   --weight=2
+  //   --tokens=/path/to/tokens.txt
+  //   --encoder=/path/to/encoder.onnx
+  //   ...
+  std::string online_models;
+  std::string offline_models;
+
+  // Model used if a client selects neither a model nor a language.
+  // If empty, the first model is used.
+  std::string default_model;
+
+  std::string log_file = "./log.txt";
+
+  // Size of the thread pool for neural network computation and decoding.
+  // It is shared by all models. If it is greater than 1, --num-threads of
+  // each model is set to 1 since models run in parallel in the pool.
+  int32_t num_work_threads = 3;
+
+  // If true, per-stage latency and throughput metrics are collected
+  // and served at http://host:port/metrics
+  bool enable_metrics = false;
+
+  // Maximum number of concurrent connections of all models.
+  // 0 means no limit.
+  int32_t max_active_streams = 0;
+
+  void Register(ParseOptions *po);
+  void Validate() const;
+};
+
+class MultiModelWebsocketServer;
+
+// A model hosted by MultiModelWebsocketServer.
+//
+// It forwards everything to the server except that its work is put into
+// its own queue of the scheduler.
+class WebsocketModel : public WebsocketDecoderHost {
+ public:
+  WebsocketModel(MultiModelWebsocketServer *server,
+                 const WebsocketModelInfo &info, int32_t queue);
+
+  server &GetServer() override;
+  asio::io_context &GetConnectionContext() override;
+  asio::io_context &GetWorkContext() override;
+  void PostWork(std::function<void()> f) override;
+  bool Contains(connection_hdl hdl) const override;
+
+  const WebsocketModelInfo &GetInfo() const { return info_; }
+
+  // Exactly one of them is not null
+  std::unique_ptr<OnlineWebsocketDecoder> online_decoder;
+  std::unique_ptr<OfflineWebsocketDecoder> offline_decoder;
+
+  // Used only by online models for warm up
+  int32_t warm_up = 0;
+  std::string model_type;
+
+ private:
+  MultiModelWebsocketServer *server_;  // not owned
+  WebsocketModelInfo info_;
+
+  // Index of the queue in the scheduler of the server
+  int32_t queue_;
+};
+
+/* A websocket server hosting several online and offline models.
+ *
+ * All models share the same port and the same pool of work threads. Work
+ * of different models is scheduled in proportion to their weights; see
+ * WeightedFairScheduler. Each model batches its own streams.
+ *
+ * A client selects the model when it connects by query parameters of
+ * the URL, e.g.,
+ *
+ *   ws://host:port/?model=zh-en
+ *   ws://host:port/?language=de&hotwords=HELLO%20WORLD/GOOD%20MORNING
+ *
+ *   - model: Name of the model
+ *   - language: Use the first model of this language
+ *   - type: online or offline. Use the first model of this type. It can
+ *           be combined with language.
+ *   - hotwords: Hotwords of the stream separated by /. Requires a model
+ *               that supports hotwords, e.g., transducer models with
+ *               modified_beam_search.
+ *
+ * If none of model, language and type is given, the default model is used.
+ * A connection that selects an unknown model is rejected with HTTP 404.
+ *
+ * After that, the protocol is the one of OnlineWebsocketServer or
+ * OfflineWebsocketServer depending on the type of the selected model.
+ *
+ * GET /models returns the list of models in JSON.
+ */
+class MultiModelWebsocketServer {
+ public:
+  MultiModelWebsocketServer(asio::io_context &io_conn,  // NOLINT
+                            asio::io_context &io_work,  // NOLINT
+                            const MultiModelWebsocketServerConfig &config);
+
+  void Run(uint16_t port);
+
+  asio::io_context &GetConnectionContext() { return io_conn_; }
+  asio::io_context &GetWorkContext() { return io_work_; }
+  server &GetServer() { return server_; }
+
+  bool Contains(connection_hdl hdl) const;
+
+  // Run f in a work thread when it is the turn of the given queue
+  void PostWork(int32_t queue, std::function<void()> f);
+
+ private:
+  void SetupLog();
+
+  void LoadModels(const std::string &filenames, bool online);
+
+  /* Select a model given the resource of the request, e.g.,
+   * /?model=en&hotwords=HELLO
+   *
+   * @param resource The requested resource
+   * @param hotwords On return, it contains the hotwords for the stream.
+   * @return Return nullptr if no model matches.
+   */
+  WebsocketModel *Route(const std::string &resource,
+                        std::string *hotwords) const;
+
+  // Reject the websocket handshake if the requested model does not exist
+  bool OnValidate(connection_hdl hdl);
+
+  void OnOpen(connection_hdl hdl);
+
+  void OnClose(connection_hdl hdl);
+
+  // Only GET /metrics and GET /models are supported.
+  void OnHttp(connection_hdl hdl);
+
+  void OnMessage(connection_hdl hdl, server::message_ptr msg);
+
+  std::string ModelsAsJson() const;
+
+ private:
+  struct ConnectionState {
+    WebsocketModel *model = nullptr;  // not owned
+
+    // Used only by offline models
+    ConnectionDataPtr data;
+  };
+
+  MultiModelWebsocketServerConfig config_;
+  asio::io_context &io_conn_;
+  asio::io_context &io_work_;
+  server server_;
+
+  std::ofstream log_;
+  TeeStream tee_;
+
+  WeightedFairScheduler scheduler_;
+  std::vector<std::unique_ptr<WebsocketModel>> models_;
+  WebsocketModel *default_model_ = nullptr;  // not owned
+
+  mutable std::mutex mutex_;
+  std::map<connection_hdl, ConnectionState, std::owner_less<connection_hdl>>
+      connections_;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_MULTI_MODEL_WEBSOCKET_SERVER_IMPL_H_
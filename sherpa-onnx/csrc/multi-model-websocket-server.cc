@@ -0,0 +1,133 @@
+// sherpa-onnx/csrc/multi-model-websocket-server.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "asio.hpp"
+#include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/multi-model-websocket-server-impl.h"
+#include "sherpa-onnx/csrc/parse-options.h"
+
+static constexpr const char *kUsageMessage = R"(
+Automatic speech recognition with several models in a single process
+using websocket.
+
+All models share the same port and the same pool of work threads.
+
+Usage:
+
+./bin/sherpa-onnx-multi-model-websocket-server --help
+
+./bin/sherpa-onnx-multi-model-websocket-server \
+  --port=6006 \
+  --num-work-threads=8 \
+  --online-models=./en.conf,./zh.conf \
+  --offline-models=./en-offline.conf \
+  --default-model=en \
+  --log-file=./log.txt
+
+where ./en.conf contains the options of a streaming model, one per line,
+e.g.,
+
+  --name=en
+  --language=en
+  --weight=2
+  --tokens=/path/to/tokens.txt
+  --encoder=/path/to/encoder.onnx
+  --decoder=/path/to/decoder.onnx
+  --joiner=/path/to/joiner.onnx
+  --num-threads=1
+  --max-batch-size=8
+
+and ./en-offline.conf contains the options of a non-streaming model in
+the same way. All options of sherpa-onnx-online-websocket-server and
+sherpa-onnx-offline-websocket-server about models and batching are supported.
+
+Since work threads are shared by all models and each of them can run a
+model, --num-threads in the model configs is set to 1 if
+--num-work-threads is greater than 1. Otherwise the threads of the models
+would oversubscribe the CPU. Use --num-work-threads=1 to let a single
+model use several threads.
+
+Clients select a model by query parameters of the URL, e.g.,
+
+  ws://127.0.0.1:6006/?model=zh
+  ws://127.0.0.1:6006/?language=en&type=offline
+  ws://127.0.0.1:6006/?model=en&hotwords=HELLO%20WORLD/GOOD%20MORNING
+
+The list of models is available at http://127.0.0.1:6006/models
+
+Please refer to
+https://k2-fsa.github.io/sherpa/onnx/pretrained_models/index.html
+for a list of pre-trained models to download.
+)";
+
+int32_t main(int32_t argc, char *argv[]) {
+  sherpa_onnx::ParseOptions po(kUsageMessage);
+
+  sherpa_onnx::MultiModelWebsocketServerConfig config;
+
+  // the server will listen on this port
+  int32_t port = 6006;
+
+  // size of the thread pool for handling network connections
+  int32_t num_io_threads = 1;
+
+  po.Register("num-io-threads", &num_io_threads,
+              "Thread pool size for network connections.");
+
+  po.Register("port", &port, "The port on which the server will listen.");
+
+  config.Register(&po);
+
+  if (argc == 1) {
+    po.PrintUsage();
+    exit(EXIT_FAILURE);
+  }
+
+  po.Read(argc, argv);
+
+  if (po.NumArgs() != 0) {
+    SHERPA_ONNX_LOGE("Unrecognized positional arguments!");
+    po.PrintUsage();
+    exit(EXIT_FAILURE);
+  }
+
+  config.Validate();
+
+  asio::io_context io_conn;  // for network connections
+  asio::io_context io_work;  // for neural network and decoding
+
+  sherpa_onnx::MultiModelWebsocketServer server(io_conn, io_work, config);
+  server.Run(port);
+
+  SHERPA_ONNX_LOGE("Started!");
+  SHERPA_ONNX_LOGE("Listening on: %d", port);
+  SHERPA_ONNX_LOGE("Number of work threads: %d", config.num_work_threads);
+
+  // give some work to do for the io_work pool
+  auto work_guard = asio::make_work_guard(io_work);
+
+  std::vector<std::thread> io_threads;
+
+  // decrement since the main thread is also used for network communications
+  for (int32_t i = 0; i < num_io_threads - 1; ++i) {
+    io_threads.emplace_back([&io_conn]() { io_conn.run(); });
+  }
+
+  std::vector<std::thread> work_threads;
+  for (int32_t i = 0; i < config.num_work_threads; ++i) {
+    work_threads.emplace_back([&io_work]() { io_work.run(); });
+  }
+
+  io_conn.run();
+
+  for (auto &t : io_threads) {
+    t.join();
+  }
+
+  for (auto &t : work_threads) {
+    t.join();
+  }
+
+  return 0;
+}
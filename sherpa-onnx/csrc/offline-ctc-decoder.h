@@ -11,6 +11,26 @@
 
 namespace sherpa_onnx {
 
+/// A hypothesis in the N-best list of OfflineCtcFstDecoder
+struct OfflineCtcHypothesis {
+  /// The decoded token IDs
+  std::vector<int64_t> tokens;
+
+  /// timestamps[i] contains the output frame index where tokens[i] is decoded.
+  /// Note: The index is after subsampling
+  std::vector<int32_t> timestamps;
+
+  /// Non-epsilon output labels of the decoding graph, e.g., word IDs
+  /// for HLG.fst
+  std::vector<int32_t> words;
+
+  /// Negated sum of the log_probs of the frames on the path
+  float acoustic_cost = 0;
+
+  /// Sum of the graph weights on the path, including the final weight
+  float graph_cost = 0;
+};
+
 struct OfflineCtcDecoderResult {
   /// The decoded token IDs
   std::vector<int64_t> tokens;
@@ -18,6 +38,10 @@ struct OfflineCtcDecoderResult {
   /// timestamps[i] contains the output frame index where tokens[i] is decoded.
   /// Note: The index is after subsampling
   std::vector<int32_t> timestamps;
+
+  /// Hypotheses sorted by cost, best first. tokens and timestamps above are
+  /// from nbest[0]. It is empty unless decoding with a graph and nbest > 1.
+  std::vector<OfflineCtcHypothesis> nbest;
 };
 
 class OfflineCtcDecoder {
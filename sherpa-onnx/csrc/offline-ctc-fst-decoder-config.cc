@@ -17,7 +17,9 @@ std::string OfflineCtcFstDecoderConfig::ToString() const {
 
   os << "OfflineCtcFstDecoderConfig(";
   os << "graph=\"" << graph << "\", ";
-  os << "max_active=" << max_active << ")";
+  os << "max_active=" << max_active << ", ";
+  os << "nbest=" << nbest << ", ";
+  os << "lattice_beam=" << lattice_beam << ")";
 
   return os.str();
 }
@@ -30,6 +32,17 @@ void OfflineCtcFstDecoderConfig::Register(ParseOptions *po) {
 
   p.Register("max-active", &max_active,
              "Decoder max active states.  Larger->slower; more accurate");
+
+  p.Register("nbest", &nbest,
+             "If larger than 1, also output up to this number of hypotheses "
+             "with distinct output label sequences and their acoustic and "
+             "graph costs for rescoring. They are produced in the same "
+             "search pass.");
+
+  p.Register("lattice-beam", &lattice_beam,
+             "Used only when nbest > 1. Hypotheses whose cost exceeds the "
+             "best one by more than this value are pruned during the "
+             "search and are not in the N-best list.");
 }
 
 bool OfflineCtcFstDecoderConfig::Validate() const {
@@ -37,6 +50,18 @@ bool OfflineCtcFstDecoderConfig::Validate() const {
     SHERPA_ONNX_LOGE("graph: '%s' does not exist", graph.c_str());
     return false;
   }
+
+  if (nbest < 1) {
+    SHERPA_ONNX_LOGE("--ctc.nbest should be positive. Given: %d", nbest);
+    return false;
+  }
+
+  if (lattice_beam <= 0) {
+    SHERPA_ONNX_LOGE("--ctc.lattice-beam should be positive. Given: %f",
+                     lattice_beam);
+    return false;
+  }
+
   return true;
 }
 
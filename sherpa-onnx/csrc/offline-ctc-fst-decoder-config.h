@@ -16,6 +16,15 @@ struct OfflineCtcFstDecoderConfig {
   std::string graph;
   int32_t max_active = 3000;
 
+  // If larger than 1, up to this number of alternative hypotheses with
+  // distinct output label sequences are kept for each utterance.
+  int32_t nbest = 1;
+
+  // Hypotheses whose cost exceeds that of the best one by more than
+  // this value are pruned during the search and are not included in the
+  // N-best list.
+  float lattice_beam = 8.0;
+
   OfflineCtcFstDecoderConfig() = default;
 
   OfflineCtcFstDecoderConfig(const std::string &graph, int32_t max_active)
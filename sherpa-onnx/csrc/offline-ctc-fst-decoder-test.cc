@@ -0,0 +1,146 @@
+// sherpa-onnx/csrc/offline-ctc-fst-decoder-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/offline-ctc-fst-decoder.h"
+
+#include <array>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fst/fstlib.h"
+#include "gtest/gtest.h"
+#include "sherpa-onnx/csrc/onnx-utils.h"
+
+namespace sherpa_onnx {
+
+static const char kGraph[] = "/tmp/sherpa-onnx-offline-ctc-fst-decoder.fst";
+
+// Tokens: 0 is blank, 1 is a, 2 is b. Input labels of the graph are
+// token IDs plus 1.
+//
+// It accepts either word 1 spelled "a" or word 2 spelled "b", which has
+// a graph cost of 1. Both words end in the final state 3.
+static void WriteGraph() {
+  fst::StdVectorFst graph;
+  for (int32_t i = 0; i != 4; ++i) {
+    graph.AddState();
+  }
+  graph.SetStart(0);
+  graph.SetFinal(3, fst::TropicalWeight::One());
+
+  graph.AddArc(0, fst::StdArc(1, 0, 0, 0));  // blank
+  graph.AddArc(0, fst::StdArc(2, 1, 0, 1));  // a, word 1
+  graph.AddArc(0, fst::StdArc(3, 2, 1, 2));  // b, word 2
+
+  graph.AddArc(1, fst::StdArc(1, 0, 0, 1));
+  graph.AddArc(1, fst::StdArc(2, 0, 0, 1));
+  graph.AddArc(1, fst::StdArc(0, 0, 0, 3));
+
+  graph.AddArc(2, fst::StdArc(1, 0, 0, 2));
+  graph.AddArc(2, fst::StdArc(3, 0, 0, 2));
+  graph.AddArc(2, fst::StdArc(0, 0, 0, 3));
+
+  ASSERT_TRUE(graph.Write(kGraph));
+}
+
+// probs[t][i] is the probability of token i at frame t
+static std::vector<OfflineCtcDecoderResult> Decode(
+    const OfflineCtcFstDecoderConfig &config,
+    const std::vector<std::array<float, 3>> &probs) {
+  Ort::AllocatorWithDefaultOptions allocator;
+
+  int32_t num_frames = static_cast<int32_t>(probs.size());
+
+  std::array<int64_t, 3> shape{1, num_frames, 3};
+  Ort::Value log_probs = Ort::Value::CreateTensor<float>(
+      allocator, shape.data(), shape.size());
+
+  float *p = log_probs.GetTensorMutableData<float>();
+  for (const auto &frame : probs) {
+    for (auto prob : frame) {
+      *p++ = std::log(prob);
+    }
+  }
+
+  std::array<int64_t, 1> length_shape{1};
+  Ort::Value length = Ort::Value::CreateTensor<int64_t>(
+      allocator, length_shape.data(), length_shape.size());
+  length.GetTensorMutableData<int64_t>()[0] = num_frames;
+
+  OfflineCtcFstDecoder decoder(config);
+  return decoder.Decode(std::move(log_probs), std::move(length));
+}
+
+static const std::vector<std::array<float, 3>> kProbs = {
+    {0.1, 0.6, 0.3},
+    {0.8, 0.1, 0.1},
+};
+
+TEST(OfflineCtcFstDecoder, OneBest) {
+  WriteGraph();
+
+  OfflineCtcFstDecoderConfig config(kGraph, 3000);
+  auto results = Decode(config, kProbs);
+
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_EQ(results[0].tokens, (std::vector<int64_t>{1}));
+  EXPECT_EQ(results[0].timestamps, (std::vector<int32_t>{0}));
+  EXPECT_TRUE(results[0].nbest.empty());
+}
+
+TEST(OfflineCtcFstDecoder, Nbest) {
+  WriteGraph();
+
+  OfflineCtcFstDecoderConfig config(kGraph, 3000);
+  config.nbest = 3;
+  auto results = Decode(config, kProbs);
+
+  ASSERT_EQ(results.size(), 1);
+
+  // Only two word sequences are accepted by the graph
+  const auto &nbest = results[0].nbest;
+  ASSERT_EQ(nbest.size(), 2);
+
+  // The best path of word 1 is "a blank"
+  EXPECT_EQ(nbest[0].tokens, (std::vector<int64_t>{1}));
+  EXPECT_EQ(nbest[0].timestamps, (std::vector<int32_t>{0}));
+  EXPECT_EQ(nbest[0].words, (std::vector<int32_t>{1}));
+  EXPECT_NEAR(nbest[0].acoustic_cost, -std::log(0.6f) - std::log(0.8f),
+              1e-4);
+  EXPECT_NEAR(nbest[0].graph_cost, 0, 1e-4);
+
+  // The best path of word 2 is "b blank"
+  EXPECT_EQ(nbest[1].tokens, (std::vector<int64_t>{2}));
+  EXPECT_EQ(nbest[1].timestamps, (std::vector<int32_t>{0}));
+  EXPECT_EQ(nbest[1].words, (std::vector<int32_t>{2}));
+  EXPECT_NEAR(nbest[1].acoustic_cost, -std::log(0.3f) - std::log(0.8f),
+              1e-4);
+  EXPECT_NEAR(nbest[1].graph_cost, 1, 1e-4);
+
+  EXPECT_EQ(results[0].tokens, nbest[0].tokens);
+  EXPECT_EQ(results[0].timestamps, nbest[0].timestamps);
+}
+
+TEST(OfflineCtcFstDecoder, LatticeBeam) {
+  WriteGraph();
+
+  OfflineCtcFstDecoderConfig config(kGraph, 3000);
+  config.nbest = 3;
+
+  // The total cost of word 2 exceeds that of word 1 by about 1.69
+  config.lattice_beam = 1;
+  auto results = Decode(config, kProbs);
+  ASSERT_EQ(results.size(), 1);
+  ASSERT_EQ(results[0].nbest.size(), 1);
+  EXPECT_EQ(results[0].nbest[0].words, (std::vector<int32_t>{1}));
+
+  config.lattice_beam = 2;
+  results = Decode(config, kProbs);
+  ASSERT_EQ(results.size(), 1);
+  ASSERT_EQ(results[0].nbest.size(), 2);
+}
+
+}  // namespace sherpa_onnx
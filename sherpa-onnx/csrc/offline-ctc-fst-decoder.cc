@@ -4,8 +4,16 @@
 
 #include "sherpa-onnx/csrc/offline-ctc-fst-decoder.h"
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "fst/fstlib.h"
 #include "kaldi-decoder/csrc/decodable-ctc.h"
@@ -20,7 +28,7 @@ namespace sherpa_onnx {
 // @param filename Path to a StdVectorFst or StdConstFst graph
 // @return The caller should free the returned pointer using `delete` to
 //         avoid memory leak.
-fst::Fst<fst::StdArc> *ReadGraph(const std::string &filename) {
+static fst::Fst<fst::StdArc> *ReadGraphImpl(const std::string &filename) {
   // read decoding network FST
   std::ifstream is(filename, std::ios::binary);
   if (!is.good()) {
@@ -36,13 +44,22 @@ fst::Fst<fst::StdArc> *ReadGraph(const std::string &filename) {
     SHERPA_ONNX_LOGE("FST with arc type %s not supported",
                      hdr.ArcType().c_str());
   }
-  fst::FstReadOptions ropts("<unspecified>", &hdr);
+
+  // The source is used to map the file into memory
+  fst::FstReadOptions ropts(filename, &hdr);
 
   fst::Fst<fst::StdArc> *decode_fst = nullptr;
 
   if (hdr.FstType() == "vector") {
     decode_fst = fst::VectorFst<fst::StdArc>::Read(is, ropts);
   } else if (hdr.FstType() == "const") {
+    // Map the states and arcs of the graph into memory instead of reading
+    // them. Pages are loaded on demand and shared by all processes
+    // using the same graph. OpenFst falls back to reading if the graph is
+    // not aligned, e.g., if it is not saved with
+    //
+    //  fstconvert --fst_type=const --fst_align HLG.fst HLG.const.fst
+    ropts.mode = fst::FstReadOptions::MAP;
     decode_fst = fst::ConstFst<fst::StdArc>::Read(is, ropts);
   } else {
     SHERPA_ONNX_LOGE("Reading FST: unsupported FST type: %s",
@@ -57,6 +74,34 @@ fst::Fst<fst::StdArc> *ReadGraph(const std::string &filename) {
   }
 }
 
+std::shared_ptr<const fst::Fst<fst::StdArc>> ReadGraph(
+    const std::string &filename) {
+  // Graphs are read-only after loading, so all decoders in the process
+  // share a single copy of each graph. Entries are weak so that a graph
+  // is freed once no decoder uses it.
+  static std::mutex mutex;
+  static std::unordered_map<std::string,
+                            std::weak_ptr<const fst::Fst<fst::StdArc>>>
+      graphs;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto it = graphs.find(filename);
+  if (it != graphs.end()) {
+    auto graph = it->second.lock();
+    if (graph) {
+      return graph;
+    }
+  }
+
+  std::shared_ptr<const fst::Fst<fst::StdArc>> graph(ReadGraphImpl(filename));
+  if (graph) {
+    graphs[filename] = graph;
+  }
+
+  return graph;
+}
+
 /**
  * @param decoder
  * @param p Pointer to a 2-d array of shape (num_frames, vocab_size)
@@ -116,6 +161,345 @@ static OfflineCtcDecoderResult DecodeOne(kaldi_decoder::FasterDecoder *decoder,
   return r;
 }
 
+namespace {
+
+// A node in the traceback of the N-best search
+struct NbestTrace {
+  int32_t prev;    // Index of the previous node. -1 for the start
+  int32_t ilabel;  // 0 for epsilon
+  int32_t olabel;  // 0 for epsilon
+  int32_t frame;
+};
+
+struct NbestToken {
+  double acoustic_cost = 0;
+  double graph_cost = 0;
+
+  // Hash of the output labels so far. Tokens at the same state with the
+  // same output labels are merged, keeping the one with the lower cost.
+  uint64_t olabel_hash = 14695981039346656037ULL;
+
+  // Index into the traceback nodes. -1 for the start
+  int32_t trace = -1;
+
+  double Cost() const { return acoustic_cost + graph_cost; }
+};
+
+// Tokens of each state, sorted by cost, at most nbest per state
+using NbestTokens = std::unordered_map<int32_t, std::vector<NbestToken>>;
+
+/** Add a token to the tokens of a state.
+ *
+ * Tokens whose cost exceeds that of the best token of the state by more
+ * than lattice_beam are dropped. All paths through the state share the
+ * rest of the path, so such tokens cannot end within lattice_beam of the
+ * best hypothesis.
+ *
+ * @return Return a pointer to the added token, or nullptr if it is not
+ *         added since it is worse than existing ones.
+ */
+NbestToken *AddToken(const NbestToken &tok, int32_t nbest, float lattice_beam,
+                     std::vector<NbestToken> *toks) {
+  double cost = tok.Cost();
+
+  if (!toks->empty() && cost > toks->front().Cost() + lattice_beam) {
+    return nullptr;
+  }
+
+  for (auto it = toks->begin(); it != toks->end(); ++it) {
+    if (it->olabel_hash == tok.olabel_hash) {
+      if (it->Cost() <= cost) {
+        return nullptr;
+      }
+      toks->erase(it);
+      break;
+    }
+  }
+
+  if (static_cast<int32_t>(toks->size()) == nbest &&
+      toks->back().Cost() <= cost) {
+    return nullptr;
+  }
+
+  auto it = std::upper_bound(
+      toks->begin(), toks->end(), cost,
+      [](double c, const NbestToken &t) { return c < t.Cost(); });
+  it = toks->insert(it, tok);
+
+  if (static_cast<int32_t>(toks->size()) > nbest) {
+    toks->pop_back();
+  }
+
+  if (it == toks->begin()) {
+    double cutoff = cost + lattice_beam;
+    while (toks->back().Cost() > cutoff) {
+      toks->pop_back();
+    }
+  }
+
+  return &(*it);
+}
+
+class CtcNbestSearch {
+ public:
+  CtcNbestSearch(const fst::Fst<fst::StdArc> &fst, int32_t nbest,
+                 int32_t max_active, float beam, float lattice_beam)
+      : fst_(fst),
+        nbest_(nbest),
+        max_active_(max_active),
+        beam_(beam),
+        lattice_beam_(lattice_beam) {}
+
+  /**
+   * @param p Pointer to a 2-d array of shape (num_frames, vocab_size)
+   * @param num_frames Number of rows in the 2-d array.
+   * @param vocab_size Number of columns in the 2-d array.
+   * @return Return up to nbest hypotheses, best first. It is empty if
+   *         no final state is reached.
+   */
+  std::vector<OfflineCtcHypothesis> Search(const float *p, int32_t num_frames,
+                                           int32_t vocab_size) {
+    traces_.clear();
+
+    NbestTokens cur;
+    cur[fst_.Start()].emplace_back();
+    ProcessNonemitting(std::numeric_limits<double>::infinity(), &cur);
+
+    NbestTokens next;
+    for (int32_t t = 0; t != num_frames; ++t) {
+      double cutoff = ProcessEmitting(cur, p + t * vocab_size, t, &next);
+      ProcessNonemitting(cutoff, &next);
+      std::swap(cur, next);
+    }
+
+    return GetNbest(cur);
+  }
+
+ private:
+  // Return the cost cutoff of the tokens in toks
+  double GetCutoff(const NbestTokens &toks) const {
+    std::vector<double> costs;
+    costs.reserve(toks.size());
+    for (const auto &p : toks) {
+      // p.second is sorted by cost
+      costs.push_back(p.second.front().Cost());
+    }
+
+    double best = *std::min_element(costs.begin(), costs.end());
+    double cutoff = best + beam_;
+
+    if (static_cast<int32_t>(costs.size()) > max_active_) {
+      std::nth_element(costs.begin(), costs.begin() + max_active_,
+                       costs.end());
+      cutoff = std::min(cutoff, costs[max_active_]);
+    }
+
+    return cutoff;
+  }
+
+  // Return the cost cutoff for the non-emitting arcs of the next frame
+  double ProcessEmitting(const NbestTokens &cur, const float *log_probs,
+                         int32_t t, NbestTokens *next) {
+    next->clear();
+    if (cur.empty()) {
+      return 0;
+    }
+
+    double cutoff = GetCutoff(cur);
+    double next_cutoff = std::numeric_limits<double>::infinity();
+
+    for (const auto &p : cur) {
+      for (const auto &tok : p.second) {
+        if (tok.Cost() > cutoff) {
+          break;
+        }
+
+        for (fst::ArcIterator<fst::Fst<fst::StdArc>> aiter(fst_, p.first);
+             !aiter.Done(); aiter.Next()) {
+          const auto &arc = aiter.Value();
+          if (arc.ilabel == 0) {
+            continue;
+          }
+
+          NbestToken new_tok = tok;
+          // -1 here since the input labels are incremented during graph
+          // construction
+          new_tok.acoustic_cost -= log_probs[arc.ilabel - 1];
+          new_tok.graph_cost += arc.weight.Value();
+
+          double cost = new_tok.Cost();
+          if (cost > next_cutoff) {
+            continue;
+          }
+
+          if (arc.olabel != 0) {
+            new_tok.olabel_hash =
+                (new_tok.olabel_hash ^ arc.olabel) * 1099511628211ULL;
+          }
+
+          NbestToken *added =
+              AddToken(new_tok, nbest_, lattice_beam_,
+                       &(*next)[arc.nextstate]);
+          if (added) {
+            added->trace = static_cast<int32_t>(traces_.size());
+            traces_.push_back({tok.trace, static_cast<int32_t>(arc.ilabel),
+                               static_cast<int32_t>(arc.olabel), t});
+
+            next_cutoff = std::min(next_cutoff, cost + beam_);
+          }
+        }
+      }
+    }
+
+    return next_cutoff;
+  }
+
+  void ProcessNonemitting(double cutoff, NbestTokens *toks) {
+    std::vector<int32_t> queue;
+    queue.reserve(toks->size());
+    for (const auto &p : *toks) {
+      queue.push_back(p.first);
+    }
+
+    while (!queue.empty()) {
+      int32_t state = queue.back();
+      queue.pop_back();
+
+      // Copy since adding tokens to other states may rehash toks
+      std::vector<NbestToken> src = (*toks)[state];
+
+      for (fst::ArcIterator<fst::Fst<fst::StdArc>> aiter(fst_, state);
+           !aiter.Done(); aiter.Next()) {
+        const auto &arc = aiter.Value();
+        if (arc.ilabel != 0) {
+          continue;
+        }
+
+        bool changed = false;
+        for (const auto &tok : src) {
+          NbestToken new_tok = tok;
+          new_tok.graph_cost += arc.weight.Value();
+          if (new_tok.Cost() > cutoff) {
+            break;
+          }
+
+          if (arc.olabel != 0) {
+            new_tok.olabel_hash =
+                (new_tok.olabel_hash ^ arc.olabel) * 1099511628211ULL;
+          }
+
+          NbestToken *added =
+              AddToken(new_tok, nbest_, lattice_beam_,
+                       &(*toks)[arc.nextstate]);
+          if (!added) {
+            continue;
+          }
+
+          if (arc.olabel != 0) {
+            // Only output labels are needed from non-emitting arcs
+            added->trace = static_cast<int32_t>(traces_.size());
+            traces_.push_back(
+                {tok.trace, 0, static_cast<int32_t>(arc.olabel), -1});
+          }
+          changed = true;
+        }
+
+        if (changed) {
+          queue.push_back(arc.nextstate);
+        }
+      }
+    }
+  }
+
+  std::vector<OfflineCtcHypothesis> GetNbest(const NbestTokens &toks) const {
+    // (total cost, final weight, token)
+    std::vector<std::tuple<double, float, const NbestToken *>> ends;
+    for (const auto &p : toks) {
+      float final_weight = fst_.Final(p.first).Value();
+      if (final_weight == fst::StdArc::Weight::Zero().Value()) {
+        continue;
+      }
+
+      for (const auto &tok : p.second) {
+        ends.emplace_back(tok.Cost() + final_weight, final_weight, &tok);
+      }
+    }
+
+    std::sort(ends.begin(), ends.end(),
+              [](const std::tuple<double, float, const NbestToken *> &a,
+                 const std::tuple<double, float, const NbestToken *> &b) {
+                return std::get<0>(a) < std::get<0>(b);
+              });
+
+    std::vector<OfflineCtcHypothesis> ans;
+    std::unordered_set<uint64_t> seen;
+    for (const auto &e : ends) {
+      if (static_cast<int32_t>(ans.size()) == nbest_ ||
+          std::get<0>(e) > std::get<0>(ends[0]) + lattice_beam_) {
+        break;
+      }
+
+      const NbestToken *tok = std::get<2>(e);
+      if (!seen.insert(tok->olabel_hash).second) {
+        // The same output labels reach another final state with a
+        // lower cost
+        continue;
+      }
+
+      OfflineCtcHypothesis h = Traceback(tok->trace);
+      h.acoustic_cost = tok->acoustic_cost;
+      h.graph_cost = tok->graph_cost + std::get<1>(e);
+      ans.push_back(std::move(h));
+    }
+
+    return ans;
+  }
+
+  OfflineCtcHypothesis Traceback(int32_t trace) const {
+    std::vector<const NbestTrace *> path;
+    for (int32_t i = trace; i != -1; i = traces_[i].prev) {
+      path.push_back(&traces_[i]);
+    }
+    std::reverse(path.begin(), path.end());
+
+    OfflineCtcHypothesis h;
+    int32_t blank_id = 0;
+    int32_t prev = -1;
+    for (const auto *node : path) {
+      if (node->olabel != 0) {
+        h.words.push_back(node->olabel);
+      }
+
+      if (node->ilabel == prev) {
+        continue;
+      }
+
+      prev = node->ilabel;
+
+      // 0 is epsilon here
+      if (node->ilabel == 0 || node->ilabel == blank_id + 1) {
+        continue;
+      }
+
+      h.tokens.push_back(node->ilabel - 1);
+      h.timestamps.push_back(node->frame);
+    }
+
+    return h;
+  }
+
+ private:
+  const fst::Fst<fst::StdArc> &fst_;
+  int32_t nbest_;
+  int32_t max_active_;
+  float beam_;
+  float lattice_beam_;
+
+  std::vector<NbestTrace> traces_;
+};
+
+}  // namespace
+
 OfflineCtcFstDecoder::OfflineCtcFstDecoder(
     const OfflineCtcFstDecoderConfig &config)
     : config_(config), fst_(ReadGraph(config_.graph)) {}
@@ -137,17 +521,40 @@ std::vector<OfflineCtcDecoderResult> OfflineCtcFstDecoder::Decode(
 
   kaldi_decoder::FasterDecoderOptions opts;
   opts.max_active = config_.max_active;
-  kaldi_decoder::FasterDecoder faster_decoder(*fst_, opts);
 
   const float *start = log_probs.GetTensorData<float>();
+  const int64_t *p_length = log_probs_length.GetTensorData<int64_t>();
 
   std::vector<OfflineCtcDecoderResult> ans;
   ans.reserve(batch_size);
 
+  if (config_.nbest == 1) {
+    kaldi_decoder::FasterDecoder faster_decoder(*fst_, opts);
+
+    for (int32_t i = 0; i != batch_size; ++i) {
+      const float *p = start + i * T * vocab_size;
+      auto r = DecodeOne(&faster_decoder, p, p_length[i], vocab_size);
+      ans.push_back(std::move(r));
+    }
+
+    return ans;
+  }
+
+  // It is reused for all utterances in the batch
+  CtcNbestSearch search(*fst_, config_.nbest, opts.max_active, opts.beam,
+                        config_.lattice_beam);
+
   for (int32_t i = 0; i != batch_size; ++i) {
     const float *p = start + i * T * vocab_size;
-    int32_t num_frames = log_probs_length.GetTensorData<int64_t>()[i];
-    auto r = DecodeOne(&faster_decoder, p, num_frames, vocab_size);
+
+    OfflineCtcDecoderResult r;
+    r.nbest = search.Search(p, p_length[i], vocab_size);
+    if (r.nbest.empty()) {
+      SHERPA_ONNX_LOGE("Not reached final!");
+    } else {
+      r.tokens = r.nbest[0].tokens;
+      r.timestamps = r.nbest[0].timestamps;
+    }
     ans.push_back(std::move(r));
   }
 
@@ -6,6 +6,7 @@
 #define SHERPA_ONNX_CSRC_OFFLINE_CTC_FST_DECODER_H_
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "fst/fst.h"
@@ -25,9 +26,22 @@ class OfflineCtcFstDecoder : public OfflineCtcDecoder {
  private:
   OfflineCtcFstDecoderConfig config_;
 
-  std::unique_ptr<fst::Fst<fst::StdArc>> fst_;
+  // Shared with other decoders using the same graph
+  std::shared_ptr<const fst::Fst<fst::StdArc>> fst_;
 };
 
+/** Read a decoding graph.
+ *
+ * Graphs are cached by filename, so decoders using the same graph share it
+ * as long as any of them is alive. A ConstFst graph is mapped into memory
+ * if it is saved with alignment.
+ *
+ * @param filename Path to a StdVectorFst or StdConstFst graph
+ * @return Return nullptr on error.
+ */
+std::shared_ptr<const fst::Fst<fst::StdArc>> ReadGraph(
+    const std::string &filename);
+
 }  // namespace sherpa_onnx
 
 #endif  // SHERPA_ONNX_CSRC_OFFLINE_CTC_FST_DECODER_H_
@@ -5,6 +5,10 @@
 #include "sherpa-onnx/csrc/offline-lm.h"
 
 #include <algorithm>
+#include <array>
+#include <numeric>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -23,39 +27,88 @@ std::unique_ptr<OfflineLM> OfflineLM::Create(AAssetManager *mgr,
 }
 #endif
 
+// Upper bound of the number of (padded) tokens in a single call of
+// Rescore(). Hypotheses are sorted by length before they are split into
+// batches, so the padding inside each batch is small.
+static constexpr int32_t kMaxTokensPerBatch = 16384;
+
 void OfflineLM::ComputeLMScore(float scale, int32_t context_size,
                                std::vector<Hypotheses> *hyps) {
-  // compute the max token seq so that we know how much space to allocate
-  int32_t max_token_seq = 0;
-  int32_t num_hyps = 0;
+  // Hypotheses from different utterances, or paths that differ only in
+  // timestamps, may share the same token sequence. We rescore each
+  // distinct token sequence only once.
+  std::unordered_map<std::string, int32_t> key2index;
+  std::vector<const std::vector<int64_t> *> unique_ys;
+  std::vector<int32_t> hyp2index;
 
-  // we subtract context_size below since each token sequence is prepended
-  // with context_size blanks
   for (const auto &h : *hyps) {
-    num_hyps += h.Size();
     for (const auto &t : h) {
-      max_token_seq =
-          std::max<int32_t>(max_token_seq, t.second.ys.size() - context_size);
+      auto it = key2index.find(t.first);
+      if (it != key2index.end()) {
+        hyp2index.push_back(it->second);
+        continue;
+      }
+
+      int32_t index = static_cast<int32_t>(unique_ys.size());
+      key2index.emplace(t.first, index);
+      unique_ys.push_back(&t.second.ys);
+      hyp2index.push_back(index);
     }
   }
 
+  int32_t num_unique = static_cast<int32_t>(unique_ys.size());
+  if (num_unique == 0) {
+    return;
+  }
+
+  // we subtract context_size below since each token sequence is prepended
+  // with context_size blanks
+  std::vector<int32_t> order(num_unique);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&unique_ys](int32_t a, int32_t b) {
+    return unique_ys[a]->size() < unique_ys[b]->size();
+  });
+
+  std::vector<float> nll(num_unique);
+
   Ort::AllocatorWithDefaultOptions allocator;
-  std::array<int64_t, 2> x_shape{num_hyps, max_token_seq};
-  Ort::Value x = Ort::Value::CreateTensor<int64_t>(allocator, x_shape.data(),
-                                                   x_shape.size());
 
-  std::array<int64_t, 1> x_lens_shape{num_hyps};
-  Ort::Value x_lens = Ort::Value::CreateTensor<int64_t>(
-      allocator, x_lens_shape.data(), x_lens_shape.size());
+  int32_t begin = 0;
+  while (begin < num_unique) {
+    // Since order is sorted by length, the last one in a batch is the
+    // longest one
+    int32_t end = begin + 1;
+    while (end < num_unique) {
+      int32_t len = std::max<int32_t>(
+          unique_ys[order[end]]->size() - context_size, 1);
+      if ((end - begin + 1) * len > kMaxTokensPerBatch) {
+        break;
+      }
+      ++end;
+    }
 
-  int64_t *p = x.GetTensorMutableData<int64_t>();
-  std::fill(p, p + num_hyps * max_token_seq, 0);
+    int32_t batch_size = end - begin;
 
-  int64_t *p_lens = x_lens.GetTensorMutableData<int64_t>();
+    // If all hypotheses in the batch are empty, we still use a width of 1
+    // since the model does not accept an empty tensor. x_lens is 0 for them.
+    int32_t max_token_seq = std::max<int32_t>(
+        unique_ys[order[end - 1]]->size() - context_size, 1);
 
-  for (const auto &h : *hyps) {
-    for (const auto &t : h) {
-      const auto &ys = t.second.ys;
+    std::array<int64_t, 2> x_shape{batch_size, max_token_seq};
+    Ort::Value x = Ort::Value::CreateTensor<int64_t>(allocator, x_shape.data(),
+                                                     x_shape.size());
+
+    std::array<int64_t, 1> x_lens_shape{batch_size};
+    Ort::Value x_lens = Ort::Value::CreateTensor<int64_t>(
+        allocator, x_lens_shape.data(), x_lens_shape.size());
+
+    int64_t *p = x.GetTensorMutableData<int64_t>();
+    std::fill(p, p + batch_size * max_token_seq, 0);
+
+    int64_t *p_lens = x_lens.GetTensorMutableData<int64_t>();
+
+    for (int32_t i = begin; i != end; ++i) {
+      const auto &ys = *unique_ys[order[i]];
       int32_t len = ys.size() - context_size;
       std::copy(ys.begin() + context_size, ys.end(), p);
       *p_lens = len;
@@ -63,14 +116,22 @@ void OfflineLM::ComputeLMScore(float scale, int32_t context_size,
       p += max_token_seq;
       ++p_lens;
     }
+
+    auto negative_loglike = Rescore(std::move(x), std::move(x_lens));
+    const float *p_nll = negative_loglike.GetTensorData<float>();
+    for (int32_t i = begin; i != end; ++i) {
+      nll[order[i]] = p_nll[i - begin];
+    }
+
+    begin = end;
   }
-  auto negative_loglike = Rescore(std::move(x), std::move(x_lens));
-  const float *p_nll = negative_loglike.GetTensorData<float>();
+
+  const int32_t *p_index = hyp2index.data();
   for (auto &h : *hyps) {
     for (auto &t : h) {
       // Use -scale here since we want to change negative loglike to loglike.
-      t.second.lm_log_prob = -scale * (*p_nll);
-      ++p_nll;
+      t.second.lm_log_prob = -scale * nll[*p_index];
+      ++p_index;
     }
   }
 }
@@ -44,6 +44,10 @@ class OfflineLM {
 
   // This function updates hyp.lm_lob_prob of hyps.
   //
+  // All hyps of all utterances are rescored together. Distinct token
+  // sequences are sorted by length and grouped into padded batches so that
+  // each call of Rescore() contains sequences of similar lengths.
+  //
   // @param scale LM score
   // @param context_size Context size of the transducer decoder model
   // @param hyps It is changed in-place.
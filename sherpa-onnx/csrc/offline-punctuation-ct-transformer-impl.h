@@ -6,7 +6,11 @@
 
 #include <math.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
@@ -42,151 +46,315 @@ class OfflinePunctuationCtTransformerImpl : public OfflinePunctuationImpl {
       return {};
     }
 
-    std::vector<std::string> tokens = SplitUtf8(text);
-    std::vector<int32_t> token_ids;
-    token_ids.reserve(tokens.size());
+    OfflinePunctuationStream s;
+    s.AcceptText(text);
+    s.InputFinished();
 
+    OfflinePunctuationStream *p = &s;
+    Process(&p, 1);
+
+    return s.GetResult();
+  }
+
+  std::vector<std::string> AddPunctuation(
+      const std::vector<std::string> &texts) const override {
+    int32_t n = static_cast<int32_t>(texts.size());
+
+    std::vector<OfflinePunctuationStream> streams(n);
+    for (int32_t i = 0; i != n; ++i) {
+      streams[i].AcceptText(texts[i]);
+      streams[i].InputFinished();
+    }
+
+    // Texts of similar lengths are put into the same batch to reduce padding
+    std::vector<int32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&streams](int32_t a,
+                                                            int32_t b) {
+      return streams[a].tokens_.size() < streams[b].tokens_.size();
+    });
+
+    std::vector<OfflinePunctuationStream *> ss;
+    for (int32_t i = 0; i < n; i += kMaxBatchSize) {
+      ss.clear();
+      for (int32_t k = i; k < std::min(i + kMaxBatchSize, n); ++k) {
+        ss.push_back(&streams[order[k]]);
+      }
+      Process(ss.data(), static_cast<int32_t>(ss.size()));
+    }
+
+    std::vector<std::string> ans(n);
+    for (int32_t i = 0; i != n; ++i) {
+      ans[i] = streams[i].GetResult();
+    }
+
+    return ans;
+  }
+
+  void AddPunctuation(OfflinePunctuationStream *s) const override {
+    Process(&s, 1);
+  }
+
+ private:
+  // Process all segments of the given streams that are ready. In each
+  // iteration, the next segment of every stream is run in a single batch.
+  void Process(OfflinePunctuationStream **ss, int32_t n) const {
     const auto &meta_data = model_.GetModelMetadata();
 
-    for (const auto &t : tokens) {
-      std::string token = ToLowerCase(t);
-      if (meta_data.token2id.count(token)) {
-        token_ids.push_back(meta_data.token2id.at(token));
-      } else {
-        token_ids.push_back(meta_data.unk_id);
+    for (int32_t i = 0; i != n; ++i) {
+      auto *s = ss[i];
+      for (int32_t k = static_cast<int32_t>(s->token_ids_.size());
+           k < static_cast<int32_t>(s->tokens_.size()); ++k) {
+        std::string token = ToLowerCase(s->tokens_[k]);
+        if (meta_data.token2id.count(token)) {
+          s->token_ids_.push_back(meta_data.token2id.at(token));
+        } else {
+          s->token_ids_.push_back(meta_data.unk_id);
+        }
       }
     }
 
-    auto memory_info =
-        Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+    std::vector<OfflinePunctuationStream *> ready;
+    std::vector<int32_t> starts;
+    std::vector<int32_t> ends;
+    while (true) {
+      ready.clear();
+      starts.clear();
+      ends.clear();
+
+      for (int32_t i = 0; i != n; ++i) {
+        int32_t start, end;
+        if (NextSegment(ss[i], &start, &end)) {
+          ready.push_back(ss[i]);
+          starts.push_back(start);
+          ends.push_back(end);
+        }
+      }
 
-    int32_t segment_size = 20;
-    int32_t max_len = 200;
-    int32_t num_segments =
-        ceil((static_cast<float>(token_ids.size()) + segment_size - 1) /
-             segment_size);
-
-    std::vector<int32_t> punctuations;
-    int32_t last = -1;
-    for (int32_t i = 0; i != num_segments; ++i) {
-      int32_t this_start = i * segment_size;         // inclusive
-      int32_t this_end = this_start + segment_size;  // exclusive
-      if (this_end > token_ids.size()) {
-        this_end = token_ids.size();
+      if (ready.empty()) {
+        break;
       }
 
-      if (last != -1) {
-        this_start = last;
+      RunSegments(ready, starts, ends);
+    }
+
+    for (int32_t i = 0; i != n; ++i) {
+      auto *s = ss[i];
+      if (s->input_finished_ && !s->done_) {
+        Finish(s);
       }
-      // token_ids[this_start:this_end] is sent to the model
+    }
+  }
 
-      std::array<int64_t, 2> x_shape = {1, this_end - this_start};
-      Ort::Value x =
-          Ort::Value::CreateTensor(memory_info, token_ids.data() + this_start,
-                                   x_shape[1], x_shape.data(), x_shape.size());
+  // Number of segments of a stream after InputFinished() is called.
+  // The last segment contains the remaining tokens.
+  static int32_t NumSegments(const OfflinePunctuationStream *s) {
+    int32_t num_tokens = static_cast<int32_t>(s->tokens_.size());
+    return (num_tokens + 2 * kSegmentSize - 2) / kSegmentSize;
+  }
 
-      int64_t len_shape = 1;
-      int32_t len = x_shape[1];
-      Ort::Value x_len =
-          Ort::Value::CreateTensor(memory_info, &len, 1, &len_shape, 1);
+  bool IsLastSegment(const OfflinePunctuationStream *s) const {
+    return s->input_finished_ && s->segment_ == NumSegments(s) - 1;
+  }
 
-      Ort::Value out = model_.Forward(std::move(x), std::move(x_len));
+  /* Get the tokens to run for the next segment of a stream.
+   *
+   * Tokens after the last finished sentence are run again with the tokens of
+   * the next segment.
+   *
+   * @return false if the stream has no segment to run. If the input is not
+   *         finished, a segment is run only after it is full.
+   */
+  bool NextSegment(const OfflinePunctuationStream *s, int32_t *start,
+                   int32_t *end) const {
+    int32_t num_tokens = static_cast<int32_t>(s->tokens_.size());
+    int32_t segment_end = (s->segment_ + 1) * kSegmentSize;
+
+    if (num_tokens == 0) {
+      return false;
+    }
 
-      // [N, T, num_punctuations]
-      std::vector<int64_t> out_shape =
-          out.GetTensorTypeAndShapeInfo().GetShape();
+    if (s->input_finished_) {
+      if (s->segment_ >= NumSegments(s)) {
+        return false;
+      }
+    } else if (segment_end > num_tokens) {
+      // Wait for more text to fill the segment
+      return false;
+    }
 
-      assert(out_shape[0] == 1);
-      assert(out_shape[1] == len);
-      assert(out_shape[2] == meta_data.num_punctuations);
+    *start = static_cast<int32_t>(s->punctuations_.size());
+    *end = std::min(segment_end, num_tokens);
 
-      std::vector<int32_t> this_punctuations;
-      this_punctuations.reserve(len);
+    return true;
+  }
 
-      const float *p = out.GetTensorData<float>();
-      for (int32_t k = 0; k != len; ++k, p += meta_data.num_punctuations) {
-        auto index = static_cast<int32_t>(std::distance(
-            p, std::max_element(p, p + meta_data.num_punctuations)));
-        this_punctuations.push_back(index);
-      }  // for (int32_t k = 0; k != len; ++k, p += meta_data.num_punctuations)
+  // ss[i]->token_ids_[starts[i], ends[i]) is the input for the i-th stream
+  void RunSegments(const std::vector<OfflinePunctuationStream *> &ss,
+                   const std::vector<int32_t> &starts,
+                   const std::vector<int32_t> &ends) const {
+    const auto &meta_data = model_.GetModelMetadata();
+    int32_t batch_size = static_cast<int32_t>(ss.size());
 
-      int32_t dot_index = -1;
-      int32_t comma_index = -1;
+    std::vector<int32_t> lens(batch_size);
+    int32_t max_len = 0;
+    for (int32_t i = 0; i != batch_size; ++i) {
+      lens[i] = ends[i] - starts[i];
+      max_len = std::max(max_len, lens[i]);
+    }
 
-      for (int32_t m = this_punctuations.size() - 2; m >= 1; --m) {
-        int32_t punct_id = this_punctuations[m];
+    // Padded with 0. Padded tokens are masked out by the model using lens.
+    std::vector<int32_t> x(batch_size * max_len, 0);
+    for (int32_t i = 0; i != batch_size; ++i) {
+      std::copy(ss[i]->token_ids_.begin() + starts[i],
+                ss[i]->token_ids_.begin() + ends[i],
+                x.begin() + i * max_len);
+    }
 
-        if (punct_id == meta_data.dot_id || punct_id == meta_data.quest_id) {
-          dot_index = m;
-          break;
-        }
+    auto memory_info =
+        Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
 
-        if (comma_index == -1 && punct_id == meta_data.comma_id) {
-          comma_index = m;
-        }
-      }  // for (int32_t k = this_punctuations.size() - 1; k >= 1; --k)
+    std::array<int64_t, 2> x_shape = {batch_size, max_len};
+    Ort::Value x_tensor = Ort::Value::CreateTensor(
+        memory_info, x.data(), x.size(), x_shape.data(), x_shape.size());
 
-      if (dot_index == -1 && len >= max_len && comma_index != -1) {
-        dot_index = comma_index;
-        this_punctuations[dot_index] = meta_data.dot_id;
-      }
+    int64_t lens_shape = batch_size;
+    Ort::Value lens_tensor = Ort::Value::CreateTensor(
+        memory_info, lens.data(), lens.size(), &lens_shape, 1);
 
-      if (dot_index == -1) {
-        if (last == -1) {
-          last = this_start;
-        }
+    Ort::Value out =
+        model_.Forward(std::move(x_tensor), std::move(lens_tensor));
 
-        if (i == num_segments - 1) {
-          dot_index = token_ids.size() - 1;
-        }
-      } else {
-        last = this_start + dot_index + 1;
-      }
+    // [N, T, num_punctuations]
+    std::vector<int64_t> out_shape = out.GetTensorTypeAndShapeInfo().GetShape();
 
-      if (dot_index != 1) {
-        punctuations.insert(punctuations.end(), this_punctuations.begin(),
-                            this_punctuations.begin() + (dot_index + 1));
-      }
-    }  // for (int32_t i = 0; i != num_segments; ++i)
+    assert(out_shape[0] == batch_size);
+    assert(out_shape[1] == max_len);
+    assert(out_shape[2] == meta_data.num_punctuations);
 
-    if (punctuations.empty()) {
-      return text + meta_data.id2punct[meta_data.dot_id];
+    const float *p = out.GetTensorData<float>();
+    for (int32_t i = 0; i != batch_size; ++i) {
+      UpdateStream(ss[i], starts[i],
+                   p + i * max_len * meta_data.num_punctuations, lens[i]);
     }
-    std::vector<std::string> words_punct;
+  }
+
+  // p is the model output of len tokens starting from token start
+  void UpdateStream(OfflinePunctuationStream *s, int32_t start,
+                    const float *p, int32_t len) const {
+    const auto &meta_data = model_.GetModelMetadata();
 
-    for (int32_t i = 0; i != static_cast<int32_t>(punctuations.size()); ++i) {
-      if (i >= tokens.size()) {
+    std::vector<int32_t> this_punctuations;
+    this_punctuations.reserve(len);
+
+    for (int32_t k = 0; k != len; ++k, p += meta_data.num_punctuations) {
+      auto index = static_cast<int32_t>(std::distance(
+          p, std::max_element(p, p + meta_data.num_punctuations)));
+      this_punctuations.push_back(index);
+    }  // for (int32_t k = 0; k != len; ++k, p += meta_data.num_punctuations)
+
+    int32_t dot_index = -1;
+    int32_t comma_index = -1;
+
+    // All tokens of the last segment are finished. For other segments,
+    // search for the last sentence end. Tokens after it are run again with
+    // the next segment.
+    bool is_last_segment = IsLastSegment(s);
+
+    for (int32_t m = is_last_segment ? -1 : len - 2; m >= 1; --m) {
+      int32_t punct_id = this_punctuations[m];
+
+      if (punct_id == meta_data.dot_id || punct_id == meta_data.quest_id) {
+        dot_index = m;
         break;
       }
-      std::string &w = tokens[i];
-      if (i > 0 && !(words_punct.back()[0] & 0x80) && !(w[0] & 0x80)) {
-        words_punct.push_back(" ");
+
+      if (comma_index == -1 && punct_id == meta_data.comma_id) {
+        comma_index = m;
+      }
+    }  // for (int32_t m = len - 2; m >= 1; --m)
+
+    if (dot_index == -1 && len >= kMaxLen && comma_index != -1 &&
+        !is_last_segment) {
+      dot_index = comma_index;
+      this_punctuations[dot_index] = meta_data.dot_id;
+    }
+
+    if (is_last_segment) {
+      dot_index = len - 1;
+    }
+
+    if (dot_index != -1) {
+      // tokens up to dot_index are finished
+      s->punctuations_.insert(s->punctuations_.end(),
+                              this_punctuations.begin(),
+                              this_punctuations.begin() + (dot_index + 1));
+      AppendText(s, start, start + dot_index + 1);
+    }
+
+    ++s->segment_;
+  }
+
+  // Append tokens_[begin, end) with punctuation to text_
+  void AppendText(OfflinePunctuationStream *s, int32_t begin,
+                  int32_t end) const {
+    const auto &meta_data = model_.GetModelMetadata();
+
+    for (int32_t i = begin; i != end; ++i) {
+      const std::string &w = s->tokens_[i];
+      if (!s->text_.empty() && !(s->text_.back() & 0x80) && !(w[0] & 0x80)) {
+        s->text_.push_back(' ');
       }
-      words_punct.push_back(std::move(w));
+      s->text_.append(w);
 
-      if (punctuations[i] != meta_data.underline_id) {
-        words_punct.push_back(meta_data.id2punct[punctuations[i]]);
+      int32_t punct = s->punctuations_[i];
+      if (punct != meta_data.underline_id) {
+        s->text_.append(meta_data.id2punct[punct]);
       }
     }
+  }
 
-    if (words_punct.back() == meta_data.id2punct[meta_data.comma_id] ||
-        words_punct.back() == meta_data.id2punct[meta_data.pause_id]) {
-      words_punct.back() = meta_data.id2punct[meta_data.dot_id];
+  // Make sure the text ends with a period or a question mark
+  void Finish(OfflinePunctuationStream *s) const {
+    s->done_ = true;
+
+    if (s->text_.empty()) {
+      return;
     }
 
-    if (words_punct.back() != meta_data.id2punct[meta_data.dot_id] &&
-        words_punct.back() != meta_data.id2punct[meta_data.quest_id]) {
-      words_punct.push_back(meta_data.id2punct[meta_data.dot_id]);
+    const auto &meta_data = model_.GetModelMetadata();
+    const std::string &dot = meta_data.id2punct[meta_data.dot_id];
+    const std::string &quest = meta_data.id2punct[meta_data.quest_id];
+    const std::string &comma = meta_data.id2punct[meta_data.comma_id];
+    const std::string &pause = meta_data.id2punct[meta_data.pause_id];
+
+    std::string &text = s->text_;
+    if (EndsWith(text, comma)) {
+      text.replace(text.size() - comma.size(), comma.size(), dot);
+    } else if (EndsWith(text, pause)) {
+      text.replace(text.size() - pause.size(), pause.size(), dot);
     }
 
-    std::string ans;
-    for (const auto &w : words_punct) {
-      ans.append(w);
+    if (!EndsWith(text, dot) && !EndsWith(text, quest)) {
+      text.append(dot);
     }
-    return ans;
   }
 
- private:
+  static bool EndsWith(const std::string &s, const std::string &suffix) {
+    return s.size() >= suffix.size() &&
+           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  // Number of tokens added to the model input in each step
+  static constexpr int32_t kSegmentSize = 20;
+
+  // If no sentence is finished in an input of this many tokens, the
+  // input is split at the last comma
+  static constexpr int32_t kMaxLen = 200;
+
+  // Maximum number of texts run in a batch
+  static constexpr int32_t kMaxBatchSize = 32;
+
   OfflinePunctuationConfig config_;
   OfflineCtTransformerModel model_;
 };
@@ -29,6 +29,11 @@ class OfflinePunctuationImpl {
 #endif
 
   virtual std::string AddPunctuation(const std::string &text) const = 0;
+
+  virtual std::vector<std::string> AddPunctuation(
+      const std::vector<std::string> &texts) const = 0;
+
+  virtual void AddPunctuation(OfflinePunctuationStream *s) const = 0;
 };
 
 }  // namespace sherpa_onnx
@@ -4,6 +4,11 @@
 
 #include "sherpa-onnx/csrc/offline-punctuation.h"
 
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
 #if __ANDROID_API__ >= 9
 #include "android/asset_manager.h"
 #include "android/asset_manager_jni.h"
@@ -11,9 +16,31 @@
 
 #include "sherpa-onnx/csrc/macros.h"
 #include "sherpa-onnx/csrc/offline-punctuation-impl.h"
+#include "sherpa-onnx/csrc/text-utils.h"
 
 namespace sherpa_onnx {
 
+void OfflinePunctuationStream::AcceptText(const std::string &text) {
+  std::vector<std::string> tokens = SplitUtf8(text);
+  tokens_.insert(tokens_.end(), std::make_move_iterator(tokens.begin()),
+                 std::make_move_iterator(tokens.end()));
+}
+
+std::string OfflinePunctuationStream::GetResult() const {
+  std::string ans = text_;
+  for (int32_t i = static_cast<int32_t>(punctuations_.size());
+       i < static_cast<int32_t>(tokens_.size()); ++i) {
+    const auto &w = tokens_[i];
+    // Separate words that are not CJK characters with a space
+    if (!ans.empty() && !(ans.back() & 0x80) && !(w[0] & 0x80)) {
+      ans.push_back(' ');
+    }
+    ans.append(w);
+  }
+
+  return ans;
+}
+
 void OfflinePunctuationConfig::Register(ParseOptions *po) {
   model.Register(po);
 }
@@ -50,4 +77,18 @@ std::string OfflinePunctuation::AddPunctuation(const std::string &text) const {
   return impl_->AddPunctuation(text);
 }
 
+std::vector<std::string> OfflinePunctuation::AddPunctuation(
+    const std::vector<std::string> &texts) const {
+  return impl_->AddPunctuation(texts);
+}
+
+std::unique_ptr<OfflinePunctuationStream> OfflinePunctuation::CreateStream()
+    const {
+  return std::make_unique<OfflinePunctuationStream>();
+}
+
+void OfflinePunctuation::AddPunctuation(OfflinePunctuationStream *s) const {
+  impl_->AddPunctuation(s);
+}
+
 }  // namespace sherpa_onnx
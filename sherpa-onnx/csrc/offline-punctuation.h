@@ -34,6 +34,53 @@ struct OfflinePunctuationConfig {
 
 class OfflinePunctuationImpl;
 
+/** Text that arrives in pieces, e.g., results of streaming ASR.
+ *
+ * Punctuation is added by OfflinePunctuation::AddPunctuation(). Sentences
+ * that are finished are not processed again when more text is added.
+ */
+class OfflinePunctuationStream {
+ public:
+  // Append a piece of text. Words in different pieces are separated.
+  void AcceptText(const std::string &text);
+
+  // Call it after the last piece of text so that the last sentence is
+  // also finished. No text can be added after it is called.
+  void InputFinished() { input_finished_ = true; }
+
+  bool IsInputFinished() const { return input_finished_; }
+
+  /* Return the text with punctuation.
+   *
+   * Words after the last finished sentence are returned without punctuation
+   * until more text is added or InputFinished() is called.
+   */
+  std::string GetResult() const;
+
+ private:
+  friend class OfflinePunctuationCtTransformerImpl;
+
+  std::vector<std::string> tokens_;
+
+  // token_ids_[i] is the ID of tokens_[i]. IDs are computed when the
+  // stream is processed.
+  std::vector<int32_t> token_ids_;
+
+  // Punctuation IDs of tokens_[0, punctuations_.size()). They won't change.
+  std::vector<int32_t> punctuations_;
+
+  // tokens_[0, punctuations_.size()) with punctuation
+  std::string text_;
+
+  // Index of the next segment of tokens to process
+  int32_t segment_ = 0;
+
+  bool input_finished_ = false;
+
+  // true if all tokens have been processed after InputFinished()
+  bool done_ = false;
+};
+
 class OfflinePunctuation {
  public:
   explicit OfflinePunctuation(const OfflinePunctuationConfig &config);
@@ -48,6 +95,17 @@ class OfflinePunctuation {
   // Add punctuation to the input text and return it.
   std::string AddPunctuation(const std::string &text) const;
 
+  // Add punctuation to a list of texts. Segments of different texts are
+  // processed in batches. ans[i] is the result of texts[i].
+  std::vector<std::string> AddPunctuation(
+      const std::vector<std::string> &texts) const;
+
+  std::unique_ptr<OfflinePunctuationStream> CreateStream() const;
+
+  // Add punctuation to the text accepted by the stream so far. Call
+  // s->GetResult() to get the result.
+  void AddPunctuation(OfflinePunctuationStream *s) const;
+
  private:
   std::unique_ptr<OfflinePunctuationImpl> impl_;
 };
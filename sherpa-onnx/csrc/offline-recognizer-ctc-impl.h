@@ -17,6 +17,7 @@
 #include "android/asset_manager_jni.h"
 #endif
 
+#include "sherpa-onnx/csrc/metrics.h"
 #include "sherpa-onnx/csrc/offline-ctc-decoder.h"
 #include "sherpa-onnx/csrc/offline-ctc-fst-decoder.h"
 #include "sherpa-onnx/csrc/offline-ctc-greedy-search-decoder.h"
@@ -27,23 +28,22 @@
 
 namespace sherpa_onnx {
 
-static OfflineRecognitionResult Convert(const OfflineCtcDecoderResult &src,
-                                        const SymbolTable &sym_table,
-                                        int32_t frame_shift_ms,
-                                        int32_t subsampling_factor) {
-  OfflineRecognitionResult r;
-  r.tokens.reserve(src.tokens.size());
-  r.timestamps.reserve(src.timestamps.size());
-
-  std::string text;
-
-  for (int32_t i = 0; i != src.tokens.size(); ++i) {
-    if (sym_table.Contains("SIL") && src.tokens[i] == sym_table["SIL"]) {
+// Convert token IDs and frame indexes to symbols and times
+static void ConvertTokens(const std::vector<int64_t> &src_tokens,
+                          const std::vector<int32_t> &src_timestamps,
+                          const SymbolTable &sym_table, float frame_shift_s,
+                          std::string *text, std::vector<std::string> *tokens,
+                          std::vector<float> *timestamps) {
+  tokens->reserve(src_tokens.size());
+  timestamps->reserve(src_timestamps.size());
+
+  for (int32_t i = 0; i != src_tokens.size(); ++i) {
+    if (sym_table.Contains("SIL") && src_tokens[i] == sym_table["SIL"]) {
       // tdnn models from yesno have a SIL token, we should remove it.
       continue;
     }
-    auto sym = sym_table[src.tokens[i]];
-    text.append(sym);
+    auto sym = sym_table[src_tokens[i]];
+    text->append(sym);
 
     if (sym.size() == 1 && (sym[0] < 0x20 || sym[0] > 0x7e)) {
       // for byte bpe models
@@ -55,14 +55,34 @@ static OfflineRecognitionResult Convert(const OfflineCtcDecoderResult &src,
       sym = os.str();
     }
 
-    r.tokens.push_back(std::move(sym));
+    tokens->push_back(std::move(sym));
   }
-  r.text = std::move(text);
 
-  float frame_shift_s = frame_shift_ms / 1000. * subsampling_factor;
-  for (auto t : src.timestamps) {
+  for (auto t : src_timestamps) {
     float time = frame_shift_s * t;
-    r.timestamps.push_back(time);
+    timestamps->push_back(time);
+  }
+}
+
+static OfflineRecognitionResult Convert(const OfflineCtcDecoderResult &src,
+                                        const SymbolTable &sym_table,
+                                        int32_t frame_shift_ms,
+                                        int32_t subsampling_factor) {
+  OfflineRecognitionResult r;
+
+  float frame_shift_s = frame_shift_ms / 1000. * subsampling_factor;
+  ConvertTokens(src.tokens, src.timestamps, sym_table, frame_shift_s, &r.text,
+                &r.tokens, &r.timestamps);
+
+  r.nbest.reserve(src.nbest.size());
+  for (const auto &h : src.nbest) {
+    OfflineRecognitionHypothesis hyp;
+    ConvertTokens(h.tokens, h.timestamps, sym_table, frame_shift_s, &hyp.text,
+                  &hyp.tokens, &hyp.timestamps);
+    hyp.words = h.words;
+    hyp.acoustic_cost = h.acoustic_cost;
+    hyp.graph_cost = h.graph_cost;
+    r.nbest.push_back(std::move(hyp));
   }
 
   return r;
@@ -145,6 +165,17 @@ class OfflineRecognizerCtcImpl : public OfflineRecognizerImpl {
       return;
     }
 
+    static Histogram *feature_time =
+        GetStageHistogram("offline_recognizer", "feature");
+    static Histogram *encoder_time =
+        GetStageHistogram("offline_recognizer", "encoder");
+    static Histogram *search_time =
+        GetStageHistogram("offline_recognizer", "search");
+    static Histogram *result_time =
+        GetStageHistogram("offline_recognizer", "result");
+
+    ScopedTimer feature_timer(feature_time);
+
     auto memory_info =
         Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
 
@@ -184,10 +215,17 @@ class OfflineRecognizerCtcImpl : public OfflineRecognizerImpl {
 
     Ort::Value x = PadSequence(model_->Allocator(), features_pointer,
                                -23.025850929940457f);
+    feature_timer.Stop();
+
+    ScopedTimer encoder_timer(encoder_time);
     auto t = model_->Forward(std::move(x), std::move(x_length));
+    encoder_timer.Stop();
 
+    ScopedTimer search_timer(search_time);
     auto results = decoder_->Decode(std::move(t[0]), std::move(t[1]));
+    search_timer.Stop();
 
+    ScopedTimer result_timer(result_time);
     int32_t frame_shift_ms = 10;
     for (int32_t i = 0; i != n; ++i) {
       auto r = Convert(results[i], symbol_table_, frame_shift_ms,
@@ -200,6 +238,17 @@ class OfflineRecognizerCtcImpl : public OfflineRecognizerImpl {
   // Decode a single stream.
   // Some models do not support batch size > 1, e.g., WeNet CTC models.
   void DecodeStream(OfflineStream *s) const {
+    static Histogram *feature_time =
+        GetStageHistogram("offline_recognizer", "feature");
+    static Histogram *encoder_time =
+        GetStageHistogram("offline_recognizer", "encoder");
+    static Histogram *search_time =
+        GetStageHistogram("offline_recognizer", "search");
+    static Histogram *result_time =
+        GetStageHistogram("offline_recognizer", "result");
+
+    ScopedTimer feature_timer(feature_time);
+
     auto memory_info =
         Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
 
@@ -218,9 +267,17 @@ class OfflineRecognizerCtcImpl : public OfflineRecognizerImpl {
     Ort::Value x_length =
         Ort::Value::CreateTensor(memory_info, &x_length_scalar, 1,
                                  x_length_shape.data(), x_length_shape.size());
+    feature_timer.Stop();
 
+    ScopedTimer encoder_timer(encoder_time);
     auto t = model_->Forward(std::move(x), std::move(x_length));
+    encoder_timer.Stop();
+
+    ScopedTimer search_timer(search_time);
     auto results = decoder_->Decode(std::move(t[0]), std::move(t[1]));
+    search_timer.Stop();
+
+    ScopedTimer result_timer(result_time);
     int32_t frame_shift_ms = 10;
 
     auto r = Convert(results[0], symbol_table_, frame_shift_ms,
@@ -22,6 +22,7 @@
 #include "sherpa-onnx/csrc/context-graph.h"
 #include "sherpa-onnx/csrc/log.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/metrics.h"
 #include "sherpa-onnx/csrc/offline-recognizer-impl.h"
 #include "sherpa-onnx/csrc/offline-recognizer.h"
 #include "sherpa-onnx/csrc/offline-transducer-decoder.h"
@@ -96,7 +97,8 @@ class OfflineRecognizerTransducerImpl : public OfflineRecognizerImpl {
 
       decoder_ = std::make_unique<OfflineTransducerModifiedBeamSearchDecoder>(
           model_.get(), lm_.get(), config_.max_active_paths,
-          config_.lm_config.scale, config_.blank_penalty);
+          config_.lm_config.scale, config_.blank_penalty,
+          config_.decoder_out_cache_size);
     } else {
       SHERPA_ONNX_LOGE("Unsupported decoding method: %s",
                        config_.decoding_method.c_str());
@@ -131,7 +133,8 @@ class OfflineRecognizerTransducerImpl : public OfflineRecognizerImpl {
 
       decoder_ = std::make_unique<OfflineTransducerModifiedBeamSearchDecoder>(
           model_.get(), lm_.get(), config_.max_active_paths,
-          config_.lm_config.scale, config_.blank_penalty);
+          config_.lm_config.scale, config_.blank_penalty,
+          config_.decoder_out_cache_size);
     } else {
       SHERPA_ONNX_LOGE("Unsupported decoding method: %s",
                        config_.decoding_method.c_str());
@@ -150,10 +153,11 @@ class OfflineRecognizerTransducerImpl : public OfflineRecognizerImpl {
       SHERPA_ONNX_LOGE("Encode hotwords failed, skipping, hotwords are : %s",
                        hotwords.c_str());
     }
-    current.insert(current.end(), hotwords_.begin(), hotwords_.end());
 
-    auto context_graph =
-        std::make_shared<ContextGraph>(current, config_.hotwords_score);
+    // Build only the per-stream hotwords. The global hotwords graph is
+    // shared by all streams and used as the base layer.
+    auto context_graph = std::make_shared<ContextGraph>(
+        hotwords_graph_, current, config_.hotwords_score);
     return std::make_unique<OfflineStream>(config_.feat_config, context_graph);
   }
 
@@ -163,6 +167,17 @@ class OfflineRecognizerTransducerImpl : public OfflineRecognizerImpl {
   }
 
   void DecodeStreams(OfflineStream **ss, int32_t n) const override {
+    static Histogram *feature_time =
+        GetStageHistogram("offline_recognizer", "feature");
+    static Histogram *encoder_time =
+        GetStageHistogram("offline_recognizer", "encoder");
+    static Histogram *search_time =
+        GetStageHistogram("offline_recognizer", "search");
+    static Histogram *result_time =
+        GetStageHistogram("offline_recognizer", "result");
+
+    ScopedTimer feature_timer(feature_time);
+
     auto memory_info =
         Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
 
@@ -201,11 +216,18 @@ class OfflineRecognizerTransducerImpl : public OfflineRecognizerImpl {
 
     Ort::Value x = PadSequence(model_->Allocator(), features_pointer,
                                -23.025850929940457f);
+    feature_timer.Stop();
 
+    ScopedTimer encoder_timer(encoder_time);
     auto t = model_->RunEncoder(std::move(x), std::move(x_length));
+    encoder_timer.Stop();
+
+    ScopedTimer search_timer(search_time);
     auto results =
         decoder_->Decode(std::move(t.first), std::move(t.second), ss, n);
+    search_timer.Stop();
 
+    ScopedTimer result_timer(result_time);
     int32_t frame_shift_ms = 10;
     for (int32_t i = 0; i != n; ++i) {
       auto r = Convert(results[i], symbol_table_, frame_shift_ms,
@@ -8,6 +8,7 @@
 
 #include "sherpa-onnx/csrc/file-utils.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/metrics.h"
 #include "sherpa-onnx/csrc/offline-lm-config.h"
 #include "sherpa-onnx/csrc/offline-recognizer-impl.h"
 
@@ -44,9 +45,21 @@ void OfflineRecognizerConfig::Register(ParseOptions *po) {
   po->Register("hotwords-score", &hotwords_score,
                "The bonus score for each token in context word/phrase. "
                "Used only when decoding_method is modified_beam_search");
+
+  po->Register("decoder-out-cache-size", &decoder_out_cache_size,
+               "Maximum number of decoder outputs cached across frames and "
+               "utterances. Hypotheses with the same last context-size "
+               "tokens share a cached decoder output. 0 disables the cache. "
+               "Used only for transducer models with modified_beam_search.");
 }
 
 bool OfflineRecognizerConfig::Validate() const {
+  if (decoder_out_cache_size < 0) {
+    SHERPA_ONNX_LOGE("--decoder-out-cache-size should be >= 0. Given: %d",
+                     decoder_out_cache_size);
+    return false;
+  }
+
   if (decoding_method == "modified_beam_search" && !lm_config.model.empty()) {
     if (max_active_paths <= 0) {
       SHERPA_ONNX_LOGE("max_active_paths is less than 0! Given: %d",
@@ -87,7 +100,8 @@ std::string OfflineRecognizerConfig::ToString() const {
   os << "max_active_paths=" << max_active_paths << ", ";
   os << "hotwords_file=\"" << hotwords_file << "\", ";
   os << "hotwords_score=" << hotwords_score << ", ";
-  os << "blank_penalty=" << blank_penalty << ")";
+  os << "blank_penalty=" << blank_penalty << ", ";
+  os << "decoder_out_cache_size=" << decoder_out_cache_size << ")";
 
   return os.str();
 }
@@ -113,6 +127,13 @@ std::unique_ptr<OfflineStream> OfflineRecognizer::CreateStream() const {
 }
 
 void OfflineRecognizer::DecodeStreams(OfflineStream **ss, int32_t n) const {
+  static Histogram *decode_time =
+      GetStageHistogram("offline_recognizer", "decode_streams");
+  static Histogram *batch_size = GetBatchSizeHistogram("offline_recognizer");
+
+  ObserveIfEnabled(batch_size, n);
+
+  ScopedTimer timer(decode_time);
   impl_->DecodeStreams(ss, n);
 }
 
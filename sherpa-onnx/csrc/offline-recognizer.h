@@ -40,6 +40,11 @@ struct OfflineRecognizerConfig {
 
   float blank_penalty = 0.0;
 
+  /// Used only for transducer models with modified_beam_search. Maximum
+  /// number of decoder outputs, keyed by the last context_size tokens,
+  /// cached across frames and utterances. 0 disables the cache.
+  int32_t decoder_out_cache_size = 1024;
+
   // only greedy_search is implemented
   // TODO(fangjun): Implement modified_beam_search
 
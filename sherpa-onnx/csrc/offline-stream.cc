@@ -14,6 +14,7 @@
 #include "sherpa-onnx/csrc/macros.h"
 #include "sherpa-onnx/csrc/offline-recognizer.h"
 #include "sherpa-onnx/csrc/resample.h"
+#include "sherpa-onnx/csrc/sample-format.h"
 
 namespace sherpa_onnx {
 
@@ -105,14 +106,34 @@ class OfflineStream::Impl {
     if (config_.normalize_samples) {
       AcceptWaveformImpl(sampling_rate, waveform, n);
     } else {
-      std::vector<float> buf(n);
-      for (int32_t i = 0; i != n; ++i) {
-        buf[i] = waveform[i] * 32768;
-      }
-      AcceptWaveformImpl(sampling_rate, buf.data(), n);
+      AcceptSamples(sampling_rate, SampleFormat::kFloat, waveform, n);
     }
   }
 
+  void AcceptWaveform(int32_t sampling_rate, const int16_t *waveform,
+                      int32_t n) {
+    AcceptSamples(sampling_rate, SampleFormat::kInt16, waveform, n);
+  }
+
+  void AcceptWaveformMuLaw(int32_t sampling_rate, const uint8_t *waveform,
+                           int32_t n) {
+    AcceptSamples(sampling_rate, SampleFormat::kMuLaw, waveform, n);
+  }
+
+  void AcceptWaveformALaw(int32_t sampling_rate, const uint8_t *waveform,
+                          int32_t n) {
+    AcceptSamples(sampling_rate, SampleFormat::kALaw, waveform, n);
+  }
+
+  void AcceptSamples(int32_t sampling_rate, SampleFormat format,
+                     const void *samples, int32_t n) {
+    // converted_ is reused across calls so that we don't allocate memory
+    // for every call
+    ConvertSamples(format, samples, n, config_.normalize_samples,
+                   &converted_);
+    AcceptWaveformImpl(sampling_rate, converted_.data(), n);
+  }
+
   void AcceptWaveformImpl(int32_t sampling_rate, const float *waveform,
                           int32_t n) {
     if (sampling_rate != opts_.frame_opts.samp_freq) {
@@ -226,6 +247,7 @@ class OfflineStream::Impl {
   knf::FbankOptions opts_;
   OfflineRecognitionResult r_;
   ContextGraphPtr context_graph_;
+  std::vector<float> converted_;
 };
 
 OfflineStream::OfflineStream(const FeatureExtractorConfig &config /*= {}*/,
@@ -244,6 +266,23 @@ void OfflineStream::AcceptWaveform(int32_t sampling_rate, const float *waveform,
   impl_->AcceptWaveform(sampling_rate, waveform, n);
 }
 
+void OfflineStream::AcceptWaveform(int32_t sampling_rate,
+                                   const int16_t *waveform, int32_t n) const {
+  impl_->AcceptWaveform(sampling_rate, waveform, n);
+}
+
+void OfflineStream::AcceptWaveformMuLaw(int32_t sampling_rate,
+                                        const uint8_t *waveform,
+                                        int32_t n) const {
+  impl_->AcceptWaveformMuLaw(sampling_rate, waveform, n);
+}
+
+void OfflineStream::AcceptWaveformALaw(int32_t sampling_rate,
+                                       const uint8_t *waveform,
+                                       int32_t n) const {
+  impl_->AcceptWaveformALaw(sampling_rate, waveform, n);
+}
+
 int32_t OfflineStream::FeatureDim() const { return impl_->FeatureDim(); }
 
 std::vector<float> OfflineStream::GetFrames() const {
@@ -304,6 +343,28 @@ std::string OfflineRecognitionResult::AsJsonString() const {
     sep = ", ";
   }
   os << "]";
+
+  if (!nbest.empty()) {
+    os << ", \"nbest\": [";
+    sep = "";
+    for (const auto &h : nbest) {
+      os << sep << "{";
+      os << "\"text\": \"" << h.text << "\", ";
+      os << "\"acoustic_cost\": " << std::fixed << std::setprecision(4)
+         << h.acoustic_cost << ", ";
+      os << "\"graph_cost\": " << h.graph_cost << ", ";
+      os << "\"words\": [";
+      std::string word_sep = "";
+      for (auto w : h.words) {
+        os << word_sep << w;
+        word_sep = ", ";
+      }
+      os << "]}";
+      sep = ", ";
+    }
+    os << "]";
+  }
+
   os << "}";
 
   return os.str();
@@ -16,6 +16,26 @@
 
 namespace sherpa_onnx {
 
+/// An alternative hypothesis of an utterance. See
+/// OfflineRecognitionResult::nbest
+struct OfflineRecognitionHypothesis {
+  std::string text;
+
+  std::vector<std::string> tokens;
+
+  /// timestamps[i] records the time in seconds when tokens[i] is decoded.
+  std::vector<float> timestamps;
+
+  /// Output labels of the decoding graph, e.g., word IDs for HLG.fst
+  std::vector<int32_t> words;
+
+  /// Negated log-likelihood of the acoustic model along the path
+  float acoustic_cost = 0;
+
+  /// Sum of the graph weights along the path
+  float graph_cost = 0;
+};
+
 struct OfflineRecognitionResult {
   // Recognition results.
   // For English, it consists of space separated words.
@@ -30,6 +50,10 @@ struct OfflineRecognitionResult {
   /// timestamps[i] records the time in seconds when tokens[i] is decoded.
   std::vector<float> timestamps;
 
+  /// Hypotheses sorted by cost, best first, for rescoring. It is set only
+  /// for CTC models decoded with a graph and --ctc.nbest > 1.
+  std::vector<OfflineRecognitionHypothesis> nbest;
+
   std::string AsJsonString() const;
 };
 
@@ -59,6 +83,18 @@ class OfflineStream {
   void AcceptWaveform(int32_t sampling_rate, const float *waveform,
                       int32_t n) const;
 
+  /// Same as above, but the input is 16-bit linear PCM
+  void AcceptWaveform(int32_t sampling_rate, const int16_t *waveform,
+                      int32_t n) const;
+
+  /// Same as above, but the input is encoded with G.711 mu-law
+  void AcceptWaveformMuLaw(int32_t sampling_rate, const uint8_t *waveform,
+                           int32_t n) const;
+
+  /// Same as above, but the input is encoded with G.711 A-law
+  void AcceptWaveformALaw(int32_t sampling_rate, const uint8_t *waveform,
+                          int32_t n) const;
+
   /// Return feature dim of this extractor
   int32_t FeatureDim() const;
 
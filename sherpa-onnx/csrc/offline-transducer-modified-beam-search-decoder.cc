@@ -4,6 +4,8 @@
 
 #include "sherpa-onnx/csrc/offline-transducer-modified-beam-search-decoder.h"
 
+#include <algorithm>
+#include <array>
 #include <deque>
 #include <utility>
 #include <vector>
@@ -42,14 +44,16 @@ OfflineTransducerModifiedBeamSearchDecoder::Decode(
   std::vector<ContextGraphPtr> context_graphs(batch_size, nullptr);
 
   for (int32_t i = 0; i < batch_size; ++i) {
-    const ContextState *context_state;
+    Hypothesis blank(blanks, 0);
     if (ss != nullptr) {
       context_graphs[i] =
           ss[packed_encoder_out.sorted_indexes[i]]->GetContextGraph();
-      if (context_graphs[i] != nullptr)
-        context_state = context_graphs[i]->Root();
+      if (context_graphs[i] != nullptr) {
+        blank.context_state = context_graphs[i]->Root();
+        blank.base_context_state = context_graphs[i]->BaseRoot();
+      }
     }
-    Hypotheses blank_hyp({{blanks, 0, context_state}});
+    Hypotheses blank_hyp({blank});
     cur.emplace_back(std::move(blank_hyp));
   }
 
@@ -83,10 +87,7 @@ OfflineTransducerModifiedBeamSearchDecoder::Decode(
     cur.clear();
     cur.reserve(n);
 
-    auto decoder_input = model_->BuildDecoderInput(prev, num_hyps);
-    // decoder_input shape: (num_hyps, context_size)
-
-    auto decoder_out = model_->RunDecoder(std::move(decoder_input));
+    auto decoder_out = RunDecoder(prev);
     // decoder_out is (num_hyps, joiner_dim)
 
     cur_encoder_out =
@@ -136,8 +137,8 @@ OfflineTransducerModifiedBeamSearchDecoder::Decode(
           new_hyp.ys.push_back(new_token);
           new_hyp.timestamps.push_back(t);
           if (context_graphs[i] != nullptr) {
-            auto context_res =
-                context_graphs[i]->ForwardOneStep(context_state, new_token);
+            auto context_res = context_graphs[i]->ForwardOneStep(
+                context_state, &new_hyp.base_context_state, new_token);
             context_score = std::get<0>(context_res);
             new_hyp.context_state = std::get<1>(context_res);
           }
@@ -161,8 +162,8 @@ OfflineTransducerModifiedBeamSearchDecoder::Decode(
   for (int32_t i = 0; i < cur.size(); ++i) {
     for (auto iter = cur[i].begin(); iter != cur[i].end(); ++iter) {
       if (context_graphs[i] != nullptr) {
-        auto context_res =
-            context_graphs[i]->Finalize(iter->second.context_state);
+        auto context_res = context_graphs[i]->Finalize(
+            iter->second.context_state, &iter->second.base_context_state);
         iter->second.log_prob += context_res.first;
         iter->second.context_state = context_res.second;
       }
@@ -188,4 +189,43 @@ OfflineTransducerModifiedBeamSearchDecoder::Decode(
   return unsorted_ans;
 }
 
+Ort::Value OfflineTransducerModifiedBeamSearchDecoder::RunDecoder(
+    const std::vector<Hypothesis> &hyps) {
+  int32_t context_size = model_->ContextSize();
+  int32_t num_hyps = static_cast<int32_t>(hyps.size());
+
+  std::vector<int64_t> contexts(num_hyps * context_size);
+  int64_t *p = contexts.data();
+  for (const auto &h : hyps) {
+    std::copy(h.ys.end() - context_size, h.ys.end(), p);
+    p += context_size;
+  }
+
+  auto run_decoder = [this, context_size](const int64_t *contexts, int32_t n,
+                                          std::vector<float> *decoder_out) {
+    std::array<int64_t, 2> shape{n, context_size};
+    Ort::Value decoder_input = Ort::Value::CreateTensor<int64_t>(
+        model_->Allocator(), shape.data(), shape.size());
+    std::copy(contexts, contexts + n * context_size,
+              decoder_input.GetTensorMutableData<int64_t>());
+
+    Ort::Value out = model_->RunDecoder(std::move(decoder_input));
+    const float *p_out = out.GetTensorData<float>();
+    decoder_out->assign(
+        p_out, p_out + out.GetTensorTypeAndShapeInfo().GetElementCount());
+  };
+
+  std::vector<float> rows;
+  decoder_out_cache_.Get(contexts.data(), num_hyps, run_decoder, &rows);
+
+  std::array<int64_t, 2> shape{num_hyps,
+                               static_cast<int64_t>(rows.size() / num_hyps)};
+  Ort::Value decoder_out = Ort::Value::CreateTensor<float>(
+      model_->Allocator(), shape.data(), shape.size());
+  std::copy(rows.begin(), rows.end(),
+            decoder_out.GetTensorMutableData<float>());
+
+  return decoder_out;
+}
+
 }  // namespace sherpa_onnx
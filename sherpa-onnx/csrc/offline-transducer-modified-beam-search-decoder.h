@@ -7,6 +7,8 @@
 
 #include <vector>
 
+#include "sherpa-onnx/csrc/decoder-out-cache.h"
+#include "sherpa-onnx/csrc/hypothesis.h"
 #include "sherpa-onnx/csrc/offline-lm.h"
 #include "sherpa-onnx/csrc/offline-transducer-decoder.h"
 #include "sherpa-onnx/csrc/offline-transducer-model.h"
@@ -20,17 +22,27 @@ class OfflineTransducerModifiedBeamSearchDecoder
                                              OfflineLM *lm,
                                              int32_t max_active_paths,
                                              float lm_scale,
-                                             float blank_penalty)
+                                             float blank_penalty,
+                                             int32_t decoder_out_cache_size = 0)
       : model_(model),
         lm_(lm),
         max_active_paths_(max_active_paths),
         lm_scale_(lm_scale),
-        blank_penalty_(blank_penalty) {}
+        blank_penalty_(blank_penalty),
+        decoder_out_cache_(model->ContextSize(), decoder_out_cache_size) {}
 
   std::vector<OfflineTransducerDecoderResult> Decode(
       Ort::Value encoder_out, Ort::Value encoder_out_length,
       OfflineStream **ss = nullptr, int32_t n = 0) override;
 
+ private:
+  /** Run the decoder for the given hypotheses. Only contexts that are not
+   * in decoder_out_cache_ are passed to the decoder model.
+   *
+   * @return Return a tensor of shape (hyps.size(), decoder_dim).
+   */
+  Ort::Value RunDecoder(const std::vector<Hypothesis> &hyps);
+
  private:
   OfflineTransducerModel *model_;  // Not owned
   OfflineLM *lm_;                  // Not owned; may be nullptr
@@ -38,6 +50,9 @@ class OfflineTransducerModifiedBeamSearchDecoder
   int32_t max_active_paths_;
   float lm_scale_;  // used only when lm_ is not nullptr
   float blank_penalty_;
+
+  // Decoder outputs shared by all utterances decoded by the recognizer
+  DecoderOutCache decoder_out_cache_;
 };
 
 }  // namespace sherpa_onnx
@@ -22,6 +22,7 @@
 #include "sherpa-onnx/csrc/jieba-lexicon.h"
 #include "sherpa-onnx/csrc/lexicon.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/metrics.h"
 #include "sherpa-onnx/csrc/offline-tts-character-frontend.h"
 #include "sherpa-onnx/csrc/offline-tts-frontend.h"
 #include "sherpa-onnx/csrc/offline-tts-impl.h"
@@ -165,7 +166,11 @@ class OfflineTtsVitsImpl : public OfflineTtsImpl {
       SHERPA_ONNX_LOGE("Raw text: %s", text.c_str());
     }
 
+    static Histogram *tn_time = GetStageHistogram("tts", "text_normalizer");
+    static Histogram *frontend_time = GetStageHistogram("tts", "frontend");
+
     if (!tn_list_.empty()) {
+      ScopedTimer timer(tn_time);
       for (const auto &tn : tn_list_) {
         text = tn->Normalize(text);
         if (config_.model.debug) {
@@ -174,8 +179,10 @@ class OfflineTtsVitsImpl : public OfflineTtsImpl {
       }
     }
 
+    ScopedTimer frontend_timer(frontend_time);
     std::vector<std::vector<int64_t>> x =
         frontend_->ConvertTextToTokenIds(text, meta_data.voice);
+    frontend_timer.Stop();
 
     if (x.empty() || (x.size() == 1 && x[0].empty())) {
       SHERPA_ONNX_LOGE("Failed to convert %s to token IDs", text.c_str());
@@ -361,7 +368,11 @@ class OfflineTtsVitsImpl : public OfflineTtsImpl {
     Ort::Value x_tensor = Ort::Value::CreateTensor(
         memory_info, x.data(), x.size(), x_shape.data(), x_shape.size());
 
+    static Histogram *model_time = GetStageHistogram("tts", "model");
+
+    ScopedTimer model_timer(model_time);
     Ort::Value audio = model_->Run(std::move(x_tensor), sid, speed);
+    model_timer.Stop();
 
     std::vector<int64_t> audio_shape =
         audio.GetTensorTypeAndShapeInfo().GetShape();
@@ -13,7 +13,9 @@ namespace sherpa_onnx {
 
 void OfflineTtsVitsModelConfig::Register(ParseOptions *po) {
   po->Register("vits-model", &model, "Path to VITS model");
-  po->Register("vits-lexicon", &lexicon, "Path to lexicon.txt for VITS models");
+  po->Register("vits-lexicon", &lexicon,
+               "Path to lexicon.txt for VITS models. It can also be a lexicon "
+               "compiled by sherpa-onnx-compile-lexicon");
   po->Register("vits-tokens", &tokens, "Path to tokens.txt for VITS models");
   po->Register("vits-data-dir", &data_dir,
                "Path to the directory containing dict for espeak-ng. If it is "
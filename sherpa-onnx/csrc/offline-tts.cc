@@ -8,6 +8,7 @@
 
 #include "sherpa-onnx/csrc/file-utils.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/metrics.h"
 #include "sherpa-onnx/csrc/offline-tts-impl.h"
 #include "sherpa-onnx/csrc/text-utils.h"
 
@@ -87,7 +88,18 @@ OfflineTts::~OfflineTts() = default;
 GeneratedAudio OfflineTts::Generate(
     const std::string &text, int64_t sid /*=0*/, float speed /*= 1.0*/,
     GeneratedAudioCallback callback /*= nullptr*/) const {
-  return impl_->Generate(text, sid, speed, callback);
+  static Histogram *generate_time = GetStageHistogram("tts", "generate");
+  static Counter *audio_seconds = GetAudioSecondsCounter("tts");
+
+  ScopedTimer timer(generate_time);
+  GeneratedAudio audio = impl_->Generate(text, sid, speed, callback);
+
+  if (audio.sample_rate > 0) {
+    IncIfEnabled(audio_seconds,
+                 static_cast<double>(audio.samples.size()) / audio.sample_rate);
+  }
+
+  return audio;
 }
 
 int32_t OfflineTts::SampleRate() const { return impl_->SampleRate(); }
@@ -5,8 +5,17 @@
 #include "sherpa-onnx/csrc/offline-websocket-server-impl.h"
 
 #include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/metrics.h"
 
 namespace sherpa_onnx {
 
@@ -16,11 +25,32 @@ void OfflineWebsocketDecoderConfig::Register(ParseOptions *po) {
   po->Register("max-batch-size", &max_batch_size,
                "Max batch size for decoding.");
 
+  po->Register("max-batch-frames", &max_batch_frames,
+               "Max number of feature frames (10 ms each) in a batch after "
+               "padding, i.e., batch size times the number of frames of the "
+               "longest utterance in the batch. Utterances of similar lengths "
+               "are batched together. An utterance longer than this value is "
+               "decoded alone.");
+
+  po->Register("max-batch-wait-ms", &max_batch_wait_ms,
+               "If a request has been waiting for more than this number of "
+               "milliseconds, it is decoded in the next batch even if other "
+               "requests can form a larger batch.");
+
   po->Register(
       "max-utterance-length", &max_utterance_length,
       "Max utterance length in seconds. If we receive an utterance "
       "longer than this value, we will reject the connection. "
-      "If you have enough memory, you can select a large value for it.");
+      "If you have enough memory, you can select a large value for it. "
+      "In the incremental mode, it is the max length of a segment.");
+
+  po->Register("max-backlog-seconds", &max_backlog_seconds,
+               "In the incremental mode, stop reading from a connection if "
+               "it has more than this number of seconds of audio that is "
+               "not decoded yet, and resume once it drops below half of it. "
+               "0 means no limit.");
+
+  vad_config.Register(po);
 }
 
 void OfflineWebsocketDecoderConfig::Validate() const {
@@ -34,172 +64,455 @@ void OfflineWebsocketDecoderConfig::Validate() const {
     exit(-1);
   }
 
+  if (max_batch_frames <= 0) {
+    SHERPA_ONNX_LOGE("Expect --max-batch-frames > 0. Given: %d",
+                     max_batch_frames);
+    exit(-1);
+  }
+
+  if (max_batch_wait_ms < 0) {
+    SHERPA_ONNX_LOGE("Expect --max-batch-wait-ms >= 0. Given: %d",
+                     max_batch_wait_ms);
+    exit(-1);
+  }
+
   if (max_utterance_length <= 0) {
     SHERPA_ONNX_LOGE("Expect --max-utterance-length > 0. Given: %f",
                      max_utterance_length);
     exit(-1);
   }
+
+  if (max_backlog_seconds < 0) {
+    SHERPA_ONNX_LOGE("Expect --max-backlog-seconds >= 0. Given: %f",
+                     max_backlog_seconds);
+    exit(-1);
+  }
+
+  if (IncrementalModeEnabled() && !vad_config.Validate()) {
+    SHERPA_ONNX_LOGE("Error in vad config");
+    exit(-1);
+  }
 }
 
-OfflineWebsocketDecoder::OfflineWebsocketDecoder(OfflineWebsocketServer *server)
-    : config_(server->GetConfig().decoder_config),
-      server_(server),
-      recognizer_(config_.recognizer_config) {}
+OfflineWebsocketDecoder::OfflineWebsocketDecoder(
+    const OfflineWebsocketDecoderConfig &config, WebsocketDecoderHost *host)
+    : config_(config), host_(host), recognizer_(config_.recognizer_config) {}
+
+OfflineWebsocketRequest OfflineWebsocketDecoder::MakeRequest(
+    connection_hdl hdl, int32_t sample_rate, const float *samples,
+    int32_t num_samples, const std::string &hotwords) {
+  OfflineWebsocketRequest r;
+  r.hdl = hdl;
+
+  // frame shift is 10 ms
+  r.num_frames = static_cast<int64_t>(num_samples) * 100 /
+                 std::max<int32_t>(sample_rate, 1);
+
+  // Length ratio of two utterances in the same bucket is less than 2, so
+  // at most half of a batch is padding.
+  r.bucket = static_cast<int32_t>(std::log2(std::max(r.num_frames, 1)));
+
+  // Feature extraction runs in the calling work thread without holding
+  // mutex_, so requests are featurized in parallel and batches contain
+  // only streams that are ready for DecodeStreams().
+  r.stream = hotwords.empty() ? recognizer_.CreateStream()
+                              : recognizer_.CreateStream(hotwords);
+  r.stream->AcceptWaveform(sample_rate, samples, num_samples);
+
+  r.arrival_time = std::chrono::steady_clock::now();
+
+  return r;
+}
 
 void OfflineWebsocketDecoder::Push(connection_hdl hdl, ConnectionDataPtr d) {
+  int32_t num_samples = d->expected_byte_size / sizeof(float);
+  auto samples = reinterpret_cast<const float *>(d->data.data());
+
+  OfflineWebsocketRequest r =
+      MakeRequest(hdl, d->sample_rate, samples, num_samples, d->hotwords);
+
+  // The received bytes are no longer needed. Free them before the request
+  // waits in the queue.
+  d.reset();
+
   std::lock_guard<std::mutex> lock(mutex_);
-  streams_.push_back({hdl, d});
+  streams_.push_back(std::move(r));
 }
 
-void OfflineWebsocketDecoder::Decode() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  if (streams_.empty()) {
-    return;
+// Return true if the client has sent "Done" for the upload.
+// It is called by an IO thread.
+static bool UploadFinished(IncrementalUpload &u) {
+  std::lock_guard<std::mutex> lock(u.mutex);
+  return u.eof;
+}
+
+static std::string FinalMessage(int32_t num_segments) {
+  std::ostringstream os;
+  os << "{\"is_final\": true, \"num_segments\": " << num_segments << "}";
+  return os.str();
+}
+
+int32_t OfflineWebsocketDecoder::PushSegments(
+    connection_hdl hdl, std::shared_ptr<IncrementalUpload> u) {
+  // Samples of an upload are given to the VAD in the order they are
+  // received, even if several work threads run this function for it.
+  std::lock_guard<std::mutex> vad_lock(u->vad_mutex);
+
+  std::vector<float> samples;
+  bool eof = false;
+  {
+    std::lock_guard<std::mutex> lock(u->mutex);
+    samples.swap(u->samples);
+    u->vad_scheduled = false;
+    eof = u->eof;
   }
 
-  int32_t size =
-      std::min(static_cast<int32_t>(streams_.size()), config_.max_batch_size);
-  SHERPA_ONNX_LOGE("size: %d", size);
+  if (u->flushed || !host_->Contains(hdl)) {
+    return 0;
+  }
 
-  // We first lock the mutex for streams_, take items from it, and then
-  // unlock the mutex; in doing so we don't need to lock the mutex to
-  // access hdl and connection_data later.
-  std::vector<connection_hdl> handles(size);
+  if (!u->vad) {
+    // Cut a long segment so that the memory of a connection is bounded
+    VadModelConfig vad_config = config_.vad_config;
+    vad_config.max_speech_duration = config_.max_utterance_length;
+    u->vad = std::make_unique<VoiceActivityDetector>(vad_config);
+  }
 
-  // Store connection_data here to prevent the data from being freed
-  // while we are still using it.
-  std::vector<ConnectionDataPtr> connection_data(size);
+  u->vad->AcceptWaveform(samples.data(), samples.size());
+  int32_t num_segments = PopSegments(hdl, u);
 
-  std::vector<const float *> samples(size);
-  std::vector<int32_t> samples_length(size);
-  std::vector<std::unique_ptr<OfflineStream>> ss(size);
-  std::vector<OfflineStream *> p_ss(size);
+  if (eof) {
+    u->vad->Flush();
+    num_segments += PopSegments(hdl, u);
 
-  for (int32_t i = 0; i != size; ++i) {
-    auto &p = streams_.front();
-    handles[i] = p.first;
-    connection_data[i] = p.second;
-    streams_.pop_front();
-
-    auto sample_rate = connection_data[i]->sample_rate;
-    auto samples =
-        reinterpret_cast<const float *>(&connection_data[i]->data[0]);
-    auto num_samples = connection_data[i]->expected_byte_size / sizeof(float);
-    auto s = recognizer_.CreateStream();
-    s->AcceptWaveform(sample_rate, samples, num_samples);
-
-    ss[i] = std::move(s);
-    p_ss[i] = ss[i].get();
+    // The VAD is no longer needed
+    u->vad.reset();
+
+    std::lock_guard<std::mutex> lock(u->mutex);
+    u->flushed = true;
+    if (u->num_pending == 0) {
+      SendFinalMessage(hdl, u);
+    }
   }
 
-  lock.unlock();
+  std::lock_guard<std::mutex> lock(u->mutex);
+  MaybeResumeReading(hdl, u);
 
-  // Note: DecodeStreams is thread-safe
-  recognizer_.DecodeStreams(p_ss.data(), size);
+  return num_segments;
+}
 
-  for (int32_t i = 0; i != size; ++i) {
-    connection_hdl hdl = handles[i];
-    asio::post(server_->GetConnectionContext(),
-               [this, hdl, result = ss[i]->GetResult()]() {
-                 websocketpp::lib::error_code ec;
-                 server_->GetServer().send(hdl, result.AsJsonString(),
-                                           websocketpp::frame::opcode::text,
-                                           ec);
-                 if (ec) {
-                   server_->GetServer().get_alog().write(
-                       websocketpp::log::alevel::app, ec.message());
-                 }
-               });
+int32_t OfflineWebsocketDecoder::PopSegments(
+    connection_hdl hdl, const std::shared_ptr<IncrementalUpload> &u) {
+  int32_t ans = 0;
+  while (!u->vad->Empty()) {
+    const SpeechSegment &s = u->vad->Front();
+    int32_t num_samples = static_cast<int32_t>(s.samples.size());
+
+    OfflineWebsocketRequest r = MakeRequest(
+        hdl, u->sample_rate, s.samples.data(), num_samples, u->hotwords);
+    r.upload = u;
+    r.segment = u->num_segments++;
+    r.num_samples = num_samples;
+    r.start = static_cast<float>(s.start) / u->sample_rate;
+    r.duration = static_cast<float>(num_samples) / u->sample_rate;
+
+    u->vad->Pop();
+
+    {
+      std::lock_guard<std::mutex> lock(u->mutex);
+      ++u->num_pending;
+      u->num_pending_samples += num_samples;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.push_back(std::move(r));
+    ++ans;
   }
+
+  return ans;
 }
 
-void OfflineWebsocketServerConfig::Register(ParseOptions *po) {
-  decoder_config.Register(po);
-  po->Register("log-file", &log_file,
-               "Path to the log file. Logs are "
-               "appended to this file");
+void OfflineWebsocketDecoder::ScheduleVad(
+    connection_hdl hdl, const std::shared_ptr<IncrementalUpload> &u) {
+  if (u->vad_scheduled) {
+    return;
+  }
+  u->vad_scheduled = true;
+
+  host_->PostWork([this, hdl, u]() {
+    int32_t n = PushSegments(hdl, u);
+    for (int32_t i = 0; i != n; ++i) {
+      Decode();
+    }
+  });
 }
 
-void OfflineWebsocketServerConfig::Validate() const {
-  decoder_config.Validate();
+void OfflineWebsocketDecoder::MaybePauseReading(
+    connection_hdl hdl, const std::shared_ptr<IncrementalUpload> &u) {
+  int64_t max_backlog =
+      static_cast<int64_t>(config_.max_backlog_seconds * u->sample_rate);
+
+  if (max_backlog > 0 && !u->paused && Backlog(*u) > max_backlog) {
+    // It is resumed by a work thread. We pause it while holding the lock
+    // so that it cannot be resumed before it is paused.
+    u->paused = true;
+    host_->PauseReading(hdl);
+  }
 }
 
-OfflineWebsocketServer::OfflineWebsocketServer(
-    asio::io_context &io_conn,  // NOLINT
-    asio::io_context &io_work,  // NOLINT
-    const OfflineWebsocketServerConfig &config)
-    : io_conn_(io_conn),
-      io_work_(io_work),
-      config_(config),
-      log_(config.log_file, std::ios::app),
-      tee_(std::cout, log_),
-      decoder_(this) {
-  SetupLog();
+void OfflineWebsocketDecoder::MaybeResumeReading(
+    connection_hdl hdl, const std::shared_ptr<IncrementalUpload> &u) {
+  int64_t max_backlog =
+      static_cast<int64_t>(config_.max_backlog_seconds * u->sample_rate);
 
-  server_.init_asio(&io_conn_);
+  if (u->paused && Backlog(*u) < max_backlog / 2) {
+    u->paused = false;
+    asio::post(host_->GetConnectionContext(),
+               [this, hdl]() { host_->ResumeReading(hdl); });
+  }
+}
 
-  server_.set_open_handler([this](connection_hdl hdl) { OnOpen(hdl); });
+void OfflineWebsocketDecoder::SendFinalMessage(
+    connection_hdl hdl, const std::shared_ptr<IncrementalUpload> &u) {
+  asio::post(u->strand,
+             [this, hdl, u, text = FinalMessage(u->num_segments)]() {
+               {
+                 // Set it before sending so that the next upload, which
+                 // the client starts after receiving it, is accepted
+                 std::lock_guard<std::mutex> lock(u->mutex);
+                 u->final_sent = true;
+               }
+               host_->Send(hdl, text);
+             });
+}
 
-  server_.set_close_handler([this](connection_hdl hdl) { OnClose(hdl); });
+void OfflineWebsocketDecoder::StartUpload(connection_hdl hdl,
+                                          ConnectionDataPtr connection_data,
+                                          const int8_t *p, int32_t n) {
+  if (!config_.IncrementalModeEnabled()) {
+    host_->Close(hdl, websocketpp::close::status::normal,
+                 "The incremental mode is disabled. Please start the server "
+                 "with --silero-vad-model");
+    return;
+  }
 
-  server_.set_message_handler(
-      [this](connection_hdl hdl, server::message_ptr msg) {
-        OnMessage(hdl, msg);
-      });
+  if (connection_data->sample_rate != config_.vad_config.sample_rate) {
+    std::ostringstream os;
+    os << "Expect sample rate " << config_.vad_config.sample_rate
+       << " in the incremental mode. Given: " << connection_data->sample_rate;
+    host_->Close(hdl, websocketpp::close::status::normal, os.str());
+    return;
+  }
+
+  auto u = std::make_shared<IncrementalUpload>(host_->GetConnectionContext());
+  u->sample_rate = connection_data->sample_rate;
+  u->hotwords = connection_data->hotwords;
+  connection_data->upload = u;
+
+  AppendSamples(hdl, u, p, n);
 }
 
-void OfflineWebsocketServer::SetupLog() {
-  server_.clear_access_channels(websocketpp::log::alevel::all);
-  server_.set_access_channels(websocketpp::log::alevel::connect);
-  server_.set_access_channels(websocketpp::log::alevel::disconnect);
+void OfflineWebsocketDecoder::AppendSamples(
+    connection_hdl hdl, const std::shared_ptr<IncrementalUpload> &u,
+    const int8_t *p, int32_t n) {
+  // A sample may be split across two messages
+  std::vector<int8_t> &bytes = u->leftover;
+  bytes.insert(bytes.end(), p, p + n);
 
-  // So that it also prints to std::cout and std::cerr
-  server_.get_alog().set_ostream(&tee_);
-  server_.get_elog().set_ostream(&tee_);
+  int32_t num_samples = bytes.size() / sizeof(float);
+  if (num_samples == 0) {
+    return;
+  }
+
+  auto samples = reinterpret_cast<const float *>(bytes.data());
+  {
+    std::lock_guard<std::mutex> lock(u->mutex);
+    u->samples.insert(u->samples.end(), samples, samples + num_samples);
+    ScheduleVad(hdl, u);
+    MaybePauseReading(hdl, u);
+  }
+
+  bytes.erase(bytes.begin(), bytes.begin() + num_samples * sizeof(float));
 }
 
-void OfflineWebsocketServer::OnOpen(connection_hdl hdl) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  connections_.emplace(hdl, std::make_shared<ConnectionData>());
+void OfflineWebsocketDecoder::FinishUpload(
+    connection_hdl hdl, const std::shared_ptr<IncrementalUpload> &u) {
+  std::lock_guard<std::mutex> lock(u->mutex);
+  u->eof = true;
+  ScheduleVad(hdl, u);
+}
 
-  SHERPA_ONNX_LOGE("Number of active connections: %d",
-                   static_cast<int32_t>(connections_.size()));
+void OfflineWebsocketDecoder::SendSegmentResult(
+    const OfflineWebsocketRequest &r) {
+  std::ostringstream os;
+  os << "{\"is_final\": false, \"segment\": " << r.segment << ", "
+     << std::fixed << std::setprecision(2) << "\"start\": " << r.start
+     << ", \"duration\": " << r.duration
+     << ", \"result\": " << r.stream->GetResult().AsJsonString() << "}";
+
+  connection_hdl hdl = r.hdl;
+  auto u = r.upload;
+
+  // Post under the lock so that the final message is posted last
+  std::lock_guard<std::mutex> lock(u->mutex);
+  asio::post(u->strand,
+             [this, hdl, u, text = os.str()]() { host_->Send(hdl, text); });
+
+  --u->num_pending;
+  u->num_pending_samples -= r.num_samples;
+  MaybeResumeReading(hdl, u);
+
+  if (u->flushed && u->num_pending == 0) {
+    SendFinalMessage(hdl, u);
+  }
 }
 
-void OfflineWebsocketServer::OnClose(connection_hdl hdl) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  connections_.erase(hdl);
+std::vector<OfflineWebsocketRequest> OfflineWebsocketDecoder::NextBatch() {
+  std::vector<OfflineWebsocketRequest> ans;
+  if (streams_.empty()) {
+    return ans;
+  }
 
-  SHERPA_ONNX_LOGE("Number of active connections: %d",
-                   static_cast<int32_t>(connections_.size()));
+  auto now = std::chrono::steady_clock::now();
+  auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    now - streams_.front().arrival_time)
+                    .count();
+
+  int32_t bucket = streams_.front().bucket;
+  if (waited < config_.max_batch_wait_ms) {
+    // Nobody is in a hurry. Select the bucket with the most requests
+    std::unordered_map<int32_t, int32_t> bucket_size;
+    int32_t max_size = 0;
+    for (const auto &r : streams_) {
+      int32_t size = ++bucket_size[r.bucket];
+      if (size > max_size) {
+        max_size = size;
+        bucket = r.bucket;
+      }
+    }
+  }
+
+  int32_t max_num_frames = 0;
+  for (auto it = streams_.begin(); it != streams_.end();) {
+    if (static_cast<int32_t>(ans.size()) == config_.max_batch_size) {
+      break;
+    }
+
+    if (it->bucket != bucket) {
+      ++it;
+      continue;
+    }
+
+    int32_t num_frames = std::max(max_num_frames, it->num_frames);
+    int64_t padded_frames =
+        static_cast<int64_t>(num_frames) * (ans.size() + 1);
+
+    // The first one is always selected even if it is too long
+    if (!ans.empty() && padded_frames > config_.max_batch_frames) {
+      ++it;
+      continue;
+    }
+
+    max_num_frames = num_frames;
+    ans.push_back(std::move(*it));
+    it = streams_.erase(it);
+  }
+
+  return ans;
 }
 
-void OfflineWebsocketServer::OnMessage(connection_hdl hdl,
-                                       server::message_ptr msg) {
+void OfflineWebsocketDecoder::Decode() {
   std::unique_lock<std::mutex> lock(mutex_);
-  auto connection_data = connections_.find(hdl)->second;
+  std::vector<OfflineWebsocketRequest> requests = NextBatch();
+  if (requests.empty()) {
+    return;
+  }
+
+  int32_t size = static_cast<int32_t>(requests.size());
+  SHERPA_ONNX_LOGE("size: %d", size);
+
+  // We first lock the mutex for streams_, take items from it, and then
+  // unlock the mutex; in doing so we don't need to lock the mutex to
+  // access the requests later.
   lock.unlock();
+
+  // Features of the streams have already been computed in Push()
+  std::vector<OfflineStream *> p_ss(size);
+  for (int32_t i = 0; i != size; ++i) {
+    p_ss[i] = requests[i].stream.get();
+  }
+
+  // Note: DecodeStreams is thread-safe
+  recognizer_.DecodeStreams(p_ss.data(), size);
+
+  for (int32_t i = 0; i != size; ++i) {
+    if (requests[i].upload) {
+      SendSegmentResult(requests[i]);
+      continue;
+    }
+
+    connection_hdl hdl = requests[i].hdl;
+    asio::post(host_->GetConnectionContext(),
+               [this, hdl, result = requests[i].stream->GetResult()]() {
+                 host_->Send(hdl, result.AsJsonString());
+               });
+  }
+}
+
+void OfflineWebsocketDecoder::OnMessage(connection_hdl hdl,
+                                        ConnectionDataPtr connection_data,
+                                        server::message_ptr msg) {
   const std::string &payload = msg->get_payload();
 
   switch (msg->get_opcode()) {
     case websocketpp::frame::opcode::text:
-      if (payload == "Done") {
+      if (payload == "Done" && connection_data->upload &&
+          !UploadFinished(*connection_data->upload)) {
+        // End of an upload in the incremental mode. The connection is
+        // kept open for the next upload.
+        FinishUpload(hdl, connection_data->upload);
+      } else if (payload == "Done") {
         // The client will not send any more data. We can close the
         // connection now.
-        Close(hdl, websocketpp::close::status::normal, "Done");
+        host_->Close(hdl, websocketpp::close::status::normal, "Done");
       } else {
-        Close(hdl, websocketpp::close::status::normal,
-              std::string("Invalid payload: ") + payload);
+        host_->Close(hdl, websocketpp::close::status::normal,
+                     std::string("Invalid payload: ") + payload);
       }
       break;
 
     case websocketpp::frame::opcode::binary: {
       auto p = reinterpret_cast<const int8_t *>(payload.data());
 
+      if (connection_data->upload) {
+        auto &u = connection_data->upload;
+        if (!UploadFinished(*u)) {
+          AppendSamples(hdl, u, p, payload.size());
+          break;
+        }
+
+        // Otherwise, it is the header of the next upload. Results of the
+        // two uploads must not be interleaved.
+        bool final_sent;
+        {
+          std::lock_guard<std::mutex> lock(u->mutex);
+          final_sent = u->final_sent;
+        }
+
+        if (!final_sent) {
+          host_->Close(hdl, websocketpp::close::status::policy_violation,
+                       "Please wait for the final message of the previous "
+                       "upload before starting a new one");
+          break;
+        }
+
+        connection_data->Clear();
+      }
+
       if (connection_data->expected_byte_size == 0) {
         if (payload.size() < 8) {
-          Close(hdl, websocketpp::close::status::normal,
-                "Payload is too short");
+          host_->Close(hdl, websocketpp::close::status::normal,
+                       "Payload is too short");
           break;
         }
 
@@ -208,7 +521,12 @@ void OfflineWebsocketServer::OnMessage(connection_hdl hdl,
         connection_data->expected_byte_size =
             *reinterpret_cast<const int32_t *>(p + 4);
 
-        int32_t max_byte_size_ = decoder_.GetConfig().max_utterance_length *
+        if (connection_data->expected_byte_size < 0) {
+          StartUpload(hdl, connection_data, p + 8, payload.size() - 8);
+          break;
+        }
+
+        int32_t max_byte_size_ = config_.max_utterance_length *
                                  connection_data->sample_rate * sizeof(float);
         if (connection_data->expected_byte_size > max_byte_size_) {
           float num_samples =
@@ -218,10 +536,11 @@ void OfflineWebsocketServer::OnMessage(connection_hdl hdl,
 
           std::ostringstream os;
           os << "Max utterance length is configured to "
-             << decoder_.GetConfig().max_utterance_length
+             << config_.max_utterance_length
              << " seconds, received length is " << duration << " seconds. "
              << "Payload is too large!";
-          Close(hdl, websocketpp::close::status::message_too_big, os.str());
+          host_->Close(hdl, websocketpp::close::status::message_too_big,
+                       os.str());
           break;
         }
 
@@ -244,11 +563,14 @@ void OfflineWebsocketServer::OnMessage(connection_hdl hdl,
         connection_data->expected_byte_size = 0;
         connection_data->cur = 0;
 
-        decoder_.Push(hdl, d);
-
         connection_data->Clear();
+        connection_data->hotwords = d->hotwords;
 
-        asio::post(io_work_, [this]() { decoder_.Decode(); });
+        // Both feature extraction and decoding run in the work threads
+        host_->PostWork([this, hdl, d = std::move(d)]() mutable {
+          Push(hdl, std::move(d));
+          Decode();
+        });
       }
       break;
     }
@@ -259,22 +581,104 @@ void OfflineWebsocketServer::OnMessage(connection_hdl hdl,
   }
 }
 
-void OfflineWebsocketServer::Close(connection_hdl hdl,
-                                   websocketpp::close::status::value code,
-                                   const std::string &reason) {
-  auto con = server_.get_con_from_hdl(hdl);
+void OfflineWebsocketServerConfig::Register(ParseOptions *po) {
+  decoder_config.Register(po);
+  po->Register("log-file", &log_file,
+               "Path to the log file. Logs are "
+               "appended to this file");
 
-  std::ostringstream os;
-  os << "Closing " << con->get_remote_endpoint() << " with reason: " << reason
-     << "\n";
-
-  websocketpp::lib::error_code ec;
-  server_.close(hdl, code, reason, ec);
-  if (ec) {
-    os << "Failed to close" << con->get_remote_endpoint() << ". "
-       << ec.message() << "\n";
+  po->Register("enable-metrics", &enable_metrics,
+               "true to collect per-stage latency and throughput metrics "
+               "and serve them in the Prometheus text format at /metrics");
+}
+
+void OfflineWebsocketServerConfig::Validate() const {
+  decoder_config.Validate();
+}
+
+OfflineWebsocketServer::OfflineWebsocketServer(
+    asio::io_context &io_conn,  // NOLINT
+    asio::io_context &io_work,  // NOLINT
+    const OfflineWebsocketServerConfig &config)
+    : io_conn_(io_conn),
+      io_work_(io_work),
+      config_(config),
+      log_(config.log_file, std::ios::app),
+      tee_(std::cout, log_),
+      decoder_(config_.decoder_config, this) {
+  SetupLog();
+
+  if (config.enable_metrics) {
+    EnableMetrics(true);
+  }
+
+  server_.init_asio(&io_conn_);
+
+  server_.set_open_handler([this](connection_hdl hdl) { OnOpen(hdl); });
+
+  server_.set_close_handler([this](connection_hdl hdl) { OnClose(hdl); });
+
+  server_.set_http_handler([this](connection_hdl hdl) { OnHttp(hdl); });
+
+  server_.set_message_handler(
+      [this](connection_hdl hdl, server::message_ptr msg) {
+        OnMessage(hdl, msg);
+      });
+}
+
+void OfflineWebsocketServer::SetupLog() {
+  server_.clear_access_channels(websocketpp::log::alevel::all);
+  server_.set_access_channels(websocketpp::log::alevel::connect);
+  server_.set_access_channels(websocketpp::log::alevel::disconnect);
+
+  // So that it also prints to std::cout and std::cerr
+  server_.get_alog().set_ostream(&tee_);
+  server_.get_elog().set_ostream(&tee_);
+}
+
+void OfflineWebsocketServer::OnOpen(connection_hdl hdl) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  connections_.emplace(hdl, std::make_shared<ConnectionData>());
+
+  SHERPA_ONNX_LOGE("Number of active connections: %d",
+                   static_cast<int32_t>(connections_.size()));
+}
+
+void OfflineWebsocketServer::OnClose(connection_hdl hdl) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  connections_.erase(hdl);
+
+  SHERPA_ONNX_LOGE("Number of active connections: %d",
+                   static_cast<int32_t>(connections_.size()));
+}
+
+void OfflineWebsocketServer::OnHttp(connection_hdl hdl) {
+  server::connection_ptr con = server_.get_con_from_hdl(hdl);
+
+  if (!config_.enable_metrics || con->get_request().get_method() != "GET" ||
+      con->get_resource() != "/metrics") {
+    con->set_status(websocketpp::http::status_code::not_found);
+    con->set_body("Not found");
+    return;
   }
-  server_.get_alog().write(websocketpp::log::alevel::app, os.str());
+
+  con->replace_header("Content-Type", "text/plain; version=0.0.4");
+  con->set_body(MetricsToPrometheusText());
+  con->set_status(websocketpp::http::status_code::ok);
+}
+
+void OfflineWebsocketServer::OnMessage(connection_hdl hdl,
+                                       server::message_ptr msg) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto connection_data = connections_.find(hdl)->second;
+  lock.unlock();
+
+  decoder_.OnMessage(hdl, connection_data, msg);
+}
+
+bool OfflineWebsocketServer::Contains(connection_hdl hdl) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return connections_.count(hdl);
 }
 
 void OfflineWebsocketServer::Run(uint16_t port) {
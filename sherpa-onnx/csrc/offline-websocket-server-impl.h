@@ -5,10 +5,12 @@
 #ifndef SHERPA_ONNX_CSRC_OFFLINE_WEBSOCKET_SERVER_IMPL_H_
 #define SHERPA_ONNX_CSRC_OFFLINE_WEBSOCKET_SERVER_IMPL_H_
 
+#include <chrono>  // NOLINT
 #include <deque>
 #include <fstream>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
@@ -16,11 +18,9 @@
 #include "sherpa-onnx/csrc/offline-recognizer.h"
 #include "sherpa-onnx/csrc/parse-options.h"
 #include "sherpa-onnx/csrc/tee-stream.h"
-#include "websocketpp/config/asio_no_tls.hpp"  // TODO(fangjun): support TLS
-#include "websocketpp/server.hpp"
-
-using server = websocketpp::server<websocketpp::config::asio>;
-using connection_hdl = websocketpp::connection_hdl;
+#include "sherpa-onnx/csrc/vad-model-config.h"
+#include "sherpa-onnx/csrc/voice-activity-detector.h"
+#include "sherpa-onnx/csrc/websocket-decoder-host.h"
 
 namespace sherpa_onnx {
 
@@ -36,7 +36,12 @@ namespace sherpa_onnx {
  * The byte stream can be broken into arbitrary number of messages.
  * We require that the first message has to be at least 8 bytes so that
  * we can get `sample_rate` and `expected_byte_size` from the first message.
+ *
+ * If `expected_byte_size` is -1, the upload uses the incremental mode;
+ * see IncrementalUpload.
  */
+struct IncrementalUpload;
+
 struct ConnectionData {
   // Sample rate of the audio samples the client
   int32_t sample_rate;
@@ -52,38 +57,168 @@ struct ConnectionData {
   // We expect that data.size() == expected_byte_size
   std::vector<int8_t> data;
 
+  // Hotwords for all utterances of this connection, separated by /.
+  // If empty, the hotwords of the recognizer config are used.
+  // It is not cleared by Clear().
+  std::string hotwords;
+
+  // Not null after an upload in the incremental mode is started. It is
+  // kept after the client sends "Done" until the next upload starts.
+  std::shared_ptr<IncrementalUpload> upload;
+
   void Clear() {
     sample_rate = 0;
     expected_byte_size = 0;
     cur = 0;
     data.clear();
+    upload.reset();
   }
 };
 
 using ConnectionDataPtr = std::shared_ptr<ConnectionData>;
 
+/** An upload in the incremental mode.
+ *
+ * The length of the audio is not known in advance. Received samples are
+ * split into segments by a VAD in the work threads, and each segment is
+ * decoded as soon as it ends, so results are sent back while the client
+ * is still uploading.
+ *
+ * Memory of an upload is bounded. The VAD keeps at most
+ * --max-utterance-length seconds of speech; longer speech is cut. The
+ * server stops reading from the connection while more than
+ * --max-backlog-seconds of received audio is waiting for the VAD or for
+ * decoding, and resumes once it drops below half of it.
+ *
+ * For each segment, the server sends a text message
+ *
+ *   {"is_final": false, "segment": 0, "start": 1.25, "duration": 3.10,
+ *    "result": {"text": ..., "timestamps": ..., ...}}
+ *
+ * where start and duration are in seconds and timestamps in the result
+ * are relative to the start of the segment. Results of different segments
+ * may arrive out of order. After the client sends "Done" and all segments
+ * are decoded, the server sends
+ *
+ *   {"is_final": true, "num_segments": 10}
+ *
+ * The client must not start another upload on the same connection before
+ * it receives the final message; otherwise, the connection is closed.
+ */
+struct IncrementalUpload {
+  explicit IncrementalUpload(asio::io_context &io_conn)  // NOLINT
+      : strand(asio::make_strand(io_conn)) {}
+
+  // Messages to the client are sent in this strand so that the final
+  // message is sent after the results of all segments.
+  asio::strand<asio::io_context::executor_type> strand;
+
+  int32_t sample_rate = 0;
+  std::string hotwords;
+
+  // Bytes of an incomplete sample at the end of the last message.
+  // Used only by the IO thread.
+  std::vector<int8_t> leftover;
+
+  // Protected by mutex
+  std::mutex mutex;
+  std::vector<float> samples;  // received but not given to the VAD yet
+  bool vad_scheduled = false;
+  bool eof = false;         // true if the client has sent "Done"
+  bool flushed = false;     // true if all segments have been queued
+  int32_t num_pending = 0;  // queued segments not decoded yet
+  bool paused = false;      // true if reading from the client is paused
+  bool final_sent = false;  // true if the final message has been sent
+
+  // Number of samples of the queued segments not decoded yet
+  int64_t num_pending_samples = 0;
+
+  // Used only by the work thread holding vad_mutex
+  std::mutex vad_mutex;
+  std::unique_ptr<VoiceActivityDetector> vad;
+  int32_t num_segments = 0;
+};
+
 struct OfflineWebsocketDecoderConfig {
   OfflineRecognizerConfig recognizer_config;
 
   int32_t max_batch_size = 5;
 
+  // Max number of feature frames (10 ms each) in a batch after padding,
+  // i.e., batch_size * num_frames_of_the_longest_utterance.
+  // An utterance longer than this value is decoded alone.
+  int32_t max_batch_frames = 30000;
+
+  // If a request has been waiting for longer than this value, the next batch
+  // is built around it even if other requests can form a fuller batch.
+  int32_t max_batch_wait_ms = 500;
+
   float max_utterance_length = 300;  // seconds
 
+  // In the incremental mode, stop reading from a connection if it has more
+  // than this number of seconds of audio that is not decoded yet. Reading
+  // is resumed once the backlog drops below half of it. 0 means no limit.
+  float max_backlog_seconds = 30;
+
+  // If a VAD model is given, clients can upload audio of unknown length
+  // in the incremental mode. See IncrementalUpload.
+  VadModelConfig vad_config;
+
+  bool IncrementalModeEnabled() const {
+    return !vad_config.silero_vad.model.empty();
+  }
+
   void Register(ParseOptions *po);
   void Validate() const;
 };
 
-class OfflineWebsocketServer;
+struct OfflineWebsocketRequest {
+  connection_hdl hdl;
+
+  // Features have been computed when the request is put into the queue
+  std::unique_ptr<OfflineStream> stream;
+
+  // Number of feature frames (10 ms each) of this request
+  int32_t num_frames = 0;
+
+  // Requests with similar num_frames share the same bucket
+  int32_t bucket = 0;
+
+  std::chrono::steady_clock::time_point arrival_time;
+
+  // Not null if the request is a segment of an incremental upload
+  std::shared_ptr<IncrementalUpload> upload;
+  int32_t segment = 0;
+  int32_t num_samples = 0;
+  float start = 0;     // in seconds
+  float duration = 0;  // in seconds
+};
 
 class OfflineWebsocketDecoder {
  public:
   /**
    * @param config Configuration for the decoder.
-   * @param server **Borrowed** from outside.
+   * @param host The server hosting this decoder. **Borrowed** from outside.
    */
-  explicit OfflineWebsocketDecoder(OfflineWebsocketServer *server);
+  OfflineWebsocketDecoder(const OfflineWebsocketDecoderConfig &config,
+                          WebsocketDecoderHost *host);
 
-  /** Insert received data to the queue for decoding.
+  /** Handle a message from the client. It is called by an IO thread.
+   *
+   * See OfflineWebsocketServer::OnMessage() for the protocol.
+   *
+   * @param hdl The connection
+   * @param connection_data Data received so far from this connection
+   * @param msg The message
+   */
+  void OnMessage(connection_hdl hdl, ConnectionDataPtr connection_data,
+                 server::message_ptr msg);
+
+  /** Compute features of the received data and insert it into the queue
+   * for decoding.
+   *
+   * It is called by one of the work threads. Feature extraction runs
+   * without holding the lock of the queue.
    *
    * @param hdl A handle to the connection. We can use it to send the result
    *            back to the client once it finishes decoding.
@@ -91,6 +226,16 @@ class OfflineWebsocketDecoder {
    */
   void Push(connection_hdl hdl, ConnectionDataPtr d);
 
+  /** Run the VAD on the samples received so far by an incremental upload
+   * and insert the segments it detects into the queue for decoding.
+   *
+   * It is called by one of the work threads.
+   *
+   * @return Return the number of segments inserted into the queue.
+   */
+  int32_t PushSegments(connection_hdl hdl,
+                       std::shared_ptr<IncrementalUpload> u);
+
   /** It is called by one of the work thread.
    */
   void Decode();
@@ -100,18 +245,84 @@ class OfflineWebsocketDecoder {
  private:
   OfflineWebsocketDecoderConfig config_;
 
+  // Create a request and compute its features
+  OfflineWebsocketRequest MakeRequest(connection_hdl hdl, int32_t sample_rate,
+                                      const float *samples,
+                                      int32_t num_samples,
+                                      const std::string &hotwords);
+
+  // Insert the segments detected by the VAD of u into the queue
+  int32_t PopSegments(connection_hdl hdl,
+                      const std::shared_ptr<IncrementalUpload> &u);
+
+  // Start an upload in the incremental mode. p and n are the samples in
+  // the first message after the header. It is called by an IO thread.
+  void StartUpload(connection_hdl hdl, ConnectionDataPtr connection_data,
+                   const int8_t *p, int32_t n);
+
+  // Handle the samples of an incremental upload in a message.
+  // It is called by an IO thread.
+  void AppendSamples(connection_hdl hdl,
+                     const std::shared_ptr<IncrementalUpload> &u,
+                     const int8_t *p, int32_t n);
+
+  // Mark the end of an incremental upload. It is called by an IO thread.
+  void FinishUpload(connection_hdl hdl,
+                    const std::shared_ptr<IncrementalUpload> &u);
+
+  // Post PushSegments() and Decode() to the work threads unless they are
+  // already posted. The caller must hold u->mutex.
+  void ScheduleVad(connection_hdl hdl,
+                   const std::shared_ptr<IncrementalUpload> &u);
+
+  // Number of samples of u that are received but not decoded yet.
+  // The caller must hold u->mutex.
+  static int64_t Backlog(const IncrementalUpload &u) {
+    return u.samples.size() + u.num_pending_samples;
+  }
+
+  // Pause reading from the client if the backlog of u is too large.
+  // It is called by an IO thread holding u->mutex.
+  void MaybePauseReading(connection_hdl hdl,
+                         const std::shared_ptr<IncrementalUpload> &u);
+
+  // Resume reading from the client once the backlog of u is small enough.
+  // The caller must hold u->mutex.
+  void MaybeResumeReading(connection_hdl hdl,
+                          const std::shared_ptr<IncrementalUpload> &u);
+
+  // Send the final message of u after the results of all its segments.
+  // The caller must hold u->mutex.
+  void SendFinalMessage(connection_hdl hdl,
+                        const std::shared_ptr<IncrementalUpload> &u);
+
+  // Send the result of a segment. It is called by a work thread.
+  void SendSegmentResult(const OfflineWebsocketRequest &r);
+
+  /** Select requests from streams_ for the next batch.
+   *
+   * Requests are grouped into buckets by their lengths. If the oldest request
+   * has waited longer than `--max-batch-wait-ms`, its bucket is selected;
+   * otherwise, the bucket with the most pending requests is selected.
+   * Requests are taken from the selected bucket in arrival order as long as
+   * the padded batch fits into `--max-batch-frames` and `--max-batch-size`.
+   *
+   * The caller must hold mutex_.
+   */
+  std::vector<OfflineWebsocketRequest> NextBatch();
+
   /** When we have received all the data from the client, we put it into
    * this queue; the worker threads will get items from this queue for
-   * decoding.
+   * decoding. Items are kept in arrival order.
    *
-   * Number of items to take from this queue is determined by
-   * `--max-batch-size`. If there are not enough items in the queue, we won't
-   * wait and take whatever we have for decoding.
+   * See NextBatch() for how items are taken from this queue. If there are
+   * not enough items in the queue, we won't wait and take whatever we have
+   * for decoding.
    */
   std::mutex mutex_;
-  std::deque<std::pair<connection_hdl, ConnectionDataPtr>> streams_;
+  std::deque<OfflineWebsocketRequest> streams_;
 
-  OfflineWebsocketServer *server_;  // Not owned
+  WebsocketDecoderHost *host_;  // Not owned
   OfflineRecognizer recognizer_;
 };
 
@@ -119,18 +330,25 @@ struct OfflineWebsocketServerConfig {
   OfflineWebsocketDecoderConfig decoder_config;
   std::string log_file = "./log.txt";
 
+  // If true, per-stage latency and throughput metrics are collected
+  // and served at http://host:port/metrics
+  bool enable_metrics = false;
+
   void Register(ParseOptions *po);
   void Validate() const;
 };
 
-class OfflineWebsocketServer {
+class OfflineWebsocketServer : public WebsocketDecoderHost {
  public:
   OfflineWebsocketServer(asio::io_context &io_conn,  // NOLINT
                          asio::io_context &io_work,  // NOLINT
                          const OfflineWebsocketServerConfig &config);
 
-  asio::io_context &GetConnectionContext() { return io_conn_; }
-  server &GetServer() { return server_; }
+  asio::io_context &GetConnectionContext() override { return io_conn_; }
+  asio::io_context &GetWorkContext() override { return io_work_; }
+  server &GetServer() override { return server_; }
+
+  bool Contains(connection_hdl hdl) const override;
 
   void Run(uint16_t port);
 
@@ -146,6 +364,10 @@ class OfflineWebsocketServer {
   // When a websocket client is disconnected, it will invoke this method
   void OnClose(connection_hdl hdl);
 
+  // When an HTTP request is received, it will invoke this method.
+  // Only GET /metrics is supported.
+  void OnHttp(connection_hdl hdl);
+
   // When a message is received from a websocket client, this method will
   // be invoked.
   //
@@ -177,12 +399,15 @@ class OfflineWebsocketServer {
   //  (b) Only sound files with a single channel is supported
   //  (c) Only audio samples are sent. For instance, if we want to decode
   //      a WAVE file, the RIFF header of the WAVE is not sent.
+  //  (d) If the server is started with --silero-vad-model, the client can
+  //      send -1 as the total number of bytes in (2). The audio is then
+  //      decoded segment by segment while it is uploaded; the client sends
+  //      "Done" to end the upload and receives a final message after the
+  //      results of all segments. See IncrementalUpload. After receiving
+  //      the final message, it can upload another file or send "Done"
+  //      again to close the connection.
   void OnMessage(connection_hdl hdl, server::message_ptr msg);
 
-  // Close a websocket connection with given code and reason
-  void Close(connection_hdl hdl, websocketpp::close::status::value code,
-             const std::string &reason);
-
  private:
   asio::io_context &io_conn_;
   asio::io_context &io_work_;
@@ -190,7 +415,7 @@ class OfflineWebsocketServer {
 
   std::map<connection_hdl, ConnectionDataPtr, std::owner_less<connection_hdl>>
       connections_;
-  std::mutex mutex_;
+  mutable std::mutex mutex_;
 
   OfflineWebsocketServerConfig config_;
 
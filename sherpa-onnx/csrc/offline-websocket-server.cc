@@ -24,7 +24,8 @@ Usage:
   --decoder=/path/to/decoder.onnx \
   --joiner=/path/to/joiner.onnx \
   --log-file=./log.txt \
-  --max-batch-size=5
+  --max-batch-size=5 \
+  --max-batch-frames=30000
 
 (2) For Paraformer
 
@@ -34,7 +35,15 @@ Usage:
   --tokens=/path/to/tokens.txt \
   --paraformer=/path/to/model.onnx \
   --log-file=./log.txt \
-  --max-batch-size=5
+  --max-batch-size=5 \
+  --max-batch-frames=30000
+
+(3) With incremental uploads
+
+Add --silero-vad-model=/path/to/silero_vad.onnx to any of the above.
+Clients can then send -1 as the number of bytes in the header and
+stream audio of unknown length. It is split into segments by the VAD
+and the result of each segment is sent back as soon as it is decoded.
 
 Please refer to
 https://k2-fsa.github.io/sherpa/onnx/pretrained_models/index.html
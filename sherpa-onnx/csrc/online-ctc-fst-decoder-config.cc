@@ -17,7 +17,8 @@ std::string OnlineCtcFstDecoderConfig::ToString() const {
 
   os << "OnlineCtcFstDecoderConfig(";
   os << "graph=\"" << graph << "\", ";
-  os << "max_active=" << max_active << ")";
+  os << "max_active=" << max_active << ", ";
+  os << "num_threads=" << num_threads << ")";
 
   return os.str();
 }
@@ -27,6 +28,11 @@ void OnlineCtcFstDecoderConfig::Register(ParseOptions *po) {
 
   po->Register("ctc-max-active", &max_active,
                "Decoder max active states.  Larger->slower; more accurate");
+
+  po->Register("ctc-num-threads", &num_threads,
+               "Number of threads to run the graph search of different "
+               "streams of a batch in parallel. 1 decodes them one by one "
+               "in the calling thread.");
 }
 
 bool OnlineCtcFstDecoderConfig::Validate() const {
@@ -34,6 +40,13 @@ bool OnlineCtcFstDecoderConfig::Validate() const {
     SHERPA_ONNX_LOGE("graph: '%s' does not exist", graph.c_str());
     return false;
   }
+
+  if (num_threads < 1) {
+    SHERPA_ONNX_LOGE("--ctc-num-threads should be positive. Given: %d",
+                     num_threads);
+    return false;
+  }
+
   return true;
 }
 
@@ -16,6 +16,10 @@ struct OnlineCtcFstDecoderConfig {
   std::string graph;
   int32_t max_active = 3000;
 
+  // Number of threads to decode the streams of a batch in parallel.
+  // The search of each stream is independent of other streams.
+  int32_t num_threads = 1;
+
   OnlineCtcFstDecoderConfig() = default;
 
   OnlineCtcFstDecoderConfig(const std::string &graph, int32_t max_active)
@@ -14,17 +14,21 @@
 #include "kaldi-decoder/csrc/decodable-ctc.h"
 #include "kaldifst/csrc/fstext-utils.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/offline-ctc-fst-decoder.h"
 #include "sherpa-onnx/csrc/online-stream.h"
+#include "sherpa-onnx/csrc/thread-pool.h"
 
 namespace sherpa_onnx {
 
-// defined in ./offline-ctc-fst-decoder.cc
-fst::Fst<fst::StdArc> *ReadGraph(const std::string &filename);
-
 OnlineCtcFstDecoder::OnlineCtcFstDecoder(
     const OnlineCtcFstDecoderConfig &config, int32_t blank_id)
     : config_(config), fst_(ReadGraph(config.graph)), blank_id_(blank_id) {
   options_.max_active = config_.max_active;
+
+  if (config_.num_threads > 1) {
+    // The calling thread also decodes streams
+    pool_ = std::make_unique<ThreadPool>(config_.num_threads - 1);
+  }
 }
 
 std::unique_ptr<kaldi_decoder::FasterDecoder>
@@ -32,6 +36,49 @@ OnlineCtcFstDecoder::CreateFasterDecoder() const {
   return std::make_unique<kaldi_decoder::FasterDecoder>(*fst_, options_);
 }
 
+// Convert the best path, which is a linear FST, to tokens.
+// Each arc with a non-zero ilabel is a frame.
+static void ConvertBestPath(const fst::VectorFst<fst::LatticeArc> &best_path,
+                            int32_t blank_id, OnlineCtcDecoderResult *result) {
+  auto &tokens = result->tokens;
+  auto &timestamps = result->timestamps;
+  tokens.clear();
+  timestamps.clear();
+
+  int32_t prev_id = -1;
+  int32_t num_trailing_blanks = 0;
+  int32_t f = 0;  // frame number
+
+  auto s = best_path.Start();
+  while (s != fst::kNoStateId && best_path.NumArcs(s) > 0) {
+    fst::ArcIterator<fst::VectorFst<fst::LatticeArc>> aiter(best_path, s);
+    const auto &arc = aiter.Value();
+    s = arc.nextstate;
+
+    if (arc.ilabel == 0) {
+      continue;
+    }
+
+    int32_t i = arc.ilabel - 1;
+
+    if (i == blank_id) {
+      num_trailing_blanks += 1;
+    } else {
+      num_trailing_blanks = 0;
+    }
+
+    if (i != blank_id && i != prev_id) {
+      tokens.push_back(i);
+      timestamps.push_back(f);
+    }
+    prev_id = i;
+    f += 1;
+  }
+
+  result->num_trailing_blanks = num_trailing_blanks;
+  // no need to set frame_offset
+}
+
 static void DecodeOne(const float *log_probs, int32_t num_rows,
                       int32_t num_cols, OnlineCtcDecoderResult *result,
                       OnlineStream *s, int32_t blank_id) {
@@ -47,44 +94,9 @@ static void DecodeOne(const float *log_probs, int32_t num_rows,
   decoder->AdvanceDecoding(&decodable);
 
   if (decoder->ReachedFinal()) {
-    fst::VectorFst<fst::LatticeArc> fst_out;
-    bool ok = decoder->GetBestPath(&fst_out);
-    if (ok) {
-      std::vector<int32_t> isymbols_out;
-      std::vector<int32_t> osymbols_out_unused;
-      ok = fst::GetLinearSymbolSequence(fst_out, &isymbols_out,
-                                        &osymbols_out_unused, nullptr);
-      std::vector<int64_t> tokens;
-      tokens.reserve(isymbols_out.size());
-
-      std::vector<int32_t> timestamps;
-      timestamps.reserve(isymbols_out.size());
-
-      std::ostringstream os;
-      int32_t prev_id = -1;
-      int32_t &num_trailing_blanks = result->num_trailing_blanks;
-      int32_t f = 0;  // frame number
-
-      for (auto i : isymbols_out) {
-        i -= 1;
-
-        if (i == blank_id) {
-          num_trailing_blanks += 1;
-        } else {
-          num_trailing_blanks = 0;
-        }
-
-        if (i != blank_id && i != prev_id) {
-          tokens.push_back(i);
-          timestamps.push_back(f);
-        }
-        prev_id = i;
-        f += 1;
-      }
-
-      result->tokens = std::move(tokens);
-      result->timestamps = std::move(timestamps);
-      // no need to set frame_offset
+    fst::VectorFst<fst::LatticeArc> best_path;
+    if (decoder->GetBestPath(&best_path)) {
+      ConvertBestPath(best_path, blank_id, result);
     }
   }
 
@@ -116,9 +128,19 @@ void OnlineCtcFstDecoder::Decode(Ort::Value log_probs,
 
   const float *p = log_probs.GetTensorData<float>();
 
-  for (int32_t i = 0; i != batch_size; ++i) {
+  auto decode = [=](int32_t i) {
     DecodeOne(p + i * num_frames * vocab_size, num_frames, vocab_size,
               &(*results)[i], ss[i], blank_id_);
+  };
+
+  if (pool_) {
+    // Each stream has its own FasterDecoder, so they can be decoded
+    // in parallel
+    pool_->ParallelFor(batch_size, decode);
+  } else {
+    for (int32_t i = 0; i != batch_size; ++i) {
+      decode(i);
+    }
   }
 }
 
@@ -11,6 +11,7 @@
 #include "fst/fst.h"
 #include "sherpa-onnx/csrc/online-ctc-decoder.h"
 #include "sherpa-onnx/csrc/online-ctc-fst-decoder-config.h"
+#include "sherpa-onnx/csrc/thread-pool.h"
 
 namespace sherpa_onnx {
 
@@ -30,8 +31,12 @@ class OnlineCtcFstDecoder : public OnlineCtcDecoder {
   OnlineCtcFstDecoderConfig config_;
   kaldi_decoder::FasterDecoderOptions options_;
 
-  std::unique_ptr<fst::Fst<fst::StdArc>> fst_;
+  // Shared with other decoders using the same graph
+  std::shared_ptr<const fst::Fst<fst::StdArc>> fst_;
   int32_t blank_id_ = 0;
+
+  // Used only when config_.num_threads > 1
+  std::unique_ptr<ThreadPool> pool_;
 };
 
 }  // namespace sherpa_onnx
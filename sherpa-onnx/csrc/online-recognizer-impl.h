@@ -50,6 +50,8 @@ class OnlineRecognizerImpl {
   virtual bool IsEndpoint(OnlineStream *s) const = 0;
 
   virtual void Reset(OnlineStream *s) const = 0;
+
+  virtual OnlineTransducerDecoderStats GetDecoderStats() const { return {}; }
 };
 
 }  // namespace sherpa_onnx
@@ -21,6 +21,7 @@
 
 #include "sherpa-onnx/csrc/file-utils.h"
 #include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/metrics.h"
 #include "sherpa-onnx/csrc/online-lm.h"
 #include "sherpa-onnx/csrc/online-recognizer-impl.h"
 #include "sherpa-onnx/csrc/online-recognizer.h"
@@ -109,12 +110,13 @@ class OnlineRecognizerTransducerImpl : public OnlineRecognizerImpl {
       decoder_ = std::make_unique<OnlineTransducerModifiedBeamSearchDecoder>(
           model_.get(), lm_.get(), config_.max_active_paths,
           config_.lm_config.scale, unk_id_, config_.blank_penalty,
-          config_.temperature_scale);
+          config_.temperature_scale, config_.blank_skip_threshold,
+          config_.decoder_out_cache_size);
 
     } else if (config.decoding_method == "greedy_search") {
       decoder_ = std::make_unique<OnlineTransducerGreedySearchDecoder>(
           model_.get(), unk_id_, config_.blank_penalty,
-          config_.temperature_scale);
+          config_.temperature_scale, config_.blank_skip_threshold);
 
     } else {
       SHERPA_ONNX_LOGE("Unsupported decoding method: %s",
@@ -157,12 +159,13 @@ class OnlineRecognizerTransducerImpl : public OnlineRecognizerImpl {
       decoder_ = std::make_unique<OnlineTransducerModifiedBeamSearchDecoder>(
           model_.get(), lm_.get(), config_.max_active_paths,
           config_.lm_config.scale, unk_id_, config_.blank_penalty,
-          config_.temperature_scale);
+          config_.temperature_scale, config_.blank_skip_threshold,
+          config_.decoder_out_cache_size);
 
     } else if (config.decoding_method == "greedy_search") {
       decoder_ = std::make_unique<OnlineTransducerGreedySearchDecoder>(
           model_.get(), unk_id_, config_.blank_penalty,
-          config_.temperature_scale);
+          config_.temperature_scale, config_.blank_skip_threshold);
 
     } else {
       SHERPA_ONNX_LOGE("Unsupported decoding method: %s",
@@ -189,9 +192,10 @@ class OnlineRecognizerTransducerImpl : public OnlineRecognizerImpl {
       SHERPA_ONNX_LOGE("Encode hotwords failed, skipping, hotwords are : %s",
                        hotwords.c_str());
     }
-    current.insert(current.end(), hotwords_.begin(), hotwords_.end());
-    auto context_graph =
-        std::make_shared<ContextGraph>(current, config_.hotwords_score);
+    // Build only the per-stream hotwords. The global hotwords graph is
+    // shared by all streams and used as the base layer.
+    auto context_graph = std::make_shared<ContextGraph>(
+        hotwords_graph_, current, config_.hotwords_score);
     auto stream =
         std::make_unique<OnlineStream>(config_.feat_config, context_graph);
     InitOnlineStream(stream.get());
@@ -239,6 +243,19 @@ class OnlineRecognizerTransducerImpl : public OnlineRecognizerImpl {
   }
 
   void DecodeStreams(OnlineStream **ss, int32_t n) const override {
+    static Histogram *feature_time =
+        GetStageHistogram("online_recognizer", "feature");
+    static Histogram *stack_states_time =
+        GetStageHistogram("online_recognizer", "stack_states");
+    static Histogram *encoder_time =
+        GetStageHistogram("online_recognizer", "encoder");
+    static Histogram *search_time =
+        GetStageHistogram("online_recognizer", "search");
+    static Histogram *unstack_states_time =
+        GetStageHistogram("online_recognizer", "unstack_states");
+
+    ScopedTimer feature_timer(feature_time);
+
     int32_t chunk_size = model_->ChunkSize();
     int32_t chunk_shift = model_->ChunkShift();
 
@@ -285,20 +302,29 @@ class OnlineRecognizerTransducerImpl : public OnlineRecognizerImpl {
     Ort::Value processed_frames = Ort::Value::CreateTensor(
         memory_info, all_processed_frames.data(), all_processed_frames.size(),
         processed_frames_shape.data(), processed_frames_shape.size());
+    feature_timer.Stop();
 
+    ScopedTimer stack_states_timer(stack_states_time);
     auto states = model_->StackStates(states_vec);
+    stack_states_timer.Stop();
 
+    ScopedTimer encoder_timer(encoder_time);
     auto pair = model_->RunEncoder(std::move(x), std::move(states),
                                    std::move(processed_frames));
+    encoder_timer.Stop();
 
+    ScopedTimer search_timer(search_time);
     if (has_context_graph) {
       decoder_->Decode(std::move(pair.first), ss, &results);
     } else {
       decoder_->Decode(std::move(pair.first), &results);
     }
+    search_timer.Stop();
 
+    ScopedTimer unstack_states_timer(unstack_states_time);
     std::vector<std::vector<Ort::Value>> next_states =
         model_->UnStackStates(pair.second);
+    unstack_states_timer.Stop();
 
     for (int32_t i = 0; i != n; ++i) {
       ss[i]->SetResult(results[i]);
@@ -356,6 +382,7 @@ class OnlineRecognizerTransducerImpl : public OnlineRecognizerImpl {
         nullptr != s->GetContextGraph()) {
       for (auto it = r.hyps.begin(); it != r.hyps.end(); ++it) {
         it->second.context_state = s->GetContextGraph()->Root();
+        it->second.base_context_state = s->GetContextGraph()->BaseRoot();
       }
     }
     s->SetResult(r);
@@ -366,6 +393,10 @@ class OnlineRecognizerTransducerImpl : public OnlineRecognizerImpl {
     s->Reset();
   }
 
+  OnlineTransducerDecoderStats GetDecoderStats() const override {
+    return decoder_->GetStats();
+  }
+
  private:
   void InitHotwords() {
     // each line in hotwords_file contains space-separated words
@@ -420,6 +451,8 @@ class OnlineRecognizerTransducerImpl : public OnlineRecognizerImpl {
       // r.hyps has only one element.
       for (auto it = r.hyps.begin(); it != r.hyps.end(); ++it) {
         it->second.context_state = stream->GetContextGraph()->Root();
+        it->second.base_context_state =
+            stream->GetContextGraph()->BaseRoot();
       }
     }
 
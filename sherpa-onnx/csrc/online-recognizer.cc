@@ -6,63 +6,116 @@
 #include "sherpa-onnx/csrc/online-recognizer.h"
 
 #include <assert.h>
+#include <stdio.h>
 
 #include <algorithm>
-#include <iomanip>
 #include <memory>
 #include <sstream>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "sherpa-onnx/csrc/metrics.h"
 #include "sherpa-onnx/csrc/online-recognizer-impl.h"
 
 namespace sherpa_onnx {
 
-/// Helper for `OnlineRecognizerResult::AsJsonString()`
-template <typename T>
-std::string VecToString(const std::vector<T> &vec, int32_t precision = 6) {
-  std::ostringstream oss;
-  oss << std::fixed << std::setprecision(precision);
-  oss << "[ ";
-  std::string sep = "";
-  for (const auto &item : vec) {
-    oss << sep << item;
+/// Helpers for `OnlineRecognizerResult::AsJsonString()`.
+///
+/// They append to a std::string directly instead of using std::ostringstream
+/// since AsJsonString() is called for every chunk of every stream in the
+/// websocket server. The output is the same as that of
+/// `os << std::fixed << std::setprecision(precision) << f`.
+static void AppendFloat(float f, int32_t precision, std::string *out) {
+  char buf[64];
+  int32_t n = snprintf(buf, sizeof(buf), "%.*f", precision, f);
+  out->append(buf, n);
+}
+
+static void AppendFloats(const std::vector<float> &vec, int32_t precision,
+                         std::string *out) {
+  out->append("[ ");
+  const char *sep = "";
+  for (auto f : vec) {
+    out->append(sep);
+    AppendFloat(f, precision, out);
     sep = ", ";
   }
-  oss << " ]";
-  return oss.str();
-}
-
-/// Helper for `OnlineRecognizerResult::AsJsonString()`
-template <>  // explicit specialization for T = std::string
-std::string VecToString<std::string>(const std::vector<std::string> &vec,
-                                     int32_t) {  // ignore 2nd arg
-  std::ostringstream oss;
-  oss << "[ ";
-  std::string sep = "";
-  for (const auto &item : vec) {
-    oss << sep << "\"" << item << "\"";
+  out->append(" ]");
+}
+
+static void AppendStrings(const std::vector<std::string> &vec,
+                          std::string *out) {
+  out->append("[ ");
+  const char *sep = "";
+  for (const auto &s : vec) {
+    out->append(sep);
+    out->push_back('"');
+    out->append(s);
+    out->push_back('"');
     sep = ", ";
   }
-  oss << " ]";
-  return oss.str();
+  out->append(" ]");
 }
 
 std::string OnlineRecognizerResult::AsJsonString() const {
-  std::ostringstream os;
-  os << "{ ";
-  os << "\"text\": " << "\"" << text << "\"" << ", ";
-  os << "\"tokens\": " << VecToString(tokens) << ", ";
-  os << "\"timestamps\": " << VecToString(timestamps, 2) << ", ";
-  os << "\"ys_probs\": " << VecToString(ys_probs, 6) << ", ";
-  os << "\"lm_probs\": " << VecToString(lm_probs, 6) << ", ";
-  os << "\"context_scores\": " << VecToString(context_scores, 6) << ", ";
-  os << "\"segment\": " << segment << ", ";
-  os << "\"start_time\": " << std::fixed << std::setprecision(2) << start_time
-     << ", ";
-  os << "\"is_final\": " << (is_final ? "true" : "false");
-  os << "}";
-  return os.str();
+  return AsJsonStringWithFields(kAllFields);
+}
+
+std::string OnlineRecognizerResult::AsJsonStringWithFields(
+    int32_t fields) const {
+  std::string os;
+  os.reserve(128 + text.size() + (tokens.size() + timestamps.size() +
+                                  ys_probs.size() + lm_probs.size() +
+                                  context_scores.size()) *
+                                     12);
+
+  os.append("{ ");
+  if (fields & kText) {
+    os.append("\"text\": \"");
+    os.append(text);
+    os.append("\", ");
+  }
+
+  if (fields & kTokens) {
+    os.append("\"tokens\": ");
+    AppendStrings(tokens, &os);
+    os.append(", ");
+  }
+
+  if (fields & kTimestamps) {
+    os.append("\"timestamps\": ");
+    AppendFloats(timestamps, 2, &os);
+    os.append(", ");
+  }
+
+  if (fields & kYsProbs) {
+    os.append("\"ys_probs\": ");
+    AppendFloats(ys_probs, 6, &os);
+    os.append(", ");
+  }
+
+  if (fields & kLmProbs) {
+    os.append("\"lm_probs\": ");
+    AppendFloats(lm_probs, 6, &os);
+    os.append(", ");
+  }
+
+  if (fields & kContextScores) {
+    os.append("\"context_scores\": ");
+    AppendFloats(context_scores, 6, &os);
+    os.append(", ");
+  }
+
+  os.append("\"segment\": ");
+  os.append(std::to_string(segment));
+  os.append(", \"start_time\": ");
+  AppendFloat(start_time, 2, &os);
+  os.append(", \"is_final\": ");
+  os.append(is_final ? "true" : "false");
+  os.append("}");
+
+  return os;
 }
 
 void OnlineRecognizerConfig::Register(ParseOptions *po) {
@@ -95,9 +148,38 @@ void OnlineRecognizerConfig::Register(ParseOptions *po) {
                "now support greedy_search and modified_beam_search.");
   po->Register("temperature-scale", &temperature_scale,
                "Temperature scale for confidence computation in decoding.");
+  po->Register("blank-skip-threshold", &blank_skip_threshold,
+               "If positive, the joiner is run on all frames of a chunk in "
+               "a single batch first. With greedy_search, the batch is "
+               "redone for the rest of the chunk after a stream emits a "
+               "token, so the result is exact. With modified_beam_search, "
+               "frames whose blank probability exceeds this threshold are "
+               "decoded as blank without running the joiner for them "
+               "again. Only the best path is checked, so it is an "
+               "approximation; the first pass of a stream is redone for "
+               "the rest of the chunk after its best path emits a token. "
+               "0.95 is a good value to start with. 0 disables it. "
+               "Currently only applicable for transducer models.");
+  po->Register("decoder-out-cache-size", &decoder_out_cache_size,
+               "Maximum number of decoder outputs cached across frames and "
+               "streams. Hypotheses with the same last context-size tokens "
+               "share a cached decoder output. 0 disables the cache. Used "
+               "only for transducer models with modified_beam_search.");
 }
 
 bool OnlineRecognizerConfig::Validate() const {
+  if (blank_skip_threshold < 0 || blank_skip_threshold >= 1) {
+    SHERPA_ONNX_LOGE("--blank-skip-threshold should be in [0, 1). Given: %f",
+                     blank_skip_threshold);
+    return false;
+  }
+
+  if (decoder_out_cache_size < 0) {
+    SHERPA_ONNX_LOGE("--decoder-out-cache-size should be >= 0. Given: %d",
+                     decoder_out_cache_size);
+    return false;
+  }
+
   if (decoding_method == "modified_beam_search" && !lm_config.model.empty()) {
     if (max_active_paths <= 0) {
       SHERPA_ONNX_LOGE("max_active_paths is less than 0! Given: %d",
@@ -142,7 +224,9 @@ std::string OnlineRecognizerConfig::ToString() const {
   os << "hotwords_file=\"" << hotwords_file << "\", ";
   os << "decoding_method=\"" << decoding_method << "\", ";
   os << "blank_penalty=" << blank_penalty << ", ";
-  os << "temperature_scale=" << temperature_scale << ")";
+  os << "temperature_scale=" << temperature_scale << ", ";
+  os << "blank_skip_threshold=" << blank_skip_threshold << ", ";
+  os << "decoder_out_cache_size=" << decoder_out_cache_size << ")";
 
   return os.str();
 }
@@ -178,10 +262,21 @@ void OnlineRecognizer::WarmpUpRecognizer(int32_t warmup, int32_t mbs) const {
 }
 
 void OnlineRecognizer::DecodeStreams(OnlineStream **ss, int32_t n) const {
+  static Histogram *decode_time =
+      GetStageHistogram("online_recognizer", "decode_streams");
+  static Histogram *batch_size = GetBatchSizeHistogram("online_recognizer");
+
+  ObserveIfEnabled(batch_size, n);
+
+  ScopedTimer timer(decode_time);
   impl_->DecodeStreams(ss, n);
 }
 
 OnlineRecognizerResult OnlineRecognizer::GetResult(OnlineStream *s) const {
+  static Histogram *result_time =
+      GetStageHistogram("online_recognizer", "result");
+
+  ScopedTimer timer(result_time);
   return impl_->GetResult(s);
 }
 
@@ -191,4 +286,8 @@ bool OnlineRecognizer::IsEndpoint(OnlineStream *s) const {
 
 void OnlineRecognizer::Reset(OnlineStream *s) const { impl_->Reset(s); }
 
+OnlineTransducerDecoderStats OnlineRecognizer::GetDecoderStats() const {
+  return impl_->GetDecoderStats();
+}
+
 }  // namespace sherpa_onnx
@@ -74,6 +74,23 @@ struct OnlineRecognizerResult {
    *   }
    */
   std::string AsJsonString() const;
+
+  /// Fields that can be selected in AsJsonStringWithFields()
+  enum JsonField : int32_t {
+    kText = 1,
+    kTokens = 2,
+    kTimestamps = 4,
+    kYsProbs = 8,
+    kLmProbs = 16,
+    kContextScores = 32,
+    kAllFields = 63,
+  };
+
+  /** Like AsJsonString() but only the fields whose bits are set in
+   * `fields` are included. See JsonField. "segment", "start_time" and
+   * "is_final" are always included.
+   */
+  std::string AsJsonStringWithFields(int32_t fields) const;
 };
 
 struct OnlineRecognizerConfig {
@@ -98,6 +115,20 @@ struct OnlineRecognizerConfig {
 
   float temperature_scale = 2.0;
 
+  /// Used only for transducer models. If positive, the joiner is run on
+  /// all frames of a chunk in a batch first. With greedy_search, the batch
+  /// is redone for the rest of the chunk after a stream emits a token, so
+  /// the result is exact. With modified_beam_search, frames whose blank
+  /// probability exceeds it are decoded as blank without running the
+  /// joiner for them separately. Only the best path is checked, so it is
+  /// an approximation. 0 disables it.
+  float blank_skip_threshold = 0;
+
+  /// Used only for transducer models with modified_beam_search. Maximum
+  /// number of decoder outputs, keyed by the last context_size tokens,
+  /// cached across frames and streams. 0 disables the cache.
+  int32_t decoder_out_cache_size = 1024;
+
   OnlineRecognizerConfig() = default;
 
   OnlineRecognizerConfig(
@@ -197,6 +228,13 @@ class OnlineRecognizer {
   // after calling this function, IsEndpoint(s) will return false
   void Reset(OnlineStream *s) const;
 
+  /** Return statistics of blank-frame skipping, accumulated over all
+   * streams decoded so far. See OnlineRecognizerConfig::blank_skip_threshold.
+   *
+   * It returns all zeros for non-transducer models.
+   */
+  OnlineTransducerDecoderStats GetDecoderStats() const;
+
  private:
   std::unique_ptr<OnlineRecognizerImpl> impl_;
 };
@@ -21,6 +21,21 @@ class OnlineStream::Impl {
     feat_extractor_.AcceptWaveform(sampling_rate, waveform, n);
   }
 
+  void AcceptWaveform(int32_t sampling_rate, const int16_t *waveform,
+                      int32_t n) {
+    feat_extractor_.AcceptWaveform(sampling_rate, waveform, n);
+  }
+
+  void AcceptWaveformMuLaw(int32_t sampling_rate, const uint8_t *waveform,
+                           int32_t n) {
+    feat_extractor_.AcceptWaveformMuLaw(sampling_rate, waveform, n);
+  }
+
+  void AcceptWaveformALaw(int32_t sampling_rate, const uint8_t *waveform,
+                          int32_t n) {
+    feat_extractor_.AcceptWaveformALaw(sampling_rate, waveform, n);
+  }
+
   void InputFinished() const { feat_extractor_.InputFinished(); }
 
   int32_t NumFramesReady() const {
@@ -148,6 +163,23 @@ void OnlineStream::AcceptWaveform(int32_t sampling_rate, const float *waveform,
   impl_->AcceptWaveform(sampling_rate, waveform, n);
 }
 
+void OnlineStream::AcceptWaveform(int32_t sampling_rate,
+                                  const int16_t *waveform, int32_t n) const {
+  impl_->AcceptWaveform(sampling_rate, waveform, n);
+}
+
+void OnlineStream::AcceptWaveformMuLaw(int32_t sampling_rate,
+                                       const uint8_t *waveform,
+                                       int32_t n) const {
+  impl_->AcceptWaveformMuLaw(sampling_rate, waveform, n);
+}
+
+void OnlineStream::AcceptWaveformALaw(int32_t sampling_rate,
+                                      const uint8_t *waveform,
+                                      int32_t n) const {
+  impl_->AcceptWaveformALaw(sampling_rate, waveform, n);
+}
+
 void OnlineStream::InputFinished() const { impl_->InputFinished(); }
 
 int32_t OnlineStream::NumFramesReady() const { return impl_->NumFramesReady(); }
@@ -4,10 +4,14 @@
 
 #include "sherpa-onnx/csrc/online-transducer-decoder.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <utility>
 #include <vector>
 
 #include "onnxruntime_cxx_api.h"  // NOLINT
+#include "sherpa-onnx/csrc/online-transducer-model.h"
 #include "sherpa-onnx/csrc/onnx-utils.h"
 
 namespace sherpa_onnx {
@@ -71,4 +75,52 @@ OnlineTransducerDecoderResult &OnlineTransducerDecoderResult::operator=(
   return *this;
 }
 
+Ort::Value RunJoinerOnAllFrames(OnlineTransducerModel *model,
+                                Ort::Value *encoder_out,
+                                const Ort::Value &decoder_out) {
+  std::vector<int64_t> encoder_out_shape =
+      encoder_out->GetTensorTypeAndShapeInfo().GetShape();
+  int64_t batch_size = encoder_out_shape[0];
+  int64_t num_frames = encoder_out_shape[1];
+  int64_t encoder_out_dim = encoder_out_shape[2];
+
+  auto memory_info =
+      Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+
+  // (N, T, C) -> (N * T, C). It shares the memory with encoder_out
+  std::array<int64_t, 2> x_shape{batch_size * num_frames, encoder_out_dim};
+  Ort::Value x = Ort::Value::CreateTensor(
+      memory_info, encoder_out->GetTensorMutableData<float>(),
+      batch_size * num_frames * encoder_out_dim, x_shape.data(),
+      x_shape.size());
+
+  std::vector<int64_t> decoder_out_shape =
+      decoder_out.GetTensorTypeAndShapeInfo().GetShape();
+  int64_t decoder_out_dim = decoder_out_shape[1];
+
+  std::array<int64_t, 2> y_shape{batch_size * num_frames, decoder_out_dim};
+  Ort::Value y = Ort::Value::CreateTensor<float>(
+      model->Allocator(), y_shape.data(), y_shape.size());
+
+  const float *src = decoder_out.GetTensorData<float>();
+  float *dst = y.GetTensorMutableData<float>();
+  for (int64_t b = 0; b != batch_size; ++b, src += decoder_out_dim) {
+    for (int64_t t = 0; t != num_frames; ++t, dst += decoder_out_dim) {
+      std::copy(src, src + decoder_out_dim, dst);
+    }
+  }
+
+  return model->RunJoiner(std::move(x), std::move(y));
+}
+
+float BlankLogProb(const float *logit, int32_t vocab_size) {
+  float max_logit = *std::max_element(logit, logit + vocab_size);
+  float sum = 0;
+  for (int32_t i = 0; i != vocab_size; ++i) {
+    sum += std::exp(logit[i] - max_logit);
+  }
+
+  return logit[0] - max_logit - std::log(sum);
+}
+
 }  // namespace sherpa_onnx
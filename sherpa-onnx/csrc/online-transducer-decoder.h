@@ -50,7 +50,44 @@ struct OnlineTransducerDecoderResult {
       OnlineTransducerDecoderResult &&other);
 };
 
+/// Statistics of blank-frame skipping. See --blank-skip-threshold
+struct OnlineTransducerDecoderStats {
+  /// Number of frames decoded, summed over all streams
+  int64_t num_frames = 0;
+
+  /// Number of frames decoded without running the joiner for them
+  /// separately, i.e., frames decoded from the batched first pass
+  int64_t num_skipped_frames = 0;
+
+  float SkipRate() const {
+    return num_frames ? static_cast<float>(num_skipped_frames) / num_frames
+                      : 0;
+  }
+};
+
 class OnlineStream;
+class OnlineTransducerModel;
+
+/** Run the joiner on all frames of encoder_out in a single call, using
+ * the same decoder output for all frames of a stream.
+ *
+ * It is the first pass of blank-frame skipping. Since the decoder output
+ * changes only when a token is emitted, its result is exact for frames
+ * before the first emitted token of each stream.
+ *
+ * @param model The transducer model.
+ * @param encoder_out A 3-D tensor of shape (N, T, joiner_dim)
+ * @param decoder_out A 2-D tensor of shape (N, joiner_dim)
+ * @return Return a tensor of shape (N * T, vocab_size). Row b * T + t
+ *         contains the logits of frame t of stream b.
+ */
+Ort::Value RunJoinerOnAllFrames(OnlineTransducerModel *model,
+                                Ort::Value *encoder_out,
+                                const Ort::Value &decoder_out);
+
+/// Return the log-posterior of blank (ID 0) given the logits of a frame
+float BlankLogProb(const float *logit, int32_t vocab_size);
+
 class OnlineTransducerDecoder {
  public:
   virtual ~OnlineTransducerDecoder() = default;
@@ -104,6 +141,9 @@ class OnlineTransducerDecoder {
 
   // used for endpointing. We need to keep decoder_out after reset
   virtual void UpdateDecoderOut(OnlineTransducerDecoderResult *result) {}
+
+  /// Return statistics of blank-frame skipping since the decoder is created
+  virtual OnlineTransducerDecoderStats GetStats() const { return {}; }
 };
 
 }  // namespace sherpa_onnx
@@ -0,0 +1,171 @@
+// sherpa-onnx/csrc/online-transducer-greedy-search-decoder-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/online-transducer-greedy-search-decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+// A fake model with vocab_size 3 and context_size 1.
+//
+// The decoder output is the last token. Each encoder frame contains two
+// sets of logits: the first one is used if the last token is blank and
+// the second one is used otherwise.
+class FakeModel : public OnlineTransducerModel {
+ public:
+  std::vector<Ort::Value> StackStates(
+      const std::vector<std::vector<Ort::Value>> &states) const override {
+    return {};
+  }
+
+  std::vector<std::vector<Ort::Value>> UnStackStates(
+      const std::vector<Ort::Value> &states) const override {
+    return {};
+  }
+
+  std::vector<Ort::Value> GetEncoderInitStates() override { return {}; }
+
+  std::pair<Ort::Value, std::vector<Ort::Value>> RunEncoder(
+      Ort::Value features, std::vector<Ort::Value> states,
+      Ort::Value processed_frames) override {
+    return {std::move(features), std::move(states)};
+  }
+
+  Ort::Value RunDecoder(Ort::Value decoder_input) override {
+    std::vector<int64_t> shape =
+        decoder_input.GetTensorTypeAndShapeInfo().GetShape();
+    std::array<int64_t, 2> out_shape{shape[0], 1};
+    Ort::Value ans = Ort::Value::CreateTensor<float>(
+        Allocator(), out_shape.data(), out_shape.size());
+
+    const int64_t *src = decoder_input.GetTensorData<int64_t>();
+    float *dst = ans.GetTensorMutableData<float>();
+    std::copy(src, src + shape[0], dst);
+
+    ++num_decoder_calls;
+    return ans;
+  }
+
+  Ort::Value RunJoiner(Ort::Value encoder_out,
+                       Ort::Value decoder_out) override {
+    int64_t n = encoder_out.GetTensorTypeAndShapeInfo().GetShape()[0];
+    std::array<int64_t, 2> shape{n, kVocabSize};
+    Ort::Value ans = Ort::Value::CreateTensor<float>(Allocator(), shape.data(),
+                                                     shape.size());
+
+    const float *p_encoder_out = encoder_out.GetTensorData<float>();
+    const float *p_decoder_out = decoder_out.GetTensorData<float>();
+    float *dst = ans.GetTensorMutableData<float>();
+    for (int64_t i = 0; i != n; ++i, dst += kVocabSize) {
+      const float *src = p_encoder_out + i * 2 * kVocabSize;
+      if (p_decoder_out[i] != 0) {
+        src += kVocabSize;
+      }
+      std::copy(src, src + kVocabSize, dst);
+    }
+
+    ++num_joiner_calls;
+    return ans;
+  }
+
+  int32_t ContextSize() const override { return 1; }
+
+  int32_t ChunkSize() const override { return 1; }
+
+  int32_t ChunkShift() const override { return 1; }
+
+  int32_t VocabSize() const override { return kVocabSize; }
+
+  OrtAllocator *Allocator() override { return allocator_; }
+
+  static constexpr int32_t kVocabSize = 3;
+
+  int32_t num_decoder_calls = 0;
+  int32_t num_joiner_calls = 0;
+
+ private:
+  Ort::AllocatorWithDefaultOptions allocator_;
+};
+
+// Two streams with 3 frames each. Stream 0 emits token 1 at frame 0.
+// Frame 1 is a strong blank if the last token is blank but emits token 2
+// after token 1, so it must not be decoded from the first pass.
+// Stream 1 contains only blanks.
+static Ort::Value GetEncoderOut(OrtAllocator *allocator) {
+  std::vector<float> data = {
+      // stream 0
+      0, 5, 0, 10, 0, 0,   // frame 0
+      10, 0, 0, 0, 0, 5,   // frame 1
+      10, 0, 0, 10, 0, 0,  // frame 2
+
+      // stream 1
+      10, 0, 0, 10, 0, 0,  // frame 0
+      10, 0, 0, 10, 0, 0,  // frame 1
+      10, 0, 0, 10, 0, 0,  // frame 2
+  };
+
+  std::array<int64_t, 3> shape{2, 3, 2 * FakeModel::kVocabSize};
+  Ort::Value ans =
+      Ort::Value::CreateTensor<float>(allocator, shape.data(), shape.size());
+  std::copy(data.begin(), data.end(), ans.GetTensorMutableData<float>());
+  return ans;
+}
+
+static std::vector<OnlineTransducerDecoderResult> Decode(
+    float blank_skip_threshold, FakeModel *model,
+    OnlineTransducerDecoderStats *stats) {
+  OnlineTransducerGreedySearchDecoder decoder(model, -1, 0, 1,
+                                              blank_skip_threshold);
+  std::vector<OnlineTransducerDecoderResult> results(2);
+  for (auto &r : results) {
+    r = decoder.GetEmptyResult();
+  }
+
+  decoder.Decode(GetEncoderOut(model->Allocator()), &results);
+  *stats = decoder.GetStats();
+  return results;
+}
+
+TEST(OnlineTransducerGreedySearchDecoder, SkipAfterEmission) {
+  FakeModel model;
+  OnlineTransducerDecoderStats stats;
+  auto expected = Decode(0, &model, &stats);
+
+  ASSERT_EQ(expected[0].tokens, (std::vector<int64_t>{0, 1, 2}));
+  ASSERT_EQ(expected[0].timestamps, (std::vector<int32_t>{0, 1}));
+  ASSERT_EQ(expected[1].tokens, (std::vector<int64_t>{0}));
+  EXPECT_EQ(stats.num_frames, 6);
+  EXPECT_EQ(stats.num_skipped_frames, 0);
+
+  FakeModel skip_model;
+  auto results = Decode(0.95, &skip_model, &stats);
+
+  for (int32_t i = 0; i != 2; ++i) {
+    EXPECT_EQ(results[i].tokens, expected[i].tokens);
+    EXPECT_EQ(results[i].timestamps, expected[i].timestamps);
+    ASSERT_EQ(results[i].ys_probs.size(), expected[i].ys_probs.size());
+    for (size_t k = 0; k != results[i].ys_probs.size(); ++k) {
+      EXPECT_FLOAT_EQ(results[i].ys_probs[k], expected[i].ys_probs[k]);
+    }
+    EXPECT_EQ(results[i].num_trailing_blanks,
+              expected[i].num_trailing_blanks);
+  }
+
+  // frames 1 and 2 of stream 0 are computed again after token 1
+  EXPECT_EQ(stats.num_frames, 6);
+  EXPECT_EQ(stats.num_skipped_frames, 4);
+
+  // one joiner call for the first pass and one after each emission that
+  // is not at the last frame
+  EXPECT_EQ(skip_model.num_joiner_calls, 3);
+  EXPECT_EQ(model.num_joiner_calls, 3);
+}
+
+}  // namespace sherpa_onnx
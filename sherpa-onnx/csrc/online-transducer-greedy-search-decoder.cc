@@ -5,6 +5,8 @@
 #include "sherpa-onnx/csrc/online-transducer-greedy-search-decoder.h"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <utility>
 #include <vector>
 
@@ -50,6 +52,42 @@ static void UpdateCachedDecoderOut(
   }
 }
 
+Ort::Value OnlineTransducerGreedySearchDecoder::RunJoinerOnRemainingFrames(
+    Ort::Value *encoder_out, const Ort::Value &decoder_out,
+    const std::vector<int32_t> &streams, int32_t t) const {
+  std::vector<int64_t> encoder_out_shape =
+      encoder_out->GetTensorTypeAndShapeInfo().GetShape();
+  int32_t num_frames = static_cast<int32_t>(encoder_out_shape[1]);
+  int32_t encoder_out_dim = static_cast<int32_t>(encoder_out_shape[2]);
+
+  int32_t decoder_out_dim = static_cast<int32_t>(
+      decoder_out.GetTensorTypeAndShapeInfo().GetShape()[1]);
+
+  int32_t n = static_cast<int32_t>(streams.size());
+
+  std::array<int64_t, 3> x_shape{n, num_frames - t, encoder_out_dim};
+  Ort::Value x = Ort::Value::CreateTensor<float>(
+      model_->Allocator(), x_shape.data(), x_shape.size());
+
+  std::array<int64_t, 2> y_shape{n, decoder_out_dim};
+  Ort::Value y = Ort::Value::CreateTensor<float>(
+      model_->Allocator(), y_shape.data(), y_shape.size());
+
+  const float *p_encoder_out = encoder_out->GetTensorData<float>();
+  const float *p_decoder_out = decoder_out.GetTensorData<float>();
+  float *p_x = x.GetTensorMutableData<float>();
+  float *p_y = y.GetTensorMutableData<float>();
+  for (auto i : streams) {
+    const float *src = p_encoder_out + (i * num_frames + t) * encoder_out_dim;
+    p_x = std::copy(src, src + (num_frames - t) * encoder_out_dim, p_x);
+
+    src = p_decoder_out + i * decoder_out_dim;
+    p_y = std::copy(src, src + decoder_out_dim, p_y);
+  }
+
+  return RunJoinerOnAllFrames(model_, &x, y);
+}
+
 OnlineTransducerDecoderResult
 OnlineTransducerGreedySearchDecoder::GetEmptyResult() const {
   int32_t context_size = model_->ContextSize();
@@ -112,20 +150,74 @@ void OnlineTransducerGreedySearchDecoder::Decode(
     decoder_out = model_->RunDecoder(std::move(decoder_input));
   }
 
+  bool skip_blanks = blank_skip_threshold_ > 0;
+
+  // Logits of frames computed in batches; used only if skip_blanks is true.
+  // The first pass contains all frames of all streams, computed with the
+  // decoder_out at the start of this chunk. After a stream emits a token,
+  // its remaining frames are computed again with the new decoder_out in a
+  // later pass, so the logits are always exact.
+  std::vector<Ort::Value> passes;
+
+  // next_logits[i] points to the logits of stream i for the next frame
+  std::vector<float *> next_logits(batch_size);
+
+  // changed[i] is true if stream i has emitted a token in this chunk, so
+  // its logits are no longer from the first pass
+  std::vector<bool> changed(batch_size, false);
+
+  if (skip_blanks) {
+    passes.push_back(RunJoinerOnAllFrames(model_, &encoder_out, decoder_out));
+    float *p = passes.back().GetTensorMutableData<float>();
+    for (int32_t i = 0; i != batch_size; ++i) {
+      next_logits[i] = p + i * num_frames * vocab_size;
+    }
+  }
+
+  // logits[i] points to the logits of stream i for the current frame
+  std::vector<float *> logits(batch_size);
+
+  // streams that have emitted a token at the current frame
+  std::vector<int32_t> streams;
+
+  int64_t num_skipped_frames = 0;
+
   for (int32_t t = 0; t != num_frames; ++t) {
-    Ort::Value cur_encoder_out =
-        GetEncoderOutFrame(model_->Allocator(), &encoder_out, t);
-    Ort::Value logit =
-        model_->RunJoiner(std::move(cur_encoder_out), View(&decoder_out));
+    Ort::Value logit{nullptr};
+
+    if (skip_blanks) {
+      for (int32_t i = 0; i != batch_size; ++i) {
+        logits[i] = next_logits[i];
+        next_logits[i] += vocab_size;
+
+        if (blank_penalty_ > 0.0) {
+          logits[i][0] -= blank_penalty_;  // assuming blank id is 0
+        }
 
-    float *p_logit = logit.GetTensorMutableData<float>();
+        if (!changed[i]) {
+          ++num_skipped_frames;
+        }
+      }
+    } else {
+      Ort::Value cur_encoder_out =
+          GetEncoderOutFrame(model_->Allocator(), &encoder_out, t);
+      logit =
+          model_->RunJoiner(std::move(cur_encoder_out), View(&decoder_out));
 
+      float *p_logit = logit.GetTensorMutableData<float>();
+      for (int32_t i = 0; i != batch_size; ++i, p_logit += vocab_size) {
+        if (blank_penalty_ > 0.0) {
+          p_logit[0] -= blank_penalty_;  // assuming blank id is 0
+        }
+        logits[i] = p_logit;
+      }
+    }
+
+    streams.clear();
     bool emitted = false;
-    for (int32_t i = 0; i < batch_size; ++i, p_logit += vocab_size) {
+    for (int32_t i = 0; i < batch_size; ++i) {
       auto &r = (*result)[i];
-      if (blank_penalty_ > 0.0) {
-        p_logit[0] -= blank_penalty_;  // assuming blank id is 0
-      }
+      float *p_logit = logits[i];
 
       auto y = static_cast<int32_t>(std::distance(
           static_cast<const float *>(p_logit),
@@ -135,6 +227,8 @@ void OnlineTransducerGreedySearchDecoder::Decode(
       // also, it treats unk as blank
       if (y != 0 && y != unk_id_) {
         emitted = true;
+        changed[i] = true;
+        streams.push_back(i);
         r.tokens.push_back(y);
         r.timestamps.push_back(t + r.frame_offset);
         r.num_trailing_blanks = 0;
@@ -160,9 +254,22 @@ void OnlineTransducerGreedySearchDecoder::Decode(
     if (emitted) {
       Ort::Value decoder_input = model_->BuildDecoderInput(*result);
       decoder_out = model_->RunDecoder(std::move(decoder_input));
+
+      if (skip_blanks && t + 1 != num_frames) {
+        passes.push_back(RunJoinerOnRemainingFrames(&encoder_out, decoder_out,
+                                                    streams, t + 1));
+        float *p = passes.back().GetTensorMutableData<float>();
+        for (auto i : streams) {
+          next_logits[i] = p;
+          p += (num_frames - t - 1) * vocab_size;
+        }
+      }
     }
   }
 
+  num_frames_ += batch_size * num_frames;
+  num_skipped_frames_ += num_skipped_frames;
+
   UpdateCachedDecoderOut(model_->Allocator(), &decoder_out, result);
 
   // Update frame_offset
@@ -171,4 +278,12 @@ void OnlineTransducerGreedySearchDecoder::Decode(
   }
 }
 
+OnlineTransducerDecoderStats OnlineTransducerGreedySearchDecoder::GetStats()
+    const {
+  OnlineTransducerDecoderStats stats;
+  stats.num_frames = num_frames_;
+  stats.num_skipped_frames = num_skipped_frames_;
+  return stats;
+}
+
 }  // namespace sherpa_onnx
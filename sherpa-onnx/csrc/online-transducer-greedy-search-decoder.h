@@ -5,6 +5,7 @@
 #ifndef SHERPA_ONNX_CSRC_ONLINE_TRANSDUCER_GREEDY_SEARCH_DECODER_H_
 #define SHERPA_ONNX_CSRC_ONLINE_TRANSDUCER_GREEDY_SEARCH_DECODER_H_
 
+#include <atomic>
 #include <vector>
 
 #include "sherpa-onnx/csrc/online-transducer-decoder.h"
@@ -17,11 +18,13 @@ class OnlineTransducerGreedySearchDecoder : public OnlineTransducerDecoder {
   OnlineTransducerGreedySearchDecoder(OnlineTransducerModel *model,
                                       int32_t unk_id,
                                       float blank_penalty,
-                                      float temperature_scale)
+                                      float temperature_scale,
+                                      float blank_skip_threshold = 0)
       : model_(model),
       unk_id_(unk_id),
       blank_penalty_(blank_penalty),
-      temperature_scale_(temperature_scale) {}
+      temperature_scale_(temperature_scale),
+      blank_skip_threshold_(blank_skip_threshold) {}
 
   OnlineTransducerDecoderResult GetEmptyResult() const override;
 
@@ -30,11 +33,37 @@ class OnlineTransducerGreedySearchDecoder : public OnlineTransducerDecoder {
   void Decode(Ort::Value encoder_out,
               std::vector<OnlineTransducerDecoderResult> *result) override;
 
+  OnlineTransducerDecoderStats GetStats() const override;
+
  private:
+  /** Run the joiner on frames [t, T) of the given streams in a single
+   * call with their rows of decoder_out.
+   *
+   * @param encoder_out A tensor of shape (N, T, C).
+   * @param decoder_out A tensor of shape (N, decoder_dim).
+   * @return Return a tensor of shape (streams.size() * (T - t), vocab_size).
+   *         Row j * (T - t) + k contains the logits of frame t + k of
+   *         stream streams[j].
+   */
+  Ort::Value RunJoinerOnRemainingFrames(Ort::Value *encoder_out,
+                                        const Ort::Value &decoder_out,
+                                        const std::vector<int32_t> &streams,
+                                        int32_t t) const;
+
   OnlineTransducerModel *model_;  // Not owned
   int32_t unk_id_;
   float blank_penalty_;
   float temperature_scale_;
+
+  // If positive, the joiner is run on all frames of a chunk at once first.
+  // A stream uses the result until it emits a token. After that, the
+  // joiner is run again at once on the remaining frames of the stream.
+  // The result is the same as with a joiner call per frame, so the value
+  // of the threshold does not matter for greedy search.
+  float blank_skip_threshold_;
+
+  std::atomic<int64_t> num_frames_{0};
+  std::atomic<int64_t> num_skipped_frames_{0};
 };
 
 }  // namespace sherpa_onnx
@@ -6,6 +6,9 @@
 #include "sherpa-onnx/csrc/online-transducer-modified-beam-search-decoder.h"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
 #include <utility>
 #include <vector>
 
@@ -14,10 +17,14 @@
 
 namespace sherpa_onnx {
 
+// is_first_frame[i] is true if stream i has not been decoded in this chunk.
+// Only such streams use the cached decoder_out. Streams without hyps in
+// hyps_row_splits are skipped in the current frame.
 static void UseCachedDecoderOut(
     const std::vector<int32_t> &hyps_row_splits,
     const std::vector<OnlineTransducerDecoderResult> &results,
-    int32_t context_size, Ort::Value *decoder_out) {
+    int32_t context_size, std::vector<bool> *is_first_frame,
+    Ort::Value *decoder_out) {
   std::vector<int64_t> shape =
       decoder_out->GetTensorTypeAndShapeInfo().GetShape();
 
@@ -26,7 +33,14 @@ static void UseCachedDecoderOut(
   int32_t batch_size = static_cast<int32_t>(results.size());
   for (int32_t i = 0; i != batch_size; ++i) {
     int32_t num_hyps = hyps_row_splits[i + 1] - hyps_row_splits[i];
-    if (num_hyps > 1 || !results[i].decoder_out) {
+    if (num_hyps == 0) {
+      continue;
+    }
+
+    bool first_frame = (*is_first_frame)[i];
+    (*is_first_frame)[i] = false;
+
+    if (!first_frame || num_hyps > 1 || !results[i].decoder_out) {
       dst += num_hyps * shape[1];
       continue;
     }
@@ -99,27 +113,90 @@ void OnlineTransducerModifiedBeamSearchDecoder::Decode(
   }
   std::vector<Hypothesis> prev;
 
+  bool skip_blanks = blank_skip_threshold_ > 0;
+  float log_threshold = skip_blanks ? std::log(blank_skip_threshold_) : 0;
+
+  int32_t context_size = model_->ContextSize();
+
+  // contexts[b] is the context of the path of stream b used to compute
+  // blank_log_probs of stream b
+  std::vector<float> blank_log_probs;
+  std::vector<std::vector<int64_t>> contexts;
+  std::vector<int32_t> streams;
+  if (skip_blanks) {
+    blank_log_probs.resize(batch_size * num_frames);
+    contexts.resize(batch_size);
+    streams.resize(batch_size);
+    std::iota(streams.begin(), streams.end(), 0);
+
+    ComputeBlankLogProbs(&encoder_out, cur, *result, streams, 0,
+                         &blank_log_probs, &contexts);
+  }
+
+  std::vector<bool> is_first_frame(batch_size, true);
+  std::vector<int32_t> hyps_row_splits(batch_size + 1);
+  int64_t num_skipped_frames = 0;
+
   for (int32_t t = 0; t != num_frames; ++t) {
+    if (skip_blanks && t != 0) {
+      // The blank probabilities of a stream are computed again for the
+      // remaining frames once its best path has emitted a token, since
+      // they depend on the last context_size tokens of the path
+      streams.clear();
+      for (int32_t b = 0; b != batch_size; ++b) {
+        Hypothesis best = cur[b].GetMostProbable(false);
+        if (!std::equal(best.ys.end() - context_size, best.ys.end(),
+                        contexts[b].begin())) {
+          streams.push_back(b);
+        }
+      }
+
+      if (!streams.empty()) {
+        ComputeBlankLogProbs(&encoder_out, cur, *result, streams, t,
+                             &blank_log_probs, &contexts);
+      }
+    }
+
     // Due to merging paths with identical token sequences,
     // not all utterances have "num_active_paths" paths.
-    auto hyps_row_splits = GetHypsRowSplits(cur);
+    //
+    // A stream whose blank probability of this frame exceeds the threshold
+    // in the first pass gets 0 rows, and all of its paths are extended
+    // with blank.
+    for (int32_t b = 0; b != batch_size; ++b) {
+      int32_t n = cur[b].Size();
+      if (skip_blanks && blank_log_probs[b * num_frames + t] > log_threshold) {
+        float blank_log_prob = blank_log_probs[b * num_frames + t];
+        for (auto &h : cur[b]) {
+          h.second.log_prob += blank_log_prob;
+          ++h.second.num_trailing_blanks;
+        }
+        ++num_skipped_frames;
+        n = 0;
+      }
+      hyps_row_splits[b + 1] = hyps_row_splits[b] + n;
+    }
+
     int32_t num_hyps =
         hyps_row_splits.back();  // total num hyps for all utterance
+    if (num_hyps == 0) {
+      continue;
+    }
+
     prev.clear();
-    for (auto &hyps : cur) {
-      for (auto &h : hyps) {
+    for (int32_t b = 0; b != batch_size; ++b) {
+      if (hyps_row_splits[b + 1] == hyps_row_splits[b]) {
+        continue;
+      }
+
+      for (auto &h : cur[b]) {
         prev.push_back(std::move(h.second));
       }
     }
-    cur.clear();
-    cur.reserve(batch_size);
-
-    Ort::Value decoder_input = model_->BuildDecoderInput(prev);
-    Ort::Value decoder_out = model_->RunDecoder(std::move(decoder_input));
-    if (t == 0) {
-      UseCachedDecoderOut(hyps_row_splits, *result, model_->ContextSize(),
-                          &decoder_out);
-    }
+
+    Ort::Value decoder_out = RunDecoder(prev);
+    UseCachedDecoderOut(hyps_row_splits, *result, model_->ContextSize(),
+                        &is_first_frame, &decoder_out);
 
     Ort::Value cur_encoder_out =
         GetEncoderOutFrame(model_->Allocator(), &encoder_out, t);
@@ -168,6 +245,11 @@ void OnlineTransducerModifiedBeamSearchDecoder::Decode(
       int32_t frame_offset = (*result)[b].frame_offset;
       int32_t start = hyps_row_splits[b];
       int32_t end = hyps_row_splits[b + 1];
+      if (start == end) {
+        // this frame is skipped for this stream
+        continue;
+      }
+
       auto topk =
           TopkIndex(p_logprob, vocab_size * (end - start), max_active_paths_);
 
@@ -189,7 +271,8 @@ void OnlineTransducerModifiedBeamSearchDecoder::Decode(
           new_hyp.num_trailing_blanks = 0;
           if (ss != nullptr && ss[b]->GetContextGraph() != nullptr) {
             auto context_res = ss[b]->GetContextGraph()->ForwardOneStep(
-                context_state, new_token, false /*strict mode*/);
+                context_state, &new_hyp.base_context_state, new_token,
+                false /*strict mode*/);
             context_score = std::get<0>(context_res);
             new_hyp.context_state = std::get<1>(context_res);
           }
@@ -223,11 +306,14 @@ void OnlineTransducerModifiedBeamSearchDecoder::Decode(
 
         hyps.Add(std::move(new_hyp));
       }  // for (auto k : topk)
-      cur.push_back(std::move(hyps));
+      cur[b] = std::move(hyps);
       p_logprob += (end - start) * vocab_size;
     }  // for (int32_t b = 0; b != batch_size; ++b)
   }  // for (int32_t t = 0; t != num_frames; ++t)
 
+  num_frames_ += batch_size * num_frames;
+  num_skipped_frames_ += num_skipped_frames;
+
   for (int32_t b = 0; b != batch_size; ++b) {
     auto &hyps = cur[b];
     auto best_hyp = hyps.GetMostProbable(true);
@@ -240,6 +326,123 @@ void OnlineTransducerModifiedBeamSearchDecoder::Decode(
   }
 }
 
+void OnlineTransducerModifiedBeamSearchDecoder::ComputeBlankLogProbs(
+    Ort::Value *encoder_out, const std::vector<Hypotheses> &hyps,
+    const std::vector<OnlineTransducerDecoderResult> &results,
+    const std::vector<int32_t> &streams, int32_t t,
+    std::vector<float> *blank_log_probs,
+    std::vector<std::vector<int64_t>> *contexts) {
+  int32_t vocab_size = model_->VocabSize();
+  int32_t context_size = model_->ContextSize();
+  int32_t num_streams = static_cast<int32_t>(streams.size());
+
+  std::vector<Hypothesis> best_hyps;
+  best_hyps.reserve(num_streams);
+  std::vector<int32_t> row_splits(num_streams + 1);
+  for (int32_t i = 0; i != num_streams; ++i) {
+    best_hyps.push_back(hyps[streams[i]].GetMostProbable(false));
+    row_splits[i + 1] = i + 1;
+
+    const auto &ys = best_hyps.back().ys;
+    (*contexts)[streams[i]].assign(ys.end() - context_size, ys.end());
+  }
+
+  Ort::Value decoder_out = RunDecoder(best_hyps);
+
+  std::vector<int64_t> encoder_out_shape =
+      encoder_out->GetTensorTypeAndShapeInfo().GetShape();
+  int32_t num_frames = static_cast<int32_t>(encoder_out_shape[1]);
+  int32_t encoder_out_dim = static_cast<int32_t>(encoder_out_shape[2]);
+
+  Ort::Value logit{nullptr};
+  if (t == 0) {
+    // Streams that have a single path may still use the decoder_out kept
+    // after endpointing. See UpdateDecoderOut()
+    std::vector<bool> is_first_frame(num_streams);
+    for (int32_t b = 0; b != num_streams; ++b) {
+      is_first_frame[b] = hyps[b].Size() == 1;
+    }
+    UseCachedDecoderOut(row_splits, results, context_size, &is_first_frame,
+                        &decoder_out);
+
+    logit = RunJoinerOnAllFrames(model_, encoder_out, decoder_out);
+  } else {
+    // Frames [t, T) of the given streams
+    std::array<int64_t, 3> shape{num_streams, num_frames - t,
+                                 encoder_out_dim};
+    Ort::Value x = Ort::Value::CreateTensor<float>(
+        model_->Allocator(), shape.data(), shape.size());
+
+    const float *src = encoder_out->GetTensorData<float>();
+    float *dst = x.GetTensorMutableData<float>();
+    for (auto b : streams) {
+      const float *p = src + (b * num_frames + t) * encoder_out_dim;
+      dst = std::copy(p, p + (num_frames - t) * encoder_out_dim, dst);
+    }
+
+    logit = RunJoinerOnAllFrames(model_, &x, decoder_out);
+  }
+
+  float *p_logit = logit.GetTensorMutableData<float>();
+
+  for (auto b : streams) {
+    float *p_ans = blank_log_probs->data() + b * num_frames;
+    for (int32_t i = t; i != num_frames; ++i, p_logit += vocab_size) {
+      if (blank_penalty_ > 0.0) {
+        p_logit[0] -= blank_penalty_;  // assuming blank id is 0
+      }
+      p_ans[i] = BlankLogProb(p_logit, vocab_size);
+    }
+  }
+}
+
+Ort::Value OnlineTransducerModifiedBeamSearchDecoder::RunDecoder(
+    const std::vector<Hypothesis> &hyps) {
+  int32_t context_size = model_->ContextSize();
+  int32_t num_hyps = static_cast<int32_t>(hyps.size());
+
+  std::vector<int64_t> contexts(num_hyps * context_size);
+  int64_t *p = contexts.data();
+  for (const auto &h : hyps) {
+    std::copy(h.ys.end() - context_size, h.ys.end(), p);
+    p += context_size;
+  }
+
+  auto run_decoder = [this, context_size](const int64_t *contexts, int32_t n,
+                                          std::vector<float> *decoder_out) {
+    std::array<int64_t, 2> shape{n, context_size};
+    Ort::Value decoder_input = Ort::Value::CreateTensor<int64_t>(
+        model_->Allocator(), shape.data(), shape.size());
+    std::copy(contexts, contexts + n * context_size,
+              decoder_input.GetTensorMutableData<int64_t>());
+
+    Ort::Value out = model_->RunDecoder(std::move(decoder_input));
+    const float *p_out = out.GetTensorData<float>();
+    decoder_out->assign(
+        p_out, p_out + out.GetTensorTypeAndShapeInfo().GetElementCount());
+  };
+
+  std::vector<float> rows;
+  decoder_out_cache_.Get(contexts.data(), num_hyps, run_decoder, &rows);
+
+  std::array<int64_t, 2> shape{num_hyps,
+                               static_cast<int64_t>(rows.size() / num_hyps)};
+  Ort::Value decoder_out = Ort::Value::CreateTensor<float>(
+      model_->Allocator(), shape.data(), shape.size());
+  std::copy(rows.begin(), rows.end(),
+            decoder_out.GetTensorMutableData<float>());
+
+  return decoder_out;
+}
+
+OnlineTransducerDecoderStats
+OnlineTransducerModifiedBeamSearchDecoder::GetStats() const {
+  OnlineTransducerDecoderStats stats;
+  stats.num_frames = num_frames_;
+  stats.num_skipped_frames = num_skipped_frames_;
+  return stats;
+}
+
 void OnlineTransducerModifiedBeamSearchDecoder::UpdateDecoderOut(
     OnlineTransducerDecoderResult *result) {
   if (result->tokens.size() == model_->ContextSize()) {
@@ -6,8 +6,10 @@
 #ifndef SHERPA_ONNX_CSRC_ONLINE_TRANSDUCER_MODIFIED_BEAM_SEARCH_DECODER_H_
 #define SHERPA_ONNX_CSRC_ONLINE_TRANSDUCER_MODIFIED_BEAM_SEARCH_DECODER_H_
 
+#include <atomic>
 #include <vector>
 
+#include "sherpa-onnx/csrc/decoder-out-cache.h"
 #include "sherpa-onnx/csrc/online-lm.h"
 #include "sherpa-onnx/csrc/online-stream.h"
 #include "sherpa-onnx/csrc/online-transducer-decoder.h"
@@ -23,14 +25,18 @@ class OnlineTransducerModifiedBeamSearchDecoder
                                             int32_t max_active_paths,
                                             float lm_scale, int32_t unk_id,
                                             float blank_penalty,
-                                            float temperature_scale)
+                                            float temperature_scale,
+                                            float blank_skip_threshold = 0,
+                                            int32_t decoder_out_cache_size = 0)
       : model_(model),
         lm_(lm),
         max_active_paths_(max_active_paths),
         lm_scale_(lm_scale),
         unk_id_(unk_id),
         blank_penalty_(blank_penalty),
-        temperature_scale_(temperature_scale) {}
+        temperature_scale_(temperature_scale),
+        blank_skip_threshold_(blank_skip_threshold),
+        decoder_out_cache_(model->ContextSize(), decoder_out_cache_size) {}
 
   OnlineTransducerDecoderResult GetEmptyResult() const override;
 
@@ -44,6 +50,36 @@ class OnlineTransducerModifiedBeamSearchDecoder
 
   void UpdateDecoderOut(OnlineTransducerDecoderResult *result) override;
 
+  OnlineTransducerDecoderStats GetStats() const override;
+
+ private:
+  /** Compute the blank log-posterior of frames [t, T) of the given streams
+   * with the joiner run once on all of these frames, using the decoder
+   * output of the most probable hypothesis of each stream.
+   *
+   * @param encoder_out  A tensor of shape (N, T, C).
+   * @param streams  Indexes of the streams to compute. It must contain all
+   *                 streams if t is 0.
+   * @param t  Index of the first frame to compute.
+   * @param blank_log_probs  A vector of size N * T. Entry b * T + i is set
+   *                         for each given stream b and each i >= t.
+   * @param contexts  A vector of size N. contexts[b] is set to the context
+   *                  of the hypothesis used for each given stream b.
+   */
+  void ComputeBlankLogProbs(
+      Ort::Value *encoder_out, const std::vector<Hypotheses> &hyps,
+      const std::vector<OnlineTransducerDecoderResult> &results,
+      const std::vector<int32_t> &streams, int32_t t,
+      std::vector<float> *blank_log_probs,
+      std::vector<std::vector<int64_t>> *contexts);
+
+  /** Run the decoder for the given hypotheses. Only contexts that are not
+   * in decoder_out_cache_ are passed to the decoder model.
+   *
+   * @return Return a tensor of shape (hyps.size(), decoder_dim).
+   */
+  Ort::Value RunDecoder(const std::vector<Hypothesis> &hyps);
+
  private:
   OnlineTransducerModel *model_;  // Not owned
   OnlineLM *lm_;                  // Not owned
@@ -53,6 +89,20 @@ class OnlineTransducerModifiedBeamSearchDecoder
   int32_t unk_id_;
   float blank_penalty_;
   float temperature_scale_;
+
+  // If positive, frames where the blank probability of the best path
+  // exceeds it in a batched first pass extend all paths with blank
+  // without running the decoder and the joiner for them. The first pass
+  // of a stream is redone for the remaining frames of the chunk once its
+  // best path has emitted a token. Other paths are not checked, so it is
+  // an approximation.
+  float blank_skip_threshold_;
+
+  // Decoder outputs shared by all streams of the recognizer
+  DecoderOutCache decoder_out_cache_;
+
+  std::atomic<int64_t> num_frames_{0};
+  std::atomic<int64_t> num_skipped_frames_{0};
 };
 
 }  // namespace sherpa_onnx
@@ -4,13 +4,51 @@
 
 #include "sherpa-onnx/csrc/online-websocket-server-impl.h"
 
+#include <string>
 #include <vector>
 
 #include "sherpa-onnx/csrc/file-utils.h"
 #include "sherpa-onnx/csrc/log.h"
+#include "sherpa-onnx/csrc/metrics.h"
+#include "sherpa-onnx/csrc/text-utils.h"
 
 namespace sherpa_onnx {
 
+// Convert a comma-separated list of fields, e.g., "text,timestamps",
+// to a bit mask of OnlineRecognizerResult::JsonField.
+static bool ParseResultFields(const std::string &s, int32_t *fields) {
+  if (s.empty() || s == "all") {
+    *fields = OnlineRecognizerResult::kAllFields;
+    return true;
+  }
+
+  std::vector<std::string> names;
+  SplitStringToVector(s, ",", true, &names);
+
+  int32_t ans = 0;
+  for (const auto &name : names) {
+    if (name == "text") {
+      ans |= OnlineRecognizerResult::kText;
+    } else if (name == "tokens") {
+      ans |= OnlineRecognizerResult::kTokens;
+    } else if (name == "timestamps") {
+      ans |= OnlineRecognizerResult::kTimestamps;
+    } else if (name == "ys_probs") {
+      ans |= OnlineRecognizerResult::kYsProbs;
+    } else if (name == "lm_probs") {
+      ans |= OnlineRecognizerResult::kLmProbs;
+    } else if (name == "context_scores") {
+      ans |= OnlineRecognizerResult::kContextScores;
+    } else {
+      SHERPA_ONNX_LOGE("Unknown result field: '%s'", name.c_str());
+      return false;
+    }
+  }
+
+  *fields = ans;
+  return true;
+}
+
 void OnlineWebsocketDecoderConfig::Register(ParseOptions *po) {
   recognizer_config.Register(po);
 
@@ -22,6 +60,35 @@ void OnlineWebsocketDecoderConfig::Register(ParseOptions *po) {
 
   po->Register("end-tail-padding", &end_tail_padding,
                "It determines the length of tail_padding at the end of audio.");
+
+  po->Register("result-fields", &result_fields,
+               "Comma-separated list of fields sent to the client in each "
+               "result. Valid fields are: text, tokens, timestamps, ys_probs, "
+               "lm_probs, context_scores. segment, start_time and is_final "
+               "are always sent. Leave it empty to send all fields. "
+               "A client can override it by sending a text message "
+               "'Options: result-fields=text,timestamps'");
+
+  po->Register("skip-unchanged-results", &skip_unchanged_results,
+               "If true, a result is not sent to the client if its text, "
+               "segment and is_final are the same as the last one sent. "
+               "A client can override it by sending a text message "
+               "'Options: skip-unchanged-results=1'");
+
+  po->Register("sample-format", &sample_format,
+               "Format of audio samples sent by clients. Valid values are: "
+               "float (normalized to [-1, 1]), int16, mulaw, alaw. "
+               "A client can override it by sending a text message "
+               "'Options: sample-format=mulaw sample-rate=8000'");
+
+  po->Register("idle-timeout-seconds", &idle_timeout_seconds,
+               "Close a connection if nothing is received from it for this "
+               "number of seconds. 0 means to never close it.");
+
+  po->Register("max-backlog-seconds", &max_backlog_seconds,
+               "Stop reading from a connection if it has more than this "
+               "number of seconds of audio that is not decoded yet, and "
+               "resume once it drops below half of it. 0 means no limit.");
 }
 
 void OnlineWebsocketDecoderConfig::Validate() const {
@@ -29,6 +96,27 @@ void OnlineWebsocketDecoderConfig::Validate() const {
   SHERPA_ONNX_CHECK_GT(loop_interval_ms, 0);
   SHERPA_ONNX_CHECK_GT(max_batch_size, 0);
   SHERPA_ONNX_CHECK_GT(end_tail_padding, 0);
+  SHERPA_ONNX_CHECK_GE(idle_timeout_seconds, 0);
+
+  // Half of it must be more than a chunk of the model. Otherwise, a
+  // paused connection may never be resumed.
+  if (max_backlog_seconds != 0 && max_backlog_seconds < 2) {
+    SHERPA_ONNX_LOGE("--max-backlog-seconds should be 0 or >= 2. Given: %.3f",
+                     max_backlog_seconds);
+    exit(-1);
+  }
+
+  int32_t fields;
+  if (!ParseResultFields(result_fields, &fields)) {
+    SHERPA_ONNX_LOGE("Invalid --result-fields: '%s'", result_fields.c_str());
+    exit(-1);
+  }
+
+  SampleFormat format;
+  if (!ParseSampleFormat(sample_format, &format)) {
+    SHERPA_ONNX_LOGE("Invalid --sample-format: '%s'", sample_format.c_str());
+    exit(-1);
+  }
 }
 
 void OnlineWebsocketServerConfig::Register(sherpa_onnx::ParseOptions *po) {
@@ -37,29 +125,44 @@ void OnlineWebsocketServerConfig::Register(sherpa_onnx::ParseOptions *po) {
   po->Register("log-file", &log_file,
                "Path to the log file. Logs are "
                "appended to this file");
+
+  po->Register("enable-metrics", &enable_metrics,
+               "true to collect per-stage latency and throughput metrics "
+               "and serve them in the Prometheus text format at /metrics");
+
+  po->Register("max-active-streams", &max_active_streams,
+               "Maximum number of concurrent connections. New connections "
+               "beyond it are closed with code 1013 (try again later). "
+               "0 means no limit.");
 }
 
 void OnlineWebsocketServerConfig::Validate() const {
   decoder_config.Validate();
+  SHERPA_ONNX_CHECK_GE(max_active_streams, 0);
 }
 
-OnlineWebsocketDecoder::OnlineWebsocketDecoder(OnlineWebsocketServer *server)
-    : server_(server),
-      config_(server->GetConfig().decoder_config),
-      timer_(server->GetWorkContext()) {
+OnlineWebsocketDecoder::OnlineWebsocketDecoder(
+    const OnlineWebsocketDecoderConfig &config, WebsocketDecoderHost *host)
+    : config_(config), host_(host), timer_(host->GetWorkContext()) {
   recognizer_ = std::make_unique<OnlineRecognizer>(config_.recognizer_config);
 }
 
 std::shared_ptr<Connection> OnlineWebsocketDecoder::GetOrCreateConnection(
-    connection_hdl hdl) {
+    connection_hdl hdl, const std::string &hotwords /*= ""*/) {
   std::lock_guard<std::mutex> lock(mutex_);
   auto it = connections_.find(hdl);
   if (it != connections_.end()) {
     return it->second;
   } else {
     // create a new connection
-    std::shared_ptr<OnlineStream> s = recognizer_->CreateStream();
+    std::shared_ptr<OnlineStream> s = hotwords.empty()
+                                          ? recognizer_->CreateStream()
+                                          : recognizer_->CreateStream(hotwords);
     auto c = std::make_shared<Connection>(hdl, s);
+    ParseResultFields(config_.result_fields, &c->result_fields);
+    c->skip_unchanged_results = config_.skip_unchanged_results;
+    ParseSampleFormat(config_.sample_format, &c->sample_format);
+    c->sample_rate = config_.recognizer_config.feat_config.sampling_rate;
     connections_.insert({hdl, c});
     return c;
   }
@@ -67,25 +170,15 @@ std::shared_ptr<Connection> OnlineWebsocketDecoder::GetOrCreateConnection(
 
 void OnlineWebsocketDecoder::AcceptWaveform(std::shared_ptr<Connection> c) {
   std::lock_guard<std::mutex> lock(c->mutex);
-  float sample_rate = config_.recognizer_config.feat_config.sampling_rate;
-  while (!c->samples.empty()) {
-    const auto &s = c->samples.front();
-    c->s->AcceptWaveform(sample_rate, s.data(), s.size());
-    c->samples.pop_front();
-  }
+  AcceptSamples(c.get());
 }
 
 void OnlineWebsocketDecoder::InputFinished(std::shared_ptr<Connection> c) {
   std::lock_guard<std::mutex> lock(c->mutex);
 
-  float sample_rate = config_.recognizer_config.feat_config.sampling_rate;
-
-  while (!c->samples.empty()) {
-    const auto &s = c->samples.front();
-    c->s->AcceptWaveform(sample_rate, s.data(), s.size());
-    c->samples.pop_front();
-  }
+  AcceptSamples(c.get());
 
+  float sample_rate = config_.recognizer_config.feat_config.sampling_rate;
   std::vector<float> tail_padding(
       static_cast<int64_t>(config_.end_tail_padding * sample_rate));
 
@@ -95,6 +188,158 @@ void OnlineWebsocketDecoder::InputFinished(std::shared_ptr<Connection> c) {
   c->eof = true;
 }
 
+bool OnlineWebsocketDecoder::IsIdle(
+    Connection *c, std::chrono::steady_clock::time_point now) const {
+  if (config_.idle_timeout_seconds <= 0) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(c->mutex);
+
+  // A client waiting for the final result after sending Done, or one
+  // we have stopped reading from, is not idle.
+  if (c->eof || c->paused) {
+    return false;
+  }
+
+  return std::chrono::duration<float>(now - c->last_active).count() >
+         config_.idle_timeout_seconds;
+}
+
+void OnlineWebsocketDecoder::AcceptSamples(Connection *c) const {
+  while (!c->samples.empty()) {
+    const auto &chunk = c->samples.front();
+    const char *p = chunk.data.data();
+    int32_t n = chunk.data.size() / BytesPerSample(chunk.format);
+
+    switch (chunk.format) {
+      case SampleFormat::kFloat:
+        c->s->AcceptWaveform(c->sample_rate,
+                             reinterpret_cast<const float *>(p), n);
+        break;
+      case SampleFormat::kInt16:
+        c->s->AcceptWaveform(c->sample_rate,
+                             reinterpret_cast<const int16_t *>(p), n);
+        break;
+      case SampleFormat::kMuLaw:
+        c->s->AcceptWaveformMuLaw(c->sample_rate,
+                                  reinterpret_cast<const uint8_t *>(p), n);
+        break;
+      case SampleFormat::kALaw:
+        c->s->AcceptWaveformALaw(c->sample_rate,
+                                 reinterpret_cast<const uint8_t *>(p), n);
+        break;
+    }
+
+    c->samples.pop_front();
+  }
+}
+
+bool OnlineWebsocketDecoder::SetOptions(std::shared_ptr<Connection> c,
+                                        const std::string &options) {
+  std::vector<std::string> pairs;
+  SplitStringToVector(options, " ", true, &pairs);
+
+  int32_t result_fields;
+  bool skip_unchanged_results;
+  SampleFormat sample_format;
+  int32_t sample_rate;
+  {
+    std::lock_guard<std::mutex> lock(c->mutex);
+    result_fields = c->result_fields;
+    skip_unchanged_results = c->skip_unchanged_results;
+    sample_format = c->sample_format;
+    sample_rate = c->sample_rate;
+  }
+
+  for (const auto &p : pairs) {
+    auto pos = p.find('=');
+    if (pos == std::string::npos) {
+      SHERPA_ONNX_LOGE("Invalid option: '%s'", p.c_str());
+      return false;
+    }
+
+    std::string key = p.substr(0, pos);
+    std::string value = p.substr(pos + 1);
+    if (key == "result-fields") {
+      if (!ParseResultFields(value, &result_fields)) {
+        return false;
+      }
+    } else if (key == "skip-unchanged-results") {
+      skip_unchanged_results = (value == "1" || value == "true");
+    } else if (key == "sample-format") {
+      if (!ParseSampleFormat(value, &sample_format)) {
+        SHERPA_ONNX_LOGE("Unknown sample format: '%s'", value.c_str());
+        return false;
+      }
+    } else if (key == "sample-rate") {
+      if (!ConvertStringToInteger(value, &sample_rate) || sample_rate <= 0) {
+        SHERPA_ONNX_LOGE("Invalid sample rate: '%s'", value.c_str());
+        return false;
+      }
+    } else {
+      SHERPA_ONNX_LOGE("Unknown option: '%s'", key.c_str());
+      return false;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(c->mutex);
+  c->result_fields = result_fields;
+  c->skip_unchanged_results = skip_unchanged_results;
+  c->sample_format = sample_format;
+  c->sample_rate = sample_rate;
+  return true;
+}
+
+void OnlineWebsocketDecoder::OnMessage(connection_hdl hdl,
+                                       server::message_ptr msg) {
+  auto c = GetOrCreateConnection(hdl);
+
+  const std::string &payload = msg->get_payload();
+  {
+    std::lock_guard<std::mutex> lock(c->mutex);
+    c->last_active = std::chrono::steady_clock::now();
+  }
+
+  switch (msg->get_opcode()) {
+    case websocketpp::frame::opcode::text:
+      if (payload == "Done") {
+        host_->PostWork([this, c]() { InputFinished(c); });
+      } else if (payload.compare(0, 8, "Options:") == 0) {
+        if (!SetOptions(c, payload.substr(8))) {
+          host_->Close(hdl, websocketpp::close::status::normal,
+                       std::string("Invalid options: ") + payload);
+        }
+      }
+      break;
+    case websocketpp::frame::opcode::binary: {
+      {
+        // Samples are converted to float by the feature extractor
+        std::lock_guard<std::mutex> lock(c->mutex);
+        c->samples.push_back({c->sample_format, payload});
+
+        c->received_seconds += static_cast<double>(payload.size()) /
+                               BytesPerSample(c->sample_format) /
+                               c->sample_rate;
+
+        if (config_.max_backlog_seconds > 0 && !c->paused &&
+            c->received_seconds - c->decoded_seconds >
+                config_.max_backlog_seconds) {
+          // It is resumed in Decode(). We pause it while holding the lock
+          // so that it cannot be resumed before it is paused.
+          c->paused = true;
+          host_->PauseReading(hdl);
+        }
+      }
+
+      host_->PostWork([this, c]() { AcceptWaveform(c); });
+      break;
+    }
+    default:
+      break;
+  }
+}
+
 void OnlineWebsocketDecoder::Warmup() const {
   recognizer_->WarmpUpRecognizer(config_.recognizer_config.model_config.warm_up,
                                  config_.max_batch_size);
@@ -112,6 +357,8 @@ void OnlineWebsocketDecoder::ProcessConnections(const asio::error_code &ec) {
     SHERPA_ONNX_LOG(FATAL) << "The decoder loop is aborted!";
   }
 
+  auto now = std::chrono::steady_clock::now();
+
   std::lock_guard<std::mutex> lock(mutex_);
   std::vector<connection_hdl> to_remove;
   for (auto &p : connections_) {
@@ -119,7 +366,7 @@ void OnlineWebsocketDecoder::ProcessConnections(const asio::error_code &ec) {
     auto c = p.second;
 
     // The order of `if` below matters!
-    if (!server_->Contains(hdl)) {
+    if (!host_->Contains(hdl)) {
       // If the connection is disconnected, we stop processing it
       to_remove.push_back(hdl);
       continue;
@@ -130,6 +377,19 @@ void OnlineWebsocketDecoder::ProcessConnections(const asio::error_code &ec) {
       continue;
     }
 
+    if (IsIdle(c.get(), now)) {
+      // Free the stream now and close the connection in an IO thread
+      asio::post(host_->GetConnectionContext(), [this, hdl]() {
+        if (host_->Contains(hdl)) {
+          host_->Close(hdl, websocketpp::close::status::going_away,
+                       "Idle timeout");
+        }
+      });
+
+      to_remove.push_back(hdl);
+      continue;
+    }
+
     if (!recognizer_->IsReady(c->s.get()) && !c->eof) {
       // this stream has not enough frames to decode, so skip it
       continue;
@@ -138,16 +398,13 @@ void OnlineWebsocketDecoder::ProcessConnections(const asio::error_code &ec) {
     if (!recognizer_->IsReady(c->s.get()) && c->eof) {
       // We won't receive samples from the client, so send a Done! to client
 
-      asio::post(server_->GetWorkContext(),
-                 [this, hdl = c->hdl]() { server_->Send(hdl, "Done!"); });
+      asio::post(host_->GetConnectionContext(),
+                 [this, hdl = c->hdl]() { host_->Send(hdl, "Done!"); });
 
       to_remove.push_back(hdl);
       continue;
     }
 
-    // TODO(fangun): If the connection is timed out, we need to also
-    // add it to `to_remove`
-
     // this stream has enough frames and is currently not processed by any
     // threads, so put it into the ready queue
     ready_connections_.push_back(c);
@@ -161,7 +418,7 @@ void OnlineWebsocketDecoder::ProcessConnections(const asio::error_code &ec) {
   }
 
   if (!ready_connections_.empty()) {
-    asio::post(server_->GetWorkContext(), [this]() { Decode(); });
+    host_->PostWork([this]() { Decode(); });
   }
 
   // Schedule another call
@@ -194,13 +451,17 @@ void OnlineWebsocketDecoder::Decode() {
     // there are too many ready connections but this thread can only handle
     // max_batch_size connections at a time, so we schedule another call
     // to Decode() and let other threads to process the ready connections
-    asio::post(server_->GetWorkContext(), [this]() { Decode(); });
+    host_->PostWork([this]() { Decode(); });
   }
 
   lock.unlock();
   recognizer_->DecodeStreams(s_vec.data(), s_vec.size());
   lock.lock();
 
+  // in seconds
+  float frame_shift =
+      config_.recognizer_config.feat_config.frame_shift_ms / 1000;
+
   for (auto c : c_vec) {
     auto result = recognizer_->GetResult(c->s.get());
     if (recognizer_->IsEndpoint(c->s.get())) {
@@ -212,9 +473,47 @@ void OnlineWebsocketDecoder::Decode() {
       result.is_final = true;
     }
 
-    asio::post(server_->GetConnectionContext(),
-               [this, hdl = c->hdl, str = result.AsJsonString()]() {
-                 server_->Send(hdl, str);
+    // Frames are never discarded on Reset(), so this is the total number
+    // of frames decoded so far
+    int32_t num_decoded_frames =
+        c->s->GetNumFramesSinceStart() + c->s->GetNumProcessedFrames();
+
+    int32_t result_fields;
+    bool skip_unchanged_results;
+    bool resume = false;
+    {
+      std::lock_guard<std::mutex> c_lock(c->mutex);
+      result_fields = c->result_fields;
+      skip_unchanged_results = c->skip_unchanged_results;
+
+      c->decoded_seconds = num_decoded_frames * frame_shift;
+      if (c->paused && c->received_seconds - c->decoded_seconds <
+                           config_.max_backlog_seconds / 2) {
+        c->paused = false;
+        resume = true;
+      }
+    }
+
+    if (resume) {
+      asio::post(host_->GetConnectionContext(),
+                 [this, hdl = c->hdl]() { host_->ResumeReading(hdl); });
+    }
+
+    // Only this thread is decoding c, so last_text and last_segment can be
+    // accessed without locking c->mutex
+    if (skip_unchanged_results && !result.is_final &&
+        result.segment == c->last_segment && result.text == c->last_text) {
+      active_.erase(c->hdl);
+      continue;
+    }
+
+    c->last_segment = result.segment;
+    c->last_text = result.text;
+
+    asio::post(host_->GetConnectionContext(),
+               [this, hdl = c->hdl,
+                str = result.AsJsonStringWithFields(result_fields)]() {
+                 host_->Send(hdl, str);
                });
     active_.erase(c->hdl);
   }
@@ -228,15 +527,21 @@ OnlineWebsocketServer::OnlineWebsocketServer(
       io_work_(io_work),
       log_(config.log_file, std::ios::app),
       tee_(std::cout, log_),
-      decoder_(this) {
+      decoder_(config_.decoder_config, this) {
   SetupLog();
 
+  if (config.enable_metrics) {
+    EnableMetrics(true);
+  }
+
   server_.init_asio(&io_conn_);
 
   server_.set_open_handler([this](connection_hdl hdl) { OnOpen(hdl); });
 
   server_.set_close_handler([this](connection_hdl hdl) { OnClose(hdl); });
 
+  server_.set_http_handler([this](connection_hdl hdl) { OnHttp(hdl); });
+
   server_.set_message_handler(
       [this](connection_hdl hdl, server::message_ptr msg) {
         OnMessage(hdl, msg);
@@ -278,20 +583,19 @@ void OnlineWebsocketServer::SetupLog() {
   server_.get_elog().set_ostream(&tee_);
 }
 
-void OnlineWebsocketServer::Send(connection_hdl hdl, const std::string &text) {
-  websocketpp::lib::error_code ec;
-  if (!Contains(hdl)) {
+void OnlineWebsocketServer::OnOpen(connection_hdl hdl) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (config_.max_active_streams > 0 &&
+      static_cast<int32_t>(connections_.size()) >=
+          config_.max_active_streams) {
+    lock.unlock();
+
+    // It is not added to connections_, so we won't create a stream for it
+    Close(hdl, websocketpp::close::status::try_again_later,
+          "Too many active streams");
     return;
   }
 
-  server_.send(hdl, text, websocketpp::frame::opcode::text, ec);
-  if (ec) {
-    server_.get_alog().write(websocketpp::log::alevel::app, ec.message());
-  }
-}
-
-void OnlineWebsocketServer::OnOpen(connection_hdl hdl) {
-  std::lock_guard<std::mutex> lock(mutex_);
   connections_.insert(hdl);
 
   std::ostringstream os;
@@ -299,6 +603,11 @@ void OnlineWebsocketServer::OnOpen(connection_hdl hdl) {
      << server_.get_con_from_hdl(hdl)->get_remote_endpoint() << ". "
      << "Number of active connections: " << connections_.size() << ".\n";
   SHERPA_ONNX_LOG(INFO) << os.str();
+  lock.unlock();
+
+  // Create the stream now so that the connection is closed on idle timeout
+  // even if the client never sends anything
+  decoder_.GetOrCreateConnection(hdl);
 }
 
 void OnlineWebsocketServer::OnClose(connection_hdl hdl) {
@@ -309,6 +618,21 @@ void OnlineWebsocketServer::OnClose(connection_hdl hdl) {
                         << connections_.size() << "\n";
 }
 
+void OnlineWebsocketServer::OnHttp(connection_hdl hdl) {
+  server::connection_ptr con = server_.get_con_from_hdl(hdl);
+
+  if (!config_.enable_metrics || con->get_request().get_method() != "GET" ||
+      con->get_resource() != "/metrics") {
+    con->set_status(websocketpp::http::status_code::not_found);
+    con->set_body("Not found");
+    return;
+  }
+
+  con->replace_header("Content-Type", "text/plain; version=0.0.4");
+  con->set_body(MetricsToPrometheusText());
+  con->set_status(websocketpp::http::status_code::ok);
+}
+
 bool OnlineWebsocketServer::Contains(connection_hdl hdl) const {
   std::lock_guard<std::mutex> lock(mutex_);
   return connections_.count(hdl);
@@ -316,50 +640,12 @@ bool OnlineWebsocketServer::Contains(connection_hdl hdl) const {
 
 void OnlineWebsocketServer::OnMessage(connection_hdl hdl,
                                       server::message_ptr msg) {
-  auto c = decoder_.GetOrCreateConnection(hdl);
-
-  const std::string &payload = msg->get_payload();
-
-  switch (msg->get_opcode()) {
-    case websocketpp::frame::opcode::text:
-      if (payload == "Done") {
-        asio::post(io_work_, [this, c]() { decoder_.InputFinished(c); });
-      }
-      break;
-    case websocketpp::frame::opcode::binary: {
-      auto p = reinterpret_cast<const float *>(payload.data());
-      int32_t num_samples = payload.size() / sizeof(float);
-      std::vector<float> samples(p, p + num_samples);
-
-      {
-        std::lock_guard<std::mutex> lock(c->mutex);
-        c->samples.push_back(std::move(samples));
-      }
-
-      asio::post(io_work_, [this, c]() { decoder_.AcceptWaveform(c); });
-      break;
-    }
-    default:
-      break;
+  if (!Contains(hdl)) {
+    // It is rejected in OnOpen() and is being closed
+    return;
   }
-}
-
-void OnlineWebsocketServer::Close(connection_hdl hdl,
-                                  websocketpp::close::status::value code,
-                                  const std::string &reason) {
-  auto con = server_.get_con_from_hdl(hdl);
 
-  std::ostringstream os;
-  os << "Closing " << con->get_remote_endpoint() << " with reason: " << reason
-     << "\n";
-
-  websocketpp::lib::error_code ec;
-  server_.close(hdl, code, reason, ec);
-  if (ec) {
-    os << "Failed to close" << con->get_remote_endpoint() << ". "
-       << ec.message() << "\n";
-  }
-  server_.get_alog().write(websocketpp::log::alevel::app, os.str());
+  decoder_.OnMessage(hdl, msg);
 }
 
 }  // namespace sherpa_onnx
@@ -16,18 +16,21 @@
 #include <utility>
 #include <vector>
 
-#include "asio.hpp"
 #include "sherpa-onnx/csrc/online-recognizer.h"
 #include "sherpa-onnx/csrc/online-stream.h"
 #include "sherpa-onnx/csrc/parse-options.h"
+#include "sherpa-onnx/csrc/sample-format.h"
 #include "sherpa-onnx/csrc/tee-stream.h"
-#include "websocketpp/config/asio_no_tls.hpp"  // TODO(fangjun): support TLS
-#include "websocketpp/server.hpp"
-using server = websocketpp::server<websocketpp::config::asio>;
-using connection_hdl = websocketpp::connection_hdl;
+#include "sherpa-onnx/csrc/websocket-decoder-host.h"
 
 namespace sherpa_onnx {
 
+// Audio samples in a binary message from the client
+struct AudioChunk {
+  SampleFormat format = SampleFormat::kFloat;
+  std::string data;
+};
+
 struct Connection {
   // handle to the connection. We can use it to send messages to the client
   connection_hdl hdl;
@@ -36,18 +39,45 @@ struct Connection {
   // set it to true when InputFinished() is called
   bool eof = false;
 
-  // The last time we received a message from the client
-  // TODO(fangjun): Use it to disconnect from a client if it is inactive
-  // for a specified time.
+  std::mutex mutex;  // protect samples and the fields below
+
+  // The last time we received a message from the client. If it is
+  // inactive for OnlineWebsocketDecoderConfig::idle_timeout_seconds,
+  // we close the connection.
   std::chrono::steady_clock::time_point last_active;
 
-  std::mutex mutex;  // protect samples
+  // Seconds of audio received from the client and decoded so far.
+  // Their difference is the backlog of this connection.
+  double received_seconds = 0;
+  double decoded_seconds = 0;
+
+  // True if we have stopped reading from the socket because the
+  // backlog is larger than OnlineWebsocketDecoderConfig::max_backlog_seconds
+  bool paused = false;
 
   // Audio samples received from the client.
   //
   // The I/O threads receive audio samples into this queue
   // and invoke work threads to compute features
-  std::deque<std::vector<float>> samples;
+  std::deque<AudioChunk> samples;
+
+  // Format and sample rate of audio samples sent by the client.
+  // Protected by `mutex`.
+  SampleFormat sample_format = SampleFormat::kFloat;
+  int32_t sample_rate = 16000;
+
+  // Fields of OnlineRecognizerResult that are sent to the client.
+  // See OnlineRecognizerResult::JsonField. Protected by `mutex`.
+  int32_t result_fields = OnlineRecognizerResult::kAllFields;
+
+  // If true, a result is sent only if its text, segment, or is_final differs
+  // from the last one sent to the client. Protected by `mutex`.
+  bool skip_unchanged_results = false;
+
+  // The last result sent to the client. Used only if skip_unchanged_results
+  // is true.
+  std::string last_text;
+  int32_t last_segment = -1;
 
   Connection() = default;
   Connection(connection_hdl hdl, std::shared_ptr<OnlineStream> s)
@@ -64,20 +94,49 @@ struct OnlineWebsocketDecoderConfig {
 
   float end_tail_padding = 0.8;
 
+  // Comma-separated list of fields of OnlineRecognizerResult sent to the
+  // client, e.g., "text,timestamps". Empty means all fields.
+  std::string result_fields;
+
+  // True to not send a result if it is the same as the last one
+  bool skip_unchanged_results = false;
+
+  // Format of audio samples sent by the client: float, int16, mulaw, alaw
+  std::string sample_format = "float";
+
+  // Close a connection if we receive nothing from it for this number of
+  // seconds. 0 means to never close it.
+  float idle_timeout_seconds = 300;
+
+  // Stop reading from a connection if it has more than this number of
+  // seconds of audio that is received but not decoded yet. Reading is
+  // resumed once the backlog drops below half of it. 0 means no limit.
+  float max_backlog_seconds = 10;
+
   void Register(ParseOptions *po);
   void Validate() const;
 };
 
-class OnlineWebsocketServer;
-
 class OnlineWebsocketDecoder {
  public:
   /**
-   * @param server  Not owned.
+   * @param config  Config of the decoder
+   * @param host  The server hosting this decoder. Not owned.
    */
-  explicit OnlineWebsocketDecoder(OnlineWebsocketServer *server);
+  OnlineWebsocketDecoder(const OnlineWebsocketDecoderConfig &config,
+                         WebsocketDecoderHost *host);
 
-  std::shared_ptr<Connection> GetOrCreateConnection(connection_hdl hdl);
+  /**
+   * @param hdl  The connection
+   * @param hotwords  Hotwords of the stream if the connection is new,
+   *                  separated by /. See OnlineRecognizer::CreateStream().
+   *                  If empty, the hotwords of the recognizer config are used.
+   */
+  std::shared_ptr<Connection> GetOrCreateConnection(
+      connection_hdl hdl, const std::string &hotwords = "");
+
+  // Handle a message from the client. It is called by an IO thread.
+  void OnMessage(connection_hdl hdl, server::message_ptr msg);
 
   // Compute features for a stream given audio samples
   void AcceptWaveform(std::shared_ptr<Connection> c);
@@ -85,6 +144,16 @@ class OnlineWebsocketDecoder {
   // signal that there will be no more audio samples for a stream
   void InputFinished(std::shared_ptr<Connection> c);
 
+  /** Set per-connection options given by the client.
+   *
+   * @param c The connection
+   * @param options A string of the form
+   *                "result-fields=text,timestamps skip-unchanged-results=1
+   *                 sample-format=mulaw sample-rate=8000"
+   * @return Return false if options is invalid.
+   */
+  bool SetOptions(std::shared_ptr<Connection> c, const std::string &options);
+
   void Warmup() const;
 
   void Run();
@@ -96,10 +165,16 @@ class OnlineWebsocketDecoder {
    */
   void Decode();
 
+  // Feed received audio samples to the stream. The caller must hold c->mutex
+  void AcceptSamples(Connection *c) const;
+
+  // Return true if c has not received anything for idle_timeout_seconds
+  bool IsIdle(Connection *c, std::chrono::steady_clock::time_point now) const;
+
  private:
-  OnlineWebsocketServer *server_;  // not owned
-  std::unique_ptr<OnlineRecognizer> recognizer_;
   OnlineWebsocketDecoderConfig config_;
+  WebsocketDecoderHost *host_;  // not owned
+  std::unique_ptr<OnlineRecognizer> recognizer_;
   asio::steady_timer timer_;
 
   // It protects `connections_`, `ready_connections_`, and `active_`
@@ -123,11 +198,20 @@ struct OnlineWebsocketServerConfig {
 
   std::string log_file = "./log.txt";
 
+  // If true, per-stage latency and throughput metrics are collected
+  // and served at http://host:port/metrics
+  bool enable_metrics = false;
+
+  // Maximum number of concurrent connections, each of which has a stream.
+  // New connections beyond it are closed with "try again later".
+  // 0 means no limit.
+  int32_t max_active_streams = 0;
+
   void Register(sherpa_onnx::ParseOptions *po);
   void Validate() const;
 };
 
-class OnlineWebsocketServer {
+class OnlineWebsocketServer : public WebsocketDecoderHost {
  public:
   explicit OnlineWebsocketServer(asio::io_context &io_conn,  // NOLINT
                                  asio::io_context &io_work,  // NOLINT
@@ -136,13 +220,11 @@ class OnlineWebsocketServer {
   void Run(uint16_t port);
 
   const OnlineWebsocketServerConfig &GetConfig() const { return config_; }
-  asio::io_context &GetConnectionContext() { return io_conn_; }
-  asio::io_context &GetWorkContext() { return io_work_; }
-  server &GetServer() { return server_; }
+  asio::io_context &GetConnectionContext() override { return io_conn_; }
+  asio::io_context &GetWorkContext() override { return io_work_; }
+  server &GetServer() override { return server_; }
 
-  void Send(connection_hdl hdl, const std::string &text);
-
-  bool Contains(connection_hdl hdl) const;
+  bool Contains(connection_hdl hdl) const override;
 
  private:
   void SetupLog();
@@ -154,11 +236,11 @@ class OnlineWebsocketServer {
   // When a websocket client is disconnected, it will invoke this method
   void OnClose(connection_hdl hdl);
 
-  void OnMessage(connection_hdl hdl, server::message_ptr msg);
+  // When an HTTP request is received, it will invoke this method.
+  // Only GET /metrics is supported.
+  void OnHttp(connection_hdl hdl);
 
-  // Close a websocket connection with given code and reason
-  void Close(connection_hdl hdl, websocketpp::close::status::value code,
-             const std::string &reason);
+  void OnMessage(connection_hdl hdl, server::message_ptr msg);
 
  private:
   OnlineWebsocketServerConfig config_;
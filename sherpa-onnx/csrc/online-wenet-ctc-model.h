@@ -69,6 +69,10 @@ class OnlineWenetCtcModel : public OnlineCtcModel {
   // before we process the next chunk.
   int32_t ChunkShift() const override;
 
+  // The exported model takes a scalar offset shared by the whole batch,
+  // and its attn_cache of shape (num_blocks, head, cache_size, dim) has no
+  // batch axis, so streams at different positions cannot be run together.
+  // Unlike it, OnlineNeMoCtcModel supports batch processing.
   bool SupportBatchProcessing() const override { return false; }
 
  private:
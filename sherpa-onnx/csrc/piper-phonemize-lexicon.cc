@@ -6,6 +6,7 @@
 
 #include <codecvt>
 #include <fstream>
+#include <iterator>
 #include <locale>
 #include <map>
 #include <mutex>  // NOLINT
@@ -26,6 +27,7 @@
 #include "phonemize.hpp"
 #include "sherpa-onnx/csrc/macros.h"
 #include "sherpa-onnx/csrc/onnx-utils.h"
+#include "sherpa-onnx/csrc/text-utils.h"
 
 namespace sherpa_onnx {
 
@@ -187,7 +189,7 @@ void InitEspeak(const std::string &data_dir) {
 PiperPhonemizeLexicon::PiperPhonemizeLexicon(
     const std::string &tokens, const std::string &data_dir,
     const OfflineTtsVitsModelMetaData &meta_data)
-    : meta_data_(meta_data) {
+    : meta_data_(meta_data), cache_(kMaxCachedSentences) {
   {
     std::ifstream is(tokens);
     token2id_ = ReadTokens(is);
@@ -200,7 +202,7 @@ PiperPhonemizeLexicon::PiperPhonemizeLexicon(
 PiperPhonemizeLexicon::PiperPhonemizeLexicon(
     AAssetManager *mgr, const std::string &tokens, const std::string &data_dir,
     const OfflineTtsVitsModelMetaData &meta_data)
-    : meta_data_(meta_data) {
+    : meta_data_(meta_data), cache_(kMaxCachedSentences) {
   {
     auto buf = ReadFile(mgr, tokens);
     std::istrstream is(buf.data(), buf.size());
@@ -216,6 +218,35 @@ PiperPhonemizeLexicon::PiperPhonemizeLexicon(
 
 std::vector<std::vector<int64_t>> PiperPhonemizeLexicon::ConvertTextToTokenIds(
     const std::string &text, const std::string &voice /*= ""*/) const {
+  // Sentences are cached separately so that a new text sharing
+  // sentences with earlier ones only needs espeak-ng for the new ones
+  std::vector<std::vector<int64_t>> ans;
+  for (const auto &sentence : SplitSentences(text)) {
+    auto ids = ConvertSentenceToTokenIds(sentence, voice);
+    ans.insert(ans.end(), std::make_move_iterator(ids.begin()),
+               std::make_move_iterator(ids.end()));
+  }
+
+  return ans;
+}
+
+std::vector<std::vector<int64_t>>
+PiperPhonemizeLexicon::ConvertSentenceToTokenIds(
+    const std::string &sentence, const std::string &voice) const {
+  bool use_cache =
+      static_cast<int32_t>(sentence.size()) <= kMaxCachedSentenceLength;
+  std::string key;
+  std::vector<std::vector<int64_t>> ans;
+  if (use_cache) {
+    key.reserve(voice.size() + 1 + sentence.size());
+    key.append(voice);
+    key.push_back('\0');
+    key.append(sentence);
+    if (cache_.Get(key, &ans)) {
+      return ans;
+    }
+  }
+
   piper::eSpeakPhonemeConfig config;
 
   // ./bin/espeak-ng-bin --path  ./install/share/espeak-ng-data/ --voices
@@ -224,34 +255,32 @@ std::vector<std::vector<int64_t>> PiperPhonemizeLexicon::ConvertTextToTokenIds(
 
   std::vector<std::vector<piper::Phoneme>> phonemes;
 
+  // espeak-ng keeps its state in global variables, so it cannot be called
+  // from several threads at the same time. All calls in the process are
+  // serialized by this lock; cached sentences do not need it.
   static std::mutex espeak_mutex;
   {
     std::lock_guard<std::mutex> lock(espeak_mutex);
-
-    // keep multi threads from calling into piper::phonemize_eSpeak
-    piper::phonemize_eSpeak(text, config, phonemes);
+    piper::phonemize_eSpeak(sentence, config, phonemes);
   }
 
-  std::vector<std::vector<int64_t>> ans;
-
-  std::vector<int64_t> phoneme_ids;
-
   if (meta_data_.is_piper || meta_data_.is_icefall) {
     for (const auto &p : phonemes) {
-      phoneme_ids = PiperPhonemesToIds(token2id_, p);
-      ans.push_back(std::move(phoneme_ids));
+      ans.push_back(PiperPhonemesToIds(token2id_, p));
     }
   } else if (meta_data_.is_coqui) {
     for (const auto &p : phonemes) {
-      phoneme_ids = CoquiPhonemesToIds(token2id_, p, meta_data_);
-      ans.push_back(std::move(phoneme_ids));
+      ans.push_back(CoquiPhonemesToIds(token2id_, p, meta_data_));
     }
-
   } else {
     SHERPA_ONNX_LOGE("Unsupported model");
     exit(-1);
   }
 
+  if (use_cache) {
+    cache_.Put(key, ans);
+  }
+
   return ans;
 }
 
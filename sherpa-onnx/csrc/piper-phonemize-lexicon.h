@@ -5,6 +5,7 @@
 #ifndef SHERPA_ONNX_CSRC_PIPER_PHONEMIZE_LEXICON_H_
 #define SHERPA_ONNX_CSRC_PIPER_PHONEMIZE_LEXICON_H_
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -14,6 +15,7 @@
 #include "android/asset_manager_jni.h"
 #endif
 
+#include "sherpa-onnx/csrc/lru-cache.h"
 #include "sherpa-onnx/csrc/offline-tts-frontend.h"
 #include "sherpa-onnx/csrc/offline-tts-vits-model-metadata.h"
 
@@ -33,10 +35,27 @@ class PiperPhonemizeLexicon : public OfflineTtsFrontend {
   std::vector<std::vector<int64_t>> ConvertTextToTokenIds(
       const std::string &text, const std::string &voice = "") const override;
 
+  // Number of cached (voice, sentence) pairs
+  static constexpr int32_t kMaxCachedSentences = 4096;
+
+  // Sentences longer than this number of bytes are not cached
+  static constexpr int32_t kMaxCachedSentenceLength = 2048;
+
+ private:
+  std::vector<std::vector<int64_t>> ConvertSentenceToTokenIds(
+      const std::string &sentence, const std::string &voice) const;
+
  private:
   // map unicode codepoint to an integer ID
   std::unordered_map<char32_t, int32_t> token2id_;
   OfflineTtsVitsModelMetaData meta_data_;
+
+  // espeak-ng keeps its state in global variables, so all calls into it
+  // in a process are serialized. The token IDs of recent (voice, sentence)
+  // pairs are cached so that repeated sentences do not need espeak-ng.
+  //
+  // The key is voice + '\0' + sentence.
+  mutable LruCache<std::string, std::vector<std::vector<int64_t>>> cache_;
 };
 
 }  // namespace sherpa_onnx
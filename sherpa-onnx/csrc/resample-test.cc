@@ -0,0 +1,211 @@
+// sherpa-onnx/csrc/resample-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/resample.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+// A plain scalar implementation of the same filter. It computes the
+// weights of each output sample separately and is used as a reference
+// for both correctness and speed.
+class ScalarResample {
+ public:
+  ScalarResample(int32_t samp_rate_in, int32_t samp_rate_out,
+                 float filter_cutoff, int32_t num_zeros)
+      : samp_rate_in_(samp_rate_in),
+        samp_rate_out_(samp_rate_out),
+        filter_cutoff_(filter_cutoff),
+        num_zeros_(num_zeros) {
+    int32_t base_freq = samp_rate_in;
+    for (int32_t n = samp_rate_out; n != 0;) {
+      int32_t r = base_freq % n;
+      base_freq = n;
+      n = r;
+    }
+    input_samples_in_unit_ = samp_rate_in / base_freq;
+    output_samples_in_unit_ = samp_rate_out / base_freq;
+
+    double window_width = num_zeros_ / (2.0 * filter_cutoff_);
+    first_index_.resize(output_samples_in_unit_);
+    weights_.resize(output_samples_in_unit_);
+    for (int32_t i = 0; i < output_samples_in_unit_; i++) {
+      double output_t = i / static_cast<double>(samp_rate_out_);
+      double min_t = output_t - window_width, max_t = output_t + window_width;
+      int32_t min_input_index = ceil(min_t * samp_rate_in_),
+              max_input_index = floor(max_t * samp_rate_in_);
+      first_index_[i] = min_input_index;
+      for (int32_t j = min_input_index; j <= max_input_index; j++) {
+        double delta_t = j / static_cast<double>(samp_rate_in_) - output_t;
+        weights_[i].push_back(FilterFunc(delta_t) / samp_rate_in_);
+      }
+    }
+  }
+
+  std::vector<float> Resample(const std::vector<float> &input,
+                              int32_t num_output_samples) const {
+    std::vector<float> output(num_output_samples);
+    int32_t input_dim = static_cast<int32_t>(input.size());
+
+    for (int32_t samp_out = 0; samp_out < num_output_samples; ++samp_out) {
+      int32_t unit_index = samp_out / output_samples_in_unit_;
+      int32_t wrapped = samp_out - unit_index * output_samples_in_unit_;
+      int32_t first =
+          first_index_[wrapped] + unit_index * input_samples_in_unit_;
+
+      const auto &weights = weights_[wrapped];
+      float sum = 0;
+      for (int32_t i = 0; i != static_cast<int32_t>(weights.size()); ++i) {
+        int32_t k = first + i;
+        if (k >= 0 && k < input_dim) {
+          sum += weights[i] * input[k];
+        }
+      }
+      output[samp_out] = sum;
+    }
+
+    return output;
+  }
+
+ private:
+  float FilterFunc(float t) const {
+    float window, filter;
+    if (fabs(t) < num_zeros_ / (2.0 * filter_cutoff_))
+      window = 0.5 * (1 + cos(2 * M_PI * filter_cutoff_ / num_zeros_ * t));
+    else
+      window = 0.0;
+    if (t != 0)
+      filter = sin(2 * M_PI * filter_cutoff_ * t) / (M_PI * t);
+    else
+      filter = 2 * filter_cutoff_;
+    return filter * window;
+  }
+
+ private:
+  int32_t samp_rate_in_;
+  int32_t samp_rate_out_;
+  float filter_cutoff_;
+  int32_t num_zeros_;
+  int32_t input_samples_in_unit_;
+  int32_t output_samples_in_unit_;
+  std::vector<int32_t> first_index_;
+  std::vector<std::vector<float>> weights_;
+};
+
+static std::vector<float> RandomSignal(int32_t n) {
+  std::mt19937 mt(20240101);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<float> ans(n);
+  for (auto &f : ans) {
+    f = dist(mt);
+  }
+  return ans;
+}
+
+static float FilterCutoff(int32_t samp_rate_in, int32_t samp_rate_out) {
+  // The same as the one used in features.cc
+  return 0.99 * 0.5 * std::min(samp_rate_in, samp_rate_out);
+}
+
+static void TestHelper(int32_t samp_rate_in, int32_t samp_rate_out) {
+  float cutoff = FilterCutoff(samp_rate_in, samp_rate_out);
+  int32_t num_zeros = 6;
+
+  auto input = RandomSignal(samp_rate_in / 2);
+
+  LinearResample resampler(samp_rate_in, samp_rate_out, cutoff, num_zeros);
+  std::vector<float> expected;
+  resampler.Resample(input.data(), input.size(), true, &expected);
+
+  ScalarResample reference(samp_rate_in, samp_rate_out, cutoff, num_zeros);
+  auto scalar = reference.Resample(input, expected.size());
+  ASSERT_EQ(scalar.size(), expected.size());
+  for (int32_t i = 0; i != static_cast<int32_t>(expected.size()); ++i) {
+    EXPECT_NEAR(scalar[i], expected[i], 1e-4) << i;
+  }
+
+  // Process the input in chunks of random sizes into a reused buffer
+  std::mt19937 mt(0);
+  std::uniform_int_distribution<int32_t> chunk_dist(1, samp_rate_in / 50);
+
+  std::vector<float> chunked;
+  std::vector<float> buf;
+  int32_t start = 0;
+  while (start < static_cast<int32_t>(input.size())) {
+    int32_t n = std::min<int32_t>(chunk_dist(mt), input.size() - start);
+    bool flush = start + n == static_cast<int32_t>(input.size());
+
+    buf.resize(resampler.NumOutputSamples(n, flush));
+    int32_t k = resampler.Resample(input.data() + start, n, flush, buf.data());
+    EXPECT_EQ(k, static_cast<int32_t>(buf.size()));
+
+    chunked.insert(chunked.end(), buf.begin(), buf.begin() + k);
+    start += n;
+  }
+
+  ASSERT_EQ(chunked.size(), expected.size());
+  for (int32_t i = 0; i != static_cast<int32_t>(expected.size()); ++i) {
+    EXPECT_NEAR(chunked[i], expected[i], 1e-5) << i;
+  }
+}
+
+TEST(LinearResample, Upsample8kTo16k) { TestHelper(8000, 16000); }
+
+TEST(LinearResample, Downsample44100To16k) { TestHelper(44100, 16000); }
+
+TEST(LinearResample, Downsample48kTo16k) { TestHelper(48000, 16000); }
+
+TEST(LinearResample, Downsample22050To16k) { TestHelper(22050, 16000); }
+
+TEST(LinearResample, Benchmark) {
+  int32_t num_seconds = 60;
+  for (int32_t samp_rate_in : {8000, 44100, 48000}) {
+    int32_t samp_rate_out = 16000;
+    float cutoff = FilterCutoff(samp_rate_in, samp_rate_out);
+    auto input = RandomSignal(samp_rate_in * num_seconds);
+
+    LinearResample resampler(samp_rate_in, samp_rate_out, cutoff, 6);
+    int32_t num_output = resampler.NumOutputSamples(input.size(), true);
+
+    ScalarResample reference(samp_rate_in, samp_rate_out, cutoff, 6);
+    auto start = std::chrono::high_resolution_clock::now();
+    auto scalar = reference.Resample(input, num_output);
+    auto stop = std::chrono::high_resolution_clock::now();
+    auto scalar_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+    // 10 ms per chunk, as in streaming ASR
+    int32_t chunk_size = samp_rate_in / 100;
+    std::vector<float> buf(resampler.NumOutputSamples(chunk_size, true) + 1);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int32_t i = 0; i < static_cast<int32_t>(input.size());
+         i += chunk_size) {
+      int32_t n = std::min<int32_t>(chunk_size, input.size() - i);
+      bool flush = i + n == static_cast<int32_t>(input.size());
+      buf.resize(std::max<int32_t>(buf.size(),
+                                   resampler.NumOutputSamples(n, flush)));
+      resampler.Resample(input.data() + i, n, flush, buf.data());
+    }
+    stop = std::chrono::high_resolution_clock::now();
+    auto us =
+        std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+    SHERPA_ONNX_LOGE(
+        "Resample %d s from %d Hz to %d Hz: scalar %d us, LinearResample %d us",
+        num_seconds, samp_rate_in, samp_rate_out,
+        static_cast<int32_t>(scalar_us.count()),
+        static_cast<int32_t>(us.count()));
+  }
+}
+
+}  // namespace sherpa_onnx
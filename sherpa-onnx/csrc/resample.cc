@@ -28,9 +28,19 @@
 #include <math.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <type_traits>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #ifndef M_2PI
 #define M_2PI 6.283185307179586476925286766559005
 #endif
@@ -73,12 +83,54 @@ I Lcm(I m, I n) {
   return gcd * (m / gcd) * (n / gcd);
 }
 
+// n must be a multiple of 8. It is used only with weights_, whose number of
+// taps per phase is rounded up to a multiple of 8.
 static float DotProduct(const float *a, const float *b, int32_t n) {
-  float sum = 0;
-  for (int32_t i = 0; i != n; ++i) {
-    sum += a[i] * b[i];
+#if defined(__AVX__)
+  __m256 sum = _mm256_setzero_ps();
+  for (int32_t i = 0; i != n; i += 8) {
+    sum = _mm256_add_ps(
+        sum, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+  }
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(sum),
+                        _mm256_extractf128_ps(sum, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  return _mm_cvtss_f32(s);
+#elif defined(__SSE2__)
+  __m128 sum0 = _mm_setzero_ps();
+  __m128 sum1 = _mm_setzero_ps();
+  for (int32_t i = 0; i != n; i += 8) {
+    sum0 = _mm_add_ps(sum0,
+                      _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    sum1 = _mm_add_ps(
+        sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  __m128 s = _mm_add_ps(sum0, sum1);
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  return _mm_cvtss_f32(s);
+#elif defined(__ARM_NEON)
+  float32x4_t sum0 = vdupq_n_f32(0);
+  float32x4_t sum1 = vdupq_n_f32(0);
+  for (int32_t i = 0; i != n; i += 8) {
+    sum0 = vmlaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+    sum1 = vmlaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
   }
-  return sum;
+  float32x4_t s = vaddq_f32(sum0, sum1);
+  float32x2_t s2 = vadd_f32(vget_low_f32(s), vget_high_f32(s));
+  return vget_lane_f32(vpadd_f32(s2, s2), 0);
+#else
+  // Use independent accumulators so that the compiler can vectorize it
+  float sum[8] = {0};
+  for (int32_t i = 0; i != n; i += 8) {
+    for (int32_t k = 0; k != 8; ++k) {
+      sum[k] += a[i + k] * b[i + k];
+    }
+  }
+  return ((sum[0] + sum[1]) + (sum[2] + sum[3])) +
+         ((sum[4] + sum[5]) + (sum[6] + sum[7]));
+#endif
 }
 
 LinearResample::LinearResample(int32_t samp_rate_in_hz,
@@ -104,7 +156,9 @@ LinearResample::LinearResample(int32_t samp_rate_in_hz,
 
 void LinearResample::SetIndexesAndWeights() {
   first_index_.resize(output_samples_in_unit_);
-  weights_.resize(output_samples_in_unit_);
+  num_weights_.resize(output_samples_in_unit_);
+
+  std::vector<std::vector<float>> weights(output_samples_in_unit_);
 
   double window_width = num_zeros_ / (2.0 * filter_cutoff_);
 
@@ -122,15 +176,27 @@ void LinearResample::SetIndexesAndWeights() {
             max_input_index = floor(max_t * samp_rate_in_),
             num_indices = max_input_index - min_input_index + 1;
     first_index_[i] = min_input_index;
-    weights_[i].resize(num_indices);
+    num_weights_[i] = num_indices;
+    weights[i].resize(num_indices);
     for (int32_t j = 0; j < num_indices; j++) {
       int32_t input_index = min_input_index + j;
       double input_t = input_index / static_cast<double>(samp_rate_in_),
              delta_t = input_t - output_t;
       // sign of delta_t doesn't matter.
-      weights_[i][j] = FilterFunc(delta_t) / samp_rate_in_;
+      weights[i][j] = FilterFunc(delta_t) / samp_rate_in_;
     }
   }
+
+  // Put the weights of all phases into a single contiguous filter bank
+  int32_t max_num_weights =
+      *std::max_element(num_weights_.begin(), num_weights_.end());
+  num_taps_ = (max_num_weights + 7) / 8 * 8;
+
+  weights_.assign(output_samples_in_unit_ * num_taps_, 0);
+  for (int32_t i = 0; i < output_samples_in_unit_; i++) {
+    std::copy(weights[i].begin(), weights[i].end(),
+              weights_.begin() + i * num_taps_);
+  }
 }
 
 /** Here, t is a time in seconds representing an offset from
@@ -161,33 +227,52 @@ void LinearResample::Reset() {
 
 void LinearResample::Resample(const float *input, int32_t input_dim, bool flush,
                               std::vector<float> *output) {
+  output->resize(NumOutputSamples(input_dim, flush));
+  Resample(input, input_dim, flush, output->data());
+}
+
+int32_t LinearResample::NumOutputSamples(int32_t input_dim, bool flush) const {
+  int64_t tot_input_samp = input_sample_offset_ + input_dim;
+  return static_cast<int32_t>(GetNumOutputSamples(tot_input_samp, flush) -
+                              output_sample_offset_);
+}
+
+int32_t LinearResample::Resample(const float *input, int32_t input_dim,
+                                 bool flush, float *output) {
   int64_t tot_input_samp = input_sample_offset_ + input_dim,
           tot_output_samp = GetNumOutputSamples(tot_input_samp, flush);
 
   assert(tot_output_samp >= output_sample_offset_);
 
-  output->resize(tot_output_samp - output_sample_offset_);
-
   // samp_out is the index into the total output signal, not just the part
   // of it we are producing here.
-  for (int64_t samp_out = output_sample_offset_; samp_out < tot_output_samp;
-       samp_out++) {
-    int64_t first_samp_in;
-    int32_t samp_out_wrapped;
-    GetIndexes(samp_out, &first_samp_in, &samp_out_wrapped);
-    const std::vector<float> &weights = weights_[samp_out_wrapped];
+  int64_t samp_out = output_sample_offset_;
+
+  // We walk through the output unit by unit so that we don't need a
+  // division per output sample as in GetIndexes().
+  int64_t first_samp_in;
+  int32_t phase;
+  GetIndexes(samp_out, &first_samp_in, &phase);
+
+  // The first input-sample index of phase 0 of the current unit, relative
+  // to the start of "input"
+  int64_t unit_offset = first_samp_in - first_index_[phase] -
+                        input_sample_offset_;
+
+  float *p = output;
+  for (; samp_out < tot_output_samp; ++samp_out) {
+    const float *weights = weights_.data() + phase * num_taps_;
+
     // first_input_index is the first index into "input" that we have a weight
     // for.
     int32_t first_input_index =
-        static_cast<int32_t>(first_samp_in - input_sample_offset_);
+        static_cast<int32_t>(first_index_[phase] + unit_offset);
     float this_output;
-    if (first_input_index >= 0 &&
-        first_input_index + static_cast<int32_t>(weights.size()) <= input_dim) {
-      this_output =
-          DotProduct(input + first_input_index, weights.data(), weights.size());
+    if (first_input_index >= 0 && first_input_index + num_taps_ <= input_dim) {
+      this_output = DotProduct(input + first_input_index, weights, num_taps_);
     } else {  // Handle edge cases.
       this_output = 0.0;
-      for (int32_t i = 0; i < static_cast<int32_t>(weights.size()); i++) {
+      for (int32_t i = 0; i < num_weights_[phase]; i++) {
         float weight = weights[i];
         int32_t input_index = first_input_index + i;
         if (input_index < 0 &&
@@ -204,11 +289,16 @@ void LinearResample::Resample(const float *input, int32_t input_dim, bool flush,
         }
       }
     }
-    int32_t output_index =
-        static_cast<int32_t>(samp_out - output_sample_offset_);
-    (*output)[output_index] = this_output;
+    *p++ = this_output;
+
+    if (++phase == output_samples_in_unit_) {
+      phase = 0;
+      unit_offset += input_samples_in_unit_;
+    }
   }
 
+  int32_t num_output_samples = static_cast<int32_t>(p - output);
+
   if (flush) {
     Reset();  // Reset the internal state.
   } else {
@@ -216,6 +306,8 @@ void LinearResample::Resample(const float *input, int32_t input_dim, bool flush,
     input_sample_offset_ = tot_input_samp;
     output_sample_offset_ = tot_output_samp;
   }
+
+  return num_output_samples;
 }
 
 int64_t LinearResample::GetNumOutputSamples(int64_t input_num_samp,
@@ -280,7 +372,6 @@ void LinearResample::GetIndexes(int64_t samp_out, int64_t *first_samp_in,
 }
 
 void LinearResample::SetRemainder(const float *input, int32_t input_dim) {
-  std::vector<float> old_remainder(input_remainder_);
   // max_remainder_needed is the width of the filter from side to side,
   // measured in input samples.  you might think it should be half that,
   // but you have to consider that you might be wanting to output samples
@@ -288,21 +379,24 @@ void LinearResample::SetRemainder(const float *input, int32_t input_dim) {
   // input... anyway, storing more remainder than needed is not harmful.
   int32_t max_remainder_needed =
       ceil(samp_rate_in_ * num_zeros_ / filter_cutoff_);
-  input_remainder_.resize(max_remainder_needed);
-  for (int32_t index = -static_cast<int32_t>(input_remainder_.size());
-       index < 0; index++) {
-    // we interpret "index" as an offset from the end of "input" and
-    // from the end of input_remainder_.
-    int32_t input_index = index + input_dim;
-    if (input_index >= 0) {
-      input_remainder_[index + static_cast<int32_t>(input_remainder_.size())] =
-          input[input_index];
-    } else if (input_index + static_cast<int32_t>(old_remainder.size()) >= 0) {
-      input_remainder_[index + static_cast<int32_t>(input_remainder_.size())] =
-          old_remainder[input_index +
-                        static_cast<int32_t>(old_remainder.size())];
-      // else leave it at zero.
-    }
+
+  if (static_cast<int32_t>(input_remainder_.size()) != max_remainder_needed) {
+    // It is empty after Reset(). Samples before the start of the signal
+    // are zero.
+    input_remainder_.assign(max_remainder_needed, 0);
+  }
+
+  // The new remainder is the last max_remainder_needed samples of the
+  // old remainder followed by input. It is updated in-place so that no memory
+  // is allocated.
+  float *dst = input_remainder_.data();
+  if (input_dim >= max_remainder_needed) {
+    std::copy(input + input_dim - max_remainder_needed, input + input_dim,
+              dst);
+  } else {
+    int32_t num_to_keep = max_remainder_needed - input_dim;
+    std::memmove(dst, dst + input_dim, num_to_keep * sizeof(float));
+    std::copy(input, input + input_dim, dst + num_to_keep);
   }
 }
 
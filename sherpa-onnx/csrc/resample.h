@@ -73,6 +73,19 @@ class LinearResample {
   void Resample(const float *input, int32_t input_dim, bool flush,
                 std::vector<float> *output);
 
+  /// Same as the above one, but the output is written to a buffer provided
+  /// by the caller, so no memory is allocated if the buffer is reused across
+  /// calls. The buffer must have room for at least
+  /// NumOutputSamples(input_dim, flush) samples.
+  ///
+  /// @return Return the number of samples written to output.
+  int32_t Resample(const float *input, int32_t input_dim, bool flush,
+                   float *output);
+
+  /// Return the number of output samples the next call of Resample() will
+  /// produce for input_dim input samples.
+  int32_t NumOutputSamples(int32_t input_dim, bool flush) const;
+
   //// Return the input and output sampling rates (for checks, for example)
   int32_t GetInputSamplingRate() const { return samp_rate_in_; }
   int32_t GetOutputSamplingRate() const { return samp_rate_out_; }
@@ -124,8 +137,17 @@ class LinearResample {
   /// extrapolate the correct input-sample index for arbitrary output samples.
   std::vector<int32_t> first_index_;
 
-  /// Weights on the input samples, for this output-sample index.
-  std::vector<std::vector<float>> weights_;
+  /// Weights on the input samples, for each output-sample index in a unit.
+  /// Weights of all output-sample indexes are stored contiguously, each
+  /// occupying num_taps_ entries. Entries after num_weights_[i] are
+  /// zero-padded so that all of them can use the same vectorized kernel.
+  std::vector<float> weights_;
+
+  /// Number of valid weights for each output-sample index in a unit.
+  std::vector<int32_t> num_weights_;
+
+  /// Max of num_weights_, rounded up to a multiple of 8.
+  int32_t num_taps_ = 0;
 
   // the following variables keep track of where we are in a particular signal,
   // if it is being provided over multiple calls to Resample().
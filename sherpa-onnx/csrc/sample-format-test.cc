@@ -0,0 +1,106 @@
+// sherpa-onnx/csrc/sample-format-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/sample-format.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(SampleFormat, MuLaw) {
+  EXPECT_EQ(MuLawToLinear(0xff), 0);
+  EXPECT_EQ(MuLawToLinear(0x7f), 0);
+  EXPECT_EQ(MuLawToLinear(0x80), 32124);
+  EXPECT_EQ(MuLawToLinear(0x00), -32124);
+
+  for (int32_t i = 0; i != 128; ++i) {
+    EXPECT_EQ(MuLawToLinear(i), -MuLawToLinear(i | 0x80)) << i;
+  }
+
+  // Positive values decrease as the code increases
+  for (int32_t i = 0x80; i != 0xff; ++i) {
+    EXPECT_GT(MuLawToLinear(i), MuLawToLinear(i + 1)) << i;
+  }
+}
+
+TEST(SampleFormat, ALaw) {
+  EXPECT_EQ(ALawToLinear(0xd5), 8);
+  EXPECT_EQ(ALawToLinear(0x55), -8);
+  EXPECT_EQ(ALawToLinear(0xaa), 32256);
+  EXPECT_EQ(ALawToLinear(0x2a), -32256);
+
+  for (int32_t i = 0; i != 128; ++i) {
+    EXPECT_EQ(ALawToLinear(i), -ALawToLinear(i | 0x80)) << i;
+  }
+}
+
+TEST(SampleFormat, Convert) {
+  std::vector<int16_t> pcm = {0, 1, -1, 16384, -32768, 32767};
+  std::vector<float> out(pcm.size());
+
+  ConvertSamples(pcm.data(), pcm.size(), 1.0f / 32768, out.data());
+  for (int32_t i = 0; i != static_cast<int32_t>(pcm.size()); ++i) {
+    EXPECT_EQ(out[i], pcm[i] / 32768.0f);
+  }
+
+  std::vector<uint8_t> g711(256);
+  for (int32_t i = 0; i != 256; ++i) {
+    g711[i] = i;
+  }
+  out.resize(g711.size());
+
+  ConvertMuLawSamples(g711.data(), g711.size(), 1.0f, out.data());
+  for (int32_t i = 0; i != 256; ++i) {
+    EXPECT_EQ(out[i], MuLawToLinear(i));
+  }
+
+  ConvertALawSamples(g711.data(), g711.size(), 0.5f, out.data());
+  for (int32_t i = 0; i != 256; ++i) {
+    EXPECT_EQ(out[i], ALawToLinear(i) * 0.5f);
+  }
+}
+
+TEST(SampleFormat, ConvertToModelInput) {
+  std::vector<int16_t> pcm = {0, 1, -1, 16384, -32768, 32767};
+  std::vector<float> out;
+
+  ConvertSamples(SampleFormat::kInt16, pcm.data(), pcm.size(), true, &out);
+  ASSERT_EQ(out.size(), pcm.size());
+  for (int32_t i = 0; i != static_cast<int32_t>(pcm.size()); ++i) {
+    EXPECT_EQ(out[i], pcm[i] / 32768.0f);
+  }
+
+  ConvertSamples(SampleFormat::kInt16, pcm.data(), pcm.size(), false, &out);
+  for (int32_t i = 0; i != static_cast<int32_t>(pcm.size()); ++i) {
+    EXPECT_EQ(out[i], pcm[i]);
+  }
+
+  std::vector<float> samples = {0, 0.5, -1};
+  ConvertSamples(SampleFormat::kFloat, samples.data(), samples.size(), false,
+                 &out);
+  ASSERT_EQ(out.size(), samples.size());
+  EXPECT_EQ(out[1], 16384);
+  EXPECT_EQ(out[2], -32768);
+
+  std::vector<uint8_t> g711 = {0, 0x55, 0xff};
+  ConvertSamples(SampleFormat::kALaw, g711.data(), g711.size(), false, &out);
+  ASSERT_EQ(out.size(), g711.size());
+  for (int32_t i = 0; i != static_cast<int32_t>(g711.size()); ++i) {
+    EXPECT_EQ(out[i], ALawToLinear(g711[i]));
+  }
+}
+
+TEST(SampleFormat, Parse) {
+  SampleFormat format;
+  EXPECT_TRUE(ParseSampleFormat("int16", &format));
+  EXPECT_EQ(format, SampleFormat::kInt16);
+  EXPECT_TRUE(ParseSampleFormat("alaw", &format));
+  EXPECT_EQ(format, SampleFormat::kALaw);
+  EXPECT_FALSE(ParseSampleFormat("int8", &format));
+  EXPECT_EQ(BytesPerSample(SampleFormat::kMuLaw), 1);
+}
+
+}  // namespace sherpa_onnx
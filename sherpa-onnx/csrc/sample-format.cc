@@ -0,0 +1,148 @@
+// sherpa-onnx/csrc/sample-format.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/sample-format.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace sherpa_onnx {
+
+bool ParseSampleFormat(const std::string &name, SampleFormat *format) {
+  if (name == "float") {
+    *format = SampleFormat::kFloat;
+  } else if (name == "int16") {
+    *format = SampleFormat::kInt16;
+  } else if (name == "mulaw") {
+    *format = SampleFormat::kMuLaw;
+  } else if (name == "alaw") {
+    *format = SampleFormat::kALaw;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+int32_t BytesPerSample(SampleFormat format) {
+  switch (format) {
+    case SampleFormat::kFloat:
+      return 4;
+    case SampleFormat::kInt16:
+      return 2;
+    case SampleFormat::kMuLaw:
+    case SampleFormat::kALaw:
+      return 1;
+  }
+  return 0;
+}
+
+// See g711.c from Sun Microsystems
+int16_t MuLawToLinear(uint8_t sample) {
+  int32_t u = ~sample & 0xff;
+  int32_t t = ((u & 0x0f) << 3) + 0x84;
+  t <<= (u & 0x70) >> 4;
+
+  return (u & 0x80) ? (0x84 - t) : (t - 0x84);
+}
+
+int16_t ALawToLinear(uint8_t sample) {
+  int32_t a = sample ^ 0x55;
+  int32_t t = (a & 0x0f) << 4;
+  int32_t seg = (a & 0x70) >> 4;
+  switch (seg) {
+    case 0:
+      t += 8;
+      break;
+    case 1:
+      t += 0x108;
+      break;
+    default:
+      t += 0x108;
+      t <<= seg - 1;
+  }
+
+  return (a & 0x80) ? t : -t;
+}
+
+using G711Table = std::array<int16_t, 256>;
+
+static const G711Table &MuLawTable() {
+  static const G711Table table = []() {
+    G711Table ans;
+    for (int32_t i = 0; i != 256; ++i) {
+      ans[i] = MuLawToLinear(i);
+    }
+    return ans;
+  }();
+  return table;
+}
+
+static const G711Table &ALawTable() {
+  static const G711Table table = []() {
+    G711Table ans;
+    for (int32_t i = 0; i != 256; ++i) {
+      ans[i] = ALawToLinear(i);
+    }
+    return ans;
+  }();
+  return table;
+}
+
+void ConvertSamples(const int16_t *in, int32_t n, float scale, float *out) {
+  for (int32_t i = 0; i != n; ++i) {
+    out[i] = in[i] * scale;
+  }
+}
+
+void ConvertMuLawSamples(const uint8_t *in, int32_t n, float scale,
+                         float *out) {
+  const auto &table = MuLawTable();
+  for (int32_t i = 0; i != n; ++i) {
+    out[i] = table[in[i]] * scale;
+  }
+}
+
+void ConvertALawSamples(const uint8_t *in, int32_t n, float scale,
+                        float *out) {
+  const auto &table = ALawTable();
+  for (int32_t i = 0; i != n; ++i) {
+    out[i] = table[in[i]] * scale;
+  }
+}
+
+float Int16Scale(bool normalize_samples) {
+  return normalize_samples ? 1.0f / 32768 : 1.0f;
+}
+
+void ConvertSamples(SampleFormat format, const void *in, int32_t n,
+                    bool normalize_samples, std::vector<float> *out) {
+  out->resize(n);
+  float scale = Int16Scale(normalize_samples);
+
+  switch (format) {
+    case SampleFormat::kFloat: {
+      const float *p = static_cast<const float *>(in);
+      scale = normalize_samples ? 1.0f : 32768;
+      for (int32_t i = 0; i != n; ++i) {
+        (*out)[i] = p[i] * scale;
+      }
+      break;
+    }
+    case SampleFormat::kInt16:
+      ConvertSamples(static_cast<const int16_t *>(in), n, scale, out->data());
+      break;
+    case SampleFormat::kMuLaw:
+      ConvertMuLawSamples(static_cast<const uint8_t *>(in), n, scale,
+                          out->data());
+      break;
+    case SampleFormat::kALaw:
+      ConvertALawSamples(static_cast<const uint8_t *>(in), n, scale,
+                         out->data());
+      break;
+  }
+}
+
+}  // namespace sherpa_onnx
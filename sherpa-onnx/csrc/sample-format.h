@@ -0,0 +1,75 @@
+// sherpa-onnx/csrc/sample-format.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+#ifndef SHERPA_ONNX_CSRC_SAMPLE_FORMAT_H_
+#define SHERPA_ONNX_CSRC_SAMPLE_FORMAT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sherpa_onnx {
+
+enum class SampleFormat {
+  kFloat,  // 32-bit float in the range [-1, 1]
+  kInt16,  // 16-bit linear PCM
+  kMuLaw,  // 8-bit G.711 mu-law
+  kALaw,   // 8-bit G.711 A-law
+};
+
+/** Parse a sample format from its name.
+ *
+ * @param name One of float, int16, mulaw, alaw.
+ * @param format On return, it contains the parsed format.
+ * @return Return false if name is not a valid sample format.
+ */
+bool ParseSampleFormat(const std::string &name, SampleFormat *format);
+
+/// Return the number of bytes of a single sample in the given format
+int32_t BytesPerSample(SampleFormat format);
+
+/// Decode a G.711 mu-law encoded sample to 16-bit linear PCM
+int16_t MuLawToLinear(uint8_t sample);
+
+/// Decode a G.711 A-law encoded sample to 16-bit linear PCM
+int16_t ALawToLinear(uint8_t sample);
+
+/** Convert samples to float, i.e., out[i] = in[i] * scale.
+ *
+ * For mu-law and A-law, in[i] is first decoded to 16-bit linear PCM
+ * with a lookup table.
+ *
+ * @param in  Pointer to a 1-D array of size n.
+ * @param n  Number of samples in `in`.
+ * @param scale  Use 1/32768 to get samples in the range [-1, 1].
+ * @param out  Pointer to a 1-D array of size n.
+ */
+void ConvertSamples(const int16_t *in, int32_t n, float scale, float *out);
+
+void ConvertMuLawSamples(const uint8_t *in, int32_t n, float scale,
+                         float *out);
+
+void ConvertALawSamples(const uint8_t *in, int32_t n, float scale,
+                        float *out);
+
+/// Return the scale to convert 16-bit samples to the ones a model expects.
+/// Models trained on unnormalized samples, e.g., paraformer, use them
+/// as they are, i.e., with normalize_samples being false.
+float Int16Scale(bool normalize_samples);
+
+/** Convert samples of any format to the float samples a model expects.
+ *
+ * @param format  Format of `in`. kFloat samples are in the range [-1, 1].
+ * @param in  Pointer to a 1-D array of n samples of the given format.
+ * @param n  Number of samples in `in`.
+ * @param normalize_samples  If true, the output is in the range [-1, 1].
+ *                           Otherwise, it is in the range of int16.
+ * @param out  On return, it contains n samples. Pass the same vector
+ *             across calls to avoid allocating memory for every call.
+ */
+void ConvertSamples(SampleFormat format, const void *in, int32_t n,
+                    bool normalize_samples, std::vector<float> *out);
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_SAMPLE_FORMAT_H_
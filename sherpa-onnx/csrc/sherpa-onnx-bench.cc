@@ -0,0 +1,696 @@
+// sherpa-onnx/csrc/sherpa-onnx-bench.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <regex>  // NOLINT
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "sherpa-onnx/csrc/cat.h"
+#include "sherpa-onnx/csrc/context-graph.h"
+#include "sherpa-onnx/csrc/keyword-spotter.h"
+#include "sherpa-onnx/csrc/math.h"
+#include "sherpa-onnx/csrc/offline-recognizer.h"
+#include "sherpa-onnx/csrc/online-recognizer.h"
+#include "sherpa-onnx/csrc/online-transducer-model.h"
+#include "sherpa-onnx/csrc/onnx-utils.h"
+#include "sherpa-onnx/csrc/parse-options.h"
+#include "sherpa-onnx/csrc/resample.h"
+#include "sherpa-onnx/csrc/stack.h"
+#include "sherpa-onnx/csrc/voice-activity-detector.h"
+
+#if SHERPA_ONNX_ENABLE_TTS == 1
+#include "sherpa-onnx/csrc/offline-tts.h"
+#endif
+
+#ifndef SHERPA_ONNX_BENCH_VERSION
+#define SHERPA_ONNX_BENCH_VERSION ""
+#endif
+
+// Generated at build time. It defines SHERPA_ONNX_BENCH_GIT_SHA
+#include "sherpa-onnx-bench-git-sha.h"  // NOLINT
+
+#ifndef SHERPA_ONNX_BENCH_MODEL_DIR
+#define SHERPA_ONNX_BENCH_MODEL_DIR ""
+#endif
+
+namespace {
+
+constexpr int32_t kSampleRate = 16000;
+constexpr float kPi = 3.14159265358979f;
+
+struct BenchmarkConfig {
+  std::string model_dir = SHERPA_ONNX_BENCH_MODEL_DIR;
+  std::string filter = ".*";
+  std::string output;
+  float min_time = 1.0;
+  int32_t num_threads = 1;
+
+  void Register(sherpa_onnx::ParseOptions *po) {
+    po->Register("model-dir", &model_dir,
+                 "Directory containing models generated by "
+                 "scripts/bench/generate-tiny-models.py. If empty or the "
+                 "models are missing, end-to-end benchmarks are skipped.");
+
+    po->Register("filter", &filter,
+                 "Run only benchmarks whose name matches this regular "
+                 "expression");
+
+    po->Register("output", &output,
+                 "If not empty, write the results in JSON to this file. "
+                 "Otherwise, they are written to stdout");
+
+    po->Register("min-time", &min_time,
+                 "Minimum number of seconds to run each benchmark");
+
+    po->Register("num-threads", &num_threads,
+                 "Number of threads used by onnxruntime");
+  }
+};
+
+struct BenchmarkResult {
+  std::string name;
+
+  // What an item is, e.g., audio_seconds, tokens
+  std::string item;
+
+  int64_t iterations = 0;
+  double items_per_iteration = 0;
+
+  // Statistics of the time of one iteration, in seconds
+  double mean = 0;
+  double min = 0;
+  double p50 = 0;
+  double p90 = 0;
+  double p99 = 0;
+
+  double ItemsPerSecond() const {
+    return mean > 0 ? items_per_iteration / mean : 0;
+  }
+};
+
+class BenchmarkRunner {
+ public:
+  explicit BenchmarkRunner(const BenchmarkConfig &config)
+      : config_(config), filter_(config.filter) {}
+
+  bool Selected(const std::string &name) const {
+    return std::regex_search(name, filter_);
+  }
+
+  /* Run f() repeatedly for at least config.min_time seconds.
+   *
+   * @param name  Name of the benchmark
+   * @param item  What is processed in an iteration, e.g., audio_seconds
+   * @param items_per_iteration  Number of items processed in an iteration
+   * @param f  The function to benchmark
+   */
+  void Run(const std::string &name, const std::string &item,
+           double items_per_iteration, const std::function<void()> &f) {
+    if (!Selected(name)) {
+      return;
+    }
+
+    fprintf(stderr, "Running %s\n", name.c_str());
+
+    // warm up
+    f();
+
+    std::vector<double> elapsed;
+    double total = 0;
+    while (total < config_.min_time || elapsed.size() < 3) {
+      auto begin = std::chrono::steady_clock::now();
+      f();
+      auto end = std::chrono::steady_clock::now();
+
+      double t = std::chrono::duration<double>(end - begin).count();
+      elapsed.push_back(t);
+      total += t;
+    }
+
+    std::sort(elapsed.begin(), elapsed.end());
+
+    BenchmarkResult r;
+    r.name = name;
+    r.item = item;
+    r.iterations = elapsed.size();
+    r.items_per_iteration = items_per_iteration;
+    r.mean = total / elapsed.size();
+    r.min = elapsed.front();
+    r.p50 = Percentile(elapsed, 0.5);
+    r.p90 = Percentile(elapsed, 0.9);
+    r.p99 = Percentile(elapsed, 0.99);
+
+    fprintf(stderr, "  iterations: %d, mean: %.3f ms, %s/s: %.3f\n",
+            static_cast<int32_t>(r.iterations), r.mean * 1000, item.c_str(),
+            r.ItemsPerSecond());
+
+    results_.push_back(std::move(r));
+  }
+
+  std::string ToJson() const {
+    std::ostringstream os;
+    os.precision(9);
+
+    std::time_t now = std::time(nullptr);
+    char date[64];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ",
+                  std::gmtime(&now));
+
+    os << "{\n";
+    os << "  \"context\": {\n";
+    os << "    \"date\": \"" << date << "\",\n";
+    os << "    \"version\": \"" << SHERPA_ONNX_BENCH_VERSION << "\",\n";
+    os << "    \"git_sha\": \"" << SHERPA_ONNX_BENCH_GIT_SHA << "\",\n";
+    os << "    \"num_threads\": " << config_.num_threads << ",\n";
+    os << "    \"min_time\": " << config_.min_time << "\n";
+    os << "  },\n";
+    os << "  \"benchmarks\": [";
+
+    std::string sep = "\n";
+    for (const auto &r : results_) {
+      os << sep;
+      sep = ",\n";
+
+      os << "    {\"name\": \"" << r.name << "\", ";
+      os << "\"iterations\": " << r.iterations << ", ";
+      os << "\"mean_ms\": " << r.mean * 1000 << ", ";
+      os << "\"min_ms\": " << r.min * 1000 << ", ";
+      os << "\"p50_ms\": " << r.p50 * 1000 << ", ";
+      os << "\"p90_ms\": " << r.p90 * 1000 << ", ";
+      os << "\"p99_ms\": " << r.p99 * 1000 << ", ";
+      os << "\"item\": \"" << r.item << "\", ";
+      os << "\"items_per_iteration\": " << r.items_per_iteration << ", ";
+      os << "\"items_per_second\": " << r.ItemsPerSecond() << "}";
+    }
+
+    os << "\n  ]\n}\n";
+
+    return os.str();
+  }
+
+ private:
+  // v is sorted
+  static double Percentile(const std::vector<double> &v, double p) {
+    int32_t i = std::min<int32_t>(v.size() - 1, std::ceil(p * v.size()) - 1);
+    return v[std::max(i, 0)];
+  }
+
+ private:
+  BenchmarkConfig config_;
+  std::regex filter_;
+  std::vector<BenchmarkResult> results_;
+};
+
+// Audio with speech-like bursts of tones separated by near silence.
+// It always returns the same samples for the same arguments.
+std::vector<float> GenerateAudio(float duration, int32_t seed = 0) {
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> noise(0, 1);
+  std::uniform_real_distribution<float> segment(0.3, 1.5);
+  std::uniform_real_distribution<float> freq(100, 1000);
+
+  int32_t n = duration * kSampleRate;
+  std::vector<float> samples(n);
+
+  bool is_speech = false;
+  int32_t i = 0;
+  while (i < n) {
+    int32_t end = std::min<int32_t>(n, i + segment(gen) * kSampleRate);
+    float f0 = freq(gen);
+
+    for (; i < end; ++i) {
+      float t = static_cast<float>(i) / kSampleRate;
+      if (is_speech) {
+        samples[i] = 0.2 * std::sin(2 * kPi * f0 * t) +
+                     0.1 * std::sin(4 * kPi * f0 * t) + 0.05 * noise(gen);
+      } else {
+        samples[i] = 0.001 * noise(gen);
+      }
+    }
+
+    is_speech = !is_speech;
+  }
+
+  return samples;
+}
+
+std::vector<float> RandomVector(int32_t n, int32_t seed = 0) {
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> d(0, 1);
+
+  std::vector<float> ans(n);
+  for (auto &f : ans) {
+    f = d(gen);
+  }
+  return ans;
+}
+
+bool FileExists(const std::string &filename) {
+  return std::ifstream(filename).good();
+}
+
+// ============================================================
+// Microbenchmarks. They don't need any models.
+// ============================================================
+
+void BenchmarkStackAndCat(BenchmarkRunner *runner) {
+  Ort::AllocatorWithDefaultOptions allocator;
+
+  // Similar to a cached_key state of a streaming zipformer2 model
+  std::array<int64_t, 3> shape{64, 1, 128};
+
+  for (int32_t batch_size : {1, 8, 32}) {
+    std::vector<Ort::Value> values;
+    for (int32_t i = 0; i != batch_size; ++i) {
+      auto v = Ort::Value::CreateTensor<float>(allocator, shape.data(),
+                                               shape.size());
+      sherpa_onnx::Fill<float>(&v, 0.5);
+      values.push_back(std::move(v));
+    }
+
+    std::vector<const Ort::Value *> p;
+    for (const auto &v : values) {
+      p.push_back(&v);
+    }
+
+    double num_floats = batch_size * shape[0] * shape[1] * shape[2];
+
+    std::string suffix = "/64x1x128/n=" + std::to_string(batch_size);
+
+    runner->Run("stack" + suffix, "floats", num_floats,
+                [&]() { sherpa_onnx::Stack<float>(allocator, p, 1); });
+
+    runner->Run("cat" + suffix, "floats", num_floats,
+                [&]() { sherpa_onnx::Cat<float>(allocator, p, 1); });
+  }
+}
+
+void BenchmarkTopkIndex(BenchmarkRunner *runner) {
+  for (int32_t size : {500, 5000}) {
+    for (int32_t k : {4, 16}) {
+      std::vector<float> v = RandomVector(size, size + k);
+
+      std::string name = "topk_index/size=" + std::to_string(size) +
+                         "/k=" + std::to_string(k);
+
+      // Keep the result so that the call is not optimized away
+      std::vector<int32_t> ans;
+      runner->Run(name, "calls", 1,
+                  [&]() { ans = sherpa_onnx::TopkIndex(v.data(), size, k); });
+    }
+  }
+}
+
+void BenchmarkContextGraph(BenchmarkRunner *runner) {
+  constexpr int32_t kVocabSize = 500;
+  constexpr int32_t kNumTokens = 10000;
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int32_t> token(1, kVocabSize - 1);
+  std::uniform_int_distribution<int32_t> length(2, 8);
+
+  // Decode-like token sequence, with phrases from the graph spliced in so
+  // that matches happen as well
+  for (int32_t num_phrases : {100, 10000}) {
+    std::vector<std::vector<int32_t>> phrases(num_phrases);
+    for (auto &p : phrases) {
+      p.resize(length(gen));
+      for (auto &t : p) {
+        t = token(gen);
+      }
+    }
+
+    sherpa_onnx::ContextGraph graph(phrases, 1.5);
+
+    std::vector<int32_t> tokens;
+    std::uniform_int_distribution<int32_t> phrase(0, num_phrases - 1);
+    while (static_cast<int32_t>(tokens.size()) < kNumTokens) {
+      if (gen() % 4 == 0) {
+        const auto &p = phrases[phrase(gen)];
+        tokens.insert(tokens.end(), p.begin(), p.end());
+      } else {
+        tokens.push_back(token(gen));
+      }
+    }
+
+    std::string name =
+        "context_graph/forward_one_step/phrases=" + std::to_string(num_phrases);
+
+    float score = 0;
+    runner->Run(name, "tokens", tokens.size(), [&]() {
+      const sherpa_onnx::ContextState *state = graph.Root();
+      for (int32_t t : tokens) {
+        auto r = graph.ForwardOneStep(state, t);
+        score += std::get<0>(r);
+        state = std::get<1>(r);
+      }
+    });
+
+    if (score == std::numeric_limits<float>::infinity()) {
+      fprintf(stderr, "%f\n", score);
+    }
+  }
+}
+
+void BenchmarkLinearResample(BenchmarkRunner *runner) {
+  // The same parameters as in features.cc
+  for (int32_t sample_rate : {8000, 44100, 48000}) {
+    float min_freq = std::min<int32_t>(sample_rate, kSampleRate);
+    float lowpass_cutoff = 0.99 * 0.5 * min_freq;
+    int32_t lowpass_filter_width = 6;
+
+    sherpa_onnx::LinearResample resampler(sample_rate, kSampleRate,
+                                          lowpass_cutoff, lowpass_filter_width);
+
+    // 0.1 second per call, like a chunk from a microphone
+    std::vector<float> samples = RandomVector(sample_rate / 10);
+    std::vector<float> out;
+
+    std::string name = "linear_resample/" + std::to_string(sample_rate) +
+                       "->" + std::to_string(kSampleRate);
+
+    runner->Run(name, "audio_seconds", 0.1, [&]() {
+      resampler.Resample(samples.data(), samples.size(), false, &out);
+    });
+  }
+}
+
+// ============================================================
+// End-to-end benchmarks. They use models generated by
+// scripts/bench/generate-tiny-models.py
+// ============================================================
+
+sherpa_onnx::OnlineModelConfig GetOnlineModelConfig(
+    const BenchmarkConfig &config) {
+  sherpa_onnx::OnlineModelConfig ans;
+  ans.transducer.encoder = config.model_dir + "/zipformer2-encoder.onnx";
+  ans.transducer.decoder = config.model_dir + "/zipformer2-decoder.onnx";
+  ans.transducer.joiner = config.model_dir + "/zipformer2-joiner.onnx";
+  ans.tokens = config.model_dir + "/tokens.txt";
+  ans.num_threads = config.num_threads;
+  ans.model_type = "zipformer2";
+
+  return ans;
+}
+
+void BenchmarkStackStates(const BenchmarkConfig &config,
+                          BenchmarkRunner *runner) {
+  if (!runner->Selected("zipformer2/")) {
+    return;
+  }
+
+  auto model = sherpa_onnx::OnlineTransducerModel::Create(
+      GetOnlineModelConfig(config));
+
+  for (int32_t batch_size : {8, 32}) {
+    std::vector<std::vector<Ort::Value>> states(batch_size);
+    for (auto &s : states) {
+      s = model->GetEncoderInitStates();
+    }
+
+    std::string suffix = "/batch=" + std::to_string(batch_size);
+
+    runner->Run("zipformer2/stack_states" + suffix, "streams", batch_size,
+                [&]() { model->StackStates(states); });
+
+    std::vector<Ort::Value> stacked = model->StackStates(states);
+    runner->Run("zipformer2/unstack_states" + suffix, "streams", batch_size,
+                [&]() { model->UnStackStates(stacked); });
+  }
+}
+
+void BenchmarkOnlineRecognizer(const BenchmarkConfig &config,
+                               BenchmarkRunner *runner) {
+  if (!runner->Selected("online_recognizer/")) {
+    return;
+  }
+
+  constexpr float kDuration = 5;
+
+  for (const char *method : {"greedy_search", "modified_beam_search"}) {
+    sherpa_onnx::OnlineRecognizerConfig recognizer_config;
+    recognizer_config.model_config = GetOnlineModelConfig(config);
+    recognizer_config.decoding_method = method;
+    recognizer_config.enable_endpoint = false;
+
+    sherpa_onnx::OnlineRecognizer recognizer(recognizer_config);
+
+    for (int32_t batch_size : {1, 8}) {
+      std::vector<std::vector<float>> audio(batch_size);
+      for (int32_t i = 0; i != batch_size; ++i) {
+        audio[i] = GenerateAudio(kDuration, i);
+      }
+
+      std::string name = std::string("online_recognizer/") + method +
+                         "/batch=" + std::to_string(batch_size);
+
+      runner->Run(name, "audio_seconds", kDuration * batch_size, [&]() {
+        std::vector<std::unique_ptr<sherpa_onnx::OnlineStream>> streams;
+        for (const auto &samples : audio) {
+          auto s = recognizer.CreateStream();
+          s->AcceptWaveform(kSampleRate, samples.data(), samples.size());
+          s->InputFinished();
+          streams.push_back(std::move(s));
+        }
+
+        std::vector<sherpa_onnx::OnlineStream *> ready;
+        while (true) {
+          ready.clear();
+          for (auto &s : streams) {
+            if (recognizer.IsReady(s.get())) {
+              ready.push_back(s.get());
+            }
+          }
+
+          if (ready.empty()) {
+            break;
+          }
+
+          recognizer.DecodeStreams(ready.data(), ready.size());
+        }
+
+        for (auto &s : streams) {
+          recognizer.GetResult(s.get());
+        }
+      });
+    }
+  }
+}
+
+void BenchmarkKeywordSpotter(const BenchmarkConfig &config,
+                             BenchmarkRunner *runner) {
+  if (!runner->Selected("keyword_spotter/")) {
+    return;
+  }
+
+  constexpr float kDuration = 5;
+
+  sherpa_onnx::KeywordSpotterConfig kws_config;
+  kws_config.model_config = GetOnlineModelConfig(config);
+  kws_config.keywords_file = config.model_dir + "/keywords.txt";
+
+  sherpa_onnx::KeywordSpotter kws(kws_config);
+
+  std::vector<float> samples = GenerateAudio(kDuration);
+
+  runner->Run("keyword_spotter/batch=1", "audio_seconds", kDuration, [&]() {
+    auto s = kws.CreateStream();
+    s->AcceptWaveform(kSampleRate, samples.data(), samples.size());
+    s->InputFinished();
+
+    while (kws.IsReady(s.get())) {
+      kws.DecodeStream(s.get());
+      kws.GetResult(s.get());
+    }
+  });
+}
+
+void BenchmarkOfflineRecognizer(const BenchmarkConfig &config,
+                                BenchmarkRunner *runner) {
+  if (!runner->Selected("offline_recognizer/")) {
+    return;
+  }
+
+  constexpr float kDuration = 5;
+
+  sherpa_onnx::OfflineRecognizerConfig recognizer_config;
+  recognizer_config.model_config.zipformer_ctc.model =
+      config.model_dir + "/zipformer-ctc.onnx";
+  recognizer_config.model_config.tokens = config.model_dir + "/tokens.txt";
+  recognizer_config.model_config.num_threads = config.num_threads;
+
+  sherpa_onnx::OfflineRecognizer recognizer(recognizer_config);
+
+  for (int32_t batch_size : {1, 8}) {
+    std::vector<std::vector<float>> audio(batch_size);
+    for (int32_t i = 0; i != batch_size; ++i) {
+      audio[i] = GenerateAudio(kDuration, i);
+    }
+
+    std::string name =
+        "offline_recognizer/ctc/batch=" + std::to_string(batch_size);
+
+    runner->Run(name, "audio_seconds", kDuration * batch_size, [&]() {
+      std::vector<std::unique_ptr<sherpa_onnx::OfflineStream>> streams;
+      std::vector<sherpa_onnx::OfflineStream *> p;
+      for (const auto &samples : audio) {
+        auto s = recognizer.CreateStream();
+        s->AcceptWaveform(kSampleRate, samples.data(), samples.size());
+        p.push_back(s.get());
+        streams.push_back(std::move(s));
+      }
+
+      recognizer.DecodeStreams(p.data(), p.size());
+    });
+  }
+}
+
+void BenchmarkVad(const BenchmarkConfig &config, BenchmarkRunner *runner) {
+  if (!runner->Selected("vad/")) {
+    return;
+  }
+
+  constexpr float kDuration = 30;
+
+  sherpa_onnx::VadModelConfig vad_config;
+  vad_config.silero_vad.model = config.model_dir + "/silero-vad.onnx";
+  vad_config.num_threads = config.num_threads;
+
+  sherpa_onnx::VoiceActivityDetector vad(vad_config);
+  std::vector<float> samples = GenerateAudio(kDuration);
+  int32_t window_size = vad_config.silero_vad.window_size;
+
+  runner->Run("vad/silero/accept_waveform", "audio_seconds", kDuration, [&]() {
+    vad.Reset();
+
+    for (int32_t i = 0; i + window_size <= static_cast<int32_t>(samples.size());
+         i += window_size) {
+      vad.AcceptWaveform(samples.data() + i, window_size);
+      while (!vad.Empty()) {
+        vad.Pop();
+      }
+    }
+  });
+}
+
+#if SHERPA_ONNX_ENABLE_TTS == 1
+void BenchmarkTts(const BenchmarkConfig &config, BenchmarkRunner *runner) {
+  if (!runner->Selected("tts/")) {
+    return;
+  }
+
+  sherpa_onnx::OfflineTtsConfig tts_config;
+  tts_config.model.vits.model = config.model_dir + "/vits.onnx";
+  tts_config.model.vits.lexicon = config.model_dir + "/vits-lexicon.txt";
+  tts_config.model.vits.tokens = config.model_dir + "/vits-tokens.txt";
+  tts_config.model.num_threads = config.num_threads;
+
+  sherpa_onnx::OfflineTts tts(tts_config);
+
+  std::string text =
+      "The quick brown fox jumps over the lazy dog. "
+      "Where there is a will, there is a way! "
+      "Think about the water, the land and the air, then make a great home "
+      "for people. Read the sentence three times before you turn back.";
+
+  auto audio = tts.Generate(text);
+  double seconds = static_cast<double>(audio.samples.size()) /
+                   std::max(audio.sample_rate, 1);
+
+  runner->Run("tts/vits/generate", "audio_seconds", seconds,
+              [&]() { tts.Generate(text); });
+}
+#endif
+
+}  // namespace
+
+int main(int32_t argc, char *argv[]) {
+  const char *kUsageMessage = R"usage(
+Benchmarks of sherpa-onnx.
+
+It contains microbenchmarks of kernels on the hot paths, e.g., Stack(),
+TopkIndex(), ContextGraph::ForwardOneStep() and LinearResample, as well as
+end-to-end benchmarks of ASR, KWS, VAD and TTS.
+
+The end-to-end benchmarks use tiny randomly initialized models, which are
+generated by
+
+  python3 ./scripts/bench/generate-tiny-models.py --out-dir ./bench-models
+
+They are generated at build time if Python and onnx are available. Only
+the speed of the results is meaningful; the recognized text is not.
+
+Usage:
+
+  ./bin/sherpa-onnx-bench \
+    --model-dir=./bench-models \
+    --filter='online_recognizer|vad' \
+    --output=./bench.json
+
+The results are saved in JSON. For each benchmark, it contains the
+latency of one iteration (mean, min, p50, p90, p99 in milliseconds) and
+the throughput (items_per_second).
+)usage";
+
+  sherpa_onnx::ParseOptions po(kUsageMessage);
+  BenchmarkConfig config;
+  config.Register(&po);
+  po.Read(argc, argv);
+
+  if (po.NumArgs() != 0) {
+    po.PrintUsage();
+    exit(EXIT_FAILURE);
+  }
+
+  BenchmarkRunner runner(config);
+
+  BenchmarkStackAndCat(&runner);
+  BenchmarkTopkIndex(&runner);
+  BenchmarkContextGraph(&runner);
+  BenchmarkLinearResample(&runner);
+
+  if (!config.model_dir.empty() &&
+      FileExists(config.model_dir + "/zipformer2-encoder.onnx")) {
+    BenchmarkStackStates(config, &runner);
+    BenchmarkOnlineRecognizer(config, &runner);
+    BenchmarkKeywordSpotter(config, &runner);
+    BenchmarkOfflineRecognizer(config, &runner);
+    BenchmarkVad(config, &runner);
+#if SHERPA_ONNX_ENABLE_TTS == 1
+    BenchmarkTts(config, &runner);
+#endif
+  } else {
+    fprintf(stderr,
+            "Skip end-to-end benchmarks since there are no models in '%s'. "
+            "Please see scripts/bench/generate-tiny-models.py\n",
+            config.model_dir.c_str());
+  }
+
+  std::string json = runner.ToJson();
+  if (config.output.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream os(config.output);
+    os << json;
+    fprintf(stderr, "Saved to %s\n", config.output.c_str());
+  }
+
+  return 0;
+}
@@ -0,0 +1,90 @@
+// sherpa-onnx/csrc/sherpa-onnx-compile-lexicon.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+#include <stdio.h>
+
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "sherpa-onnx/csrc/compiled-lexicon.h"
+#include "sherpa-onnx/csrc/lexicon.h"
+#include "sherpa-onnx/csrc/parse-options.h"
+
+int main(int32_t argc, char *argv[]) {
+  const char *kUsageMessage = R"usage(
+Convert a text lexicon for TTS models to a binary format that is
+memory-mapped at load time, so large lexicons are loaded instantly.
+
+Usage:
+
+./bin/sherpa-onnx-compile-lexicon \
+  --tokens=./vits-zh-aishell3/tokens.txt \
+  ./vits-zh-aishell3/lexicon.txt \
+  ./vits-zh-aishell3/lexicon.bin
+
+Then pass lexicon.bin to --vits-lexicon. It has to be used with the same
+tokens.txt since token IDs are saved in it.
+)usage";
+
+  std::string tokens;
+
+  sherpa_onnx::ParseOptions po(kUsageMessage);
+  po.Register("tokens", &tokens, "Path to tokens.txt");
+  po.Read(argc, argv);
+  if (po.NumArgs() != 2 || tokens.empty()) {
+    fprintf(stderr,
+            "Error: Please provide --tokens and 2 positional arguments: the "
+            "input lexicon and the output filename.\n\n");
+    po.PrintUsage();
+    exit(EXIT_FAILURE);
+  }
+
+  std::string lexicon = po.GetArg(1);
+  std::string output = po.GetArg(2);
+
+  const auto begin = std::chrono::steady_clock::now();
+
+  std::unordered_map<std::string, int32_t> token2id;
+  {
+    std::ifstream is(tokens);
+    if (!is) {
+      fprintf(stderr, "Failed to open %s\n", tokens.c_str());
+      return -1;
+    }
+    token2id = sherpa_onnx::ReadTokens(is);
+  }
+
+  std::unordered_map<std::string, std::vector<int32_t>> word2ids;
+  {
+    std::ifstream is(lexicon);
+    if (!is) {
+      fprintf(stderr, "Failed to open %s\n", lexicon.c_str());
+      return -1;
+    }
+    word2ids = sherpa_onnx::ReadLexicon(is, token2id);
+  }
+
+  {
+    std::ofstream os(output, std::ios::binary);
+    sherpa_onnx::CompiledLexicon::Write(word2ids, os);
+    if (!os) {
+      fprintf(stderr, "Failed to write %s\n", output.c_str());
+      return -1;
+    }
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  float elapsed_seconds =
+      std::chrono::duration_cast<std::chrono::milliseconds>(end - begin)
+          .count() /
+      1000.;
+
+  fprintf(stderr, "Saved %d words to %s in %.3f s\n",
+          static_cast<int32_t>(word2ids.size()), output.c_str(),
+          elapsed_seconds);
+
+  return 0;
+}
@@ -4,37 +4,81 @@
 
 #include <stdio.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cinttypes>
 #include <chrono>  // NOLINT
 #include <fstream>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <sstream>
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "sherpa-onnx/csrc/offline-recognizer.h"
 #include "sherpa-onnx/csrc/parse-options.h"
 #include "sherpa-onnx/csrc/wave-reader.h"
+#include "sherpa-onnx/csrc/work-stealing-queue.h"
+
+namespace {
+
+// Output of the reader stage
+struct Utterance {
+  std::string filename;
+  int32_t sampling_rate = 0;
+  std::vector<float> samples;
+};
+
+// Output of the featurizer stage
+struct FeaturizedUtterance {
+  std::string filename;
+  float duration = 0;  // in seconds
+  std::unique_ptr<sherpa_onnx::OfflineStream> stream;
+};
+
+// Output of the batcher stage
+using Batch = std::vector<FeaturizedUtterance>;
+
+// Statistics of one stage of the pipeline
+class StageStats {
+ public:
+  explicit StageStats(const char *name) : name_(name) {}
+
+  void Add(int64_t num_items, float audio_seconds, float busy_seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_items_ += num_items;
+    audio_seconds_ += audio_seconds;
+    busy_seconds_ += busy_seconds;
+  }
 
-std::atomic<int> wav_index(0);
-std::mutex mtx;
-
-std::vector<std::vector<std::string>> SplitToBatches(
-    const std::vector<std::string> &input, int32_t batch_size) {
-  std::vector<std::vector<std::string>> outputs;
-  auto itr = input.cbegin();
-  int32_t process_num = 0;
-
-  while (process_num + batch_size <= static_cast<int32_t>(input.size())) {
-    auto chunk_end = itr + batch_size;
-    outputs.emplace_back(itr, chunk_end);
-    itr = chunk_end;
-    process_num += batch_size;
+  float AudioSeconds() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return audio_seconds_;
   }
-  if (itr != input.cend()) {
-    outputs.emplace_back(itr, input.cend());
+
+  void Print(float wall_seconds) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fprintf(stderr, "%-10s %8" PRId64 " %10.3f %12.3f %10.3f %10.4f\n", name_,
+            num_items_, busy_seconds_, audio_seconds_ / wall_seconds,
+            num_items_ / wall_seconds,
+            audio_seconds_ > 0 ? busy_seconds_ / audio_seconds_ : 0);
   }
-  return outputs;
+
+ private:
+  const char *name_;
+  mutable std::mutex mutex_;
+  int64_t num_items_ = 0;
+  double audio_seconds_ = 0;
+  double busy_seconds_ = 0;
+};
+
+float SecondsSince(std::chrono::steady_clock::time_point begin) {
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - begin)
+             .count() /
+         1e6f;
 }
 
 std::vector<std::string> LoadScpFile(const std::string &wav_scp_path) {
@@ -54,84 +98,127 @@ std::vector<std::string> LoadScpFile(const std::string &wav_scp_path) {
   return wav_paths;
 }
 
-void AsrInference(const std::vector<std::vector<std::string>> &chunk_wav_paths,
-                  sherpa_onnx::OfflineRecognizer *recognizer,
-                  float *total_length, float *total_time) {
-  std::vector<std::unique_ptr<sherpa_onnx::OfflineStream>> ss;
-  std::vector<sherpa_onnx::OfflineStream *> ss_pointers;
-  float duration = 0.0f;
-  float elapsed_seconds_batch = 0.0f;
+// Read wave files and send them to the featurizers
+void Reader(const std::vector<std::string> &wav_paths,
+            std::atomic<int32_t> *next_wav,
+            sherpa_onnx::WorkStealingQueue<Utterance> *out,
+            StageStats *stats) {
+  int32_t i;
+  while ((i = next_wav->fetch_add(1)) <
+         static_cast<int32_t>(wav_paths.size())) {
+    const auto begin = std::chrono::steady_clock::now();
 
-  // warm up
-  for (const auto &wav_filename : chunk_wav_paths[0]) {
-    int32_t sampling_rate = -1;
+    Utterance u;
+    u.filename = wav_paths[i];
     bool is_ok = false;
-    const std::vector<float> samples =
-        sherpa_onnx::ReadWave(wav_filename, &sampling_rate, &is_ok);
+    u.samples = sherpa_onnx::ReadWave(u.filename, &u.sampling_rate, &is_ok);
     if (!is_ok) {
-      fprintf(stderr, "Failed to read '%s'\n", wav_filename.c_str());
+      fprintf(stderr, "Failed to read '%s'\n", u.filename.c_str());
       continue;
     }
-    duration += samples.size() / static_cast<float>(sampling_rate);
-    auto s = recognizer->CreateStream();
-    s->AcceptWaveform(sampling_rate, samples.data(), samples.size());
 
-    ss.push_back(std::move(s));
-    ss_pointers.push_back(ss.back().get());
+    float duration = u.samples.size() / static_cast<float>(u.sampling_rate);
+    stats->Add(1, duration, SecondsSince(begin));
+
+    // Spread the utterances over the featurizers; idle ones steal the rest
+    out->Push(i, std::move(u));
   }
-  recognizer->DecodeStreams(ss_pointers.data(), ss_pointers.size());
-  ss_pointers.clear();
-  ss.clear();
-
-  while (true) {
-    int chunk = wav_index.fetch_add(1);
-    if (chunk >= chunk_wav_paths.size()) {
-      break;
-    }
-    const auto &wav_paths = chunk_wav_paths[chunk];
+}
+
+// Compute features of the utterances from the readers
+void Featurizer(int32_t featurizer_id,
+                const sherpa_onnx::OfflineRecognizer *recognizer,
+                sherpa_onnx::WorkStealingQueue<Utterance> *in,
+                sherpa_onnx::WorkStealingQueue<FeaturizedUtterance> *out,
+                StageStats *stats) {
+  Utterance u;
+  while (in->Pop(featurizer_id, &u)) {
     const auto begin = std::chrono::steady_clock::now();
-    for (const auto &wav_filename : wav_paths) {
-      int32_t sampling_rate = -1;
-      bool is_ok = false;
-      const std::vector<float> samples =
-          sherpa_onnx::ReadWave(wav_filename, &sampling_rate, &is_ok);
-      if (!is_ok) {
-        fprintf(stderr, "Failed to read '%s'\n", wav_filename.c_str());
-        continue;
-      }
-      duration += samples.size() / static_cast<float>(sampling_rate);
-      auto s = recognizer->CreateStream();
-      s->AcceptWaveform(sampling_rate, samples.data(), samples.size());
-
-      ss.push_back(std::move(s));
-      ss_pointers.push_back(ss.back().get());
+
+    FeaturizedUtterance f;
+    f.filename = std::move(u.filename);
+    f.duration = u.samples.size() / static_cast<float>(u.sampling_rate);
+    f.stream = recognizer->CreateStream();
+    f.stream->AcceptWaveform(u.sampling_rate, u.samples.data(),
+                             u.samples.size());
+
+    stats->Add(1, f.duration, SecondsSince(begin));
+
+    out->Push(0, std::move(f));
+  }
+}
+
+// Group utterances of similar durations into batches so that little
+// computation is wasted on padding.
+//
+// Utterance with duration d goes to bucket floor(d / bucket_width). A batch
+// is sent to the decoders as soon as a bucket has batch_size utterances.
+void Batcher(int32_t batch_size, int32_t num_buckets, float bucket_width,
+             sherpa_onnx::WorkStealingQueue<FeaturizedUtterance> *in,
+             sherpa_onnx::WorkStealingQueue<Batch> *out, StageStats *stats) {
+  std::vector<Batch> buckets(num_buckets);
+  int32_t num_batches = 0;
+
+  auto send = [&](Batch *b) {
+    float duration = 0;
+    for (const auto &f : *b) {
+      duration += f.duration;
     }
-    recognizer->DecodeStreams(ss_pointers.data(), ss_pointers.size());
-    const auto end = std::chrono::steady_clock::now();
-    float elapsed_seconds =
-        std::chrono::duration_cast<std::chrono::milliseconds>(end - begin)
-            .count() /
-        1000.;
-    elapsed_seconds_batch += elapsed_seconds;
-    int i = 0;
-    for (const auto &wav_filename : wav_paths) {
-      fprintf(stderr, "%s\n%s\n----\n", wav_filename.c_str(),
-              ss[i]->GetResult().AsJsonString().c_str());
-      i = i + 1;
+    stats->Add(1, duration, 0);
+
+    // Round-robin over the decoders; idle ones steal from busy ones
+    out->Push(num_batches++, std::move(*b));
+    b->clear();
+  };
+
+  FeaturizedUtterance f;
+  while (in->Pop(0, &f)) {
+    int32_t k = std::min(static_cast<int32_t>(f.duration / bucket_width),
+                         num_buckets - 1);
+    buckets[k].push_back(std::move(f));
+    if (static_cast<int32_t>(buckets[k].size()) == batch_size) {
+      send(&buckets[k]);
     }
-    ss_pointers.clear();
-    ss.clear();
   }
 
-  {
-    std::lock_guard<std::mutex> guard(mtx);
-    *total_length += duration;
-    if (*total_time < elapsed_seconds_batch) {
-      *total_time = elapsed_seconds_batch;
+  // Partial batches of all buckets at the end of the input
+  for (auto &b : buckets) {
+    if (!b.empty()) {
+      send(&b);
+    }
+  }
+}
+
+// Decode batches from the batcher and print the results
+void Decoder(int32_t decoder_id, sherpa_onnx::OfflineRecognizer *recognizer,
+             sherpa_onnx::WorkStealingQueue<Batch> *in, std::mutex *print_mutex,
+             StageStats *stats) {
+  Batch batch;
+  std::vector<sherpa_onnx::OfflineStream *> ss_pointers;
+  while (in->Pop(decoder_id, &batch)) {
+    const auto begin = std::chrono::steady_clock::now();
+
+    float duration = 0;
+    ss_pointers.clear();
+    for (const auto &f : batch) {
+      duration += f.duration;
+      ss_pointers.push_back(f.stream.get());
+    }
+
+    recognizer->DecodeStreams(ss_pointers.data(), ss_pointers.size());
+
+    stats->Add(batch.size(), duration, SecondsSince(begin));
+
+    std::lock_guard<std::mutex> lock(*print_mutex);
+    for (const auto &f : batch) {
+      fprintf(stderr, "%s\n%s\n----\n", f.filename.c_str(),
+              f.stream->GetResult().AsJsonString().c_str());
     }
   }
 }
 
+}  // namespace
+
 int main(int32_t argc, char *argv[]) {
   const char *kUsageMessage = R"usage(
 Speech recognition using non-streaming models with sherpa-onnx.
@@ -214,6 +301,15 @@ See https://k2-fsa.github.io/sherpa/onnx/pretrained_models/offline-ctc/yesno/ind
 
 Note: It supports decoding multiple files in batches
 
+Files are processed by a pipeline of 4 stages running in parallel:
+
+  reader (--num-readers threads) -> featurizer (--num-featurizers threads)
+  -> batcher (1 thread) -> decoder (--nj threads)
+
+The batcher groups files of similar durations into batches of --batch-size
+files. A decoder that runs out of batches takes batches queued for other
+decoders, so threads that get long files do not hold back the others.
+
 foo.wav should be of single channel, 16-bit PCM encoded wave file; its
 sampling rate can be arbitrary and does not need to be 16kHz.
 
@@ -222,8 +318,13 @@ https://k2-fsa.github.io/sherpa/onnx/pretrained_models/index.html
 for a list of pre-trained models to download.
 )usage";
   std::string wav_scp = "";  // file path, kaldi style wav list.
-  int32_t nj = 1;            // thread number
+  int32_t nj = 1;            // number of decoder threads
   int32_t batch_size = 1;    // number of wav files processed at once.
+  int32_t num_readers = 1;
+  int32_t num_featurizers = 2;
+  int32_t num_buckets = 10;
+  float bucket_width = 2.0f;
+  int32_t queue_size = 64;
   sherpa_onnx::ParseOptions po(kUsageMessage);
   sherpa_onnx::OfflineRecognizerConfig config;
   config.Register(&po);
@@ -236,6 +337,19 @@ for a list of pre-trained models to download.
   po.Register("batch-size", &batch_size,
               "number of wav files processed at once during the decoding"
               "process. default=1");
+  po.Register("num-readers", &num_readers,
+              "Number of threads for reading wave files");
+  po.Register("num-featurizers", &num_featurizers,
+              "Number of threads for computing features");
+  po.Register("num-buckets", &num_buckets,
+              "Number of duration buckets. Files in a batch are from the "
+              "same bucket.");
+  po.Register("bucket-width", &bucket_width,
+              "Width in seconds of a duration bucket. The last bucket "
+              "contains all files longer than that.");
+  po.Register("queue-size", &queue_size,
+              "Maximum number of items waiting between two stages. It "
+              "limits the memory used when decoding is slower than reading.");
 
   po.Read(argc, argv);
   if (po.NumArgs() < 1 && wav_scp.empty()) {
@@ -250,20 +364,24 @@ for a list of pre-trained models to download.
     fprintf(stderr, "Errors in config!\n");
     return -1;
   }
-  std::this_thread::sleep_for(std::chrono::seconds(10));  // sleep 10s
+
+  if (nj < 1 || batch_size < 1 || num_readers < 1 || num_featurizers < 1 ||
+      num_buckets < 1 || bucket_width <= 0 || queue_size < 1) {
+    fprintf(stderr,
+            "--nj, --batch-size, --num-readers, --num-featurizers, "
+            "--num-buckets, --bucket-width and --queue-size should be "
+            "positive\n");
+    return -1;
+  }
+
   fprintf(stderr, "Creating recognizer ...\n");
   const auto begin = std::chrono::steady_clock::now();
   sherpa_onnx::OfflineRecognizer recognizer(config);
-  const auto end = std::chrono::steady_clock::now();
-  float elapsed_seconds =
-      std::chrono::duration_cast<std::chrono::milliseconds>(end - begin)
-          .count() /
-      1000.;
   fprintf(stderr,
           "Started nj: %d, batch_size: %d, wav_path: %s. recognizer init time: "
           "%.6f\n",
-          nj, batch_size, wav_scp.c_str(), elapsed_seconds);
-  std::this_thread::sleep_for(std::chrono::seconds(10));  // sleep 10s
+          nj, batch_size, wav_scp.c_str(), SecondsSince(begin));
+
   std::vector<std::string> wav_paths;
   if (!wav_scp.empty()) {
     wav_paths = LoadScpFile(wav_scp);
@@ -276,29 +394,87 @@ for a list of pre-trained models to download.
     fprintf(stderr, "wav files is empty.\n");
     return -1;
   }
-  std::vector<std::thread> threads;
-  std::vector<std::vector<std::string>> batch_wav_paths =
-      SplitToBatches(wav_paths, batch_size);
-  float total_length = 0.0f;
-  float total_time = 0.0f;
-  for (int i = 0; i < nj; i++) {
-    threads.emplace_back(std::thread(AsrInference, batch_wav_paths, &recognizer,
-                                     &total_length, &total_time));
+
+  sherpa_onnx::WorkStealingQueue<Utterance> wave_queue(num_featurizers,
+                                                       queue_size);
+  sherpa_onnx::WorkStealingQueue<FeaturizedUtterance> feature_queue(
+      1, queue_size);
+  sherpa_onnx::WorkStealingQueue<Batch> batch_queue(
+      nj, std::max(queue_size / batch_size, 2 * nj));
+
+  StageStats reader_stats("reader");
+  StageStats featurizer_stats("featurizer");
+  StageStats batcher_stats("batcher");
+  StageStats decoder_stats("decoder");
+  std::mutex print_mutex;
+  std::atomic<int32_t> next_wav(0);
+
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> readers;
+  for (int32_t i = 0; i != num_readers; ++i) {
+    readers.emplace_back(Reader, std::cref(wav_paths), &next_wav, &wave_queue,
+                         &reader_stats);
+  }
+
+  std::vector<std::thread> featurizers;
+  for (int32_t i = 0; i != num_featurizers; ++i) {
+    featurizers.emplace_back(Featurizer, i, &recognizer, &wave_queue,
+                             &feature_queue, &featurizer_stats);
+  }
+
+  std::thread batcher(Batcher, batch_size, num_buckets, bucket_width,
+                      &feature_queue, &batch_queue, &batcher_stats);
+
+  std::vector<std::thread> decoders;
+  for (int32_t i = 0; i != nj; ++i) {
+    decoders.emplace_back(Decoder, i, &recognizer, &batch_queue, &print_mutex,
+                          &decoder_stats);
+  }
+
+  // Shut down the stages in order. A stage exits after the queue before
+  // it is closed and drained.
+  for (auto &t : readers) {
+    t.join();
   }
+  wave_queue.Close();
 
-  for (auto &thread : threads) {
-    thread.join();
+  for (auto &t : featurizers) {
+    t.join();
   }
+  feature_queue.Close();
+
+  batcher.join();
+  batch_queue.Close();
+
+  for (auto &t : decoders) {
+    t.join();
+  }
+
+  float elapsed_seconds = SecondsSince(start);
 
   fprintf(stderr, "num threads: %d\n", config.model_config.num_threads);
   fprintf(stderr, "decoding method: %s\n", config.decoding_method.c_str());
   if (config.decoding_method == "modified_beam_search") {
     fprintf(stderr, "max active paths: %d\n", config.max_active_paths);
   }
-  fprintf(stderr, "Elapsed seconds: %.3f s\n", total_time);
-  float rtf = total_time / total_length;
-  fprintf(stderr, "Real time factor (RTF): %.6f / %.6f = %.4f\n", total_time,
-          total_length, rtf);
+
+  // busy: sum of the time spent by all threads of a stage
+  // RTF: busy / audio duration, i.e., the RTF of the stage with 1 thread
+  fprintf(stderr, "%-10s %8s %10s %12s %10s %10s\n", "stage", "items",
+          "busy(s)", "audio(s)/s", "items/s", "RTF");
+  reader_stats.Print(elapsed_seconds);
+  featurizer_stats.Print(elapsed_seconds);
+  batcher_stats.Print(elapsed_seconds);
+  decoder_stats.Print(elapsed_seconds);
+  fprintf(stderr, "Batches taken from other decoders: %" PRId64 "\n",
+          batch_queue.NumStolen());
+
+  float total_length = decoder_stats.AudioSeconds();
+  fprintf(stderr, "Elapsed seconds: %.3f s\n", elapsed_seconds);
+  float rtf = elapsed_seconds / total_length;
+  fprintf(stderr, "Real time factor (RTF): %.6f / %.6f = %.4f\n",
+          elapsed_seconds, total_length, rtf);
   fprintf(stderr, "SPEEDUP: %.4f\n", 1.0 / rtf);
 
   return 0;
@@ -0,0 +1,110 @@
+// sherpa-onnx/csrc/sherpa-onnx-vad-with-offline-asr.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include <stdio.h>
+
+#include <chrono>  // NOLINT
+#include <string>
+
+#include "sherpa-onnx/csrc/long-audio-transcriber.h"
+#include "sherpa-onnx/csrc/parse-options.h"
+
+int32_t main(int32_t argc, char *argv[]) {
+  const char *kUsageMessage = R"usage(
+Transcribe long files, e.g., recordings of a few hours, with a non-streaming
+model. Files are split into segments by silero VAD while they are read, and
+segments of similar lengths are decoded in batches.
+
+Please download silero_vad.onnx from
+https://github.com/snakers4/silero-vad/blob/master/files/silero_vad.onnx
+
+For instance, use
+wget https://github.com/snakers4/silero-vad/raw/master/files/silero_vad.onnx
+
+Usage:
+
+(1) Transducer from icefall
+
+  ./bin/sherpa-onnx-vad-with-offline-asr \
+    --silero-vad-model=/path/to/silero_vad.onnx \
+    --tokens=/path/to/tokens.txt \
+    --encoder=/path/to/encoder.onnx \
+    --decoder=/path/to/decoder.onnx \
+    --joiner=/path/to/joiner.onnx \
+    --num-threads=1 \
+    --num-decoding-threads=4 \
+    --batch-size=8 \
+    /path/to/foo.wav [/path/to/bar.wav ...]
+
+(2) Paraformer from FunASR
+
+  ./bin/sherpa-onnx-vad-with-offline-asr \
+    --silero-vad-model=/path/to/silero_vad.onnx \
+    --tokens=/path/to/tokens.txt \
+    --paraformer=/path/to/model.onnx \
+    --num-threads=1 \
+    /path/to/foo.wav
+
+Each wave file must be single channel, 16-bit PCM encoded. Each line of the
+output contains the start and end time in seconds and the text of a segment.
+)usage";
+
+  sherpa_onnx::ParseOptions po(kUsageMessage);
+  sherpa_onnx::LongAudioTranscriberConfig config;
+  config.Register(&po);
+
+  po.Read(argc, argv);
+  if (po.NumArgs() < 1) {
+    po.PrintUsage();
+    exit(EXIT_FAILURE);
+  }
+
+  fprintf(stderr, "%s\n", config.ToString().c_str());
+
+  if (!config.Validate()) {
+    fprintf(stderr, "Errors in config!\n");
+    return -1;
+  }
+
+  fprintf(stderr, "Creating recognizer ...\n");
+  sherpa_onnx::LongAudioTranscriber transcriber(config);
+  fprintf(stderr, "Recognizer created!\n");
+
+  for (int32_t i = 1; i <= po.NumArgs(); ++i) {
+    std::string filename = po.GetArg(i);
+    fprintf(stderr, "Transcribing %s\n", filename.c_str());
+
+    const auto begin = std::chrono::steady_clock::now();
+
+    float duration = 0;
+    bool ok = transcriber.TranscribeFile(
+        filename, [&duration](const sherpa_onnx::LongAudioSegment &s) {
+          fprintf(stdout, "%.3f -- %.3f %s\n", s.start, s.start + s.duration,
+                  s.result.text.c_str());
+          fflush(stdout);
+
+          duration = s.start + s.duration;
+        });
+
+    if (!ok) {
+      fprintf(stderr, "Failed to transcribe %s\n", filename.c_str());
+      continue;
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    float elapsed_seconds =
+        std::chrono::duration_cast<std::chrono::milliseconds>(end - begin)
+            .count() /
+        1000.;
+
+    fprintf(stderr, "Elapsed seconds: %.3f s\n", elapsed_seconds);
+    if (duration > 0) {
+      // duration is the end of the last segment, not of the file
+      fprintf(stderr, "Real time factor (RTF): %.3f / %.3f = %.3f\n",
+              elapsed_seconds, duration, elapsed_seconds / duration);
+    }
+  }
+
+  return 0;
+}
@@ -165,6 +165,12 @@ for a list of pre-trained models to download.
     os << r.AsJsonString() << "\n\n";
   }
 
+  if (config.blank_skip_threshold > 0) {
+    auto stats = recognizer.GetDecoderStats();
+    os << "Skipped " << stats.num_skipped_frames << " of " << stats.num_frames
+       << " frames. Skip rate: " << stats.SkipRate() << "\n";
+  }
+
   std::cerr << os.str();
 
   return 0;
@@ -0,0 +1,66 @@
+// sherpa-onnx/csrc/text-utils-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/text-utils.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(SplitSentences, English) {
+  auto ans = SplitSentences(
+      "How are you? I am fine.  Thanks!\nMr. Smith met J. Doe at 3.5 p.m. "
+      "today. He said \"bye.\" Then he left");
+
+  std::vector<std::string> expected = {
+      "How are you?",
+      "I am fine.",
+      "Thanks!",
+      "Mr. Smith met J. Doe at 3.5 p.m. today.",
+      "He said \"bye.\"",
+      "Then he left",
+  };
+  EXPECT_EQ(ans, expected);
+}
+
+TEST(SplitSentences, Abbreviations) {
+  auto ans = SplitSentences(
+      "I met Tom. Yes. Dr. Who and Mrs. Lee came, i.e. the (Prof. X) team, "
+      "etc. We left at 9 a.m. Bob. A. B. Smith says hi. So did Al.");
+
+  std::vector<std::string> expected = {
+      "I met Tom.",
+      "Yes.",
+      "Dr. Who and Mrs. Lee came, i.e. the (Prof. X) team, etc. We left at 9 "
+      "a.m. Bob.",
+      "A. B. Smith says hi.",
+      "So did Al.",
+  };
+  EXPECT_EQ(ans, expected);
+}
+
+TEST(SplitSentences, Chinese) {
+  auto ans = SplitSentences("今天天气很好。你去哪里？我去学校！");
+
+  std::vector<std::string> expected = {
+      "今天天气很好。",
+      "你去哪里？",
+      "我去学校！",
+  };
+  EXPECT_EQ(ans, expected);
+}
+
+TEST(SplitSentences, Empty) {
+  EXPECT_TRUE(SplitSentences("").empty());
+  EXPECT_TRUE(SplitSentences("  \n ").empty());
+
+  auto ans = SplitSentences("no punctuation");
+  ASSERT_EQ(ans.size(), 1);
+  EXPECT_EQ(ans[0], "no punctuation");
+}
+
+}  // namespace sherpa_onnx
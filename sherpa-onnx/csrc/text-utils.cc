@@ -10,10 +10,12 @@
 #include <algorithm>
 #include <cctype>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -385,6 +387,99 @@ std::vector<std::string> SplitUtf8(const std::string &text) {
   return MergeCharactersIntoWords(ans);
 }
 
+// Return true if the period at text[i] is after an abbreviation like Mr.,
+// after an initial like J., or ends a dotted abbreviation like p.m.
+static bool IsAbbreviation(const std::string &text, int32_t i) {
+  // Compared in lowercase without the trailing period
+  static const std::unordered_set<std::string> kAbbreviations = {
+      "mr", "mrs", "ms", "dr",  "st",  "jr",  "sr",  "prof",
+      "vs", "etc", "e.g", "i.e", "a.m", "p.m", "cf", "approx",
+  };
+
+  int32_t start = i;
+  while (start > 0 && !std::isspace(static_cast<uint8_t>(text[start - 1]))) {
+    --start;
+  }
+
+  // Skip opening quotes and brackets
+  while (start < i && std::strchr("\"'([", text[start]) != nullptr) {
+    ++start;
+  }
+
+  if (i - start == 1) {
+    return std::isupper(static_cast<uint8_t>(text[start]));
+  }
+
+  return kAbbreviations.count(ToLowerCase(text.substr(start, i - start))) != 0;
+}
+
+std::vector<std::string> SplitSentences(const std::string &text) {
+  std::vector<std::string> ans;
+
+  auto add = [&text, &ans](int32_t begin, int32_t end) {
+    while (begin < end && std::isspace(static_cast<uint8_t>(text[begin]))) {
+      ++begin;
+    }
+
+    while (end > begin && std::isspace(static_cast<uint8_t>(text[end - 1]))) {
+      --end;
+    }
+
+    if (begin < end) {
+      ans.push_back(text.substr(begin, end - begin));
+    }
+  };
+
+  // UTF-8 encoded 。！？
+  static const char *kFullWidth[] = {"\xe3\x80\x82", "\xef\xbc\x81",
+                                     "\xef\xbc\x9f"};
+
+  int32_t n = static_cast<int32_t>(text.size());
+  int32_t begin = 0;
+  for (int32_t i = 0; i < n; ++i) {
+    char c = text[i];
+    if (c == '\n') {
+      add(begin, i);
+      begin = i + 1;
+      continue;
+    }
+
+    if (c == '.' || c == '!' || c == '?') {
+      // Also keep closing quotes and brackets in this sentence
+      int32_t end = i + 1;
+      while (end < n && std::strchr("\"')]", text[end]) != nullptr) {
+        ++end;
+      }
+
+      if (end < n && !std::isspace(static_cast<uint8_t>(text[end]))) {
+        continue;
+      }
+
+      if (c == '.' && IsAbbreviation(text, i)) {
+        continue;
+      }
+
+      add(begin, end);
+      begin = end;
+      i = end - 1;
+      continue;
+    }
+
+    for (const char *p : kFullWidth) {
+      if (text.compare(i, 3, p) == 0) {
+        add(begin, i + 3);
+        begin = i + 3;
+        i += 2;
+        break;
+      }
+    }
+  }
+
+  add(begin, n);
+
+  return ans;
+}
+
 std::string ToLowerCase(const std::string &s) {
   std::string ans(s.size(), 0);
   std::transform(s.begin(), s.end(), ans.begin(),
@@ -124,6 +124,16 @@ std::vector<std::string> SplitUtf8(const std::string &text);
 std::string ToLowerCase(const std::string &s);
 void ToLowerCase(std::string *in_out);
 
+/** Split text into sentences.
+ *
+ * It splits after ., ! and ? that are followed by a space, after the
+ * full-width 。！？, and at new lines. A period after a short capitalized
+ * word, e.g., Mr. or Dr., or after a single letter, e.g., an initial,
+ * does not end a sentence. Each returned sentence keeps its punctuation;
+ * leading and trailing spaces are removed.
+ */
+std::vector<std::string> SplitSentences(const std::string &text);
+
 }  // namespace sherpa_onnx
 
 #endif  // SHERPA_ONNX_CSRC_TEXT_UTILS_H_
@@ -0,0 +1,60 @@
+// sherpa-onnx/csrc/thread-pool-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/thread-pool.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(ThreadPool, Run) {
+  std::atomic<int32_t> count{0};
+  {
+    ThreadPool pool(4);
+    for (int32_t i = 0; i != 100; ++i) {
+      pool.Run([&count]() { ++count; });
+    }
+    // The destructor waits for all queued tasks
+  }
+  EXPECT_EQ(count, 100);
+}
+
+TEST(ThreadPool, ParallelFor) {
+  for (int32_t num_threads : {0, 1, 3, 8}) {
+    ThreadPool pool(num_threads);
+    for (int32_t n : {0, 1, 2, 7, 1000}) {
+      std::vector<int32_t> v(n, 0);
+      pool.ParallelFor(n, [&v](int32_t i) { v[i] += i + 1; });
+      for (int32_t i = 0; i != n; ++i) {
+        EXPECT_EQ(v[i], i + 1) << num_threads << " " << n;
+      }
+    }
+  }
+}
+
+TEST(ThreadPool, ConcurrentParallelFor) {
+  ThreadPool pool(2);
+  std::atomic<int64_t> sum{0};
+
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t != 4; ++t) {
+    threads.emplace_back([&pool, &sum]() {
+      for (int32_t k = 0; k != 50; ++k) {
+        pool.ParallelFor(10, [&sum](int32_t i) { sum += i; });
+      }
+    });
+  }
+
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(sum, 4 * 50 * 45);
+}
+
+}  // namespace sherpa_onnx
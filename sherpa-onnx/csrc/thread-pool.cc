@@ -0,0 +1,123 @@
+// sherpa-onnx/csrc/thread-pool.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/thread-pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace sherpa_onnx {
+
+ThreadPool::ThreadPool(int32_t num_threads) {
+  threads_.reserve(std::max(num_threads, 0));
+  for (int32_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this]() { Worker(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+
+  for (auto &t : threads_) {
+    t.join();
+  }
+}
+
+void ThreadPool::Run(std::function<void()> task) {
+  if (threads_.empty()) {
+    task();
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  cond_.notify_one();
+}
+
+void ThreadPool::Worker() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+
+      if (tasks_.empty()) {
+        // stop_ is true and all tasks are done
+        return;
+      }
+
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
+
+namespace {
+
+// State shared by the caller of ParallelFor() and the helper tasks
+struct ParallelForState {
+  explicit ParallelForState(int32_t n) : n(n) {}
+
+  // Run f(i) for the remaining indexes
+  void Loop(const std::function<void(int32_t)> &f) {
+    int32_t i;
+    while ((i = next.fetch_add(1)) < n) {
+      f(i);
+
+      if (done.fetch_add(1) + 1 == n) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_all();
+      }
+    }
+  }
+
+  int32_t n;
+  std::atomic<int32_t> next{0};
+  std::atomic<int32_t> done{0};
+  std::mutex mutex;
+  std::condition_variable cond;
+};
+
+}  // namespace
+
+void ThreadPool::ParallelFor(int32_t n,
+                             const std::function<void(int32_t)> &f) {
+  if (n <= 0) {
+    return;
+  }
+
+  if (threads_.empty() || n == 1) {
+    for (int32_t i = 0; i != n; ++i) {
+      f(i);
+    }
+    return;
+  }
+
+  // Helper tasks may still be queued after all indexes are done, so the
+  // state is shared with them.
+  auto state = std::make_shared<ParallelForState>(n);
+  int32_t num_helpers = std::min(NumThreads(), n - 1);
+  for (int32_t k = 0; k != num_helpers; ++k) {
+    // f outlives the helpers that can still call it since we wait below
+    // until f has been called for all indexes.
+    Run([state, &f]() { state->Loop(f); });
+  }
+
+  state->Loop(f);
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->cond.wait(lock, [&state]() { return state->done.load() == state->n; });
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,65 @@
+// sherpa-onnx/csrc/thread-pool.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_THREAD_POOL_H_
+#define SHERPA_ONNX_CSRC_THREAD_POOL_H_
+
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace sherpa_onnx {
+
+/** A fixed-size pool of worker threads.
+ *
+ * Tasks are run in FIFO order. It is safe to call its methods from
+ * several threads at the same time.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @param num_threads Number of worker threads. If it is less than 1,
+   *                    no thread is created and tasks run in the
+   *                    calling thread.
+   */
+  explicit ThreadPool(int32_t num_threads);
+
+  // Wait for queued tasks to finish and join the worker threads
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int32_t NumThreads() const { return static_cast<int32_t>(threads_.size()); }
+
+  // Queue a task. It returns immediately.
+  void Run(std::function<void()> task);
+
+  /** Run f(i) for i in [0, n) and return after all of them have finished.
+   *
+   * The calling thread also runs f, so it does not deadlock if all worker
+   * threads are busy. Indexes are handed out one at a time, so f(i) with
+   * different costs are balanced among threads.
+   */
+  void ParallelFor(int32_t n, const std::function<void(int32_t)> &f);
+
+ private:
+  void Worker();
+
+ private:
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::function<void()>> tasks_;
+  bool stop_ = false;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_THREAD_POOL_H_
@@ -5,28 +5,147 @@
 #include "sherpa-onnx/csrc/transducer-keyword-decoder.h"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
-#include <cstring>
 #include <utility>
 #include <vector>
 
 #include "sherpa-onnx/csrc/log.h"
+#include "sherpa-onnx/csrc/math.h"
+#include "sherpa-onnx/csrc/online-stream.h"
 #include "sherpa-onnx/csrc/onnx-utils.h"
 
 namespace sherpa_onnx {
 
+void KeywordHypothesis::AddToken(int32_t token, int32_t timestamp,
+                                 float prob) {
+  if (num_tokens == kMaxTokens) {
+    // Discard the oldest token. It won't be used by any keyword
+    // of at most kMaxTokens tokens.
+    std::copy(tokens.begin() + 1, tokens.end(), tokens.begin());
+    std::copy(timestamps.begin() + 1, timestamps.end(), timestamps.begin());
+    std::copy(probs.begin() + 1, probs.end(), probs.begin());
+    --num_tokens;
+  }
+
+  tokens[num_tokens] = token;
+  timestamps[num_tokens] = timestamp;
+  probs[num_tokens] = prob;
+  ++num_tokens;
+  ++total_tokens;
+}
+
+bool KeywordHypothesis::SameAs(const KeywordHypothesis &other) const {
+  return context_state == other.context_state &&
+         total_tokens == other.total_tokens &&
+         num_tokens == other.num_tokens &&
+         std::equal(tokens.begin(), tokens.begin() + num_tokens,
+                    other.tokens.begin());
+}
+
+// Add hyp to the beam. If the beam already contains a hypothesis with the
+// same token sequence, their probabilities are merged with log-sum-exp.
+static void AddToBeam(const KeywordHypothesis &hyp,
+                      std::vector<KeywordHypothesis> *beam) {
+  for (auto &h : *beam) {
+    if (h.SameAs(hyp)) {
+      h.log_prob = LogAdd<double>()(h.log_prob, hyp.log_prob);
+      return;
+    }
+  }
+  beam->push_back(hyp);
+}
+
+static const KeywordHypothesis &GetMostProbable(
+    const std::vector<KeywordHypothesis> &beam) {
+  return *std::max_element(
+      beam.begin(), beam.end(),
+      [](const KeywordHypothesis &a, const KeywordHypothesis &b) {
+        return a.log_prob < b.log_prob;
+      });
+}
+
+// Select the indexes of the k largest entries of scores[0..n).
+// On return, topk contains min(k, n) indexes sorted by score in
+// descending order. It does not allocate memory if topk has enough capacity.
+static void TopK(const float *scores, int32_t n, int32_t k,
+                 std::vector<int32_t> *topk) {
+  topk->clear();
+  for (int32_t i = 0; i != n; ++i) {
+    float s = scores[i];
+    if (static_cast<int32_t>(topk->size()) == k && s <= scores[topk->back()]) {
+      continue;
+    }
+
+    if (static_cast<int32_t>(topk->size()) < k) {
+      topk->push_back(i);
+    } else {
+      topk->back() = i;
+    }
+
+    // Keep topk sorted. k is small, so insertion sort is fine.
+    for (int32_t j = static_cast<int32_t>(topk->size()) - 1;
+         j > 0 && scores[(*topk)[j - 1]] < s; --j) {
+      std::swap((*topk)[j - 1], (*topk)[j]);
+    }
+  }
+}
+
 TransducerKeywordResult TransducerKeywordDecoder::GetEmptyResult() const {
-  int32_t context_size = model_->ContextSize();
-  int32_t blank_id = 0;  // always 0
   TransducerKeywordResult r;
-  std::vector<int64_t> blanks(context_size, -1);
-  blanks.back() = blank_id;
-
-  Hypotheses blank_hyp({{blanks, 0}});
-  r.hyps = std::move(blank_hyp);
+  r.hyps.reserve(max_active_paths_);
+  r.hyps.emplace_back();
   return r;
 }
 
+void TransducerKeywordDecoder::GetContext(const KeywordHypothesis &hyp,
+                                          int64_t *context) const {
+  // The token sequence of a hypothesis is conceptually
+  //  [-1, ..., -1, blank, tokens...]
+  // with context_size - 1 leading -1s. We need its last context_size
+  // entries.
+  int32_t context_size = model_->ContextSize();
+  int32_t offset = hyp.total_tokens - hyp.num_tokens;
+  for (int32_t i = 0; i != context_size; ++i) {
+    int32_t k = hyp.total_tokens + i;  // index into the conceptual sequence
+    if (k < context_size - 1) {
+      context[i] = -1;
+    } else if (k == context_size - 1) {
+      context[i] = 0;  // blank_id is hardcoded to 0
+    } else {
+      context[i] = hyp.tokens[k - context_size - offset];
+    }
+  }
+}
+
+void TransducerKeywordDecoder::GetDecoderOut(
+    const std::vector<const KeywordHypothesis *> &hyps,
+    std::vector<float> *decoder_out) {
+  int32_t context_size = model_->ContextSize();
+  int32_t num_hyps = static_cast<int32_t>(hyps.size());
+
+  std::vector<int64_t> contexts(num_hyps * context_size);
+  for (int32_t i = 0; i != num_hyps; ++i) {
+    GetContext(*hyps[i], contexts.data() + i * context_size);
+  }
+
+  auto run_decoder = [this, context_size](const int64_t *contexts, int32_t n,
+                                          std::vector<float> *out) {
+    std::array<int64_t, 2> shape{n, context_size};
+    Ort::Value decoder_input = Ort::Value::CreateTensor<int64_t>(
+        model_->Allocator(), shape.data(), shape.size());
+    std::copy(contexts, contexts + n * context_size,
+              decoder_input.GetTensorMutableData<int64_t>());
+
+    Ort::Value decoder_out = model_->RunDecoder(std::move(decoder_input));
+    const float *p = decoder_out.GetTensorData<float>();
+    out->assign(p,
+                p + decoder_out.GetTensorTypeAndShapeInfo().GetElementCount());
+  };
+
+  decoder_out_cache_.Get(contexts.data(), num_hyps, run_decoder, decoder_out);
+}
+
 void TransducerKeywordDecoder::Decode(
     Ort::Value encoder_out, OnlineStream **ss,
     std::vector<TransducerKeywordResult> *result) {
@@ -42,143 +161,175 @@ void TransducerKeywordDecoder::Decode(
   }
 
   int32_t batch_size = static_cast<int32_t>(encoder_out_shape[0]);
-
   int32_t num_frames = static_cast<int32_t>(encoder_out_shape[1]);
+  int32_t encoder_out_dim = static_cast<int32_t>(encoder_out_shape[2]);
   int32_t vocab_size = model_->VocabSize();
-  int32_t context_size = model_->ContextSize();
-  std::vector<int64_t> blanks(context_size, -1);
-  blanks.back() = 0;  // blank_id is hardcoded to 0
 
-  std::vector<Hypotheses> cur;
-  for (auto &r : *result) {
-    cur.push_back(std::move(r.hyps));
-  }
-  std::vector<Hypothesis> prev;
+  const float *p_encoder_out = encoder_out.GetTensorData<float>();
+
+  auto memory_info =
+      Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+
+  // The following buffers are reused across frames
+  int32_t max_hyps = batch_size * max_active_paths_;
+  std::vector<const KeywordHypothesis *> all_hyps;
+  all_hyps.reserve(max_hyps);
+  std::vector<int32_t> row_splits(batch_size + 1);
+  std::vector<float> joiner_encoder_in;
+  joiner_encoder_in.reserve(max_hyps * encoder_out_dim);
+  std::vector<float> joiner_decoder_in;
+  std::vector<float> scores;
+  scores.reserve(max_active_paths_ * vocab_size);
+  std::vector<int32_t> topk;
+  topk.reserve(max_active_paths_);
+  std::vector<KeywordHypothesis> next;
+  next.reserve(max_active_paths_);
 
   for (int32_t t = 0; t != num_frames; ++t) {
-    // Due to merging paths with identical token sequences,
-    // not all utterances have "num_active_paths" paths.
-    auto hyps_row_splits = GetHypsRowSplits(cur);
-    int32_t num_hyps =
-        hyps_row_splits.back();  // total num hyps for all utterance
-    prev.clear();
-    for (auto &hyps : cur) {
-      for (auto &h : hyps) {
-        prev.push_back(std::move(h.second));
+    all_hyps.clear();
+    joiner_encoder_in.clear();
+    for (int32_t b = 0; b != batch_size; ++b) {
+      const auto &hyps = (*result)[b].hyps;
+      row_splits[b] = static_cast<int32_t>(all_hyps.size());
+
+      // Repeat frame t of stream b for each of its hypotheses
+      const float *frame =
+          p_encoder_out + (b * num_frames + t) * encoder_out_dim;
+      for (const auto &h : hyps) {
+        all_hyps.push_back(&h);
+        joiner_encoder_in.insert(joiner_encoder_in.end(), frame,
+                                 frame + encoder_out_dim);
       }
     }
-    cur.clear();
-    cur.reserve(batch_size);
+    int32_t num_hyps = static_cast<int32_t>(all_hyps.size());
+    row_splits[batch_size] = num_hyps;
 
-    Ort::Value decoder_input = model_->BuildDecoderInput(prev);
-    Ort::Value decoder_out = model_->RunDecoder(std::move(decoder_input));
+    GetDecoderOut(all_hyps, &joiner_decoder_in);
+    int32_t decoder_out_dim =
+        static_cast<int32_t>(joiner_decoder_in.size() / num_hyps);
 
-    Ort::Value cur_encoder_out =
-        GetEncoderOutFrame(model_->Allocator(), &encoder_out, t);
-    cur_encoder_out =
-        Repeat(model_->Allocator(), &cur_encoder_out, hyps_row_splits);
-    Ort::Value logit =
-        model_->RunJoiner(std::move(cur_encoder_out), View(&decoder_out));
+    std::array<int64_t, 2> encoder_shape{num_hyps, encoder_out_dim};
+    Ort::Value cur_encoder_out = Ort::Value::CreateTensor(
+        memory_info, joiner_encoder_in.data(), joiner_encoder_in.size(),
+        encoder_shape.data(), encoder_shape.size());
+
+    std::array<int64_t, 2> decoder_shape{num_hyps, decoder_out_dim};
+    Ort::Value decoder_out = Ort::Value::CreateTensor(
+        memory_info, joiner_decoder_in.data(), joiner_decoder_in.size(),
+        decoder_shape.data(), decoder_shape.size());
 
-    float *p_logit = logit.GetTensorMutableData<float>();
-    LogSoftmax(p_logit, vocab_size, num_hyps);
+    Ort::Value logit =
+        model_->RunJoiner(std::move(cur_encoder_out), std::move(decoder_out));
 
-    // The acoustic logprobs for current frame
-    std::vector<float> logprobs(vocab_size * num_hyps);
-    std::memcpy(logprobs.data(), p_logit,
-                sizeof(float) * vocab_size * num_hyps);
+    // now it contains log_softmax output
+    float *p_logprob = logit.GetTensorMutableData<float>();
+    LogSoftmax(p_logprob, vocab_size, num_hyps);
 
-    // now p_logit contains log_softmax output, we rename it to p_logprob
-    // to match what it actually contains
-    float *p_logprob = p_logit;
+    for (int32_t b = 0; b != batch_size; ++b) {
+      auto &r = (*result)[b];
+      auto &hyps = r.hyps;
+      int32_t frame_offset = r.frame_offset;
+      int32_t num_stream_hyps = row_splits[b + 1] - row_splits[b];
+      const float *logprobs = p_logprob + row_splits[b] * vocab_size;
+      const ContextGraphPtr &context_graph = ss[b]->GetContextGraph();
 
-    // add log_prob of each hypothesis to p_logprob before taking top_k
-    for (int32_t i = 0; i != num_hyps; ++i) {
-      float log_prob = prev[i].log_prob;
-      for (int32_t k = 0; k != vocab_size; ++k, ++p_logprob) {
-        *p_logprob += log_prob;
+      bool skip = blank_skip_threshold_ > 0;
+      for (int32_t i = 0; skip && i != num_stream_hyps; ++i) {
+        skip = std::exp(logprobs[i * vocab_size]) > blank_skip_threshold_;
       }
-    }
-    p_logprob = p_logit;  // we changed p_logprob in the above for loop
 
-    for (int32_t b = 0; b != batch_size; ++b) {
-      int32_t frame_offset = (*result)[b].frame_offset;
-      int32_t start = hyps_row_splits[b];
-      int32_t end = hyps_row_splits[b + 1];
-      auto topk =
-          TopkIndex(p_logprob, vocab_size * (end - start), max_active_paths_);
-
-      Hypotheses hyps;
-      for (auto k : topk) {
-        int32_t hyp_index = k / vocab_size + start;
-        int32_t new_token = k % vocab_size;
-
-        Hypothesis new_hyp = prev[hyp_index];
-        float context_score = 0;
-        auto context_state = new_hyp.context_state;
-
-        // blank is hardcoded to 0
-        // also, it treats unk as blank
-        if (new_token != 0 && new_token != unk_id_) {
-          new_hyp.ys.push_back(new_token);
-          new_hyp.timestamps.push_back(t + frame_offset);
-          new_hyp.ys_probs.push_back(
-              exp(logprobs[hyp_index * vocab_size + new_token]));
-
-          new_hyp.num_trailing_blanks = 0;
-          auto context_res = ss[b]->GetContextGraph()->ForwardOneStep(
-              context_state, new_token);
-          context_score = std::get<0>(context_res);
-          new_hyp.context_state = std::get<1>(context_res);
-          // Start matching from the start state, forget the decoder history.
-          if (new_hyp.context_state->token == -1) {
-            new_hyp.ys = blanks;
-            new_hyp.timestamps.clear();
-            new_hyp.ys_probs.clear();
+      if (skip) {
+        // Blank dominates every hypothesis. Extend them all with blank
+        // instead of expanding the beam.
+        for (int32_t i = 0; i != num_stream_hyps; ++i) {
+          hyps[i].log_prob += logprobs[i * vocab_size];
+          ++hyps[i].num_trailing_blanks;
+        }
+      } else {
+        // add log_prob of each hypothesis before taking top_k
+        scores.resize(num_stream_hyps * vocab_size);
+        float *p_score = scores.data();
+        const float *p = logprobs;
+        for (int32_t i = 0; i != num_stream_hyps; ++i) {
+          float log_prob = hyps[i].log_prob;
+          for (int32_t k = 0; k != vocab_size; ++k, ++p, ++p_score) {
+            *p_score = *p + log_prob;
           }
-        } else {
-          ++new_hyp.num_trailing_blanks;
         }
-        new_hyp.log_prob = p_logprob[k] + context_score;
-        hyps.Add(std::move(new_hyp));
-      }  // for (auto k : topk)
 
-      auto best_hyp = hyps.GetMostProbable(false);
+        TopK(scores.data(), num_stream_hyps * vocab_size, max_active_paths_,
+             &topk);
+
+        next.clear();
+        for (auto k : topk) {
+          int32_t hyp_index = k / vocab_size;
+          int32_t new_token = k % vocab_size;
+
+          KeywordHypothesis new_hyp = hyps[hyp_index];
+          float context_score = 0;
+
+          // blank is hardcoded to 0
+          // also, it treats unk as blank
+          if (new_token != 0 && new_token != unk_id_) {
+            new_hyp.AddToken(new_token, t + frame_offset,
+                             std::exp(logprobs[k]));
+            new_hyp.num_trailing_blanks = 0;
 
-      auto status = ss[b]->GetContextGraph()->IsMatched(best_hyp.context_state);
+            auto context_res =
+                context_graph->ForwardOneStep(new_hyp.context_state, new_token);
+            context_score = std::get<0>(context_res);
+            new_hyp.context_state = std::get<1>(context_res);
+            // Start matching from the start state, forget the decoder
+            // history.
+            if (new_hyp.context_state->token == -1) {
+              new_hyp.num_tokens = 0;
+              new_hyp.total_tokens = 0;
+            }
+          } else {
+            ++new_hyp.num_trailing_blanks;
+          }
+          new_hyp.log_prob = scores[k] + context_score;
+          AddToBeam(new_hyp, &next);
+        }  // for (auto k : topk)
+
+        hyps.swap(next);
+      }
+
+      const auto &best_hyp = GetMostProbable(hyps);
+
+      auto status = context_graph->IsMatched(best_hyp.context_state);
       bool matched = std::get<0>(status);
       const ContextState *matched_state = std::get<1>(status);
 
       if (matched) {
+        int32_t level = std::min(matched_state->level, best_hyp.num_tokens);
+        int32_t start = best_hyp.num_tokens - level;
+
         float ys_prob = 0.0;
-        int32_t length = best_hyp.ys_probs.size();
-        for (int32_t i = 0; i < matched_state->level; ++i) {
-          ys_prob += best_hyp.ys_probs[i];
+        for (int32_t i = start; i != best_hyp.num_tokens; ++i) {
+          ys_prob += best_hyp.probs[i];
         }
-        ys_prob /= matched_state->level;
+        ys_prob /= level;
+
         if (best_hyp.num_trailing_blanks > num_trailing_blanks_ &&
             ys_prob >= matched_state->ac_threshold) {
-          auto &r = (*result)[b];
-          r.tokens = {best_hyp.ys.end() - matched_state->level,
-                      best_hyp.ys.end()};
-          r.timestamps = {best_hyp.timestamps.end() - matched_state->level,
-                          best_hyp.timestamps.end()};
+          r.tokens = {best_hyp.tokens.begin() + start,
+                      best_hyp.tokens.begin() + best_hyp.num_tokens};
+          r.timestamps = {best_hyp.timestamps.begin() + start,
+                          best_hyp.timestamps.begin() + best_hyp.num_tokens};
           r.keyword = matched_state->phrase;
 
-          hyps = Hypotheses({{blanks, 0, ss[b]->GetContextGraph()->Root()}});
+          hyps.resize(1);
+          hyps[0] = KeywordHypothesis();
+          hyps[0].context_state = context_graph->Root();
         }
       }
-      cur.push_back(std::move(hyps));
-      p_logprob += (end - start) * vocab_size;
     }  // for (int32_t b = 0; b != batch_size; ++b)
   }
 
   for (int32_t b = 0; b != batch_size; ++b) {
-    auto &hyps = cur[b];
-    auto best_hyp = hyps.GetMostProbable(false);
     auto &r = (*result)[b];
-    r.hyps = std::move(hyps);
-    r.num_trailing_blanks = best_hyp.num_trailing_blanks;
+    r.num_trailing_blanks = GetMostProbable(r.hyps).num_trailing_blanks;
     r.frame_offset += num_frames;
   }
 }
@@ -5,15 +5,57 @@
 #ifndef SHERPA_ONNX_CSRC_TRANSDUCER_KEYWORD_DECODER_H_
 #define SHERPA_ONNX_CSRC_TRANSDUCER_KEYWORD_DECODER_H_
 
+#include <array>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "sherpa-onnx/csrc/online-stream.h"
+#include "sherpa-onnx/csrc/context-graph.h"
+#include "sherpa-onnx/csrc/decoder-out-cache.h"
 #include "sherpa-onnx/csrc/online-transducer-model.h"
 
 namespace sherpa_onnx {
 
+class OnlineStream;
+
+/** A hypothesis of the keyword decoder.
+ *
+ * Unlike Hypothesis, it has a fixed size so that the beam of a stream can be
+ * kept in a flat array and copied without allocating memory. Only the last
+ * kMaxTokens tokens since the hypothesis was reset to the root of the
+ * keywords graph are kept, which is enough to match keywords of up to
+ * kMaxTokens tokens.
+ */
+struct KeywordHypothesis {
+  static constexpr int32_t kMaxTokens = 32;
+
+  std::array<int32_t, kMaxTokens> tokens;
+
+  // timestamps[i] is the output frame index where tokens[i] is decoded
+  std::array<int32_t, kMaxTokens> timestamps;
+
+  // probs[i] is the acoustic probability of tokens[i]
+  std::array<float, kMaxTokens> probs;
+
+  // Number of valid entries in tokens, timestamps and probs
+  int32_t num_tokens = 0;
+
+  // Total number of tokens decoded since the last reset. It is larger
+  // than num_tokens if old tokens have been discarded.
+  int32_t total_tokens = 0;
+
+  float log_prob = 0;
+
+  const ContextState *context_state = nullptr;
+
+  int32_t num_trailing_blanks = 0;
+
+  void AddToken(int32_t token, int32_t timestamp, float prob);
+
+  // Return true if both have the same token sequence and context state
+  bool SameAs(const KeywordHypothesis &other) const;
+};
+
 struct TransducerKeywordResult {
   /// Number of frames after subsampling we have decoded so far
   int32_t frame_offset = 0;
@@ -30,19 +72,33 @@ struct TransducerKeywordResult {
   /// timestamps[i] contains the output frame index where tokens[i] is decoded.
   std::vector<int32_t> timestamps;
 
-  // used only in modified beam_search
-  Hypotheses hyps;
+  /// The beam of this stream. Its size never exceeds max_active_paths.
+  std::vector<KeywordHypothesis> hyps;
 };
 
 class TransducerKeywordDecoder {
  public:
+  /**
+   * @param model Not owned.
+   * @param max_active_paths Beam size.
+   * @param num_trailing_blanks Number of blank frames after a keyword
+   *                            before it is triggered.
+   * @param unk_id ID of <unk>. It is treated as blank.
+   * @param blank_skip_threshold If positive, a frame is skipped, i.e., no
+   *                             hypothesis is expanded, when the blank
+   *                             probability of every hypothesis of a stream
+   *                             is larger than it.
+   */
   TransducerKeywordDecoder(OnlineTransducerModel *model,
                            int32_t max_active_paths,
-                           int32_t num_trailing_blanks, int32_t unk_id)
+                           int32_t num_trailing_blanks, int32_t unk_id,
+                           float blank_skip_threshold = 0)
       : model_(model),
         max_active_paths_(max_active_paths),
         num_trailing_blanks_(num_trailing_blanks),
-        unk_id_(unk_id) {}
+        unk_id_(unk_id),
+        blank_skip_threshold_(blank_skip_threshold),
+        decoder_out_cache_(model->ContextSize(), kMaxCachedDecoderOut) {}
 
   TransducerKeywordResult GetEmptyResult() const;
 
@@ -50,11 +106,36 @@ class TransducerKeywordDecoder {
               std::vector<TransducerKeywordResult> *result);
 
  private:
+  /** Fill decoder_out with the decoder output of each hypothesis.
+   *
+   * The decoder output depends only on the last context_size tokens of a
+   * hypothesis, so it is cached across frames, streams and calls. The decoder
+   * network is run only for contexts that are not in the cache.
+   *
+   * @param hyps  Hypotheses of all streams.
+   * @param decoder_out  On return, it contains hyps.size() rows, one for
+   *                     each hypothesis.
+   */
+  void GetDecoderOut(const std::vector<const KeywordHypothesis *> &hyps,
+                     std::vector<float> *decoder_out);
+
+  // Return the context_size tokens the decoder output of hyp depends on
+  void GetContext(const KeywordHypothesis &hyp, int64_t *context) const;
+
+ private:
+  // A keywords graph visits only a small number of contexts, so the cache
+  // rarely evicts anything except for large vocabularies.
+  static constexpr int32_t kMaxCachedDecoderOut = 8192;
+
   OnlineTransducerModel *model_;  // Not owned
 
   int32_t max_active_paths_;
   int32_t num_trailing_blanks_;
   int32_t unk_id_;
+  float blank_skip_threshold_;
+
+  // Decode() may be called from several threads. The cache is thread-safe.
+  DecoderOutCache decoder_out_cache_;
 };
 
 }  // namespace sherpa_onnx
@@ -7,6 +7,8 @@
 #include <sstream>
 #include <string>
 
+#include "sherpa-onnx/csrc/macros.h"
+
 namespace sherpa_onnx {
 
 void VadModelConfig::Register(ParseOptions *po) {
@@ -26,7 +28,15 @@ void VadModelConfig::Register(ParseOptions *po) {
                "true to display debug information when loading vad models");
 }
 
-bool VadModelConfig::Validate() const { return silero_vad.Validate(); }
+bool VadModelConfig::Validate() const {
+  if (max_speech_duration < 0) {
+    SHERPA_ONNX_LOGE("max_speech_duration should be >= 0. Given: %f",
+                     max_speech_duration);
+    return false;
+  }
+
+  return silero_vad.Validate();
+}
 
 std::string VadModelConfig::ToString() const {
   std::ostringstream os;
@@ -36,7 +46,8 @@ std::string VadModelConfig::ToString() const {
   os << "sample_rate=" << sample_rate << ", ";
   os << "num_threads=" << num_threads << ", ";
   os << "provider=\"" << provider << "\", ";
-  os << "debug=" << (debug ? "True" : "False") << ")";
+  os << "debug=" << (debug ? "True" : "False") << ", ";
+  os << "max_speech_duration=" << max_speech_duration << ")";
 
   return os.str();
 }
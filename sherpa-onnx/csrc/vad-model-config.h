@@ -21,6 +21,12 @@ struct VadModelConfig {
   // true to show debug information when loading models
   bool debug = false;
 
+  // Speech longer than this number of seconds is cut into several
+  // segments by VoiceActivityDetector. 0 means no limit. It is not a
+  // command-line option; users of the detector set it from their own
+  // options, e.g., --max-utterance-length.
+  float max_speech_duration = 0;
+
   VadModelConfig() = default;
 
   VadModelConfig(const SileroVadModelConfig &silero_vad, int32_t sample_rate,
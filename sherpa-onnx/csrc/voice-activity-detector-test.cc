@@ -0,0 +1,237 @@
+// sherpa-onnx/csrc/voice-activity-detector-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/voice-activity-detector.h"
+
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sherpa-onnx/csrc/vad-model.h"
+
+namespace sherpa_onnx {
+
+namespace {
+
+constexpr int32_t kWindowSize = 4;
+constexpr int32_t kMinSpeech = 4;
+constexpr int32_t kMinSilence = 12;
+
+// Like silero VAD, it keeps reporting speech until there have been
+// kMinSilence samples of silence after the last loud window.
+class FakeVadModel : public VadModel {
+ public:
+  void Reset() override {
+    triggered_ = false;
+    num_silence_ = 0;
+  }
+
+  bool IsSpeech(const float *samples, int32_t n) override {
+    EXPECT_EQ(n, kWindowSize);
+
+    bool loud = false;
+    for (int32_t i = 0; i != n; ++i) {
+      loud = loud || std::abs(samples[i]) > 0.5;
+    }
+
+    if (loud) {
+      triggered_ = true;
+      num_silence_ = 0;
+    } else if (triggered_) {
+      num_silence_ += n;
+      if (num_silence_ >= kMinSilence) {
+        triggered_ = false;
+      }
+    }
+
+    return triggered_;
+  }
+
+  int32_t WindowSize() const override { return kWindowSize; }
+
+  int32_t MinSilenceDurationSamples() const override { return kMinSilence; }
+
+  int32_t MinSpeechDurationSamples() const override { return kMinSpeech; }
+
+ private:
+  bool triggered_ = false;
+  int32_t num_silence_ = 0;
+};
+
+std::unique_ptr<VoiceActivityDetector> CreateVad(
+    float max_speech_duration = 0) {
+  VadModelConfig config;
+  config.sample_rate = 16000;
+  config.max_speech_duration = max_speech_duration;
+  return std::make_unique<VoiceActivityDetector>(
+      std::make_unique<FakeVadModel>(), config, 1);
+}
+
+void Accept(VoiceActivityDetector *vad, const std::vector<float> &samples,
+            int32_t chunk_size) {
+  for (int32_t i = 0; i < static_cast<int32_t>(samples.size());
+       i += chunk_size) {
+    int32_t n = std::min<int32_t>(chunk_size, samples.size() - i);
+    vad->AcceptWaveform(samples.data() + i, n);
+  }
+}
+
+}  // namespace
+
+TEST(VoiceActivityDetector, WholeWindows) {
+  auto vad = CreateVad();
+
+  std::vector<float> silence(16, 0);
+  std::vector<float> speech(24, 1);
+
+  Accept(vad.get(), silence, kWindowSize);
+  Accept(vad.get(), speech, kWindowSize);
+  EXPECT_TRUE(vad->IsSpeechDetected());
+
+  Accept(vad.get(), silence, kWindowSize);
+  EXPECT_FALSE(vad->IsSpeechDetected());
+
+  ASSERT_FALSE(vad->Empty());
+  const auto &s = vad->Front();
+  // It starts 2 windows plus kMinSpeech samples before the end of the
+  // first loud window
+  EXPECT_EQ(s.start, 16 + kWindowSize - 2 * kWindowSize - kMinSpeech);
+  EXPECT_EQ(s.samples.size(), 16 + 24 - s.start);
+  vad->Pop();
+  EXPECT_TRUE(vad->Empty());
+}
+
+// A chunk that does not complete a window must not end a segment
+TEST(VoiceActivityDetector, SubWindowChunks) {
+  auto whole = CreateVad();
+  auto sub = CreateVad();
+
+  std::vector<float> samples(16, 0);
+  samples.insert(samples.end(), 40, 1);
+  samples.insert(samples.end(), 32, 0);
+
+  Accept(whole.get(), samples, kWindowSize);
+  Accept(sub.get(), samples, kWindowSize - 1);
+
+  ASSERT_FALSE(whole->Empty());
+  ASSERT_FALSE(sub->Empty());
+
+  EXPECT_EQ(sub->Front().start, whole->Front().start);
+  EXPECT_EQ(sub->Front().samples, whole->Front().samples);
+
+  whole->Pop();
+  sub->Pop();
+
+  EXPECT_TRUE(whole->Empty());
+  EXPECT_TRUE(sub->Empty());
+}
+
+// A pause inside a chunk of several windows must be detected
+TEST(VoiceActivityDetector, LargeChunks) {
+  auto whole = CreateVad();
+  auto large = CreateVad();
+
+  std::vector<float> samples(16, 0);
+  samples.insert(samples.end(), 16, 1);
+  samples.insert(samples.end(), 16, 0);
+  samples.insert(samples.end(), 16, 1);
+  samples.insert(samples.end(), 32, 0);
+
+  Accept(whole.get(), samples, kWindowSize);
+  Accept(large.get(), samples, samples.size());
+
+  for (int32_t i = 0; i != 2; ++i) {
+    ASSERT_FALSE(whole->Empty());
+    ASSERT_FALSE(large->Empty());
+
+    EXPECT_EQ(large->Front().start, whole->Front().start);
+    EXPECT_EQ(large->Front().samples, whole->Front().samples);
+
+    whole->Pop();
+    large->Pop();
+  }
+
+  EXPECT_TRUE(whole->Empty());
+  EXPECT_TRUE(large->Empty());
+}
+
+// Long speech is cut into contiguous segments of at most
+// max_speech_duration
+TEST(VoiceActivityDetector, MaxSpeechDuration) {
+  constexpr int32_t kMaxSpeech = 16;
+  auto vad = CreateVad(kMaxSpeech / 16000.0f);
+
+  std::vector<float> samples(16, 0);
+  samples.insert(samples.end(), 40, 1);
+  samples.insert(samples.end(), 32, 0);
+
+  Accept(vad.get(), samples, kWindowSize);
+
+  int32_t start = 16 + kWindowSize - 2 * kWindowSize - kMinSpeech;
+  for (int32_t i = 0; i != 3; ++i) {
+    ASSERT_FALSE(vad->Empty());
+
+    SpeechSegment &s = vad->Front();
+    EXPECT_EQ(s.start, start);
+    EXPECT_EQ(s.samples.size(), kMaxSpeech);
+
+    std::vector<float> moved = std::move(s.samples);
+    EXPECT_EQ(moved.size(), kMaxSpeech);
+
+    start += kMaxSpeech;
+    vad->Pop();
+  }
+
+  // The trailing silence reported as speech by the model is not saved
+  EXPECT_EQ(start, 16 + 40);
+  EXPECT_TRUE(vad->Empty());
+}
+
+// Flush() in the trailing silence, while the model still reports speech,
+// must not produce a segment ending before it starts
+TEST(VoiceActivityDetector, FlushDuringHangover) {
+  auto vad = CreateVad();
+
+  std::vector<float> speech(16, 1);
+  std::vector<float> silence(kWindowSize, 0);
+
+  Accept(vad.get(), speech, kWindowSize);
+  Accept(vad.get(), silence, kWindowSize);
+  EXPECT_TRUE(vad->IsSpeechDetected());
+
+  vad->Flush();
+  EXPECT_FALSE(vad->IsSpeechDetected());
+
+  ASSERT_FALSE(vad->Empty());
+  EXPECT_EQ(vad->Front().start, 0);
+  EXPECT_EQ(vad->Front().samples.size(), 20);
+  vad->Pop();
+
+  // The rest of the hangover. The model reports speech for one more
+  // window and then silence; there is no new speech to save.
+  for (int32_t i = 0; i != 4; ++i) {
+    Accept(vad.get(), silence, kWindowSize);
+  }
+  EXPECT_FALSE(vad->IsSpeechDetected());
+  EXPECT_TRUE(vad->Empty());
+
+  // Speech after it is detected as usual
+  Accept(vad.get(), speech, kWindowSize);
+  for (int32_t i = 0; i != 4; ++i) {
+    Accept(vad.get(), silence, kWindowSize);
+  }
+
+  ASSERT_FALSE(vad->Empty());
+  EXPECT_EQ(vad->Front().start,
+            36 + kWindowSize - 2 * kWindowSize - kMinSpeech);
+  EXPECT_EQ(vad->Front().samples.size(), 52 - vad->Front().start);
+  EXPECT_EQ(vad->Front().samples[0], 0);
+  EXPECT_EQ(vad->Front().samples.back(), 1);
+  vad->Pop();
+  EXPECT_TRUE(vad->Empty());
+}
+
+}  // namespace sherpa_onnx
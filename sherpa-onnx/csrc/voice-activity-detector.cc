@@ -9,6 +9,7 @@
 #include <utility>
 
 #include "sherpa-onnx/csrc/circular-buffer.h"
+#include "sherpa-onnx/csrc/metrics.h"
 #include "sherpa-onnx/csrc/vad-model.h"
 
 namespace sherpa_onnx {
@@ -28,7 +29,19 @@ class VoiceActivityDetector::Impl {
         buffer_(buffer_size_in_seconds * config.sample_rate) {}
 #endif
 
+  Impl(std::unique_ptr<VadModel> model, const VadModelConfig &config,
+       float buffer_size_in_seconds = 60)
+      : model_(std::move(model)),
+        config_(config),
+        buffer_(buffer_size_in_seconds * config.sample_rate) {}
+
   void AcceptWaveform(const float *samples, int32_t n) {
+    static Histogram *model_time = GetStageHistogram("vad", "model");
+    static Histogram *segment_time = GetStageHistogram("vad", "segment");
+    static Counter *audio_seconds = GetAudioSecondsCounter("vad");
+
+    IncIfEnabled(audio_seconds, static_cast<double>(n) / config_.sample_rate);
+
     int32_t window_size = model_->WindowSize();
 
     // note n is usually window_size and there is no need to use
@@ -36,18 +49,71 @@ class VoiceActivityDetector::Impl {
     last_.insert(last_.end(), samples, samples + n);
     int32_t k = static_cast<int32_t>(last_.size()) / window_size;
     const float *p = last_.data();
-    bool is_speech = false;
 
+    // If there are not enough samples for a window, the current state is
+    // kept; otherwise, a short chunk in the middle of speech would end the
+    // segment.
     for (int32_t i = 0; i != k; ++i, p += window_size) {
-      buffer_.Push(p, window_size);
-      // NOTE(fangjun): Please don't use a very large n.
-      bool this_window_is_speech = model_->IsSpeech(p, window_size);
-      is_speech = is_speech || this_window_is_speech;
+      bool is_speech;
+      {
+        ScopedTimer model_timer(model_time);
+        buffer_.Push(p, window_size);
+        is_speech = model_->IsSpeech(p, window_size);
+      }
+
+      ScopedTimer segment_timer(segment_time);
+      AcceptWindow(is_speech);
     }
 
     last_ = std::vector<float>(
         p, static_cast<const float *>(last_.data()) + last_.size());
+  }
+
+  bool Empty() const { return segments_.empty(); }
+
+  void Pop() { segments_.pop(); }
+
+  void Clear() { std::queue<SpeechSegment>().swap(segments_); }
+
+  const SpeechSegment &Front() const { return segments_.front(); }
+
+  SpeechSegment &Front() { return segments_.front(); }
+
+  void Reset() {
+    std::queue<SpeechSegment>().swap(segments_);
+
+    model_->Reset();
+    buffer_.Reset();
+
+    start_ = -1;
+  }
+
+  bool IsSpeechDetected() const { return start_ != -1; }
+
+  void Flush() {
+    if (start_ == -1 || buffer_.Size() == 0) {
+      return;
+    }
+
+    int32_t end = buffer_.Tail();
+
+    SpeechSegment segment;
+    segment.start = start_;
+    segment.samples = buffer_.Get(start_, end - start_);
+
+    segments_.push(std::move(segment));
+
+    buffer_.Pop(end - buffer_.Head());
 
+    start_ = -1;
+  }
+
+  const VadModelConfig &GetConfig() const { return config_; }
+
+ private:
+  // Update the state after the model has classified the last window in
+  // buffer_
+  void AcceptWindow(bool is_speech) {
     if (is_speech) {
       if (start_ == -1) {
         // beginning of speech
@@ -55,19 +121,33 @@ class VoiceActivityDetector::Impl {
                               model_->MinSpeechDurationSamples(),
                           buffer_.Head());
       }
+
+      int32_t max_speech_samples =
+          config_.max_speech_duration * config_.sample_rate;
+      if (max_speech_samples > 0 &&
+          buffer_.Tail() - start_ >= max_speech_samples) {
+        // Cut long speech. The next window continues it in a new segment.
+        Flush();
+      }
     } else {
       // non-speech
       if (start_ != -1 && buffer_.Size()) {
         // end of speech, save the speech segment
-        int32_t end = buffer_.Tail() - model_->MinSilenceDurationSamples();
+        //
+        // If the speech has been cut by Flush() in the trailing silence,
+        // the end can be before start_; there is nothing to save then.
+        int32_t end = std::max(
+            buffer_.Tail() - model_->MinSilenceDurationSamples(), start_);
 
-        std::vector<float> s = buffer_.Get(start_, end - start_);
-        SpeechSegment segment;
+        if (end > start_) {
+          std::vector<float> s = buffer_.Get(start_, end - start_);
+          SpeechSegment segment;
 
-        segment.start = start_;
-        segment.samples = std::move(s);
+          segment.start = start_;
+          segment.samples = std::move(s);
 
-        segments_.push(std::move(segment));
+          segments_.push(std::move(segment));
+        }
 
         buffer_.Pop(end - buffer_.Head());
       }
@@ -85,27 +165,6 @@ class VoiceActivityDetector::Impl {
     }
   }
 
-  bool Empty() const { return segments_.empty(); }
-
-  void Pop() { segments_.pop(); }
-
-  void Clear() { std::queue<SpeechSegment>().swap(segments_); }
-
-  const SpeechSegment &Front() const { return segments_.front(); }
-
-  void Reset() {
-    std::queue<SpeechSegment>().swap(segments_);
-
-    model_->Reset();
-    buffer_.Reset();
-
-    start_ = -1;
-  }
-
-  bool IsSpeechDetected() const { return start_ != -1; }
-
-  const VadModelConfig &GetConfig() const { return config_; }
-
  private:
   std::queue<SpeechSegment> segments_;
 
@@ -128,6 +187,12 @@ VoiceActivityDetector::VoiceActivityDetector(
     : impl_(std::make_unique<Impl>(mgr, config, buffer_size_in_seconds)) {}
 #endif
 
+VoiceActivityDetector::VoiceActivityDetector(
+    std::unique_ptr<VadModel> model, const VadModelConfig &config,
+    float buffer_size_in_seconds /*= 60*/)
+    : impl_(std::make_unique<Impl>(std::move(model), config,
+                                   buffer_size_in_seconds)) {}
+
 VoiceActivityDetector::~VoiceActivityDetector() = default;
 
 void VoiceActivityDetector::AcceptWaveform(const float *samples, int32_t n) {
@@ -144,12 +209,16 @@ const SpeechSegment &VoiceActivityDetector::Front() const {
   return impl_->Front();
 }
 
+SpeechSegment &VoiceActivityDetector::Front() { return impl_->Front(); }
+
 void VoiceActivityDetector::Reset() { impl_->Reset(); }
 
 bool VoiceActivityDetector::IsSpeechDetected() const {
   return impl_->IsSpeechDetected();
 }
 
+void VoiceActivityDetector::Flush() { impl_->Flush(); }
+
 const VadModelConfig &VoiceActivityDetector::GetConfig() const {
   return impl_->GetConfig();
 }
@@ -21,11 +21,19 @@ struct SpeechSegment {
   std::vector<float> samples;
 };
 
+class VadModel;
+
 class VoiceActivityDetector {
  public:
   explicit VoiceActivityDetector(const VadModelConfig &config,
                                  float buffer_size_in_seconds = 60);
 
+  // Use the given model instead of creating one from config.
+  // config.sample_rate is still used.
+  VoiceActivityDetector(std::unique_ptr<VadModel> model,
+                        const VadModelConfig &config,
+                        float buffer_size_in_seconds = 60);
+
 #if __ANDROID_API__ >= 9
   VoiceActivityDetector(AAssetManager *mgr, const VadModelConfig &config,
                         float buffer_size_in_seconds = 60);
@@ -33,14 +41,23 @@ class VoiceActivityDetector {
 
   ~VoiceActivityDetector();
 
+  // samples can be of any length. They are processed one window of the
+  // model at a time, so a pause inside a long chunk is detected as well.
   void AcceptWaveform(const float *samples, int32_t n);
   bool Empty() const;
   void Pop();
   void Clear();
   const SpeechSegment &Front() const;
 
+  // The caller can move the samples out of the segment before Pop()
+  SpeechSegment &Front();
+
   bool IsSpeechDetected() const;
 
+  // Save the speech that has been detected but not ended yet as a segment.
+  // Call it at the end of the input so that the last segment is not lost.
+  void Flush();
+
   void Reset();
 
   const VadModelConfig &GetConfig() const;
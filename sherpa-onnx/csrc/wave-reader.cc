@@ -102,20 +102,17 @@ struct WaveHeader {
 };
 static_assert(sizeof(WaveHeader) == 44, "");
 
-// Read a wave file of mono-channel.
-// Return its samples normalized to the range [-1, 1).
-std::vector<float> ReadWaveImpl(std::istream &is, int32_t *sampling_rate,
-                                bool *is_ok) {
+// Read the header of a wave file of mono-channel and seek to its samples.
+// Return the number of bytes of the samples; -1 on error.
+int32_t ReadWaveHeaderImpl(std::istream &is, int32_t *sampling_rate) {
   WaveHeader header;
   is.read(reinterpret_cast<char *>(&header), sizeof(header));
   if (!is) {
-    *is_ok = false;
-    return {};
+    return -1;
   }
 
   if (!header.Validate()) {
-    *is_ok = false;
-    return {};
+    return -1;
   }
 
   if (header.subchunk1_size == 18) {
@@ -132,8 +129,7 @@ std::vector<float> ReadWaveImpl(std::istream &is, int32_t *sampling_rate,
           "Extra size should be 0 for wave from NAudio. Current extra size "
           "%d\n",
           extra_size);
-      *is_ok = false;
-      return {};
+      return -1;
     }
 
     is.read(reinterpret_cast<char *>(&header.subchunk2_id),
@@ -144,17 +140,29 @@ std::vector<float> ReadWaveImpl(std::istream &is, int32_t *sampling_rate,
 
   header.SeekToDataChunk(is);
   if (!is) {
-    *is_ok = false;
-    return {};
+    return -1;
   }
 
   *sampling_rate = header.sample_rate;
 
-  // header.subchunk2_size contains the number of bytes in the data.
+  return header.subchunk2_size;
+}
+
+// Read a wave file of mono-channel.
+// Return its samples normalized to the range [-1, 1).
+std::vector<float> ReadWaveImpl(std::istream &is, int32_t *sampling_rate,
+                                bool *is_ok) {
+  int32_t num_bytes = ReadWaveHeaderImpl(is, sampling_rate);
+  if (num_bytes < 0) {
+    *is_ok = false;
+    return {};
+  }
+
+  // num_bytes contains the number of bytes in the data.
   // As we assume each sample contains two bytes, so it is divided by 2 here
-  std::vector<int16_t> samples(header.subchunk2_size / 2);
+  std::vector<int16_t> samples(num_bytes / 2);
 
-  is.read(reinterpret_cast<char *>(samples.data()), header.subchunk2_size);
+  is.read(reinterpret_cast<char *>(samples.data()), num_bytes);
   if (!is) {
     *is_ok = false;
     return {};
@@ -183,4 +191,9 @@ std::vector<float> ReadWave(std::istream &is, int32_t *sampling_rate,
   return samples;
 }
 
+int32_t ReadWaveHeader(std::istream &is, int32_t *sampling_rate) {
+  int32_t num_bytes = ReadWaveHeaderImpl(is, sampling_rate);
+  return num_bytes < 0 ? -1 : num_bytes / 2;
+}
+
 }  // namespace sherpa_onnx
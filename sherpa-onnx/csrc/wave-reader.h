@@ -26,6 +26,17 @@ std::vector<float> ReadWave(const std::string &filename, int32_t *sampling_rate,
 std::vector<float> ReadWave(std::istream &is, int32_t *sampling_rate,
                             bool *is_ok);
 
+/** Read the header of a wave file and seek to its samples, so that a long
+    file can be read a piece at a time.
+
+    @param is The input stream. On return, the next bytes are the samples,
+              each of which is an int16_t in little endian.
+    @param sampling_rate  On return, it contains the sampling rate of the file.
+
+    @return Return the number of samples in the file; -1 on error.
+ */
+int32_t ReadWaveHeader(std::istream &is, int32_t *sampling_rate);
+
 }  // namespace sherpa_onnx
 
 #endif  // SHERPA_ONNX_CSRC_WAVE_READER_H_
@@ -0,0 +1,69 @@
+// sherpa-onnx/csrc/websocket-decoder-host.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/websocket-decoder-host.h"
+
+#include <sstream>
+#include <string>
+
+namespace sherpa_onnx {
+
+void WebsocketDecoderHost::Send(connection_hdl hdl, const std::string &text) {
+  websocketpp::lib::error_code ec;
+  if (!Contains(hdl)) {
+    return;
+  }
+
+  GetServer().send(hdl, text, websocketpp::frame::opcode::text, ec);
+  if (ec) {
+    GetServer().get_alog().write(websocketpp::log::alevel::app, ec.message());
+  }
+}
+
+void WebsocketDecoderHost::Close(connection_hdl hdl,
+                                 websocketpp::close::status::value code,
+                                 const std::string &reason) {
+  server &s = GetServer();
+  auto con = s.get_con_from_hdl(hdl);
+
+  std::ostringstream os;
+  os << "Closing " << con->get_remote_endpoint() << " with reason: " << reason
+     << "\n";
+
+  websocketpp::lib::error_code ec;
+  s.close(hdl, code, reason, ec);
+  if (ec) {
+    os << "Failed to close" << con->get_remote_endpoint() << ". "
+       << ec.message() << "\n";
+  }
+  s.get_alog().write(websocketpp::log::alevel::app, os.str());
+}
+
+void WebsocketDecoderHost::PauseReading(connection_hdl hdl) {
+  websocketpp::lib::error_code ec;
+  auto con = GetServer().get_con_from_hdl(hdl, ec);
+  if (!ec) {
+    ec = con->pause_reading();
+  }
+
+  if (ec) {
+    GetServer().get_alog().write(websocketpp::log::alevel::app,
+                                 "Failed to pause reading: " + ec.message());
+  }
+}
+
+void WebsocketDecoderHost::ResumeReading(connection_hdl hdl) {
+  websocketpp::lib::error_code ec;
+  auto con = GetServer().get_con_from_hdl(hdl, ec);
+  if (!ec) {
+    ec = con->resume_reading();
+  }
+
+  if (ec) {
+    GetServer().get_alog().write(websocketpp::log::alevel::app,
+                                 "Failed to resume reading: " + ec.message());
+  }
+}
+
+}  // namespace sherpa_onnx
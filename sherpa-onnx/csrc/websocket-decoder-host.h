@@ -0,0 +1,64 @@
+// sherpa-onnx/csrc/websocket-decoder-host.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_WEBSOCKET_DECODER_HOST_H_
+#define SHERPA_ONNX_CSRC_WEBSOCKET_DECODER_HOST_H_
+
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "asio.hpp"
+#include "websocketpp/config/asio_no_tls.hpp"  // TODO(fangjun): support TLS
+#include "websocketpp/server.hpp"
+
+using server = websocketpp::server<websocketpp::config::asio>;
+using connection_hdl = websocketpp::connection_hdl;
+
+namespace sherpa_onnx {
+
+/* What OnlineWebsocketDecoder and OfflineWebsocketDecoder need from the
+ * websocket server that hosts them.
+ *
+ * It is implemented by OnlineWebsocketServer and OfflineWebsocketServer,
+ * each of which hosts a single decoder, and by
+ * MultiModelWebsocketServer, which hosts one decoder per model in a
+ * single process.
+ */
+class WebsocketDecoderHost {
+ public:
+  virtual ~WebsocketDecoderHost() = default;
+
+  virtual server &GetServer() = 0;
+
+  // For network IO
+  virtual asio::io_context &GetConnectionContext() = 0;
+
+  // For neural network computation and decoding
+  virtual asio::io_context &GetWorkContext() = 0;
+
+  // Run f in a work thread
+  virtual void PostWork(std::function<void()> f) {
+    asio::post(GetWorkContext(), std::move(f));
+  }
+
+  // Return true if the connection is open
+  virtual bool Contains(connection_hdl hdl) const = 0;
+
+  // Send a text message to the client if the connection is still open
+  void Send(connection_hdl hdl, const std::string &text);
+
+  // Close a websocket connection with given code and reason
+  void Close(connection_hdl hdl, websocketpp::close::status::value code,
+             const std::string &reason);
+
+  // Stop and resume reading messages from a connection. Used to apply
+  // backpressure to clients that send audio faster than we can decode.
+  void PauseReading(connection_hdl hdl);
+  void ResumeReading(connection_hdl hdl);
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_WEBSOCKET_DECODER_HOST_H_
@@ -0,0 +1,850 @@
+// sherpa-onnx/csrc/websocket-load-client.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+// A load generator for sherpa-onnx-online-websocket-server and
+// sherpa-onnx-offline-websocket-server.
+//
+// It simulates many concurrent clients, each sending audio in real time
+// (or faster), and reports latency percentiles, a latency histogram and
+// the throughput of the server.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "sherpa-onnx/csrc/macros.h"
+#include "sherpa-onnx/csrc/metrics.h"
+#include "sherpa-onnx/csrc/parse-options.h"
+#include "sherpa-onnx/csrc/text-utils.h"
+#include "sherpa-onnx/csrc/wave-reader.h"
+#include "websocketpp/client.hpp"
+#include "websocketpp/config/asio_no_tls_client.hpp"
+#include "websocketpp/uri.hpp"
+
+using client = websocketpp::client<websocketpp::config::asio_client>;
+
+using message_ptr = client::message_ptr;
+using websocketpp::connection_hdl;
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr const char *kUsageMessage = R"(
+Load testing of the sherpa-onnx websocket servers.
+
+It starts --num-streams concurrent streams. Each stream sends utterances
+from wav.scp one after another in chunks of --chunk-seconds, paced at
+--speed times real time, until --duration seconds have passed. Streams are
+started linearly over --ramp-up-seconds.
+
+--num-streams can be a comma-separated list, e.g., 10,100,1000, to run
+several steps with increasing load. A report is printed after each step.
+
+Usage:
+
+(1) Online websocket server
+
+./bin/sherpa-onnx-websocket-load-client \
+  --server-ip=127.0.0.1 \
+  --server-port=6006 \
+  --mode=online \
+  --num-streams=10,100,500 \
+  --ramp-up-seconds=10 \
+  --duration=60 \
+  /path/to/wav.scp
+
+(2) Offline websocket server
+
+./bin/sherpa-onnx-websocket-load-client \
+  --server-port=6006 \
+  --mode=offline \
+  --num-streams=4,8,16 \
+  --speed=0 \
+  /path/to/wav.scp
+
+Each line of wav.scp contains an utterance ID and a wave filename, e.g.,
+
+  utt1 /path/to/utt1.wav
+  utt2 /path/to/utt2.wav
+
+It supports only waves with a single channel and 16-bit samples.
+
+The following latencies are reported:
+
+  - first_partial: From sending the first chunk of an utterance to receiving
+    the first result with non-empty text. Online mode only.
+  - final: From sending the end of an utterance to receiving its final
+    result.
+  - chunk: From sending a chunk to receiving the first result after it.
+    Online mode only.
+
+Note: Remember to increase the limit of open files, e.g., ulimit -n 65535,
+if you use thousands of streams.
+)";
+
+namespace sherpa_onnx {
+
+struct LoadClientConfig {
+  std::string server_ip = "127.0.0.1";
+  int32_t server_port = 6006;
+  std::string mode = "online";
+  std::string num_streams = "1";
+  float ramp_up_seconds = 0;
+  float duration = 30;
+  float speed = 1;
+  float chunk_seconds = 0.1;
+  int32_t sample_rate = 16000;
+  int32_t num_threads = 2;
+  std::string output;
+
+  // Parsed from num_streams
+  std::vector<int32_t> steps;
+
+  void Register(ParseOptions *po) {
+    po->Register("server-ip", &server_ip, "IP address of the websocket server");
+    po->Register("server-port", &server_port, "Port of the websocket server");
+    po->Register("mode", &mode,
+                 "online or offline. Must match the type of the server");
+    po->Register("num-streams", &num_streams,
+                 "Number of concurrent streams. Use a comma-separated list, "
+                 "e.g., 10,100,1000, to ramp the load in several steps");
+    po->Register("ramp-up-seconds", &ramp_up_seconds,
+                 "Start the streams of a step linearly over this number of "
+                 "seconds");
+    po->Register("duration", &duration,
+                 "Duration in seconds of each step. No new utterances are "
+                 "started after it, but started ones are completed");
+    po->Register("speed", &speed,
+                 "Send audio at this times real time. 1 means real time. "
+                 "0 means as fast as possible");
+    po->Register("chunk-seconds", &chunk_seconds,
+                 "Send this number of seconds of audio per message");
+    po->Register("sample-rate", &sample_rate,
+                 "Sample rate of the input waves. Should be the one expected "
+                 "by the server");
+    po->Register("num-threads", &num_threads,
+                 "Number of threads for network IO");
+    po->Register("output", &output,
+                 "If not empty, also write the reports to this file in JSON");
+  }
+
+  bool Validate() {
+    if (!websocketpp::uri_helper::ipv4_literal(server_ip.begin(),
+                                               server_ip.end())) {
+      SHERPA_ONNX_LOGE("Invalid server IP: %s", server_ip.c_str());
+      return false;
+    }
+
+    if (server_port <= 0 || server_port > 65535) {
+      SHERPA_ONNX_LOGE("Invalid server port: %d", server_port);
+      return false;
+    }
+
+    if (mode != "online" && mode != "offline") {
+      SHERPA_ONNX_LOGE("--mode should be online or offline. Given: %s",
+                       mode.c_str());
+      return false;
+    }
+
+    std::vector<std::string> fields;
+    SplitStringToVector(num_streams, ",", false, &fields);
+    steps.clear();
+    for (const auto &f : fields) {
+      int32_t n = atoi(f.c_str());
+      if (n <= 0) {
+        SHERPA_ONNX_LOGE("Invalid --num-streams: %s", num_streams.c_str());
+        return false;
+      }
+      steps.push_back(n);
+    }
+
+    if (steps.empty()) {
+      SHERPA_ONNX_LOGE("Please provide --num-streams");
+      return false;
+    }
+
+    if (ramp_up_seconds < 0) {
+      SHERPA_ONNX_LOGE("--ramp-up-seconds should be >= 0. Given: %.3f",
+                       ramp_up_seconds);
+      return false;
+    }
+
+    if (duration <= 0) {
+      SHERPA_ONNX_LOGE("--duration should be > 0. Given: %.3f", duration);
+      return false;
+    }
+
+    if (speed < 0) {
+      SHERPA_ONNX_LOGE("--speed should be >= 0. Given: %.3f", speed);
+      return false;
+    }
+
+    // 0.01 and 100 are arbitrary values. You can change them.
+    if (chunk_seconds < 0.01 || chunk_seconds > 100) {
+      SHERPA_ONNX_LOGE("--chunk-seconds should be in [0.01, 100]. Given: %.3f",
+                       chunk_seconds);
+      return false;
+    }
+
+    if (num_threads < 1) {
+      SHERPA_ONNX_LOGE("--num-threads should be >= 1. Given: %d",
+                       num_threads);
+      return false;
+    }
+
+    return true;
+  }
+};
+
+struct Utterance {
+  std::string id;
+  std::vector<float> samples;
+  float duration = 0;  // in seconds
+};
+
+static std::vector<Utterance> ReadWavScp(const std::string &filename,
+                                         int32_t expected_sample_rate) {
+  std::ifstream is(filename);
+  if (!is) {
+    SHERPA_ONNX_LOGE("Failed to open '%s'", filename.c_str());
+    exit(-1);
+  }
+
+  std::vector<Utterance> ans;
+  std::string line;
+  while (std::getline(is, line)) {
+    std::istringstream iss(line);
+    std::string id;
+    std::string wave_filename;
+    if (!(iss >> id >> wave_filename)) {
+      continue;
+    }
+
+    bool is_ok = false;
+    int32_t sample_rate = -1;
+    Utterance u;
+    u.id = id;
+    u.samples = ReadWave(wave_filename, &sample_rate, &is_ok);
+    if (!is_ok) {
+      SHERPA_ONNX_LOGE("Failed to read '%s'", wave_filename.c_str());
+      exit(-1);
+    }
+
+    if (sample_rate != expected_sample_rate) {
+      SHERPA_ONNX_LOGE("Expected sample rate: %d, given %d in '%s'",
+                       expected_sample_rate, sample_rate,
+                       wave_filename.c_str());
+      exit(-1);
+    }
+
+    u.duration = static_cast<float>(u.samples.size()) / sample_rate;
+    ans.push_back(std::move(u));
+  }
+
+  if (ans.empty()) {
+    SHERPA_ONNX_LOGE("No utterances found in '%s'", filename.c_str());
+    exit(-1);
+  }
+
+  return ans;
+}
+
+// Latencies in seconds. It keeps all values for exact percentiles and
+// also counts them into the buckets of LatencyBuckets() for the histogram.
+class LatencyRecorder {
+ public:
+  LatencyRecorder() : histogram_(LatencyBuckets()) {}
+
+  void Add(double v) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    values_.push_back(v);
+    histogram_.Observe(v);
+  }
+
+  int32_t Count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return values_.size();
+  }
+
+  // p is in [0, 100]. Return 0 if there are no values.
+  double Percentile(double p) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (values_.empty()) {
+      return 0;
+    }
+
+    std::vector<double> v = values_;
+    int32_t k = std::min<int32_t>(v.size() - 1, p / 100 * v.size());
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+  }
+
+  double Mean() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (values_.empty()) {
+      return 0;
+    }
+
+    double sum = 0;
+    for (double v : values_) {
+      sum += v;
+    }
+    return sum / values_.size();
+  }
+
+  double Max() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (values_.empty()) {
+      return 0;
+    }
+    return *std::max_element(values_.begin(), values_.end());
+  }
+
+  const Histogram &GetHistogram() const { return histogram_; }
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<double> values_;
+  Histogram histogram_;
+};
+
+struct StepReport {
+  int32_t num_streams = 0;
+  double wall_seconds = 0;
+
+  LatencyRecorder first_partial;
+  LatencyRecorder final;
+  LatencyRecorder chunk;
+
+  std::mutex mutex;
+  int32_t num_utterances = 0;
+  int32_t num_errors = 0;
+  double audio_seconds = 0;
+  int64_t num_messages = 0;
+};
+
+// State of a simulated client. All members are protected by mutex since
+// timers and websocket handlers may run in different IO threads.
+struct Stream {
+  explicit Stream(asio::io_context &io) : timer(io) {}  // NOLINT
+
+  std::mutex mutex;
+  int32_t index = 0;
+  int32_t next_utterance = 0;
+
+  connection_hdl hdl;
+  const Utterance *utterance = nullptr;
+  int32_t num_sent_samples = 0;
+
+  Clock::time_point start_time;  // when the first chunk is sent
+  Clock::time_point end_time;    // when the last chunk is sent
+
+  // Send time of chunks that have not been answered yet. Online mode only.
+  std::vector<Clock::time_point> pending_chunks;
+
+  bool got_first_partial = false;
+  bool got_final = false;
+
+  asio::steady_timer timer;
+};
+
+class LoadClient {
+ public:
+  LoadClient(const LoadClientConfig &config,
+             const std::vector<Utterance> &utterances, int32_t num_streams,
+             StepReport *report)
+      : config_(config),
+        utterances_(utterances),
+        num_streams_(num_streams),
+        report_(report),
+        uri_(/*secure*/ false, config.server_ip, config.server_port,
+             /*resource*/ "/") {
+    c_.clear_access_channels(websocketpp::log::alevel::all);
+    c_.clear_error_channels(websocketpp::log::elevel::all);
+    c_.init_asio(&io_);
+  }
+
+  void Run() {
+    start_time_ = Clock::now();
+    end_time_ = start_time_ + ToDuration(config_.duration);
+
+    streams_.reserve(num_streams_);
+    for (int32_t i = 0; i != num_streams_; ++i) {
+      streams_.push_back(std::make_unique<Stream>(io_));
+      Stream *s = streams_.back().get();
+      s->index = i;
+      // So that concurrent streams do not send the same utterance
+      s->next_utterance = i % utterances_.size();
+
+      float delay = config_.ramp_up_seconds * i / num_streams_;
+      s->timer.expires_at(start_time_ + ToDuration(delay));
+      s->timer.async_wait([this, s](const asio::error_code &ec) {
+        if (!ec) {
+          Connect(s);
+        }
+      });
+    }
+
+    // io_.run() returns when all streams are finished
+    std::vector<std::thread> threads;
+    for (int32_t i = 1; i < config_.num_threads; ++i) {
+      threads.emplace_back([this]() { io_.run(); });
+    }
+    io_.run();
+
+    for (auto &t : threads) {
+      t.join();
+    }
+
+    report_->wall_seconds =
+        std::chrono::duration<double>(Clock::now() - start_time_).count();
+  }
+
+ private:
+  static Clock::duration ToDuration(double seconds) {
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds));
+  }
+
+  static double Elapsed(Clock::time_point since) {
+    return std::chrono::duration<double>(Clock::now() - since).count();
+  }
+
+  bool Online() const { return config_.mode == "online"; }
+
+  void Connect(Stream *s) {
+    websocketpp::lib::error_code ec;
+    client::connection_ptr con = c_.get_connection(uri_.str(), ec);
+    if (ec) {
+      SHERPA_ONNX_LOGE("Could not create connection to %s because %s",
+                       uri_.str().c_str(), ec.message().c_str());
+      exit(-1);
+    }
+
+    con->set_open_handler([this, s](connection_hdl hdl) { OnOpen(s, hdl); });
+    con->set_message_handler(
+        [this, s](connection_hdl /*hdl*/, message_ptr msg) {
+          OnMessage(s, msg);
+        });
+    con->set_close_handler([this, s](connection_hdl /*hdl*/) { OnClose(s); });
+    con->set_fail_handler([this, s](connection_hdl /*hdl*/) { OnFail(s); });
+
+    c_.connect(con);
+  }
+
+  void OnOpen(Stream *s, connection_hdl hdl) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    s->hdl = hdl;
+    StartUtterance(s);
+  }
+
+  // Must be called with s->mutex held
+  void StartUtterance(Stream *s) {
+    s->utterance = &utterances_[s->next_utterance];
+    s->next_utterance = (s->next_utterance + 1) % utterances_.size();
+
+    s->num_sent_samples = 0;
+    s->pending_chunks.clear();
+    s->got_first_partial = false;
+    s->got_final = false;
+    s->start_time = Clock::now();
+
+    SendChunk(s);
+  }
+
+  // Must be called with s->mutex held
+  void SendChunk(Stream *s) {
+    const auto &samples = s->utterance->samples;
+    int32_t chunk_size = config_.chunk_seconds * config_.sample_rate;
+    int32_t n = std::min<int32_t>(chunk_size,
+                                  samples.size() - s->num_sent_samples);
+
+    websocketpp::lib::error_code ec;
+    if (Online()) {
+      c_.send(s->hdl, samples.data() + s->num_sent_samples, n * sizeof(float),
+              websocketpp::frame::opcode::binary, ec);
+    } else if (s->num_sent_samples == 0) {
+      // The first message for the offline server starts with the sample
+      // rate and the number of bytes of the utterance, both in int32_t.
+      int32_t header[2] = {config_.sample_rate,
+                           static_cast<int32_t>(samples.size() *
+                                                sizeof(float))};
+      std::string buf(sizeof(header) + n * sizeof(float), '\0');
+      memcpy(&buf[0], header, sizeof(header));
+      memcpy(&buf[sizeof(header)], samples.data(), n * sizeof(float));
+      c_.send(s->hdl, buf, websocketpp::frame::opcode::binary, ec);
+    } else {
+      c_.send(s->hdl, samples.data() + s->num_sent_samples, n * sizeof(float),
+              websocketpp::frame::opcode::binary, ec);
+    }
+
+    if (ec) {
+      SHERPA_ONNX_LOGE("Failed to send audio samples because %s",
+                       ec.message().c_str());
+      // The close handler will be invoked
+      return;
+    }
+
+    auto now = Clock::now();
+    if (Online()) {
+      s->pending_chunks.push_back(now);
+    }
+
+    s->num_sent_samples += n;
+    if (s->num_sent_samples == static_cast<int32_t>(samples.size())) {
+      s->end_time = now;
+      if (Online()) {
+        // Signal the server that there is no more audio for this utterance
+        c_.send(s->hdl, "Done", websocketpp::frame::opcode::text, ec);
+      }
+      return;
+    }
+
+    Clock::time_point next = now;
+    if (config_.speed > 0) {
+      next = s->start_time +
+             ToDuration(static_cast<double>(s->num_sent_samples) /
+                        config_.sample_rate / config_.speed);
+    }
+
+    s->timer.expires_at(next);
+    s->timer.async_wait([this, s](const asio::error_code &ec) {
+      if (ec) {
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock(s->mutex);
+      if (s->utterance) {
+        SendChunk(s);
+      }
+    });
+  }
+
+  static bool HasText(const std::string &payload) {
+    // The result is in JSON, e.g., {"text": "hello", ...}
+    const char *key = "\"text\": \"";
+    auto pos = payload.find(key);
+    if (pos == std::string::npos) {
+      return false;
+    }
+
+    pos += strlen(key);
+    return pos < payload.size() && payload[pos] != '"';
+  }
+
+  void OnMessage(Stream *s, message_ptr msg) {
+    const std::string &payload = msg->get_payload();
+    auto now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (!s->utterance) {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> report_lock(report_->mutex);
+      report_->num_messages += 1;
+    }
+
+    if (!Online()) {
+      // The offline server sends a single result per utterance
+      report_->final.Add(
+          std::chrono::duration<double>(now - s->end_time).count());
+      FinishUtterance(s);
+
+      if (now < end_time_) {
+        StartUtterance(s);
+      } else {
+        Close(s);
+      }
+      return;
+    }
+
+    if (payload == "Done!") {
+      // The server has sent all results of this utterance
+      report_->final.Add(
+          std::chrono::duration<double>(now - s->end_time).count());
+      FinishUtterance(s);
+      Close(s);
+      return;
+    }
+
+    for (const auto &t : s->pending_chunks) {
+      report_->chunk.Add(std::chrono::duration<double>(now - t).count());
+    }
+    s->pending_chunks.clear();
+
+    if (!s->got_first_partial && HasText(payload)) {
+      s->got_first_partial = true;
+      report_->first_partial.Add(
+          std::chrono::duration<double>(now - s->start_time).count());
+    }
+  }
+
+  // Must be called with s->mutex held
+  void FinishUtterance(Stream *s) {
+    s->got_final = true;
+
+    std::lock_guard<std::mutex> lock(report_->mutex);
+    report_->num_utterances += 1;
+    report_->audio_seconds += s->utterance->duration;
+  }
+
+  // Must be called with s->mutex held
+  void Close(Stream *s) {
+    s->utterance = nullptr;
+    s->timer.cancel();
+
+    websocketpp::lib::error_code ec;
+    c_.close(s->hdl, websocketpp::close::status::normal, "", ec);
+    if (ec) {
+      SHERPA_ONNX_LOGE("Failed to close because %s", ec.message().c_str());
+    }
+  }
+
+  void OnClose(Stream *s) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (s->utterance) {
+      // Closed by the server before the utterance is finished
+      s->utterance = nullptr;
+      s->timer.cancel();
+      CountError();
+    }
+
+    // The online server accepts only one utterance per connection
+    if (Clock::now() < end_time_) {
+      Connect(s);
+    }
+  }
+
+  void OnFail(Stream *s) {
+    CountError();
+
+    if (Clock::now() >= end_time_) {
+      return;
+    }
+
+    // Retry after a while so that we don't flood the server
+    std::lock_guard<std::mutex> lock(s->mutex);
+    s->timer.expires_after(std::chrono::seconds(1));
+    s->timer.async_wait([this, s](const asio::error_code &ec) {
+      if (!ec) {
+        Connect(s);
+      }
+    });
+  }
+
+  void CountError() {
+    std::lock_guard<std::mutex> lock(report_->mutex);
+    report_->num_errors += 1;
+  }
+
+ private:
+  const LoadClientConfig &config_;
+  const std::vector<Utterance> &utterances_;
+  int32_t num_streams_;
+  StepReport *report_;
+
+  asio::io_context io_;
+  client c_;
+  websocketpp::uri uri_;
+
+  std::vector<std::unique_ptr<Stream>> streams_;
+
+  Clock::time_point start_time_;
+  Clock::time_point end_time_;
+};
+
+static void PrintLatency(const std::string &name, const LatencyRecorder &r,
+                         std::ostream &os) {
+  os << std::left << std::setw(14) << name << std::right << std::setw(9)
+     << r.Count();
+  for (double v : {r.Mean(), r.Percentile(50), r.Percentile(95),
+                   r.Percentile(99), r.Max()}) {
+    os << std::setw(10) << std::fixed << std::setprecision(1) << v * 1000;
+  }
+  os << "\n";
+}
+
+static void PrintHistogram(const std::string &name, const LatencyRecorder &r,
+                           std::ostream &os) {
+  const Histogram &h = r.GetHistogram();
+  int64_t total = h.Count();
+  if (total == 0) {
+    return;
+  }
+
+  os << "\nHistogram of " << name << " latency:\n";
+
+  const auto &bounds = h.Bounds();
+  for (size_t i = 0; i <= bounds.size(); ++i) {
+    int64_t n = h.BucketCount(i);
+    if (n == 0) {
+      continue;
+    }
+
+    std::ostringstream label;
+    if (i == bounds.size()) {
+      label << "> " << bounds.back() * 1000 << " ms";
+    } else {
+      label << "<= " << bounds[i] * 1000 << " ms";
+    }
+
+    int32_t width = 50 * n / total;
+    os << std::setw(14) << label.str() << std::setw(9) << n << " "
+       << std::string(width, '#') << "\n";
+  }
+}
+
+static void PrintReport(const LoadClientConfig &config, const StepReport &r,
+                        std::ostream &os) {
+  os << "\n==== num_streams: " << r.num_streams << " ====\n";
+  os << std::fixed << std::setprecision(2);
+  os << "Wall time: " << r.wall_seconds << " s\n";
+  os << "Utterances: " << r.num_utterances << ", errors: " << r.num_errors
+     << "\n";
+  os << "Audio processed: " << r.audio_seconds << " s\n";
+  os << "Throughput: " << r.audio_seconds / r.wall_seconds
+     << " seconds of audio per second, "
+     << r.num_utterances / r.wall_seconds << " utterances per second, "
+     << r.num_messages / r.wall_seconds << " results per second\n";
+
+  os << "\n"
+     << std::left << std::setw(14) << "latency (ms)" << std::right
+     << std::setw(9) << "count" << std::setw(10) << "mean" << std::setw(10)
+     << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99"
+     << std::setw(10) << "max"
+     << "\n";
+
+  if (config.mode == "online") {
+    PrintLatency("first_partial", r.first_partial, os);
+  }
+  PrintLatency("final", r.final, os);
+  if (config.mode == "online") {
+    PrintLatency("chunk", r.chunk, os);
+  }
+
+  PrintHistogram("final", r.final, os);
+  if (config.mode == "online") {
+    PrintHistogram("chunk", r.chunk, os);
+  }
+}
+
+static void WriteLatencyJson(const std::string &name, const LatencyRecorder &r,
+                             std::ostream &os) {
+  const Histogram &h = r.GetHistogram();
+  const auto &bounds = h.Bounds();
+
+  os << "\"" << name << "\": {";
+  os << "\"count\": " << r.Count() << ", ";
+  os << "\"mean\": " << r.Mean() << ", ";
+  os << "\"p50\": " << r.Percentile(50) << ", ";
+  os << "\"p95\": " << r.Percentile(95) << ", ";
+  os << "\"p99\": " << r.Percentile(99) << ", ";
+  os << "\"max\": " << r.Max() << ", ";
+
+  // Non-cumulative bucket counts. The last one is for +Inf.
+  os << "\"buckets\": [";
+  for (size_t i = 0; i <= bounds.size(); ++i) {
+    os << (i ? ", " : "") << "{\"le\": ";
+    if (i == bounds.size()) {
+      os << "\"+Inf\"";
+    } else {
+      os << bounds[i];
+    }
+    os << ", \"count\": " << h.BucketCount(i) << "}";
+  }
+  os << "]}";
+}
+
+static void WriteJson(const LoadClientConfig &config,
+                      const std::vector<std::unique_ptr<StepReport>> &reports,
+                      std::ostream &os) {
+  os << std::defaultfloat << std::setprecision(9);
+  os << "{\n";
+  os << "  \"mode\": \"" << config.mode << "\",\n";
+  os << "  \"speed\": " << config.speed << ",\n";
+  os << "  \"chunk_seconds\": " << config.chunk_seconds << ",\n";
+  os << "  \"steps\": [\n";
+
+  for (size_t i = 0; i != reports.size(); ++i) {
+    const auto &r = *reports[i];
+    os << "    {";
+    os << "\"num_streams\": " << r.num_streams << ", ";
+    os << "\"wall_seconds\": " << r.wall_seconds << ", ";
+    os << "\"num_utterances\": " << r.num_utterances << ", ";
+    os << "\"num_errors\": " << r.num_errors << ", ";
+    os << "\"audio_seconds\": " << r.audio_seconds << ", ";
+    os << "\"num_results\": " << r.num_messages << ", ";
+    os << "\"latency_seconds\": {";
+    WriteLatencyJson("first_partial", r.first_partial, os);
+    os << ", ";
+    WriteLatencyJson("final", r.final, os);
+    os << ", ";
+    WriteLatencyJson("chunk", r.chunk, os);
+    os << "}}" << (i + 1 == reports.size() ? "" : ",") << "\n";
+  }
+
+  os << "  ]\n";
+  os << "}\n";
+}
+
+}  // namespace sherpa_onnx
+
+int32_t main(int32_t argc, char *argv[]) {
+  sherpa_onnx::ParseOptions po(kUsageMessage);
+  sherpa_onnx::LoadClientConfig config;
+  config.Register(&po);
+
+  po.Read(argc, argv);
+
+  if (po.NumArgs() != 1) {
+    po.PrintUsage();
+    return -1;
+  }
+
+  if (!config.Validate()) {
+    return -1;
+  }
+
+  std::vector<sherpa_onnx::Utterance> utterances =
+      sherpa_onnx::ReadWavScp(po.GetArg(1), config.sample_rate);
+
+  SHERPA_ONNX_LOGE("Read %d utterances",
+                   static_cast<int32_t>(utterances.size()));
+
+  std::vector<std::unique_ptr<sherpa_onnx::StepReport>> reports;
+  for (int32_t num_streams : config.steps) {
+    SHERPA_ONNX_LOGE("Starting %d streams", num_streams);
+
+    reports.push_back(std::make_unique<sherpa_onnx::StepReport>());
+    auto report = reports.back().get();
+    report->num_streams = num_streams;
+
+    sherpa_onnx::LoadClient c(config, utterances, num_streams, report);
+    c.Run();
+
+    sherpa_onnx::PrintReport(config, *report, std::cout);
+  }
+
+  if (!config.output.empty()) {
+    std::ofstream os(config.output);
+    if (!os) {
+      SHERPA_ONNX_LOGE("Failed to open '%s'", config.output.c_str());
+      return -1;
+    }
+    sherpa_onnx::WriteJson(config, reports, os);
+  }
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+// sherpa-onnx/csrc/weighted-fair-scheduler-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/weighted-fair-scheduler.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(WeightedFairScheduler, Empty) {
+  WeightedFairScheduler scheduler;
+  scheduler.AddQueue(1);
+
+  int32_t queue = -1;
+  EXPECT_FALSE(scheduler.Pop(&queue));
+  EXPECT_FALSE(scheduler.RunOne());
+}
+
+TEST(WeightedFairScheduler, Weights) {
+  WeightedFairScheduler scheduler;
+  int32_t a = scheduler.AddQueue(1);
+  int32_t b = scheduler.AddQueue(3);
+
+  for (int32_t i = 0; i != 100; ++i) {
+    scheduler.Push(a, []() {});
+    scheduler.Push(b, []() {});
+  }
+
+  // Each task costs 1. b should run 3 times as often as a while both
+  // queues are busy.
+  std::vector<int32_t> count(2);
+  for (int32_t i = 0; i != 40; ++i) {
+    int32_t queue = -1;
+    auto task = scheduler.Pop(&queue);
+    ASSERT_TRUE(task);
+    task();
+    scheduler.Charge(queue, 1);
+    count[queue] += 1;
+  }
+
+  EXPECT_EQ(count[a], 10);
+  EXPECT_EQ(count[b], 30);
+}
+
+TEST(WeightedFairScheduler, Cost) {
+  WeightedFairScheduler scheduler;
+  int32_t a = scheduler.AddQueue(1);
+  int32_t b = scheduler.AddQueue(1);
+
+  for (int32_t i = 0; i != 100; ++i) {
+    scheduler.Push(a, []() {});
+    scheduler.Push(b, []() {});
+  }
+
+  // Tasks of a are 4 times as expensive, so b runs 4 times as often
+  std::vector<int32_t> count(2);
+  for (int32_t i = 0; i != 50; ++i) {
+    int32_t queue = -1;
+    scheduler.Pop(&queue)();
+    scheduler.Charge(queue, queue == a ? 4 : 1);
+    count[queue] += 1;
+  }
+
+  EXPECT_EQ(count[a], 10);
+  EXPECT_EQ(count[b], 40);
+}
+
+TEST(WeightedFairScheduler, IdleQueueGetsNoCredit) {
+  WeightedFairScheduler scheduler;
+  int32_t a = scheduler.AddQueue(1);
+  int32_t b = scheduler.AddQueue(1);
+
+  // Only a is busy for a while
+  for (int32_t i = 0; i != 10; ++i) {
+    int32_t queue = -1;
+    scheduler.Push(a, []() {});
+    scheduler.Pop(&queue)();
+    scheduler.Charge(queue, 1);
+  }
+
+  for (int32_t i = 0; i != 10; ++i) {
+    scheduler.Push(a, []() {});
+    scheduler.Push(b, []() {});
+  }
+
+  // b must not run 10 times in a row to catch up. They take turns.
+  std::vector<int32_t> count(2);
+  for (int32_t i = 0; i != 6; ++i) {
+    int32_t queue = -1;
+    scheduler.Pop(&queue)();
+    scheduler.Charge(queue, 1);
+    count[queue] += 1;
+  }
+
+  EXPECT_EQ(count[a], 3);
+  EXPECT_EQ(count[b], 3);
+}
+
+TEST(WeightedFairScheduler, Concurrent) {
+  WeightedFairScheduler scheduler;
+  int32_t a = scheduler.AddQueue(1);
+  int32_t b = scheduler.AddQueue(2);
+
+  std::atomic<int32_t> num_done{0};
+  for (int32_t i = 0; i != 1000; ++i) {
+    scheduler.Push(i % 2 ? a : b, [&num_done]() { num_done += 1; });
+  }
+
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t != 4; ++t) {
+    threads.emplace_back([&scheduler]() {
+      while (scheduler.RunOne()) {
+      }
+    });
+  }
+
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(num_done, 1000);
+  EXPECT_EQ(scheduler.Size(a), 0);
+  EXPECT_EQ(scheduler.Size(b), 0);
+}
+
+}  // namespace sherpa_onnx
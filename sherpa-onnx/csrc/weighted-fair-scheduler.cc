@@ -0,0 +1,103 @@
+// sherpa-onnx/csrc/weighted-fair-scheduler.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/weighted-fair-scheduler.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <utility>
+
+#include "sherpa-onnx/csrc/macros.h"
+
+namespace sherpa_onnx {
+
+int32_t WeightedFairScheduler::AddQueue(float weight) {
+  if (weight <= 0) {
+    SHERPA_ONNX_LOGE("Weight of a queue must be positive. Given: %.3f",
+                     weight);
+    exit(-1);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  queues_.emplace_back();
+  queues_.back().weight = weight;
+  queues_.back().virtual_time = virtual_time_;
+
+  return static_cast<int32_t>(queues_.size()) - 1;
+}
+
+int32_t WeightedFairScheduler::NumQueues() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queues_.size();
+}
+
+void WeightedFairScheduler::Push(int32_t queue, std::function<void()> task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Queue &q = queues_.at(queue);
+
+  if (q.tasks.empty()) {
+    // Don't let it catch up for the time it was idle
+    q.virtual_time = std::max(q.virtual_time, virtual_time_);
+  }
+
+  q.tasks.push_back(std::move(task));
+}
+
+std::function<void()> WeightedFairScheduler::Pop(int32_t *queue) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  int32_t best = -1;
+  for (int32_t i = 0; i != static_cast<int32_t>(queues_.size()); ++i) {
+    const Queue &q = queues_[i];
+    if (q.tasks.empty()) {
+      continue;
+    }
+
+    if (best == -1 || q.virtual_time < queues_[best].virtual_time) {
+      best = i;
+    }
+  }
+
+  if (best == -1) {
+    return {};
+  }
+
+  Queue &q = queues_[best];
+  std::function<void()> task = std::move(q.tasks.front());
+  q.tasks.pop_front();
+
+  virtual_time_ = std::max(virtual_time_, q.virtual_time);
+  *queue = best;
+
+  return task;
+}
+
+void WeightedFairScheduler::Charge(int32_t queue, double cost) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Queue &q = queues_.at(queue);
+  q.virtual_time += cost / q.weight;
+}
+
+bool WeightedFairScheduler::RunOne() {
+  int32_t queue = -1;
+  std::function<void()> task = Pop(&queue);
+  if (!task) {
+    return false;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  task();
+  auto end = std::chrono::steady_clock::now();
+
+  Charge(queue, std::chrono::duration<double>(end - start).count());
+
+  return true;
+}
+
+int32_t WeightedFairScheduler::Size(int32_t queue) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queues_.at(queue).tasks.size();
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,80 @@
+// sherpa-onnx/csrc/weighted-fair-scheduler.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_WEIGHTED_FAIR_SCHEDULER_H_
+#define SHERPA_ONNX_CSRC_WEIGHTED_FAIR_SCHEDULER_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <vector>
+
+namespace sherpa_onnx {
+
+/* Share a pool of work threads among several queues, e.g., one queue per
+ * model, in proportion to their weights.
+ *
+ * Each queue has a virtual time, which is increased by cost / weight
+ * whenever one of its tasks has run, where cost is the time the task took.
+ * The next task is taken from the non-empty queue with the smallest
+ * virtual time, so a queue with weight 2 gets twice as much time as a queue
+ * with weight 1 when both are busy. An idle queue does not accumulate
+ * credit: when it becomes non-empty, its virtual time is moved forward to
+ * that of the queue that ran last.
+ *
+ * Usage:
+ *
+ *   WeightedFairScheduler scheduler;
+ *   int32_t q = scheduler.AddQueue(2);
+ *
+ *   // For each task, push it and let a work thread run one task
+ *   scheduler.Push(q, task);
+ *   asio::post(io_work, [&scheduler]() { scheduler.RunOne(); });
+ *
+ * It is thread-safe.
+ */
+class WeightedFairScheduler {
+ public:
+  // Return the index of the new queue. weight must be positive.
+  int32_t AddQueue(float weight);
+
+  int32_t NumQueues() const;
+
+  void Push(int32_t queue, std::function<void()> task);
+
+  /* Remove the next task.
+   *
+   * @param queue On return, it contains the queue of the returned task.
+   * @return Return an empty function if all queues are empty.
+   */
+  std::function<void()> Pop(int32_t *queue);
+
+  // Increase the virtual time of the given queue by cost / weight
+  void Charge(int32_t queue, double cost);
+
+  // Pop the next task, run it and charge its queue for the time it took.
+  // Return false if there are no tasks.
+  bool RunOne();
+
+  // Number of tasks in the given queue
+  int32_t Size(int32_t queue) const;
+
+ private:
+  struct Queue {
+    float weight = 1;
+    double virtual_time = 0;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  mutable std::mutex mutex_;
+  std::vector<Queue> queues_;
+
+  // Virtual time of the queue from which the last task was popped
+  double virtual_time_ = 0;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_WEIGHTED_FAIR_SCHEDULER_H_
@@ -0,0 +1,85 @@
+// sherpa-onnx/csrc/work-stealing-queue-test.cc
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#include "sherpa-onnx/csrc/work-stealing-queue.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace sherpa_onnx {
+
+TEST(WorkStealingQueue, OwnItemsFirst) {
+  WorkStealingQueue<int32_t> q(2);
+  q.Push(0, 1);
+  q.Push(0, 2);
+  q.Push(1, 3);
+  q.Close();
+
+  int32_t i = 0;
+  EXPECT_TRUE(q.Pop(1, &i));
+  EXPECT_EQ(i, 3);
+  EXPECT_EQ(q.NumStolen(), 0);
+
+  // Steal from the back of the deque of worker 0
+  EXPECT_TRUE(q.Pop(1, &i));
+  EXPECT_EQ(i, 2);
+  EXPECT_EQ(q.NumStolen(), 1);
+
+  EXPECT_TRUE(q.Pop(0, &i));
+  EXPECT_EQ(i, 1);
+
+  EXPECT_FALSE(q.Pop(0, &i));
+  EXPECT_FALSE(q.Push(0, 4));
+}
+
+TEST(WorkStealingQueue, MoveOnly) {
+  WorkStealingQueue<std::unique_ptr<int32_t>> q(1);
+  q.Push(0, std::unique_ptr<int32_t>(new int32_t(10)));
+
+  std::unique_ptr<int32_t> p;
+  EXPECT_TRUE(q.Pop(0, &p));
+  EXPECT_EQ(*p, 10);
+}
+
+TEST(WorkStealingQueue, Concurrent) {
+  const int32_t num_workers = 4;
+  const int32_t n = 10000;
+  WorkStealingQueue<int32_t> q(num_workers, 16);
+
+  std::atomic<int64_t> sum{0};
+  std::atomic<int32_t> count{0};
+  std::vector<std::thread> workers;
+  for (int32_t w = 0; w != num_workers; ++w) {
+    workers.emplace_back([&, w]() {
+      int32_t i;
+      while (q.Pop(w, &i)) {
+        sum += i;
+        ++count;
+      }
+    });
+  }
+
+  // All items go to worker 0, so the others have to steal them
+  std::thread producer([&]() {
+    for (int32_t i = 0; i != n; ++i) {
+      q.Push(0, i);
+    }
+    q.Close();
+  });
+
+  producer.join();
+  for (auto &t : workers) {
+    t.join();
+  }
+
+  EXPECT_EQ(count, n);
+  EXPECT_EQ(sum, static_cast<int64_t>(n) * (n - 1) / 2);
+  EXPECT_EQ(q.Size(), 0);
+}
+
+}  // namespace sherpa_onnx
@@ -0,0 +1,132 @@
+// sherpa-onnx/csrc/work-stealing-queue.h
+//
+// Copyright (c)  2024  Xiaomi Corporation
+
+#ifndef SHERPA_ONNX_CSRC_WORK_STEALING_QUEUE_H_
+#define SHERPA_ONNX_CSRC_WORK_STEALING_QUEUE_H_
+
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace sherpa_onnx {
+
+/** A blocking multi-producer multi-consumer queue with one deque per worker.
+ *
+ * A worker takes items from the front of its own deque. When its own deque
+ * is empty, it steals from the back of the longest deque of other workers,
+ * so a worker that got long items does not hold back the others.
+ *
+ * Items are expected to be coarse-grained (e.g., a batch of utterances),
+ * so all deques share a single mutex.
+ */
+template <typename T>
+class WorkStealingQueue {
+ public:
+  /**
+   * @param num_workers Number of deques. Worker IDs are in [0, num_workers).
+   * @param capacity If positive, Push() blocks while there are this many
+   *                 items in total in the queue.
+   */
+  explicit WorkStealingQueue(int32_t num_workers, int32_t capacity = 0)
+      : queues_(num_workers > 0 ? num_workers : 1), capacity_(capacity) {}
+
+  WorkStealingQueue(const WorkStealingQueue &) = delete;
+  WorkStealingQueue &operator=(const WorkStealingQueue &) = delete;
+
+  int32_t NumWorkers() const { return static_cast<int32_t>(queues_.size()); }
+
+  /** Add an item to the deque of the given worker.
+   *
+   * @return false if the queue has been closed. In that case, the item
+   *         is discarded.
+   */
+  bool Push(int32_t worker, T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this]() {
+      return closed_ || capacity_ <= 0 || size_ < capacity_;
+    });
+
+    if (closed_) {
+      return false;
+    }
+
+    queues_[worker % NumWorkers()].push_back(std::move(item));
+    ++size_;
+    // Any idle worker can take it
+    not_empty_.notify_all();
+    return true;
+  }
+
+  /** Get an item for the given worker. It blocks until an item is available.
+   *
+   * @return false if the queue has been closed and it is empty.
+   */
+  bool Pop(int32_t worker, T *item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]() { return closed_ || size_ > 0; });
+
+    if (size_ == 0) {
+      return false;
+    }
+
+    auto &own = queues_[worker % NumWorkers()];
+    if (!own.empty()) {
+      *item = std::move(own.front());
+      own.pop_front();
+    } else {
+      auto *victim = &queues_[0];
+      for (auto &q : queues_) {
+        if (q.size() > victim->size()) {
+          victim = &q;
+        }
+      }
+      *item = std::move(victim->back());
+      victim->pop_back();
+      ++num_stolen_;
+    }
+
+    --size_;
+    not_full_.notify_one();
+    return true;
+  }
+
+  // Wake up all blocked workers. Pop() returns false once it is empty.
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  int32_t Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+  }
+
+  // Number of items a worker has taken from the deque of another worker
+  int64_t NumStolen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_stolen_;
+  }
+
+ private:
+  std::vector<std::deque<T>> queues_;
+  int32_t capacity_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  int32_t size_ = 0;
+  int64_t num_stolen_ = 0;
+  bool closed_ = false;
+};
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_WORK_STEALING_QUEUE_H_
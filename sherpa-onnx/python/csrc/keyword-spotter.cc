@@ -44,6 +44,7 @@ static void PybindKeywordSpotterConfig(py::module *m) {
       .def_readwrite("keywords_score", &PyClass::keywords_score)
       .def_readwrite("keywords_threshold", &PyClass::keywords_threshold)
       .def_readwrite("keywords_file", &PyClass::keywords_file)
+      .def_readwrite("blank_skip_threshold", &PyClass::blank_skip_threshold)
       .def("__str__", &PyClass::ToString);
 }
 
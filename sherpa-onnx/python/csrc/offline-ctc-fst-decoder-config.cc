@@ -17,6 +17,8 @@ void PybindOfflineCtcFstDecoderConfig(py::module *m) {
            py::arg("max_active") = 3000)
       .def_readwrite("graph", &PyClass::graph)
       .def_readwrite("max_active", &PyClass::max_active)
+      .def_readwrite("nbest", &PyClass::nbest)
+      .def_readwrite("lattice_beam", &PyClass::lattice_beam)
       .def("__str__", &PyClass::ToString);
 }
 
@@ -5,6 +5,7 @@
 #include "sherpa-onnx/python/csrc/offline-punctuation.h"
 
 #include <string>
+#include <vector>
 
 #include "sherpa-onnx/csrc/offline-punctuation.h"
 
@@ -37,14 +38,43 @@ static void PybindOfflinePunctuationConfig(py::module *m) {
       .def("__str__", &PyClass::ToString);
 }
 
+static void PybindOfflinePunctuationStream(py::module *m) {
+  using PyClass = OfflinePunctuationStream;
+
+  py::class_<PyClass>(*m, "OfflinePunctuationStream")
+      .def("accept_text", &PyClass::AcceptText, py::arg("text"))
+      .def("input_finished", &PyClass::InputFinished)
+      .def_property_readonly("is_input_finished", &PyClass::IsInputFinished)
+      .def_property_readonly("result", &PyClass::GetResult);
+}
+
 void PybindOfflinePunctuation(py::module *m) {
   PybindOfflinePunctuationConfig(m);
+  PybindOfflinePunctuationStream(m);
   using PyClass = OfflinePunctuation;
 
   py::class_<PyClass>(*m, "OfflinePunctuation")
       .def(py::init<const OfflinePunctuationConfig &>(), py::arg("config"),
            py::call_guard<py::gil_scoped_release>())
-      .def("add_punctuation", &PyClass::AddPunctuation, py::arg("text"),
+      .def(
+          "add_punctuation",
+          [](const PyClass &self, const std::string &text) {
+            return self.AddPunctuation(text);
+          },
+          py::arg("text"), py::call_guard<py::gil_scoped_release>())
+      .def(
+          "add_punctuation",
+          [](const PyClass &self, const std::vector<std::string> &texts) {
+            return self.AddPunctuation(texts);
+          },
+          py::arg("texts"), py::call_guard<py::gil_scoped_release>())
+      .def(
+          "add_punctuation",
+          [](const PyClass &self, OfflinePunctuationStream *s) {
+            self.AddPunctuation(s);
+          },
+          py::arg("s"), py::call_guard<py::gil_scoped_release>())
+      .def("create_stream", &PyClass::CreateStream,
            py::call_guard<py::gil_scoped_release>());
 }
 
@@ -33,6 +33,8 @@ static void PybindOfflineRecognizerConfig(py::module *m) {
       .def_readwrite("hotwords_file", &PyClass::hotwords_file)
       .def_readwrite("hotwords_score", &PyClass::hotwords_score)
       .def_readwrite("blank_penalty", &PyClass::blank_penalty)
+      .def_readwrite("decoder_out_cache_size",
+                     &PyClass::decoder_out_cache_size)
       .def("__str__", &PyClass::ToString);
 }
 
@@ -22,6 +22,22 @@ Args:
     to the range [-1, 1].
 )";
 
+static void PybindOfflineRecognitionHypothesis(py::module *m) {  // NOLINT
+  using PyClass = OfflineRecognitionHypothesis;
+  py::class_<PyClass>(*m, "OfflineRecognitionHypothesis")
+      .def_property_readonly(
+          "text",
+          [](const PyClass &self) -> py::str {
+            return py::str(PyUnicode_DecodeUTF8(self.text.c_str(),
+                                                self.text.size(), "ignore"));
+          })
+      .def_readonly("tokens", &PyClass::tokens)
+      .def_readonly("timestamps", &PyClass::timestamps)
+      .def_readonly("words", &PyClass::words)
+      .def_readonly("acoustic_cost", &PyClass::acoustic_cost)
+      .def_readonly("graph_cost", &PyClass::graph_cost);
+}
+
 static void PybindOfflineRecognitionResult(py::module *m) {  // NOLINT
   using PyClass = OfflineRecognitionResult;
   py::class_<PyClass>(*m, "OfflineRecognitionResult")
@@ -35,10 +51,13 @@ static void PybindOfflineRecognitionResult(py::module *m) {  // NOLINT
       .def_property_readonly("tokens",
                              [](const PyClass &self) { return self.tokens; })
       .def_property_readonly(
-          "timestamps", [](const PyClass &self) { return self.timestamps; });
+          "timestamps", [](const PyClass &self) { return self.timestamps; })
+      .def_property_readonly("nbest",
+                             [](const PyClass &self) { return self.nbest; });
 }
 
 void PybindOfflineStream(py::module *m) {
+  PybindOfflineRecognitionHypothesis(m);
   PybindOfflineRecognitionResult(m);
 
   using PyClass = OfflineStream;
@@ -17,6 +17,7 @@ void PybindOnlineCtcFstDecoderConfig(py::module *m) {
            py::arg("max_active") = 3000)
       .def_readwrite("graph", &PyClass::graph)
       .def_readwrite("max_active", &PyClass::max_active)
+      .def_readwrite("num_threads", &PyClass::num_threads)
       .def("__str__", &PyClass::ToString);
 }
 
@@ -76,6 +76,9 @@ static void PybindOnlineRecognizerConfig(py::module *m) {
       .def_readwrite("hotwords_score", &PyClass::hotwords_score)
       .def_readwrite("blank_penalty", &PyClass::blank_penalty)
       .def_readwrite("temperature_scale", &PyClass::temperature_scale)
+      .def_readwrite("blank_skip_threshold", &PyClass::blank_skip_threshold)
+      .def_readwrite("decoder_out_cache_size",
+                     &PyClass::decoder_out_cache_size)
       .def("__str__", &PyClass::ToString);
 }
 
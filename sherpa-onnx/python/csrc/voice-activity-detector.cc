@@ -38,7 +38,9 @@ void PybindVoiceActivityDetector(py::module *m) {
       .def("is_speech_detected", &PyClass::IsSpeechDetected,
            py::call_guard<py::gil_scoped_release>())
       .def("reset", &PyClass::Reset, py::call_guard<py::gil_scoped_release>())
-      .def_property_readonly("front", &PyClass::Front);
+      .def_property_readonly(
+          "front", static_cast<const SpeechSegment &(PyClass::*)() const>(
+                       &PyClass::Front));
 }
 
 }  // namespace sherpa_onnx